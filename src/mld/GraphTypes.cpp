@@ -36,6 +36,7 @@ Enum2Wstring Attrs::V {
     {NodeAttr::LABEL, L"MLD_N_LABEL"},
     {LayerAttr::IS_BASE, L"MLD_LAYER_IS_BASE"},
     {LayerAttr::DESCRIPTION, L"MLD_LAYER_DESCRIPTION"},
+    {LayerAttr::SIGNAL_BITS, L"MLD_LAYER_SIGNAL_BITS"},
     {HLinkAttr::WEIGHT, L"MLD_HLINK_WEIGHT"},
     {VLinkAttr::WEIGHT, L"MLD_VLINK_WEIGHT"},
     {OLinkAttr::WEIGHT, L"MLD_OLINK_WEIGHT"},
@@ -115,6 +115,7 @@ struct MLD_API LayerAttr
     {
         IS_BASE = NodeAttr::NODEATTR_MAX,
         DESCRIPTION,
+        SIGNAL_BITS,
         LAYERATTR_MAX
     };
 };
@@ -20,6 +20,8 @@
 #include <boost/lexical_cast.hpp>
 
 #include "mld/MLGBuilder.h"
+#include "mld/dao/MLGDao.h"
+#include "mld/model/AncestryIndex.h"
 #include "mld/operator/AbstractOperator.h"
 #include "mld/operator/coarseners.h"
 #include "mld/operator/selectors.h"
@@ -32,6 +34,7 @@ using namespace sparksee::gdb;
 namespace ba = boost::algorithm;
 
 MLGBuilder::MLGBuilder()
+    : m_index(nullptr)
 {
 }
 
@@ -40,6 +43,15 @@ MLGBuilder::~MLGBuilder()
     m_steps.clear();
 }
 
+void MLGBuilder::setAncestryIndex( Graph* g, AncestryIndex* index )
+{
+    m_index = index;
+    if( index )
+        m_dao.reset(new MLGDao(g));
+    else
+        m_dao.reset();
+}
+
 bool MLGBuilder::run()
 {
     LOG(logINFO) << "Start building multilayer graph";
@@ -47,6 +59,11 @@ bool MLGBuilder::run()
         LOG(logWARNING) << "MLGBuilder::run queue is empty";
         return false;
     }
+    if( m_index && !m_dao->updateAncestryIndex(*m_index) ) {
+        LOG(logERROR) << "MLGBuilder::run: ancestry index update failed";
+        clearSteps();
+        return false;
+    }
     // Run each step and remove it from the queue
     while( !m_steps.empty() ) {
         CoarsenerPtr& step = m_steps.front();
@@ -57,6 +74,12 @@ bool MLGBuilder::run()
             clearSteps();
             return false;
         }
+        // Only the new top layer is indexed
+        if( m_index && !m_dao->updateAncestryIndex(*m_index) ) {
+            LOG(logERROR) << "MLGBuilder::run: ancestry index update failed";
+            clearSteps();
+            return false;
+        }
         m_steps.pop_front();
     }
     return true;
@@ -20,6 +20,7 @@
 #define MLD_MLGBUILDER_H
 
 #include <deque>
+#include <memory>
 
 #include "mld/common.h"
 
@@ -31,6 +32,8 @@ namespace gdb {
 namespace mld {
 
 class AbstractCoarsener;
+class AncestryIndex;
+class MLGDao;
 
 typedef std::shared_ptr<AbstractCoarsener> CoarsenerPtr;
 /**
@@ -51,6 +54,14 @@ public:
     void addStep( const CoarsenerPtr& step ) { m_steps.push_back(step); }
     void clearSteps() { m_steps.clear(); }
 
+    /**
+     * @brief Keep an ancestry index up to date with the layers added by the steps,
+     * the index is updated before the first step and after each step
+     * @param g Graph
+     * @param index Index, not owned, nullptr to disable
+     */
+    void setAncestryIndex( sparksee::gdb::Graph* g, AncestryIndex* index );
+
     /**
      * @brief Parse coarsening plan from input
      * Create corresponding coarseners
@@ -75,6 +86,8 @@ public:
     static CoarsenerPtr createCoarsener( sparksee::gdb::Graph* g, const std::string& name, float fac );
 private:
     std::deque<CoarsenerPtr> m_steps;
+    std::unique_ptr<MLGDao> m_dao;
+    AncestryIndex* m_index;
 };
 
 } // end namespace mld
@@ -172,6 +172,8 @@ void SparkseeManager::createNodeTypes( Graph* g )
         nType = g->NewNodeType(NodeType::LAYER);
         addAttr(g, NodeType::LAYER, Attrs::V[LayerAttr::IS_BASE], Boolean, Indexed, val.SetBoolean(false));
         addAttr(g, NodeType::LAYER, Attrs::V[LayerAttr::DESCRIPTION], String, Basic, val.SetString(L""));
+        // Width of the signal values, only set on the base layer
+        addAttr(g, NodeType::LAYER, Attrs::V[LayerAttr::SIGNAL_BITS], Integer, Basic, val.SetInteger(0));
     }
 }
 
@@ -66,6 +66,14 @@ static const double NODE_DEF_VALUE = 1.0;
 
 static const int64_t INVALID_NODE_COUNT = -1;
 static const int64_t INVALID_EDGE_COUNT = -1;
+static const size_t INVALID_INDEX = static_cast<size_t>(-1);
+
+// Type of the signal values held in memory, accumulations are done in double
+#ifdef MLD_FLOAT_SIGNAL
+using SignalValue = float;
+#else
+using SignalValue = double;
+#endif
 
 enum class TSDirection {
     PAST,
@@ -370,6 +370,22 @@ void LayerDao::setAsBaseLayerImpl( oid_t newId )
         m_g->SetAttribute(oldId, attr, m_v->SetBoolean(false));
         m_g->SetAttribute(newId, attr, m_v->SetBoolean(true));
     }
+
+    // Record the width of the signal values written by this build,
+    // databases created before the attribute existed have none
+    attr = m_g->FindAttribute(m_layerType, Attrs::V[LayerAttr::SIGNAL_BITS]);
+    if( attr != Attribute::InvalidAttribute )
+        m_g->SetAttribute(newId, attr, m_v->SetInteger(int(sizeof(SignalValue) * 8)));
+}
+
+int LayerDao::signalBits()
+{
+    auto attr = m_g->FindAttribute(m_layerType, Attrs::V[LayerAttr::SIGNAL_BITS]);
+    auto base = baseLayerImpl();
+    if( attr == Attribute::InvalidAttribute || base == Objects::InvalidOID )
+        return 0;
+    m_g->GetAttribute(base, attr, *m_v);
+    return m_v->IsNull() ? 0 : m_v->GetInteger();
 }
 
 oid_t LayerDao::topLayerImpl()
@@ -49,6 +49,7 @@ public:
 
     Layer addBaseLayer();
     void setAsBaseLayer( Layer& layer );
+    int signalBits();
 
     Layer addLayerOnTop();
     Layer addLayerOnBottom();
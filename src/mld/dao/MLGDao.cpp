@@ -25,6 +25,9 @@
 #include "mld/dao/LayerDao.h"
 #include "mld/dao/NodeDao.h"
 #include "mld/dao/LinkDao.h"
+#include "mld/model/SignalStore.h"
+#include "mld/model/TransferMap.h"
+#include "mld/model/AncestryIndex.h"
 #include "mld/utils/ProgressDisplay.h"
 
 using namespace mld;
@@ -643,7 +646,7 @@ std::vector<OLink> MLGDao::getAllOLinks( oid_t nodeId )
     return res;
 }
 
-TimeSeries<double> MLGDao::getSignal( oid_t nodeId, oid_t bottomLayer, oid_t topLayer )
+TimeSeries<SignalValue> MLGDao::getSignal( oid_t nodeId, oid_t bottomLayer, oid_t topLayer )
 {
 #ifdef MLD_SAFE
     if( bottomLayer == Objects::InvalidOID
@@ -651,36 +654,36 @@ TimeSeries<double> MLGDao::getSignal( oid_t nodeId, oid_t bottomLayer, oid_t top
         || nodeId == Objects::InvalidOID ) {
 
         LOG(logERROR) << "MLGDao::getSignal: invalid ids";
-        return TimeSeries<double>();
+        return TimeSeries<SignalValue>();
     }
 #endif
 
     // Use as less overhead as possible
-    TimeSeries<double> res;
+    TimeSeries<SignalValue> res;
     oid_t layer = bottomLayer;
     type_t oType = m_link->olinkType();
     Value v;
     while( layer != topLayer ) {
         oid_t eid = findEdge(oType, layer, nodeId);
         m_g->GetAttribute(eid, m_g->FindAttribute(oType, Attrs::V[OLinkAttr::WEIGHT]), v);
-        res.data().push_back(v.GetDouble());
+        res.data().push_back(SignalValue(v.GetDouble()));
         layer = m_layer->parent(layer);
     }
 
     // Don't forget last layer, it is inclusive
     oid_t eid = findEdge(oType, layer, nodeId);
     m_g->GetAttribute(eid, m_g->FindAttribute(oType, Attrs::V[OLinkAttr::WEIGHT]), v);
-    res.data().push_back(v.GetDouble());
+    res.data().push_back(SignalValue(v.GetDouble()));
     res.clamp();
     return res;
 }
 
-TimeSeries<double> MLGDao::getSignal( oid_t nodeId, oid_t curLayer, TSDirection dir, size_t radius )
+TimeSeries<SignalValue> MLGDao::getSignal( oid_t nodeId, oid_t curLayer, TSDirection dir, size_t radius )
 {
 #ifdef MLD_SAFE
     if( nodeId == Objects::InvalidOID || curLayer == Objects::InvalidOID ) {
         LOG(logERROR) << "MLGDao::getSignal invalid ids";
-        return TimeSeries<double>();
+        return TimeSeries<SignalValue>();
     }
 #endif
     LayerIdPair bounds(getLayerBounds(curLayer, dir, radius));
@@ -726,6 +729,445 @@ LayerIdPair MLGDao::getLayerBounds( oid_t curLayer, TSDirection dir, size_t radi
     return res;
 }
 
+OLinkWeightMap MLGDao::getOLinkWeights( oid_t layerId )
+{
+    return getOLinkWeights(layerId, Attrs::V[OLinkAttr::WEIGHT]);
+}
+
+OLinkWeightMap MLGDao::getOLinkWeights( oid_t layerId, const std::wstring& attrName )
+{
+    OLinkWeightMap res;
+#ifdef MLD_SAFE
+    if( layerId == Objects::InvalidOID ) {
+        LOG(logERROR) << "MLGDao::getOLinkWeights invalid layer id";
+        return res;
+    }
+#endif
+    type_t oType = m_link->olinkType();
+    // Resolve attribute once for the whole layer
+    attr_t wAttr = m_g->FindAttribute(oType, attrName);
+    if( wAttr == Attribute::InvalidAttribute ) {
+        LOG(logERROR) << "MLGDao::getOLinkWeights invalid OLink attribute";
+        return res;
+    }
+    ObjectsPtr olinks(m_g->Explode(layerId, oType, Outgoing));
+    res.reserve(olinks->Count());
+
+    Value v;
+    ObjectsIt it(olinks->Iterator());
+    while( it->HasNext() ) {
+        oid_t eid = it->Next();
+        m_g->GetAttribute(eid, wAttr, v);
+        // Unset values are left out, callers report them as missing
+        if( !v.IsNull() )
+            res.emplace(m_g->GetEdgePeer(eid, layerId), v.GetDouble());
+    }
+    return res;
+}
+
+bool MLGDao::getOLinkWeights( oid_t layerId, const std::vector<oid_t>& nodes, double* out )
+{
+#ifdef MLD_SAFE
+    if( layerId == Objects::InvalidOID ) {
+        LOG(logERROR) << "MLGDao::getOLinkWeights invalid layer id";
+        return false;
+    }
+    try {
+#endif
+        type_t oType = m_link->olinkType();
+        attr_t wAttr = m_g->FindAttribute(oType, Attrs::V[OLinkAttr::WEIGHT]);
+        Value v;
+        for( size_t i = 0; i < nodes.size(); ++i ) {
+            oid_t eid = m_g->FindEdge(oType, layerId, nodes[i]);
+            if( eid == Objects::InvalidOID ) {
+                LOG(logERROR) << "MLGDao::getOLinkWeights no OLink for nid: " << nodes[i]
+                              << " lid: " << layerId;
+                return false;
+            }
+            m_g->GetAttribute(eid, wAttr, v);
+            if( v.IsNull() ) {
+                LOG(logERROR) << "MLGDao::getOLinkWeights no weight for nid: " << nodes[i]
+                              << " lid: " << layerId;
+                return false;
+            }
+            out[i] = v.GetDouble();
+        }
+#ifdef MLD_SAFE
+    } catch( Error& e ) {
+        LOG(logERROR) << "MLGDao::getOLinkWeights: " << e.Message();
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool MLGDao::updateOLinkWeights( oid_t layerId, const OLinkWeightMap& weights )
+{
+    return updateOLinkWeights(layerId, weights, Attrs::V[OLinkAttr::WEIGHT]);
+}
+
+bool MLGDao::updateOLinkWeights( oid_t layerId, const OLinkWeightMap& weights,
+                                 const std::wstring& attrName )
+{
+#ifdef MLD_SAFE
+    if( layerId == Objects::InvalidOID ) {
+        LOG(logERROR) << "MLGDao::updateOLinkWeights invalid layer id";
+        return false;
+    }
+#endif
+    type_t oType = m_link->olinkType();
+    attr_t wAttr = m_g->FindAttribute(oType, attrName);
+    if( wAttr == Attribute::InvalidAttribute ) {
+        LOG(logERROR) << "MLGDao::updateOLinkWeights invalid OLink attribute";
+        return false;
+    }
+    ObjectsPtr olinks(m_g->Explode(layerId, oType, Outgoing));
+
+    Value v;
+    ObjectsIt it(olinks->Iterator());
+    while( it->HasNext() ) {
+        oid_t eid = it->Next();
+        auto w = weights.find(m_g->GetEdgePeer(eid, layerId));
+        if( w == weights.end() )
+            continue;
+        m_g->SetAttribute(eid, wAttr, v.SetDouble(w->second));
+    }
+    return true;
+}
+
+bool MLGDao::updateOLinkWeights( EdgeWeightVec::const_iterator first, EdgeWeightVec::const_iterator last )
+{
+#ifdef MLD_SAFE
+    try {
+#endif
+        attr_t wAttr = m_g->FindAttribute(m_link->olinkType(), Attrs::V[OLinkAttr::WEIGHT]);
+        Value v;
+        for( ; first != last; ++first )
+            m_g->SetAttribute(first->first, wAttr, v.SetDouble(first->second));
+#ifdef MLD_SAFE
+    } catch( Error& e ) {
+        LOG(logERROR) << "MLGDao::updateOLinkWeights: " << e.Message();
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool MLGDao::addOLinks( oid_t layerId, const std::vector<oid_t>& nodes,
+                        const std::vector<double>& weights )
+{
+    if( nodes.size() != weights.size() ) {
+        LOG(logERROR) << "MLGDao::addOLinks nodes and weights sizes mismatch";
+        return false;
+    }
+#ifdef MLD_SAFE
+    if( layerId == Objects::InvalidOID ) {
+        LOG(logERROR) << "MLGDao::addOLinks invalid layer id";
+        return false;
+    }
+    try {
+#endif
+        type_t oType = m_link->olinkType();
+        attr_t wAttr = m_g->FindAttribute(oType, Attrs::V[OLinkAttr::WEIGHT]);
+        Value v;
+        for( size_t i = 0; i < nodes.size(); ++i ) {
+            oid_t eid = m_g->NewEdge(oType, layerId, nodes[i]);
+            m_g->SetAttribute(eid, wAttr, v.SetDouble(weights[i]));
+        }
+#ifdef MLD_SAFE
+    } catch( Error& e ) {
+        LOG(logERROR) << "MLGDao::addOLinks: " << e.Message();
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool MLGDao::addNodesToLayer( const Layer& l, const std::vector<uint64_t>& labels,
+                              std::vector<oid_t>& out )
+{
+    out.clear();
+#ifdef MLD_SAFE
+    if( !m_layer->exists(l) ) {
+        LOG(logERROR) << "MLGDao::addNodesToLayer: Layer doesn't exist!";
+        return false;
+    }
+    try {
+#endif
+        type_t nType = nodeType();
+        type_t oType = olinkType();
+        attr_t labelAttr = m_g->FindAttribute(nType, Attrs::V[NodeAttr::LABEL]);
+        Value v;
+        out.reserve(labels.size());
+        for( auto label: labels ) {
+            oid_t nid = m_g->NewNode(nType);
+            m_g->SetAttribute(nid, labelAttr, v.SetString(std::to_wstring(label)));
+            // New edge OWNS: Layer -> Node
+            m_g->NewEdge(oType, l.id(), nid);
+            out.push_back(nid);
+        }
+#ifdef MLD_SAFE
+    } catch( Error& e ) {
+        LOG(logERROR) << "MLGDao::addNodesToLayer: " << e.Message();
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool MLGDao::addHLinks( const std::vector<std::pair<oid_t, oid_t>>& links )
+{
+#ifdef MLD_SAFE
+    try {
+#endif
+        type_t hType = hlinkType();
+        for( auto& link: links )
+            m_g->NewEdge(hType, link.first, link.second);
+#ifdef MLD_SAFE
+    } catch( Error& e ) {
+        LOG(logERROR) << "MLGDao::addHLinks: " << e.Message();
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool MLGDao::addHLinks( const std::vector<std::pair<oid_t, oid_t>>& links,
+                        const std::vector<double>& weights )
+{
+    if( links.size() != weights.size() ) {
+        LOG(logERROR) << "MLGDao::addHLinks links and weights sizes mismatch";
+        return false;
+    }
+#ifdef MLD_SAFE
+    try {
+#endif
+        type_t hType = hlinkType();
+        attr_t wAttr = m_g->FindAttribute(hType, Attrs::V[HLinkAttr::WEIGHT]);
+        Value v;
+        for( size_t i = 0; i < links.size(); ++i ) {
+            oid_t eid = m_g->NewEdge(hType, links[i].first, links[i].second);
+            m_g->SetAttribute(eid, wAttr, v.SetDouble(weights[i]));
+        }
+#ifdef MLD_SAFE
+    } catch( Error& e ) {
+        LOG(logERROR) << "MLGDao::addHLinks: " << e.Message();
+        return false;
+    }
+#endif
+    return true;
+}
+
+GraphSnapshot MLGDao::getGraphSnapshot( const Layer& l, Objects* excluded )
+{
+    GraphSnapshot res;
+    ObjectsPtr nodes(getAllNodeIds(l));
+    if( !nodes )
+        return res;
+    if( excluded )
+        nodes->Difference(excluded);
+
+    std::vector<oid_t> ids;
+    ids.reserve(nodes->Count());
+    ObjectsIt it(nodes->Iterator());
+    while( it->HasNext() )
+        ids.push_back(it->Next());
+    res.reset(ids);
+
+    type_t hType = m_link->hlinkType();
+    attr_t wAttr = m_g->FindAttribute(hType, Attrs::V[HLinkAttr::WEIGHT]);
+    Value v;
+    for( auto nid: ids ) {
+        ObjectsPtr hlinks(m_g->Explode(nid, hType, Outgoing));
+        ObjectsIt hit(hlinks->Iterator());
+        while( hit->HasNext() ) {
+            oid_t eid = hit->Next();
+            size_t target = res.index(m_g->GetEdgePeer(eid, nid));
+            if( target == INVALID_INDEX )  // excluded neighbor
+                continue;
+            m_g->GetAttribute(eid, wAttr, v);
+            res.addNeighbor(target, v.GetDouble());
+        }
+        res.finishNode();
+    }
+    return res;
+}
+
+GraphSnapshot MLGDao::getNodeSnapshot( const Layer& l )
+{
+    GraphSnapshot res;
+    ObjectsPtr nodes(getAllNodeIds(l));
+    if( !nodes )
+        return res;
+
+    std::vector<oid_t> ids;
+    ids.reserve(nodes->Count());
+    ObjectsIt it(nodes->Iterator());
+    while( it->HasNext() )
+        ids.push_back(it->Next());
+    res.reset(ids);
+    for( size_t i = 0; i < ids.size(); ++i )
+        res.finishNode();
+    return res;
+}
+
+bool MLGDao::getTransferMap( const GraphSnapshot& fine, const GraphSnapshot& coarse, TransferMap& out )
+{
+    out.reset(fine.nodeCount(), coarse.nodeCount());
+#ifdef MLD_SAFE
+    try {
+#endif
+        ObjectsPtr children(newObjectsPtr());
+        for( auto nid: fine.nodes() )
+            children->Add(nid);
+
+        // VLinks go from the child to the parent, all of them are exploded at once
+        type_t vType = m_link->vlinkType();
+        attr_t wAttr = m_g->FindAttribute(vType, Attrs::V[VLinkAttr::WEIGHT]);
+        ObjectsPtr vlinks(m_g->Explode(children.get(), vType, Outgoing));
+        Value v;
+        ObjectsIt it(vlinks->Iterator());
+        while( it->HasNext() ) {
+            oid_t eid = it->Next();
+            std::unique_ptr<EdgeData> data(m_g->GetEdgeData(eid));
+            size_t child = fine.index(data->GetTail());
+            size_t parent = coarse.index(data->GetHead());
+            if( child == INVALID_INDEX || parent == INVALID_INDEX )
+                continue;
+            m_g->GetAttribute(eid, wAttr, v);
+            out.setParent(child, parent, v.IsNull() ? VLINK_DEF_VALUE : v.GetDouble());
+        }
+#ifdef MLD_SAFE
+    } catch( Error& e ) {
+        LOG(logERROR) << "MLGDao::getTransferMap: " << e.Message();
+        return false;
+    }
+#endif
+    out.finalize();
+    return true;
+}
+
+bool MLGDao::getTransferMaps( const GraphSnapshot& graph, const Layer& layer,
+                              std::vector<TransferMap>& maps, uint32_t maxLevels,
+                              std::vector<GraphSnapshot>* levels )
+{
+    maps.clear();
+    if( levels )
+        levels->clear();
+    // Time series layers have no VLinks, the hierarchy stops at the first one
+    GraphSnapshot fine;
+    Layer current(layer);
+    for( uint32_t k = 1; maxLevels == 0 || k < maxLevels; ++k ) {
+        Layer parent(m_layer->parent(current));
+        if( parent.id() == Objects::InvalidOID )
+            break;
+        // Both snapshots sort the nodes by id
+        GraphSnapshot coarse(levels ? getGraphSnapshot(parent) : getNodeSnapshot(parent));
+        TransferMap map;
+        if( !getTransferMap(k == 1 ? graph : fine, coarse, map) )
+            return false;
+        if( map.orphanCount() == map.fineCount() )
+            break;
+        maps.push_back(std::move(map));
+        if( levels )
+            levels->push_back(coarse);
+        fine = std::move(coarse);
+        current = parent;
+    }
+    return true;
+}
+
+bool MLGDao::updateAncestryIndex( AncestryIndex& index )
+{
+    std::vector<Layer> layers(getAllLayers());
+    const size_t indexed = index.levelCount();
+    if( indexed > layers.size() ) {
+        LOG(logERROR) << "MLGDao::updateAncestryIndex index has more layers than the graph";
+        return false;
+    }
+    for( size_t k = 0; k < indexed; ++k ) {
+        if( layers[k].id() != index.layerId(k) ) {
+            LOG(logERROR) << "MLGDao::updateAncestryIndex index does not match layer: " << layers[k].id();
+            return false;
+        }
+    }
+
+    GraphSnapshot fine;
+    if( indexed > 0 ) {
+        fine.reset(index.nodes(indexed - 1));
+        for( size_t i = 0; i < fine.nodeCount(); ++i )
+            fine.finishNode();
+    }
+    for( size_t k = indexed; k < layers.size(); ++k ) {
+        GraphSnapshot coarse(getNodeSnapshot(layers[k]));
+        std::vector<size_t> parents;
+        if( k > 0 ) {
+            TransferMap map;
+            if( !getTransferMap(fine, coarse, map) )
+                return false;
+            parents.resize(fine.nodeCount());
+            for( size_t i = 0; i < parents.size(); ++i )
+                parents[i] = map.parent(i);
+        }
+        if( !index.addLayer(layers[k].id(), coarse.nodes(), parents) )
+            return false;
+        fine = std::move(coarse);
+    }
+    return true;
+}
+
+bool MLGDao::getSignalStore( const GraphSnapshot& graph, const std::vector<oid_t>& layers,
+                             SignalStore& out, const std::vector<std::wstring>& channels )
+{
+    out.resize(layers, graph.nodeCount(), channels.size() + 1);
+    for( size_t ch = 0; ch < out.channelCount(); ++ch ) {
+        const std::wstring& attr = ch == 0 ? Attrs::V[OLinkAttr::WEIGHT] : channels[ch - 1];
+        for( size_t l = 0; l < layers.size(); ++l ) {
+            OLinkWeightMap weights(getOLinkWeights(layers[l], attr));
+            SignalValue* row = out.layer(l, ch);
+            for( size_t i = 0; i < graph.nodeCount(); ++i ) {
+                auto it = weights.find(graph.nodeId(i));
+                if( it == weights.end() ) {
+                    LOG(logERROR) << "MLGDao::getSignalStore no OLink for nid: " << graph.nodeId(i)
+                                  << " lid: " << layers[l] << " channel: " << ch;
+                    return false;
+                }
+                row[i] = it->second;
+            }
+        }
+    }
+    return true;
+}
+
+bool MLGDao::updateSignalStore( const GraphSnapshot& graph, const SignalStore& signal,
+                                const std::vector<std::wstring>& channels )
+{
+#ifdef MLD_SAFE
+    if( graph.nodeCount() != signal.nodeCount() ) {
+        LOG(logERROR) << "MLGDao::updateSignalStore snapshot and signal sizes mismatch";
+        return false;
+    }
+#endif
+    if( signal.channelCount() != channels.size() + 1 ) {
+        LOG(logERROR) << "MLGDao::updateSignalStore channel names and signal channels mismatch";
+        return false;
+    }
+
+    OLinkWeightMap weights;
+    weights.reserve(graph.nodeCount());
+    for( size_t ch = 0; ch < signal.channelCount(); ++ch ) {
+        const std::wstring& attr = ch == 0 ? Attrs::V[OLinkAttr::WEIGHT] : channels[ch - 1];
+        for( size_t l = 0; l < signal.layerCount(); ++l ) {
+            const SignalValue* row = signal.layer(l, ch);
+            for( size_t i = 0; i < graph.nodeCount(); ++i )
+                weights[graph.nodeId(i)] = row[i];
+            if( !updateOLinkWeights(signal.layerId(l), weights, attr) )
+                return false;
+        }
+    }
+    return true;
+}
+
 // ****** FORWARD METHOD OF SN DAO ****** //
 
 void MLGDao::removeNode( oid_t id )
@@ -862,6 +1304,24 @@ Layer MLGDao::baseLayer()
     return m_layer->baseLayer();
 }
 
+int MLGDao::signalBits()
+{
+    return m_layer->signalBits();
+}
+
+bool MLGDao::checkSignalBits()
+{
+    int bits = m_layer->signalBits();
+    if( bits == 0 )
+        bits = 64;
+    if( bits != int(sizeof(SignalValue) * 8) ) {
+        LOG(logERROR) << "MLGDao::checkSignalBits database signal is " << bits
+                      << " bits, this build uses " << sizeof(SignalValue) * 8 << " bits";
+        return false;
+    }
+    return true;
+}
+
 Layer MLGDao::parent( const Layer& layer )
 {
     return m_layer->parent(layer);
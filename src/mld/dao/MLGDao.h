@@ -20,6 +20,7 @@
 #define MLD_MLGDAO_H
 
 #include <map>
+#include <unordered_map>
 #include <functional>
 
 #include "mld/common.h"
@@ -28,6 +29,7 @@
 #include "mld/model/Layer.h"
 #include "mld/model/Link.h"
 #include "mld/model/TimeSeries.h"
+#include "mld/model/GraphSnapshot.h"
 
 namespace sparksee {
 namespace gdb {
@@ -37,6 +39,9 @@ namespace gdb {
 }}
 
 namespace mld {
+    class SignalStore;
+    class TransferMap;
+    class AncestryIndex;
     class NodeDao;
     class LayerDao;
     class LinkDao;
@@ -47,6 +52,9 @@ namespace mld {
 using WeightMergerFunc =  std::function<double (double, double)>;
 using NodeVec = std::vector<Node>;
 using LayerIdPair = std::pair<sparksee::gdb::oid_t, sparksee::gdb::oid_t>;
+using OLinkWeightMap = std::unordered_map<sparksee::gdb::oid_t, double>;
+using EdgeWeight = std::pair<sparksee::gdb::oid_t, double>;
+using EdgeWeightVec = std::vector<EdgeWeight>;
 
 /**
  * @brief The MultiLayerGraph (MLG) dao
@@ -269,16 +277,166 @@ typedef std::map<sparksee::gdb::oid_t, Node> NodeMap;
      */
     std::vector<OLink> getAllOLinks( sparksee::gdb::oid_t nodeId );
 
-    TimeSeries<double> getSignal( sparksee::gdb::oid_t nodeId,
+    TimeSeries<SignalValue> getSignal( sparksee::gdb::oid_t nodeId,
                                   sparksee::gdb::oid_t bottomLayer,
                                   sparksee::gdb::oid_t topLayer );
 
-    TimeSeries<double> getSignal( sparksee::gdb::oid_t nodeId,
+    TimeSeries<SignalValue> getSignal( sparksee::gdb::oid_t nodeId,
                                   sparksee::gdb::oid_t currentLayer,
                                   TSDirection dir, size_t radius );
 
     LayerIdPair getLayerBounds( sparksee::gdb::oid_t source, TSDirection dir, size_t radius );
 
+    /**
+     * @brief Get the OLink weights of all the nodes owned by a layer.
+     * The OLinks are fetched in bulk with a single Explode on the layer,
+     * which is much cheaper than one findEdge per node.
+     * @param layerId Layer id
+     * @return map node id -> OLink weight, empty if layer is invalid
+     */
+    OLinkWeightMap getOLinkWeights( sparksee::gdb::oid_t layerId );
+    /**
+     * @brief Get an OLink double attribute of all the nodes owned by a layer.
+     * @param layerId Layer id
+     * @param attrName OLink attribute name
+     * @return map node id -> attribute value, empty if layer or attribute is invalid.
+     * OLinks whose value is not set are not in the map
+     */
+    OLinkWeightMap getOLinkWeights( sparksee::gdb::oid_t layerId, const std::wstring& attrName );
+    /**
+     * @brief Get the OLink weights of a set of nodes for one layer,
+     * the attribute is resolved once.
+     * @param layerId Layer id
+     * @param nodes Node ids
+     * @param out Output array, one weight per node
+     * @return success, false if a node has no OLink or no weight in this layer
+     */
+    bool getOLinkWeights( sparksee::gdb::oid_t layerId, const std::vector<sparksee::gdb::oid_t>& nodes,
+                          double* out );
+
+    /**
+     * @brief Set the OLink weights of the nodes owned by a layer in bulk.
+     * Nodes not in the map are left untouched.
+     * @param layerId Layer id
+     * @param weights map node id -> new OLink weight
+     * @return success
+     */
+    bool updateOLinkWeights( sparksee::gdb::oid_t layerId, const OLinkWeightMap& weights );
+    bool updateOLinkWeights( sparksee::gdb::oid_t layerId, const OLinkWeightMap& weights,
+                             const std::wstring& attrName );
+    /**
+     * @brief Set the weight of OLinks in bulk, the attribute is resolved once.
+     * @param first First (OLink id, weight) pair
+     * @param last Past the last pair
+     * @return success
+     */
+    bool updateOLinkWeights( EdgeWeightVec::const_iterator first, EdgeWeightVec::const_iterator last );
+
+    /**
+     * @brief Create the OLinks of a layer in bulk.
+     * @param layerId Layer id
+     * @param nodes Node ids
+     * @param weights OLink weight for each node, same size as nodes
+     * @return success
+     */
+    bool addOLinks( sparksee::gdb::oid_t layerId, const std::vector<sparksee::gdb::oid_t>& nodes,
+                    const std::vector<double>& weights );
+
+    /**
+     * @brief Create nodes in bulk and add them to a layer, node and OLink attributes
+     * keep their default value except the label. The types are resolved once.
+     * @param l Layer
+     * @param labels Numeric node labels
+     * @param out Node ids, same order as labels
+     * @return success
+     */
+    bool addNodesToLayer( const Layer& l, const std::vector<uint64_t>& labels,
+                          std::vector<sparksee::gdb::oid_t>& out );
+    /**
+     * @brief Create HLinks with the default weight in bulk, self loops are not checked
+     * @param links (source, target) node ids
+     * @return success
+     */
+    bool addHLinks( const std::vector<std::pair<sparksee::gdb::oid_t, sparksee::gdb::oid_t>>& links );
+    /**
+     * @brief Create weighted HLinks in bulk
+     * @param links (source, target) node ids
+     * @param weights HLink weights, same size as links
+     * @return success
+     */
+    bool addHLinks( const std::vector<std::pair<sparksee::gdb::oid_t, sparksee::gdb::oid_t>>& links,
+                    const std::vector<double>& weights );
+
+    /**
+     * @brief Load the HLinks of a layer in memory
+     * @param l Input layer
+     * @param excluded Nodes to skip, they are neither nodes nor neighbors in the snapshot
+     * @return snapshot, nodes are sorted by id
+     */
+    GraphSnapshot getGraphSnapshot( const Layer& l, sparksee::gdb::Objects* excluded=nullptr );
+
+    /**
+     * @brief Load the nodes of a layer without their HLinks
+     * @param l Input layer
+     * @return snapshot, nodes are sorted by id
+     */
+    GraphSnapshot getNodeSnapshot( const Layer& l );
+
+    /**
+     * @brief Load the VLinks from the fine snapshot nodes to the coarse snapshot nodes
+     * @param fine Child nodes
+     * @param coarse Parent nodes
+     * @param out Output map, indexed as the snapshots
+     * @return success
+     */
+    bool getTransferMap( const GraphSnapshot& fine, const GraphSnapshot& coarse, TransferMap& out );
+
+    /**
+     * @brief Load the transfer maps of the layers above a layer, maps[k] goes from
+     * level k to level k+1. The hierarchy stops at the first layer without VLinks
+     * @param graph Snapshot of the first level
+     * @param layer Layer of the first level
+     * @param maps Output maps
+     * @param maxLevels Maximum number of levels (maps + 1), 0 for all the layers
+     * @param levels If not null, receives the HLink snapshots of the coarse levels,
+     * levels[k] is the target of maps[k]
+     * @return success
+     */
+    bool getTransferMaps( const GraphSnapshot& graph, const Layer& layer,
+                          std::vector<TransferMap>& maps, uint32_t maxLevels=0,
+                          std::vector<GraphSnapshot>* levels=nullptr );
+
+    /**
+     * @brief Append the layers above the indexed ones to the index, a node with
+     * several VLinks keeps the heaviest one. The indexed layers must be the bottom
+     * layers of the graph
+     * @param index Ancestry index, empty for a full build
+     * @return success
+     */
+    bool updateAncestryIndex( AncestryIndex& index );
+
+    /**
+     * @brief Load the OLink weights of the snapshot nodes for each layer
+     * @param graph Nodes to load, store columns follow the snapshot indexes
+     * @param layers Layer ids
+     * @param out Output store, resized
+     * @param channels Extra OLink double attributes loaded as channels 1..n
+     * @return success, false if an OLink is missing
+     */
+    bool getSignalStore( const GraphSnapshot& graph, const std::vector<sparksee::gdb::oid_t>& layers,
+                         SignalStore& out,
+                         const std::vector<std::wstring>& channels=std::vector<std::wstring>() );
+
+    /**
+     * @brief Write the signal values in the OLinks
+     * @param graph Nodes of the store columns
+     * @param signal Signal
+     * @param channels Extra OLink double attributes of channels 1..n
+     * @return success
+     */
+    bool updateSignalStore( const GraphSnapshot& graph, const SignalStore& signal,
+                            const std::vector<std::wstring>& channels=std::vector<std::wstring>() );
+
     // Forward to SNDao
     void removeNode( sparksee::gdb::oid_t id );
     bool updateNode( Node& n );
@@ -374,6 +532,18 @@ typedef std::map<sparksee::gdb::oid_t, Node> NodeMap;
      * @return base layer
      */
     Layer baseLayer();
+    /**
+     * @brief Get the width of the signal values, recorded on the base layer
+     * when it is created (see MLD_FLOAT_SIGNAL)
+     * @return number of bits or 0 if not recorded
+     */
+    int signalBits();
+    /**
+     * @brief Check that the database signal has the width of this build.
+     * A database without recorded width is taken as 64 bits
+     * @return success
+     */
+    bool checkSignalBits();
 
     /**
      * @brief Get parent layer.
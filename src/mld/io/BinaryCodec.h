@@ -0,0 +1,366 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_BINARYCODEC_H
+#define MLD_BINARYCODEC_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <istream>
+
+namespace mld {
+namespace bin {
+
+// Binary time series graph file, see GraphExporter::toBinaryTimeSeries
+const char TS_MAGIC[4] = { 'M', 'L', 'D', 'T' };
+const uint8_t TS_VERSION = 1;
+// Binary CSR matrix file, see MatrixExporter
+const char CSR_MAGIC[4] = { 'M', 'L', 'D', 'C' };
+const uint8_t CSR_VERSION = 1;
+
+/**
+ * @brief Append an unsigned LEB128 varint
+ * @param buf Output buffer
+ * @param v Value
+ */
+inline void writeVarint( std::string& buf, uint64_t v )
+{
+    while( v >= 0x80 ) {
+        buf += static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    buf += static_cast<char>(v);
+}
+
+/**
+ * @brief Read an unsigned LEB128 varint from a buffer
+ * @param p Current position, moved after the varint
+ * @param end End of the buffer
+ * @param v Value
+ * @return false if the buffer is truncated
+ */
+inline bool readVarint( const char*& p, const char* end, uint64_t& v )
+{
+    v = 0;
+    for( unsigned shift = 0; p != end && shift < 64; shift += 7 ) {
+        uint8_t byte = static_cast<uint8_t>(*p++);
+        v |= uint64_t(byte & 0x7F) << shift;
+        if( !(byte & 0x80) )
+            return true;
+    }
+    return false;
+}
+
+inline bool readVarint( std::istream& in, uint64_t& v )
+{
+    v = 0;
+    for( unsigned shift = 0; shift < 64; shift += 7 ) {
+        int c = in.get();
+        if( c == std::char_traits<char>::eof() )
+            return false;
+        v |= uint64_t(c & 0x7F) << shift;
+        if( !(c & 0x80) )
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Append an unsigned integer as 8 little endian bytes
+ */
+inline void writeUint64( std::string& buf, uint64_t v )
+{
+    for( int i = 0; i < 8; ++i )
+        buf += static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+inline bool readUint64( std::istream& in, uint64_t& v )
+{
+    unsigned char bytes[8];
+    if( !in.read(reinterpret_cast<char*>(bytes), 8) )
+        return false;
+    v = 0;
+    for( int i = 0; i < 8; ++i )
+        v |= uint64_t(bytes[i]) << (8 * i);
+    return true;
+}
+
+/**
+ * @brief Append a double as 8 little endian bytes
+ */
+inline void writeDouble( std::string& buf, double d )
+{
+    uint64_t v;
+    std::memcpy(&v, &d, sizeof(v));
+    writeUint64(buf, v);
+}
+
+inline bool readDouble( std::istream& in, double& d )
+{
+    uint64_t v = 0;
+    if( !readUint64(in, v) )
+        return false;
+    std::memcpy(&d, &v, sizeof(d));
+    return true;
+}
+
+inline uint64_t zigzag( int64_t v ) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+inline int64_t unzigzag( uint64_t v ) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+/**
+ * @brief Append a length prefixed byte string
+ */
+inline void writeBytes( std::string& buf, const std::string& bytes )
+{
+    writeVarint(buf, bytes.size());
+    buf += bytes;
+}
+
+inline bool readBytes( std::istream& in, std::string& bytes )
+{
+    uint64_t len = 0;
+    if( !readVarint(in, len) )
+        return false;
+    bytes.resize(size_t(len));
+    if( len > 0 )
+        in.read(&bytes[0], std::streamsize(len));
+    return bool(in);
+}
+
+/**
+ * @brief Append bits most significant first to a byte buffer
+ */
+class BitWriter
+{
+public:
+    explicit BitWriter( std::string& buf ) : m_buf(buf), m_acc(0), m_count(0) {}
+
+    /**
+     * @brief Write the n low bits of v, n <= 64
+     */
+    void write( uint64_t v, unsigned n )
+    {
+        if( n > 32 ) {
+            write(v >> 32, n - 32);
+            n = 32;
+        }
+        if( n == 0 )
+            return;
+        m_acc = (m_acc << n) | (v & ((uint64_t(1) << n) - 1));
+        m_count += n;
+        while( m_count >= 8 ) {
+            m_count -= 8;
+            m_buf += static_cast<char>((m_acc >> m_count) & 0xFF);
+        }
+    }
+
+    /**
+     * @brief Pad the last byte with zeros
+     */
+    void flush()
+    {
+        if( m_count > 0 )
+            m_buf += static_cast<char>((m_acc << (8 - m_count)) & 0xFF);
+        m_acc = 0;
+        m_count = 0;
+    }
+
+private:
+    std::string& m_buf;
+    uint64_t m_acc;
+    unsigned m_count;
+};
+
+class BitReader
+{
+public:
+    BitReader( const char* begin, const char* end ) : m_p(begin), m_end(end), m_acc(0), m_count(0) {}
+
+    /**
+     * @brief Read n bits, n <= 64
+     * @return false if the buffer is exhausted
+     */
+    bool read( unsigned n, uint64_t& v )
+    {
+        v = 0;
+        if( n > 32 ) {
+            if( !read(n - 32, v) )
+                return false;
+            uint64_t low = 0;
+            if( !read(32, low) )
+                return false;
+            v = (v << 32) | low;
+            return true;
+        }
+        while( m_count < n ) {
+            if( m_p == m_end )
+                return false;
+            m_acc = (m_acc << 8) | static_cast<uint8_t>(*m_p++);
+            m_count += 8;
+        }
+        m_count -= n;
+        v = n ? (m_acc >> m_count) & ((uint64_t(1) << n) - 1) : 0;
+        return true;
+    }
+
+private:
+    const char* m_p;
+    const char* m_end;
+    uint64_t m_acc;
+    unsigned m_count;
+};
+
+template <typename Word> struct WordTraits;
+template <> struct WordTraits<uint32_t>
+{
+    static unsigned clz( uint32_t v ) { return unsigned(__builtin_clz(v)); }
+    static unsigned ctz( uint32_t v ) { return unsigned(__builtin_ctz(v)); }
+};
+template <> struct WordTraits<uint64_t>
+{
+    static unsigned clz( uint64_t v ) { return unsigned(__builtin_clzll(v)); }
+    static unsigned ctz( uint64_t v ) { return unsigned(__builtin_ctzll(v)); }
+};
+
+/**
+ * @brief XOR compression of a floating point series (Gorilla).
+ * Word is the bit pattern of the values, uint32_t for float and uint64_t for double.
+ * Consecutive equal values cost 1 bit, close values only store the bits that differ.
+ */
+template <typename Word>
+class XorEncoder
+{
+public:
+    static const unsigned BITS = sizeof(Word) * 8;
+
+    explicit XorEncoder( std::string& buf )
+        : m_bits(buf), m_prev(0), m_lead(BITS), m_trail(0), m_first(true)
+    {}
+
+    template <typename T>
+    void add( T value )
+    {
+        static_assert(sizeof(T) == sizeof(Word), "XorEncoder value and word sizes mismatch");
+        Word v;
+        std::memcpy(&v, &value, sizeof(v));
+        if( m_first ) {
+            m_bits.write(v, BITS);
+            m_prev = v;
+            m_first = false;
+            return;
+        }
+
+        Word x = v ^ m_prev;
+        m_prev = v;
+        if( x == 0 ) {
+            m_bits.write(0, 1);
+            return;
+        }
+        m_bits.write(1, 1);
+        unsigned lead = WordTraits<Word>::clz(x);
+        unsigned trail = WordTraits<Word>::ctz(x);
+        if( lead > 31 )
+            lead = 31;
+        if( m_lead != BITS && lead >= m_lead && trail >= m_trail ) {
+            // Meaningful bits fit in the previous window
+            m_bits.write(0, 1);
+            m_bits.write(x >> m_trail, BITS - m_lead - m_trail);
+        }
+        else {
+            unsigned sig = BITS - lead - trail;
+            m_bits.write(1, 1);
+            m_bits.write(lead, 5);
+            m_bits.write(sig - 1, 6);
+            m_bits.write(x >> trail, sig);
+            m_lead = lead;
+            m_trail = trail;
+        }
+    }
+
+    void flush() { m_bits.flush(); }
+
+private:
+    BitWriter m_bits;
+    Word m_prev;
+    unsigned m_lead;
+    unsigned m_trail;
+    bool m_first;
+};
+
+template <typename Word>
+class XorDecoder
+{
+public:
+    static const unsigned BITS = sizeof(Word) * 8;
+
+    XorDecoder( const char* begin, const char* end )
+        : m_bits(begin, end), m_prev(0), m_lead(0), m_trail(0), m_first(true)
+    {}
+
+    /**
+     * @brief Decode the next value
+     * @return false if the block is truncated
+     */
+    template <typename T>
+    bool next( T& value )
+    {
+        static_assert(sizeof(T) == sizeof(Word), "XorDecoder value and word sizes mismatch");
+        uint64_t bits = 0;
+        if( m_first ) {
+            if( !m_bits.read(BITS, bits) )
+                return false;
+            m_prev = Word(bits);
+            m_first = false;
+        }
+        else {
+            uint64_t flag = 0;
+            if( !m_bits.read(1, flag) )
+                return false;
+            if( flag ) {
+                if( !m_bits.read(1, flag) )
+                    return false;
+                if( flag ) {
+                    uint64_t lead = 0;
+                    uint64_t sig = 0;
+                    if( !m_bits.read(5, lead) || !m_bits.read(6, sig) )
+                        return false;
+                    m_lead = unsigned(lead);
+                    m_trail = BITS - m_lead - unsigned(sig + 1);
+                }
+                if( !m_bits.read(BITS - m_lead - m_trail, bits) )
+                    return false;
+                m_prev ^= Word(bits << m_trail);
+            }
+        }
+        std::memcpy(&value, &m_prev, sizeof(value));
+        return true;
+    }
+
+private:
+    BitReader m_bits;
+    Word m_prev;
+    unsigned m_lead;
+    unsigned m_trail;
+    bool m_first;
+};
+
+} // end namespace bin
+} // end namespace mld
+
+#endif // MLD_BINARYCODEC_H
@@ -20,10 +20,16 @@
 #include <codecvt>
 #include <string>
 #include <fstream>
+#include <cstdio>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include <unordered_map>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/range/algorithm/remove_if.hpp>
 #include <sparksee/gdb/Objects.h>
+#include <sparksee/gdb/Graph_data.h>
 
 #include "mld/io/GraphImporter.h"
 #include "mld/GraphTypes.h"
@@ -33,6 +39,7 @@
 #include "mld/SparkseeManager.h"
 
 #include "mld/io/GraphExporter.h"
+#include "mld/io/BinaryCodec.h"
 #include "mld/utils/ProgressDisplay.h"
 
 using namespace mld;
@@ -75,6 +82,97 @@ void writeWStringToFile( std::wofstream& out, const std::wstring v, bool closeLi
         out << ",";
 }
 
+// Values of the tile buffer, bounds the memory whatever the number of layers
+const size_t TS_TILE_VALUES = size_t(4) << 20;
+const size_t TS_FLUSH_SIZE = size_t(1) << 20;
+
+// Only non ASCII strings go through the UTF-8 converter
+void appendUtf8( std::string& buf, const std::wstring& v )
+{
+    if( std::all_of(v.begin(), v.end(), []( wchar_t c ) { return c < 0x80; }) )
+        buf.append(v.begin(), v.end());
+    else
+        buf += converter.to_bytes(v);
+}
+
+// Shortest precision that round trips the signal values
+void appendDouble( std::string& buf, double v )
+{
+    char tmp[32];
+    int len = std::snprintf(tmp, sizeof(tmp), "%.*g",
+                            std::numeric_limits<SignalValue>::max_digits10, v);
+    buf.append(tmp, size_t(len));
+}
+
+void appendValue( std::string& buf, Value& v )
+{
+    switch( v.GetDataType() ) {
+        case Integer:
+            buf += std::to_string(v.GetInteger());
+            break;
+        case Long:
+            buf += std::to_string(v.GetLong());
+            break;
+        case String:
+            appendUtf8(buf, v.GetString());
+            break;
+        case Double:
+            appendDouble(buf, v.GetDouble());
+            break;
+        case Boolean:
+            buf += std::to_string(v.GetBoolean());
+            break;
+        case OID:
+            buf += std::to_string(v.GetOID());
+            break;
+        default:
+            LOG(logERROR) << "GraphExporter::appendValue unsupported datatype";
+            break;
+    }
+}
+
+// Word holding the bit pattern of a SignalValue
+using SignalWord = std::conditional<sizeof(SignalValue) == 4, uint32_t, uint64_t>::type;
+
+const size_t BIN_EDGE_CHUNK = size_t(1) << 16;
+
+void writeBinaryValue( std::string& buf, DataType type, Value& v )
+{
+    if( v.IsNull() || v.GetDataType() != type ) {
+        buf += '\0';
+        return;
+    }
+    buf += '\1';
+    switch( type ) {
+        case Boolean:
+            buf += v.GetBoolean() ? '\1' : '\0';
+            break;
+        case Integer:
+            bin::writeVarint(buf, bin::zigzag(v.GetInteger()));
+            break;
+        case Long:
+            bin::writeVarint(buf, bin::zigzag(v.GetLong()));
+            break;
+        case Timestamp:
+            bin::writeVarint(buf, bin::zigzag(v.GetTimestamp()));
+            break;
+        case OID:
+            bin::writeVarint(buf, uint64_t(v.GetOID()));
+            break;
+        case Double:
+            bin::writeDouble(buf, v.GetDouble());
+            break;
+        case String: {
+            std::string str;
+            appendUtf8(str, v.GetString());
+            bin::writeBytes(buf, str);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
 } // end namespace anonymous
 
 bool GraphExporter::toTimeSeries( Graph* g, const std::string& name, std::string& exportFolderPath )
@@ -112,78 +210,123 @@ bool GraphExporter::writeTSNodes( MLGDao& dao, const std::string& nodePath, RInd
 {
     LOG(logINFO) << "Start writing nodes";
 
-    std::wofstream outfile(nodePath);
+    std::ofstream outfile(nodePath, std::ios::binary);
     if( !outfile ) {
         LOG(logERROR) << "GraphExporter::writeTSNodes cannot open file " << nodePath;
         return false;
     }
 
     Layer base(dao.baseLayer());
-    NodeVec nodes(dao.getAllNodes(base));
-
-    if( nodes.empty() ) {
+    ObjectsPtr nodeSet(dao.getAllNodeIds(base));
+    if( !nodeSet || nodeSet->Count() == 0 ) {
         LOG(logERROR) << "GraphExporter::writeTSNodes no nodes in graph";
         return false;
     }
-    Node n1(nodes.front());
+    std::vector<oid_t> nodes;
+    nodes.reserve(nodeSet->Count());
+    ObjectsIt it(nodeSet->Iterator());
+    while( it->HasNext() )
+        nodes.push_back(it->Next());
+    it.reset();
+    nodeSet.reset();
+
+    // Layers are resolved once, ordered bottom to top
+    auto layers(dao.getAllLayers());
+    const size_t lCount = layers.size();
+    Node n1(dao.getNode(nodes.front()));
 
     // Create header with id field in first position
+    std::string buf;
     bool hasIdField = false;
-    outfile << L"#id,";
+    buf += "#id,";
     for( auto& kv: n1.data() ) {
         if( kv.first == L"id" ) {
             hasIdField = true;
+            continue;
         }
         else if( kv.first == Attrs::V[NodeAttr::LABEL] ) {
-            writeWStringToFile(outfile, L"label");
+            buf += "label";
         }
         else if( kv.first == Attrs::V[NodeAttr::WEIGHT] ) {
-            writeWStringToFile(outfile, L"weight");
+            buf += "weight";
         }
         else {
-            writeWStringToFile(outfile, kv.first);
+            appendUtf8(buf, kv.first);
         }
+        buf += ',';
     }
     // Write header TS
-    auto lCount = dao.getLayerCount();
-    outfile << "ts:" << lCount << L"\n";
+    buf += "ts:" + std::to_string(lCount) + "\n";
 
+    // Tiles of nodes are read layer by layer then transposed to write one line per node
+    const size_t tileSize = std::max(size_t(1), TS_TILE_VALUES / std::max(size_t(1), lCount));
+    std::vector<oid_t> ids;
+    std::vector<double> tile;
+    std::vector<double> rows;
     ProgressDisplay display(nodes.size());
-
-    // Write data
-    for( size_t i = 0; i < nodes.size(); ++i ) {
-        Node n = nodes.at(i);
-        AttrMap data(n.data());
-        std::wstring id;
-        if( hasIdField ) {
-            id = convertValueToWString(n.data()[L"id"]);
-            data.erase(data.find(L"id"));
-        }
-        else {
-            id = std::to_wstring(i);
+    for( size_t first = 0; first < nodes.size(); first += tileSize ) {
+        const size_t count = std::min(tileSize, nodes.size() - first);
+        ids.assign(nodes.begin() + first, nodes.begin() + first + count);
+        tile.resize(lCount * count);
+        for( size_t l = 0; l < lCount; ++l ) {
+            if( !dao.getOLinkWeights(layers[l].id(), ids, &tile[l * count]) ) {
+                LOG(logERROR) << "GraphExporter::writeTSNodes cannot read layer " << layers[l].id();
+                return false;
+            }
         }
-        writeWStringToFile(outfile, id);
-        indexMap[n.id()] = id;
-
-        // Key id has be removed if it was present
-        for( auto& kv: data ) { // iterate through key and write value to file
-            writeWStringToFile(outfile, convertValueToWString(kv.second));
+        rows.resize(lCount * count);
+        for( size_t l = 0; l < lCount; ++l ) {
+            const double* src = &tile[l * count];
+            for( size_t i = 0; i < count; ++i )
+                rows[i * lCount + l] = src[i];
         }
 
-        // Write TS data
-        outfile << L"\"";
-        auto olinks( dao.getAllOLinks(n.id()));
-        for( size_t i = 0; i < olinks.size() - 1; ++i ) {
-            outfile << olinks.at(i).weight() << L",";
+        // Write data
+        for( size_t i = 0; i < count; ++i ) {
+            Node n(dao.getNode(ids[i]));
+            AttrMap data(n.data());
+            std::wstring id;
+            if( hasIdField ) {
+                id = convertValueToWString(data[L"id"]);
+                data.erase(data.find(L"id"));
+            }
+            else {
+                id = std::to_wstring(first + i);
+            }
+            appendUtf8(buf, id);
+            buf += ',';
+            indexMap[n.id()] = id;
+
+            // Key id has be removed if it was present
+            for( auto& kv: data ) { // iterate through key and write value to file
+                appendValue(buf, kv.second);
+                buf += ',';
+            }
+
+            // Write TS data
+            buf += '"';
+            const double* row = &rows[i * lCount];
+            for( size_t l = 0; l < lCount; ++l ) {
+                if( l > 0 )
+                    buf += ',';
+                appendDouble(buf, row[l]);
+            }
+            buf += "\"\n";
+
+            if( buf.size() >= TS_FLUSH_SIZE ) {
+                outfile.write(buf.data(), std::streamsize(buf.size()));
+                buf.clear();
+            }
         }
-        // Write last value
-        outfile << olinks.at(i).weight();
-        outfile << L"\"";
-        outfile << L"\n";
-        ++display;
+        display += count;
     }
 
+    outfile.write(buf.data(), std::streamsize(buf.size()));
     outfile.close();
+    if( !outfile ) {
+        LOG(logERROR) << "GraphExporter::writeTSNodes error writing " << nodePath;
+        return false;
+    }
     return true;
 }
 
@@ -243,3 +386,173 @@ bool GraphExporter::writeTSEdges( MLGDao& dao, const std::string& edgePath, RInd
 
     return true;
 }
+
+bool GraphExporter::toBinaryTimeSeries( Graph* g, const std::string& path )
+{
+    std::unique_ptr<Timer> t(new Timer("Exporting binary TimeSeries graph"));
+    std::ofstream outfile(path, std::ios::binary);
+    if( !outfile ) {
+        LOG(logERROR) << "GraphExporter::toBinaryTimeSeries cannot open file " << path;
+        return false;
+    }
+
+    MLGDao dao(g);
+    Layer base(dao.baseLayer());
+    ObjectsPtr nodeSet(dao.getAllNodeIds(base));
+    if( !nodeSet || nodeSet->Count() == 0 ) {
+        LOG(logERROR) << "GraphExporter::toBinaryTimeSeries no nodes in graph";
+        return false;
+    }
+    std::vector<oid_t> nodes;
+    nodes.reserve(nodeSet->Count());
+    std::unordered_map<oid_t, size_t> index;
+    index.reserve(nodeSet->Count());
+    ObjectsIt it(nodeSet->Iterator());
+    while( it->HasNext() ) {
+        oid_t nid = it->Next();
+        index.emplace(nid, nodes.size());
+        nodes.push_back(nid);
+    }
+    it.reset();
+    nodeSet.reset();
+
+    auto layers(dao.getAllLayers());
+    const size_t lCount = layers.size();
+
+    // Header
+    std::string buf;
+    buf.append(bin::TS_MAGIC, sizeof(bin::TS_MAGIC));
+    buf += static_cast<char>(bin::TS_VERSION);
+    buf += static_cast<char>(sizeof(SignalValue) * 8);
+    bin::writeVarint(buf, nodes.size());
+    bin::writeVarint(buf, lCount);
+
+    // Schema, taken from the attributes of the first node
+    type_t nType = dao.nodeType();
+    Node n1(dao.getNode(nodes.front()));
+    std::vector<std::wstring> keys;
+    std::vector<DataType> types;
+    for( auto& kv: n1.data() ) {
+        std::unique_ptr<Attribute> attr(g->GetAttribute(g->FindAttribute(nType, kv.first)));
+        keys.push_back(kv.first);
+        types.push_back(attr->GetDataType());
+    }
+    bin::writeVarint(buf, keys.size());
+    for( size_t k = 0; k < keys.size(); ++k ) {
+        std::string name;
+        appendUtf8(name, keys[k]);
+        bin::writeBytes(buf, name);
+        buf += static_cast<char>(types[k]);
+    }
+
+    // Nodes, series are read in layer major tiles like the CSV export
+    const size_t tileSize = std::max(size_t(1), TS_TILE_VALUES / std::max(size_t(1), lCount));
+    std::vector<oid_t> ids;
+    std::vector<double> tile;
+    std::string series;
+    ProgressDisplay display(nodes.size());
+    for( size_t first = 0; first < nodes.size(); first += tileSize ) {
+        const size_t count = std::min(tileSize, nodes.size() - first);
+        ids.assign(nodes.begin() + first, nodes.begin() + first + count);
+        tile.resize(lCount * count);
+        for( size_t l = 0; l < lCount; ++l ) {
+            if( !dao.getOLinkWeights(layers[l].id(), ids, &tile[l * count]) ) {
+                LOG(logERROR) << "GraphExporter::toBinaryTimeSeries cannot read layer " << layers[l].id();
+                return false;
+            }
+        }
+
+        for( size_t i = 0; i < count; ++i ) {
+            Node n(dao.getNode(ids[i]));
+            for( size_t k = 0; k < keys.size(); ++k )
+                writeBinaryValue(buf, types[k], n.data()[keys[k]]);
+
+            series.clear();
+            bin::XorEncoder<SignalWord> enc(series);
+            for( size_t l = 0; l < lCount; ++l )
+                enc.add(SignalValue(tile[l * count + i]));
+            enc.flush();
+            bin::writeBytes(buf, series);
+
+            if( buf.size() >= TS_FLUSH_SIZE ) {
+                outfile.write(buf.data(), std::streamsize(buf.size()));
+                buf.clear();
+            }
+        }
+        display += count;
+    }
+
+    // Edges, each undirected HLink is stored once from its lower index node
+    type_t hType = dao.hlinkType();
+    attr_t wAttr = g->FindAttribute(hType, Attrs::V[HLinkAttr::WEIGHT]);
+    Value v;
+    std::vector<std::pair<size_t, double>> neighbors;
+    std::string adjacency;
+    std::string weights;
+    std::unique_ptr<bin::XorEncoder<uint64_t>> wEnc(new bin::XorEncoder<uint64_t>(weights));
+    size_t chunkEdges = 0;
+    size_t chunkFirst = 0;
+    // Chunks without edges are not written
+    auto flushChunk = [&]( size_t end ) {
+        if( chunkEdges == 0 ) {
+            adjacency.clear();
+            chunkFirst = end;
+            return;
+        }
+        wEnc->flush();
+        bin::writeVarint(buf, chunkEdges);
+        bin::writeVarint(buf, chunkFirst);
+        bin::writeVarint(buf, end - chunkFirst);
+        bin::writeBytes(buf, adjacency);
+        bin::writeBytes(buf, weights);
+        adjacency.clear();
+        weights.clear();
+        wEnc.reset(new bin::XorEncoder<uint64_t>(weights));
+        chunkEdges = 0;
+        chunkFirst = end;
+        if( buf.size() >= TS_FLUSH_SIZE ) {
+            outfile.write(buf.data(), std::streamsize(buf.size()));
+            buf.clear();
+        }
+    };
+
+    for( size_t i = 0; i < nodes.size(); ++i ) {
+        if( chunkEdges >= BIN_EDGE_CHUNK )
+            flushChunk(i);
+
+        neighbors.clear();
+        ObjectsPtr hlinks(g->Explode(nodes[i], hType, Outgoing));
+        ObjectsIt hit(hlinks->Iterator());
+        while( hit->HasNext() ) {
+            oid_t eid = hit->Next();
+            auto peer = index.find(g->GetEdgePeer(eid, nodes[i]));
+            if( peer == index.end() || peer->second <= i )
+                continue;
+            g->GetAttribute(eid, wAttr, v);
+            neighbors.push_back(std::make_pair(peer->second, v.IsNull() ? HLINK_DEF_VALUE : v.GetDouble()));
+        }
+        hit.reset();
+        hlinks.reset();
+        std::sort(neighbors.begin(), neighbors.end());
+
+        bin::writeVarint(adjacency, neighbors.size());
+        size_t prev = i;
+        for( auto& nb: neighbors ) {
+            bin::writeVarint(adjacency, nb.first - prev);
+            prev = nb.first;
+            wEnc->add(nb.second);
+        }
+        chunkEdges += neighbors.size();
+    }
+    flushChunk(nodes.size());
+    bin::writeVarint(buf, 0);
+
+    outfile.write(buf.data(), std::streamsize(buf.size()));
+    outfile.close();
+    if( !outfile ) {
+        LOG(logERROR) << "GraphExporter::toBinaryTimeSeries error writing " << path;
+        return false;
+    }
+    LOG(logINFO) << "Wrote: " << path;
+    return true;
+}
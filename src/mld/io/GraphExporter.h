@@ -42,6 +42,23 @@ public:
      */
     static bool toTimeSeries( sparksee::gdb::Graph* g,
                               const std::string& name, std::string& exportFolderPath );
+
+    /**
+     * @brief Export the multigraph to a single binary time series file.
+     * Layout, integers are LEB128 varints:
+     *  - header: "MLDT", version byte, value bits byte (32 or 64, see SignalValue),
+     *    node count, layer count
+     *  - schema: attribute count, then name (UTF-8) and sparksee DataType of each node attribute
+     *  - nodes: for each node the attribute values (null flag then value), then the series
+     *    from the base layer to the top layer, XOR compressed, as a length prefixed block
+     *  - edges: chunks of edge count, first node, node span, delta coded sorted neighbors
+     *    with a higher index, and XOR compressed weights. An edge count of 0 ends the file
+     * Nodes are referred to by their position in the file
+     * @param g Graph
+     * @param path Output file
+     * @return success
+     */
+    static bool toBinaryTimeSeries( sparksee::gdb::Graph* g, const std::string& path );
 private:
     static bool writeTSNodes( MLGDao& dao,
                               const std::string& nodePath, RIndexMap& indexMap );
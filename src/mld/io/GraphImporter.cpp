@@ -20,12 +20,26 @@
 #include <codecvt>
 #include <string>
 #include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <algorithm>
+#include <limits>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/range/algorithm/remove_if.hpp>
 #include <sparksee/gdb/Objects.h>
+#include <sparksee/gdb/Graph_data.h>
 
 #include "mld/io/GraphImporter.h"
+#include "mld/io/MappedFile.h"
+#include "mld/io/BinaryCodec.h"
+#include "mld/utils/ProgressDisplay.h"
+#include "mld/utils/ParallelFor.h"
 #include "mld/GraphTypes.h"
 #include "mld/utils/Timer.h"
 #include "mld/dao/MLGDao.h"
@@ -40,25 +54,106 @@ typedef std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> Converter;
 
 namespace {
 
-oid_t addOrGetFromIndexMap( uint64_t node, GraphImporter::IndexMap& indexMap,
-                            const Layer& base, MLGDao& dao )
+using NodePair = std::pair<oid_t, oid_t>;
+
+// Line aligned range of a mapped file
+struct Chunk
+{
+    const char* begin;
+    const char* end;
+};
+
+const size_t SNAP_CHUNK_SIZE = size_t(16) << 20;
+
+/**
+ * @brief Split a buffer in line aligned chunks of about chunkSize bytes
+ * @param data Buffer
+ * @param size Buffer size
+ * @param chunkSize Target size of a chunk
+ * @return chunks
+ */
+std::vector<Chunk> splitLines( const char* data, size_t size, size_t chunkSize )
+{
+    std::vector<Chunk> res;
+    const char* end = data + size;
+    const char* p = data;
+    while( p != end ) {
+        const char* q = end;
+        if( size_t(end - p) > chunkSize ) {
+            q = static_cast<const char*>(std::memchr(p + chunkSize, '\n', end - (p + chunkSize)));
+            q = q ? q + 1 : end;
+        }
+        res.push_back(Chunk{ p, q });
+        p = q;
+    }
+    return res;
+}
+
+/**
+ * @brief Parse an unsigned integer, leading blanks are skipped
+ * @param p Current position, moved after the integer
+ * @param end End of the line
+ * @param out Parsed value
+ * @return false if there is no integer or if it does not fit in 64 bits
+ */
+inline bool parseId( const char*& p, const char* end, uint64_t& out )
 {
-    oid_t id = 0;
-    auto it = indexMap.find(node);
-    if( it != indexMap.end() ) {
-        id = it->second;
-    }
-    else {  // Not in map
-        // Add to graph
-        std::wstringstream stream;
-        stream << node;
-        AttrMap data;
-        data[Attrs::V[NodeAttr::LABEL]].SetStringVoid(stream.str());
-        mld::Node n(dao.addNodeToLayer(base, data));
-        indexMap[node] = n.id();
-        id = n.id();
-    }
-    return id;
+    while( p != end && (*p == ' ' || *p == '\t' || *p == ',') )
+        ++p;
+    if( p == end || *p < '0' || *p > '9' )
+        return false;
+    const uint64_t maxId = std::numeric_limits<uint64_t>::max();
+    uint64_t v = 0;
+    while( p != end && *p >= '0' && *p <= '9' ) {
+        const uint64_t d = uint64_t(*p - '0');
+        if( v > (maxId - d) / 10 )
+            return false;
+        v = v * 10 + d;
+        ++p;
+    }
+    out = v;
+    return true;
+}
+
+/**
+ * @brief Call fn(src, tgt) for each edge of a chunk, self loops, comments
+ * and empty lines are skipped
+ * @param c Chunk
+ * @param fn Edge callback
+ * @return number of malformed lines
+ */
+template <typename F>
+size_t forEachSnapEdge( const Chunk& c, F fn )
+{
+    size_t malformed = 0;
+    const char* p = c.begin;
+    while( p != c.end ) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', c.end - p));
+        if( !eol )
+            eol = c.end;
+        const char* q = p;
+        while( q != eol && (*q == ' ' || *q == '\t') )
+            ++q;
+        if( q != eol && *q != '#' && *q != '\r' ) {
+            uint64_t src = 0;
+            uint64_t tgt = 0;
+            if( parseId(q, eol, src) && parseId(q, eol, tgt) ) {
+                if( src != tgt ) // Skip self loop
+                    fn(src, tgt);
+            }
+            else {
+                ++malformed;
+            }
+        }
+        p = (eol == c.end) ? eol : eol + 1;
+    }
+    return malformed;
+}
+
+void sortUnique( std::vector<uint64_t>& v )
+{
+    std::sort(v.begin(), v.end());
+    v.erase(std::unique(v.begin(), v.end()), v.end());
 }
 
 std::vector<std::string> getNextLineAndSplitIntoTokens( std::istream& str )
@@ -77,50 +172,405 @@ std::vector<std::string> getNextLineAndSplitIntoTokens( std::istream& str )
     return result;
 }
 
+// Cell of a CSV line in a mapped buffer
+struct Cell
+{
+    const char* begin;
+    const char* end;
+};
+
+const size_t TS_BLOCK_SIZE = 4096;
+
+inline bool isCellJunk( char c )
+{
+    return c == '#' || c == '"' || c == '\r' || c == ' ';
+}
+
+/**
+ * @brief Split the next line of a buffer on commas without copying it
+ * @param p Start of the line
+ * @param end End of the buffer
+ * @param cells Cells of the line, empty for a blank line
+ * @return start of the next line
+ */
+const char* splitCSVLine( const char* p, const char* end, std::vector<Cell>& cells )
+{
+    cells.clear();
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if( !eol )
+        eol = end;
+    const char* b = p;
+    for( const char* q = p; ; ++q ) {
+        if( q == eol || *q == ',' ) {
+            cells.push_back(Cell{ b, q });
+            if( q == eol )
+                break;
+            b = q + 1;
+        }
+    }
+    if( cells.size() == 1 && std::all_of(p, eol, isCellJunk) )
+        cells.clear();
+    return eol == end ? end : eol + 1;
+}
+
+// Copy a cell without the quote, comment and carriage return characters
+std::string cellString( const Cell& c )
+{
+    std::string res(c.begin, c.end);
+    res.erase(boost::remove_if(res, ba::is_any_of("#\"\r")), res.end());
+    return res;
+}
+
+// Only non ASCII strings go through the UTF-8 converter
+std::wstring cellWString( const Cell& c, Converter& converter )
+{
+    std::string str(cellString(c));
+    if( std::all_of(str.begin(), str.end(), []( char ch ) { return static_cast<unsigned char>(ch) < 0x80; }) )
+        return std::wstring(str.begin(), str.end());
+    return converter.from_bytes(str);
+}
+
+/**
+ * @brief Parse a floating point cell, surrounding quotes and blanks are ignored
+ * @param c Cell
+ * @param out Value
+ * @return false if the cell is not a number
+ */
+bool parseCellDouble( const Cell& c, double& out )
+{
+    const char* b = c.begin;
+    const char* e = c.end;
+    while( b != e && isCellJunk(*b) )
+        ++b;
+    while( e != b && isCellJunk(*(e - 1)) )
+        --e;
+    const size_t len = size_t(e - b);
+    if( len == 0 )
+        return false;
+    // strtod needs a null terminated string, cells are copied on the stack
+    char buf[64];
+    if( len >= sizeof(buf) ) {
+        std::string str(b, e);
+        char* stop = nullptr;
+        out = std::strtod(str.c_str(), &stop);
+        return stop == str.c_str() + len;
+    }
+    std::memcpy(buf, b, len);
+    buf[len] = '\0';
+    char* stop = nullptr;
+    out = std::strtod(buf, &stop);
+    return stop == buf + len;
+}
+
+/**
+ * @brief Parse a base 10 integer, ids are not rounded through a double
+ * @param str String
+ * @param out Value
+ * @return false if the string is not an integer or is out of range
+ */
+bool parseLong( const std::string& str, std::int64_t& out )
+{
+    if( str.empty() )
+        return false;
+    char* stop = nullptr;
+    errno = 0;
+    long long v = std::strtoll(str.c_str(), &stop, 10);
+    if( errno == ERANGE || stop != str.c_str() + str.size() )
+        return false;
+    out = std::int64_t(v);
+    return true;
+}
+
+bool readBinaryValue( std::istream& in, DataType type, Value& v, Converter& converter )
+{
+    int flag = in.get();
+    if( flag == std::char_traits<char>::eof() )
+        return false;
+    v.SetNullVoid();
+    if( flag == 0 )
+        return true;
+
+    uint64_t u = 0;
+    switch( type ) {
+        case Boolean: {
+            int b = in.get();
+            v.SetBooleanVoid(b == 1);
+            break;
+        }
+        case Integer:
+            if( !bin::readVarint(in, u) )
+                return false;
+            v.SetIntegerVoid(int32_t(bin::unzigzag(u)));
+            break;
+        case Long:
+            if( !bin::readVarint(in, u) )
+                return false;
+            v.SetLongVoid(bin::unzigzag(u));
+            break;
+        case Timestamp:
+            if( !bin::readVarint(in, u) )
+                return false;
+            v.SetTimestampVoid(bin::unzigzag(u));
+            break;
+        case OID:
+            if( !bin::readVarint(in, u) )
+                return false;
+            v.SetOIDVoid(oid_t(u));
+            break;
+        case Double: {
+            double d = 0.0;
+            if( !bin::readDouble(in, d) )
+                return false;
+            v.SetDoubleVoid(d);
+            break;
+        }
+        case String: {
+            std::string str;
+            if( !bin::readBytes(in, str) )
+                return false;
+            v.SetStringVoid(cellWString(Cell{ str.data(), str.data() + str.size() }, converter));
+            break;
+        }
+        default:
+            break;
+    }
+    return bool(in);
+}
+
+// Decode a series stored with valueBits bits per value
+bool decodeSeries( const std::string& block, unsigned valueBits, size_t count, double* out )
+{
+    const char* b = block.data();
+    const char* e = b + block.size();
+    if( valueBits == 32 ) {
+        bin::XorDecoder<uint32_t> dec(b, e);
+        float f = 0.0f;
+        for( size_t i = 0; i < count; ++i ) {
+            if( !dec.next(f) )
+                return false;
+            out[i] = f;
+        }
+        return true;
+    }
+    bin::XorDecoder<uint64_t> dec(b, e);
+    for( size_t i = 0; i < count; ++i ) {
+        if( !dec.next(out[i]) )
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read the header of a *.nodes.csv file, the last key is the
+ * size of the time series "ts:N" and is removed from the header.
+ * "ts:N:F" also gives the index F of the first step, firstStep is -1 otherwise
+ */
+bool readTSHeader( const char*& p, const char* end, std::vector<std::string>& header, size_t& tsSize,
+                   std::int64_t& firstStep )
+{
+    std::vector<Cell> cells;
+    p = splitCSVLine(p, end, cells);
+    header.clear();
+    for( auto& c: cells )
+        header.push_back(cellString(c));
+    if( header.empty() ) {
+        LOG(logERROR) << "GraphImporter::readTSHeader empty header";
+        return false;
+    }
+
+    std::vector<std::string> tsTok;
+    ba::split(tsTok, header.back(), ba::is_any_of(":"));
+    if( tsTok[0] != "ts" || tsTok.size() < 2 || tsTok.size() > 3 ) {
+        LOG(logERROR) << std::string("GraphImporter::readTSHeader key ts (timeseries) not ") +
+                         std::string("found in header or not in the last position: ") << header.back();
+        return false;
+    }
+    // Remove ts value for header
+    std::string tsKey(header.back());
+    header.pop_back();
+    // Get ts series size and the optional index of the first step (ts:size:first)
+    std::int64_t size = 0;
+    firstStep = -1;
+    if( !parseLong(tsTok[1], size) || size <= 0 || (tsTok.size() == 3 && (!parseLong(tsTok[2], firstStep) || firstStep < 0)) ) {
+        LOG(logERROR) << "GraphImporter::readTSHeader invalid ts key: " << tsKey;
+        return false;
+    }
+    tsSize = size_t(size);
+    return true;
+}
+
+/**
+ * @brief Check that each line of a time series file body has all its values,
+ * files are validated before anything is written in the database
+ * @param p Start of the body
+ * @param end End of the buffer
+ * @param tsStartIdx Cell of the first value
+ * @param tsSize Number of values
+ * @param who Caller name for the error message
+ * @return valid
+ */
+bool validateTSLines( const char* p, const char* end, size_t tsStartIdx, size_t tsSize, const char* who )
+{
+    std::vector<Cell> cells;
+    size_t lineNum = 1;
+    while( p != end ) {
+        p = splitCSVLine(p, end, cells);
+        ++lineNum;
+        if( cells.empty() )
+            continue;
+        if( cells.size() < tsStartIdx + tsSize ) {
+            LOG(logERROR) << who << " missing values line " << lineNum;
+            return false;
+        }
+        for( size_t l = 0; l < tsSize; ++l ) {
+            double val = 0.0;
+            if( !parseCellDouble(cells[tsStartIdx + l], val) ) {
+                LOG(logERROR) << who << " invalid value line " << lineNum
+                              << ": " << cellString(cells[tsStartIdx + l]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief OLinks of a block of nodes, buffered node by node and
+ * inserted layer by layer every TS_BLOCK_SIZE nodes
+ */
+class OLinkBlock
+{
+public:
+    OLinkBlock( MLGDao& dao, const std::vector<oid_t>& layers )
+        : m_dao(dao)
+        , m_layers(layers)
+        , m_values(layers.size())
+    {
+        m_nodes.reserve(TS_BLOCK_SIZE);
+    }
+
+    /**
+     * @brief Buffer the series of a node, flush the block when full
+     * @param nid Node id
+     * @param series One value per layer
+     * @return success
+     */
+    bool add( oid_t nid, const double* series )
+    {
+        for( size_t l = 0; l < m_layers.size(); ++l )
+            m_values[l].push_back(series[l]);
+        m_nodes.push_back(nid);
+        return m_nodes.size() < TS_BLOCK_SIZE || flush();
+    }
+
+    /**
+     * @brief Insert the buffered OLinks
+     * @return success
+     */
+    bool flush()
+    {
+        for( size_t l = 0; l < m_layers.size(); ++l ) {
+            if( !m_dao.addOLinks(m_layers[l], m_nodes, m_values[l]) )
+                return false;
+            m_values[l].clear();
+        }
+        m_nodes.clear();
+        return true;
+    }
+
+private:
+    MLGDao& m_dao;
+    const std::vector<oid_t>& m_layers;
+    std::vector<oid_t> m_nodes;
+    std::vector<std::vector<double>> m_values;
+};
+
 } // end namespace anonymous
 
-bool GraphImporter::fromSnapFormat( Graph* g, const std::string& filepath )
+bool GraphImporter::fromSnapFormat( Graph* g, const std::string& filepath, uint32_t numThreads )
 {
     std::unique_ptr<Timer> t(new Timer("Importing snap graph"));
     LOG(logINFO) << "Parsing SNAP undirected graph: " << filepath;
     MLGDao dao(g);
-    LinkDao linkDao(g);
     Layer base = dao.addBaseLayer();
     if( base.id() == Objects::InvalidOID ) {
         LOG(logERROR) << "GraphImporter::fromSnapFormat cannot add base layer";
         return false;
     }
 
-    std::ifstream infile(filepath.c_str());
-    if( !infile ) {
+    MappedFile file;
+    if( !file.open(filepath) ) {
         LOG(logERROR) << "GraphImporter::fromSnapFormat cannot open file " << filepath;
         return false;
     }
 
-    std::string read_line;
-    // Skip comments
-    while( std::getline(infile, read_line) ) {
-        if( read_line[0] != '#' )
-            break;
+    if( numThreads == 0 )
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    auto chunks = splitLines(file.data(), file.size(),
+                             std::min(SNAP_CHUNK_SIZE, file.size() / numThreads + 1));
+
+    // First pass: collect the unique node ids, each thread compacts its own ids
+    // as soon as they double to bound the memory
+    std::vector<std::vector<uint64_t>> threadIds(numThreads);
+    std::vector<size_t> uniqueCount(numThreads, 0);
+    std::atomic<size_t> malformed(0);
+    parallelFor(chunks.size(), numThreads, [&]( size_t c, size_t th ) {
+        auto& ids = threadIds[th];
+        malformed += forEachSnapEdge(chunks[c], [&]( uint64_t src, uint64_t tgt ) {
+            ids.push_back(src);
+            ids.push_back(tgt);
+            if( ids.size() >= 2 * uniqueCount[th] + (size_t(1) << 20) ) {
+                sortUnique(ids);
+                uniqueCount[th] = ids.size();
+            }
+        });
+    });
+    parallelFor(numThreads, numThreads, [&]( size_t th, size_t ) {
+        sortUnique(threadIds[th]);
+    });
+
+    std::vector<uint64_t> ids(std::move(threadIds[0]));
+    for( size_t th = 1; th < numThreads; ++th ) {
+        size_t mid = ids.size();
+        ids.insert(ids.end(), threadIds[th].begin(), threadIds[th].end());
+        std::inplace_merge(ids.begin(), ids.begin() + mid, ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        std::vector<uint64_t>().swap(threadIds[th]);
+    }
+    if( malformed > 0 ) {
+        LOG(logWARNING) << "GraphImporter::fromSnapFormat " << malformed.load() << " malformed lines skipped";
     }
-    // Go backwards one line
-    long pos = infile.tellg();
-    long startPos = pos - (read_line.size() + 1);
-    infile.seekg(startPos);
 
-    IndexMap indexMap;
-    uint64_t src;
-    uint64_t tgt;
-    while( infile >> src >> tgt ) {
-        if( src == tgt ) // Skip self loop
-            continue;
-        // Add node if needed
-        oid_t srcId = addOrGetFromIndexMap(src, indexMap, base, dao);
-        oid_t tgtId = addOrGetFromIndexMap(tgt, indexMap, base, dao);
-        // Create HLink
-        linkDao.addHLink(srcId, tgtId);
+    // Node ids are sorted, their position is their index
+    std::vector<oid_t> nodes;
+    if( !dao.addNodesToLayer(base, ids, nodes) ) {
+        LOG(logERROR) << "GraphImporter::fromSnapFormat cannot add nodes";
+        return false;
     }
-    infile.close();
+
+    // Second pass: remap the edges in parallel, one round of chunks at a time,
+    // then insert them in file order
+    auto nodeId = [&]( uint64_t id ) {
+        return nodes[size_t(std::lower_bound(ids.begin(), ids.end(), id) - ids.begin())];
+    };
+    std::vector<std::vector<NodePair>> edges(numThreads);
+    for( size_t first = 0; first < chunks.size(); first += numThreads ) {
+        size_t count = std::min(size_t(numThreads), chunks.size() - first);
+        parallelFor(count, numThreads, [&]( size_t i, size_t ) {
+            auto& buf = edges[i];
+            buf.clear();
+            forEachSnapEdge(chunks[first + i], [&]( uint64_t src, uint64_t tgt ) {
+                buf.push_back(NodePair(nodeId(src), nodeId(tgt)));
+            });
+        });
+        for( size_t i = 0; i < count; ++i ) {
+            if( !dao.addHLinks(edges[i]) ) {
+                LOG(logERROR) << "GraphImporter::fromSnapFormat cannot add HLinks";
+                return false;
+            }
+        }
+    }
+    file.close();
 
     LOG(logINFO) << "Base Layer #nodes: " << dao.getNodeCount(base) << " #edges: " << dao.getHLinkCount(base);
     return true;
@@ -155,52 +605,59 @@ bool GraphImporter::importTSNodes( sparksee::gdb::Graph* g,
 {
     LOG(logINFO) << "Parsing node data: " << nodePath;
 
-    std::ifstream infile(nodePath.c_str());
-    if( !infile ) {
+    MappedFile file;
+    if( !file.open(nodePath) ) {
         LOG(logERROR) << "GraphImporter::importTSNodes cannot open file " << nodePath;
         return false;
     }
 
     Converter converter; // string to wstring
-    auto header = getNextLineAndSplitIntoTokens(infile);
-    std::vector<std::string> tsTok;
-    ba::split(tsTok, header.back(), ba::is_any_of(":"));
-    if( tsTok[0] != "ts" || tsTok.size() != 2 ) {
-        LOG(logERROR) << std::string("GraphImporter::importTSNodes key ts (timeseries) not ") +
-                         std::string("found in header or not in the last position: ") << header.back();
+    std::vector<Cell> cells;
+    const char* p = file.begin();
+    std::vector<std::string> header;
+    size_t tsSize = 0;
+    std::int64_t firstStep = -1;
+    if( !readTSHeader(p, file.end(), header, tsSize, firstStep) )
+        return false;
+    if( firstStep > 0 ) {
+        LOG(logERROR) << "GraphImporter::importTSNodes the time series starts at step " << firstStep
+                      << ", use appendTimeSeries";
         return false;
     }
-    // Remove ts value for header
-    header.pop_back();
-    // Get ts series size
-    size_t tsSize = size_t(std::stoi(tsTok[1]));
     size_t tsStartIdx = header.size();
+    // The whole file is checked first, a parse error leaves the database untouched
+    if( !validateTSLines(p, file.end(), tsStartIdx, tsSize, "GraphImporter::importTSNodes") )
+        return false;
 
-    // Create an data template with keys read from the header
-    std::map<int, std::wstring> keyIdx;  // store indx to keys for AttrMap
-    AttrMap model;
+    // Resolve the node attributes from the keys read from the header
+    MLGDao dao(g);
+    type_t nType = dao.nodeType();
+    std::vector<attr_t> attrs;
+    size_t weightIdx = INVALID_INDEX;
     for( size_t i = 0; i < header.size(); ++i ) {
         ba::to_lower(header[i]);
+        std::wstring key;
         if( header[i] == "weight" ) {
-            keyIdx[i] = Attrs::V[NodeAttr::WEIGHT];
+            key = Attrs::V[NodeAttr::WEIGHT];
+            weightIdx = i;
         }
         else if( header[i] == "label" ) {
-            keyIdx[i] = Attrs::V[NodeAttr::LABEL];
+            key = Attrs::V[NodeAttr::LABEL];
         }
         else {
-            keyIdx[i] = converter.from_bytes(header[i]);
+            key = converter.from_bytes(header[i]);
             if( autoCreateAttributes ) {
-                if( !SparkseeManager::addAttrToNode(g, keyIdx[i], String, Indexed, Value().SetNull()) ) {
+                if( !SparkseeManager::addAttrToNode(g, key, String, Indexed, Value().SetNull()) ) {
                     LOG(logERROR) << "GraphImporter::importTSNodes: failed to add attribute "
-                                  << converter.to_bytes(keyIdx[i]) << " to Node";
+                                  << header[i] << " to Node";
                 }
             }
         }
-        model[keyIdx[i]].SetNullVoid();
+        // Unknown attributes are skipped
+        attrs.push_back(g->FindAttribute(nType, key));
     }
 
     // Create layer stack
-    MLGDao dao(g);
     Layer base = dao.addBaseLayer();
     std::vector<Layer> layerStack;
     layerStack.reserve(tsSize);
@@ -211,32 +668,265 @@ bool GraphImporter::importTSNodes( sparksee::gdb::Graph* g,
         layerStack.push_back(dao.addLayerOnTop());
     }
 
+    // Nodes are created as they are read, their OLinks are buffered
+    // and inserted layer by layer for each block of nodes
+    std::vector<oid_t> layers;
+    for( auto& layer: layerStack )
+        layers.push_back(layer.id());
+    OLinkBlock block(dao, layers);
+    std::vector<double> series(tsSize);
+
     uint64_t k = 0; // Count node for indexMap
-    // Read lines here
-    while( infile.good() ) {
-        auto tokens(getNextLineAndSplitIntoTokens(infile));
-        if( tokens.empty() )
-            break;
-        // Copy header model keys
-        AttrMap nodeData(model);
-        // Set values
+    Value v;
+    // Read lines here, they are already validated
+    while( p != file.end() ) {
+        p = splitCSVLine(p, file.end(), cells);
+        if( cells.empty() )
+            continue;
+        for( size_t l = 0; l < tsSize; ++l ) {
+            series[l] = 0.0;
+            parseCellDouble(cells[tsStartIdx + l], series[l]);
+        }
+
+        oid_t nid = g->NewNode(nType);
         for( size_t i = 0; i < header.size(); ++i ) {
-            nodeData[keyIdx[i]].SetString(converter.from_bytes(tokens[i]));
+            if( attrs[i] == sparksee::gdb::Attribute::InvalidAttribute )
+                continue;
+            if( i == weightIdx ) {
+                double w = 0.0;
+                if( parseCellDouble(cells[i], w) )
+                    g->SetAttribute(nid, attrs[i], v.SetDouble(w));
+            }
+            else {
+                g->SetAttribute(nid, attrs[i], v.SetString(cellWString(cells[i], converter)));
+            }
         }
+        indexMap[k++] = nid;
 
-        // Set OLink data for first edge
-        AttrMap olinkData;
-        olinkData[Attrs::V[OLinkAttr::WEIGHT]].SetDouble(std::stod(tokens[tsStartIdx]));
+        if( !block.add(nid, series.data()) ) {
+            LOG(logERROR) << "GraphImporter::importTSNodes cannot add OLinks";
+            return false;
+        }
+    }
 
-        Node node(dao.addNodeToLayer(base, nodeData, olinkData));
-        indexMap[k++] = node.id();
-        // Add olink to other layers
-        for( size_t i = tsStartIdx + 1; i < tokens.size(); ++i ) {
-            olinkData[Attrs::V[OLinkAttr::WEIGHT]].SetDouble(std::stod(tokens[i]));
-            dao.addOLink(layerStack[i - tsStartIdx], node, olinkData);
+    if( !block.flush() ) {
+        LOG(logERROR) << "GraphImporter::importTSNodes cannot add OLinks";
+        return false;
+    }
+    return true;
+}
+
+bool GraphImporter::appendTimeSeries( Graph* g, const std::string& nodePath,
+                                      const std::string& matchKey, std::int64_t expectedLayers )
+{
+    std::unique_ptr<Timer> t(new Timer("Appending TimeSeries"));
+    LOG(logINFO) << "Appending node data: " << nodePath;
+
+    MappedFile file;
+    if( !file.open(nodePath) ) {
+        LOG(logERROR) << "GraphImporter::appendTimeSeries cannot open file " << nodePath;
+        return false;
+    }
+
+    const char* p = file.begin();
+    std::vector<std::string> header;
+    size_t tsSize = 0;
+    std::int64_t firstStep = -1;
+    if( !readTSHeader(p, file.end(), header, tsSize, firstStep) )
+        return false;
+    const char* body = p;
+    size_t tsStartIdx = header.size();
+    if( !validateTSLines(p, file.end(), tsStartIdx, tsSize, "GraphImporter::appendTimeSeries") )
+        return false;
+
+    // The time series must start on the base layer and end on the top layer
+    MLGDao dao(g);
+    Layer base(dao.baseLayer());
+    if( base.id() == Objects::InvalidOID || dao.bottomLayer().id() != base.id() ) {
+        LOG(logERROR) << "GraphImporter::appendTimeSeries database is not a timeseries graph";
+        return false;
+    }
+    // The first appended step must be the next layer, it is given by the header or the caller
+    if( expectedLayers < 0 ) {
+        expectedLayers = firstStep;
+    }
+    else if( firstStep >= 0 && firstStep != expectedLayers ) {
+        LOG(logERROR) << "GraphImporter::appendTimeSeries file starts at step " << firstStep
+                      << ", expected " << expectedLayers;
+        return false;
+    }
+    if( expectedLayers < 0 ) {
+        LOG(logERROR) << "GraphImporter::appendTimeSeries unknown first step, "
+                      << "set it in the header (ts:size:first) or pass the expected layer count";
+        return false;
+    }
+    std::int64_t layerCount = dao.getLayerCount();
+    if( layerCount != expectedLayers ) {
+        LOG(logERROR) << "GraphImporter::appendTimeSeries database has " << layerCount
+                      << " layers, expected " << expectedLayers;
+        return false;
+    }
+
+    // Resolve the column used to match the rows with the existing nodes
+    Converter converter;
+    type_t nType = dao.nodeType();
+    size_t matchIdx = INVALID_INDEX;
+    std::wstring key;
+    for( size_t i = 0; i < header.size(); ++i ) {
+        std::string col(ba::to_lower_copy(header[i]));
+        if( col == matchKey ) {
+            matchIdx = i;
+            key = col == "label" ? Attrs::V[NodeAttr::LABEL] : converter.from_bytes(header[i]);
+            break;
         }
     }
-    infile.close();
+    attr_t matchAttr = matchIdx == INVALID_INDEX ? sparksee::gdb::Attribute::InvalidAttribute
+                                                 : g->FindAttribute(nType, key);
+    if( matchAttr == sparksee::gdb::Attribute::InvalidAttribute ) {
+        LOG(logERROR) << "GraphImporter::appendTimeSeries no node attribute for key: " << matchKey;
+        return false;
+    }
+    DataType matchType = String;
+    bool indexed = true;
+    {
+        std::unique_ptr<sparksee::gdb::Attribute> attr(g->GetAttribute(matchAttr));
+        matchType = attr->GetDataType();
+        indexed = attr->GetKind() != Basic;
+    }
+    if( matchType != String && matchType != Integer && matchType != Long ) {
+        LOG(logERROR) << "GraphImporter::appendTimeSeries key " << matchKey
+                      << " is not a string or an integer attribute";
+        return false;
+    }
+
+    // Lookups go through the attribute index, it is persisted with the database.
+    // A Basic attribute is scanned once here and only indexed once the file is accepted
+    auto valueKey = [matchType]( const Value& val ) -> std::wstring {
+        if( matchType == String )
+            return val.GetString();
+        return std::to_wstring(matchType == Integer ? std::int64_t(val.GetInteger()) : val.GetLong());
+    };
+    std::unordered_map<std::wstring, std::pair<oid_t, size_t>> scanned;
+    Value v;
+    if( !indexed ) {
+        ObjectsPtr all(g->Select(nType));
+        ObjectsIt it(all->Iterator());
+        while( it->HasNext() ) {
+            oid_t nid = it->Next();
+            g->GetAttribute(nid, matchAttr, v);
+            if( v.IsNull() )
+                continue;
+            auto& entry = scanned[valueKey(v)];
+            if( entry.second++ == 0 )
+                entry.first = nid;
+        }
+    }
+
+    // First pass, match every row before modifying the database
+    std::vector<Cell> cells;
+    std::vector<oid_t> rowNodes;
+    std::unordered_set<oid_t> seen;
+    size_t lineNum = 1;
+    while( p != file.end() ) {
+        p = splitCSVLine(p, file.end(), cells);
+        ++lineNum;
+        if( cells.empty() )
+            continue;
+
+        const Cell& c = cells[matchIdx];
+        if( matchType == String ) {
+            v.SetString(cellWString(c, converter));
+        }
+        else {
+            // Integer ids are not parsed through a double, they would lose precision above 2^53
+            std::int64_t id = 0;
+            if( !parseLong(ba::trim_copy(cellString(c)), id) || (matchType == Integer &&
+                (id < std::numeric_limits<int32_t>::min() || id > std::numeric_limits<int32_t>::max())) ) {
+                LOG(logERROR) << "GraphImporter::appendTimeSeries invalid key line " << lineNum
+                              << ": " << cellString(c);
+                return false;
+            }
+            if( matchType == Integer )
+                v.SetInteger(int32_t(id));
+            else
+                v.SetLong(id);
+        }
+        oid_t nid = Objects::InvalidOID;
+        size_t count = 0;
+        if( indexed ) {
+            ObjectsPtr match(g->Select(matchAttr, Equal, v));
+            count = size_t(match->Count());
+            if( count == 1 )
+                nid = match->Any();
+        }
+        else {
+            auto it = scanned.find(valueKey(v));
+            if( it != scanned.end() ) {
+                count = it->second.second;
+                nid = it->second.first;
+            }
+        }
+        if( count != 1 ) {
+            LOG(logERROR) << "GraphImporter::appendTimeSeries " << count
+                          << " nodes match " << cellString(c) << " line " << lineNum;
+            return false;
+        }
+        if( !seen.insert(nid).second ) {
+            LOG(logERROR) << "GraphImporter::appendTimeSeries duplicate row for "
+                          << cellString(c) << " line " << lineNum;
+            return false;
+        }
+        rowNodes.push_back(nid);
+    }
+
+    // Each node needs a value on every layer
+    std::int64_t nodeCount = dao.getNodeCount(base);
+    if( std::int64_t(rowNodes.size()) != nodeCount ) {
+        LOG(logERROR) << "GraphImporter::appendTimeSeries " << rowNodes.size()
+                      << " rows for " << nodeCount << " nodes";
+        return false;
+    }
+
+    // The file is accepted, the key index is persisted for the next appends
+    if( !indexed )
+        g->IndexAttribute(matchAttr, Indexed);
+
+    // Second pass, stack the new layers and insert the OLinks by blocks
+    std::vector<oid_t> layers;
+    for( size_t l = 0; l < tsSize; ++l ) {
+        Layer top(dao.addLayerOnTop());
+        if( top.id() == Objects::InvalidOID ) {
+            LOG(logERROR) << "GraphImporter::appendTimeSeries cannot add layer";
+            return false;
+        }
+        layers.push_back(top.id());
+    }
+
+    OLinkBlock block(dao, layers);
+    std::vector<double> series(tsSize);
+
+    p = body;
+    size_t row = 0;
+    while( p != file.end() ) {
+        p = splitCSVLine(p, file.end(), cells);
+        if( cells.empty() )
+            continue;
+        for( size_t l = 0; l < tsSize; ++l ) {
+            series[l] = 0.0;
+            parseCellDouble(cells[tsStartIdx + l], series[l]);
+        }
+        if( !block.add(rowNodes[row++], series.data()) ) {
+            LOG(logERROR) << "GraphImporter::appendTimeSeries cannot add OLinks";
+            return false;
+        }
+    }
+    if( !block.flush() ) {
+        LOG(logERROR) << "GraphImporter::appendTimeSeries cannot add OLinks";
+        return false;
+    }
+
+    LOG(logINFO) << "Appended " << tsSize << " timesteps to " << nodeCount
+                 << " nodes, #timeseries: " << dao.getLayerCount();
     return true;
 }
 
@@ -314,3 +1004,233 @@ bool GraphImporter::importTSEdges( sparksee::gdb::Graph* g,
     infile.close();
     return true;
 }
+
+bool GraphImporter::fromBinaryTimeSeries( Graph* g, const std::string& path, bool autoCreateAttributes )
+{
+    std::unique_ptr<Timer> t(new Timer("Importing binary TimeSeries graph"));
+    LOG(logINFO) << "Parsing binary timeseries graph: " << path;
+    std::ifstream infile(path, std::ios::binary);
+    if( !infile ) {
+        LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries cannot open file " << path;
+        return false;
+    }
+
+    // Header
+    char magic[sizeof(bin::TS_MAGIC)];
+    infile.read(magic, sizeof(magic));
+    int version = infile.get();
+    int valueBits = infile.get();
+    uint64_t nodeCount = 0;
+    uint64_t lCount = 0;
+    if( !infile || std::memcmp(magic, bin::TS_MAGIC, sizeof(magic)) != 0 ) {
+        LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries not a binary timeseries file: " << path;
+        return false;
+    }
+    if( version != bin::TS_VERSION || (valueBits != 32 && valueBits != 64) ) {
+        LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries unsupported version " << version
+                      << " or value size " << valueBits;
+        return false;
+    }
+    if( !bin::readVarint(infile, nodeCount) || !bin::readVarint(infile, lCount) || lCount == 0 ) {
+        LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries invalid header";
+        return false;
+    }
+    if( valueBits > int(sizeof(SignalValue) * 8) ) {
+        LOG(logWARNING) << "GraphImporter::fromBinaryTimeSeries values are stored with " << valueBits
+                        << " bits, they will be filtered with " << sizeof(SignalValue) * 8;
+    }
+
+    // Schema
+    Converter converter;
+    MLGDao dao(g);
+    type_t nType = dao.nodeType();
+    uint64_t attrCount = 0;
+    if( !bin::readVarint(infile, attrCount) ) {
+        LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries invalid schema";
+        return false;
+    }
+    std::vector<DataType> types;
+    std::vector<attr_t> attrs;
+    for( uint64_t k = 0; k < attrCount; ++k ) {
+        std::string name;
+        if( !bin::readBytes(infile, name) ) {
+            LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries invalid schema";
+            return false;
+        }
+        DataType type = static_cast<DataType>(infile.get());
+        std::wstring key(cellWString(Cell{ name.data(), name.data() + name.size() }, converter));
+        attr_t attr = g->FindAttribute(nType, key);
+        if( attr == sparksee::gdb::Attribute::InvalidAttribute && autoCreateAttributes ) {
+            if( !SparkseeManager::addAttrToNode(g, key, type, Indexed, Value().SetNull()) ) {
+                LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries: failed to add attribute "
+                              << name << " to Node";
+            }
+            attr = g->FindAttribute(nType, key);
+        }
+        types.push_back(type);
+        attrs.push_back(attr);
+    }
+
+    // Create layer stack
+    std::vector<oid_t> layers;
+    layers.push_back(dao.addBaseLayer().id());
+    for( uint64_t l = 1; l < lCount; ++l )
+        layers.push_back(dao.addLayerOnTop().id());
+
+    // Nodes, OLinks are inserted layer by layer for each block of nodes
+    std::vector<oid_t> nodes;
+    nodes.reserve(size_t(nodeCount));
+    OLinkBlock block(dao, layers);
+    std::vector<double> series(layers.size());
+    std::string bytes;
+    Value v;
+
+    ProgressDisplay display(nodeCount);
+    for( uint64_t i = 0; i < nodeCount; ++i ) {
+        oid_t nid = g->NewNode(nType);
+        for( size_t k = 0; k < attrs.size(); ++k ) {
+            if( !readBinaryValue(infile, types[k], v, converter) ) {
+                LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries truncated node " << i;
+                return false;
+            }
+            if( !v.IsNull() && attrs[k] != sparksee::gdb::Attribute::InvalidAttribute )
+                g->SetAttribute(nid, attrs[k], v);
+        }
+        if( !bin::readBytes(infile, bytes) || !decodeSeries(bytes, unsigned(valueBits), series.size(), series.data()) ) {
+            LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries invalid series for node " << i;
+            return false;
+        }
+        nodes.push_back(nid);
+        if( !block.add(nid, series.data()) ) {
+            LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries cannot add OLinks";
+            return false;
+        }
+        ++display;
+    }
+    if( !block.flush() ) {
+        LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries cannot add OLinks";
+        return false;
+    }
+
+    // Edges, one chunk at a time
+    std::vector<NodePair> links;
+    std::vector<double> weights;
+    std::string adjacency;
+    while( true ) {
+        uint64_t edgeCount = 0;
+        if( !bin::readVarint(infile, edgeCount) ) {
+            LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries truncated edges";
+            return false;
+        }
+        if( edgeCount == 0 )
+            break;
+
+        uint64_t first = 0;
+        uint64_t span = 0;
+        if( !bin::readVarint(infile, first) || !bin::readVarint(infile, span)
+            || !bin::readBytes(infile, adjacency) || !bin::readBytes(infile, bytes)
+            || first + span > nodeCount ) {
+            LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries invalid edge chunk";
+            return false;
+        }
+
+        links.clear();
+        const char* p = adjacency.data();
+        const char* end = p + adjacency.size();
+        for( uint64_t i = first; i < first + span; ++i ) {
+            uint64_t deg = 0;
+            uint64_t prev = i;
+            if( !bin::readVarint(p, end, deg) ) {
+                LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries invalid adjacency";
+                return false;
+            }
+            for( uint64_t k = 0; k < deg; ++k ) {
+                uint64_t delta = 0;
+                if( !bin::readVarint(p, end, delta) || prev + delta >= nodeCount ) {
+                    LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries invalid adjacency";
+                    return false;
+                }
+                prev += delta;
+                links.push_back(NodePair(nodes[size_t(i)], nodes[size_t(prev)]));
+            }
+        }
+
+        weights.resize(links.size());
+        bin::XorDecoder<uint64_t> dec(bytes.data(), bytes.data() + bytes.size());
+        for( auto& w: weights ) {
+            if( !dec.next(w) ) {
+                LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries invalid edge weights";
+                return false;
+            }
+        }
+        if( links.size() != edgeCount || !dao.addHLinks(links, weights) ) {
+            LOG(logERROR) << "GraphImporter::fromBinaryTimeSeries cannot add HLinks";
+            return false;
+        }
+    }
+
+    Layer base(dao.baseLayer());
+    LOG(logINFO) << "Base Layer #nodes: " << dao.getNodeCount(base)
+                 << " #edges: " << dao.getHLinkCount(base)
+                 << " #timeseries: " << dao.getLayerCount();
+    return true;
+}
+
+bool GraphImporter::readNodeSet( Graph* g, const std::string& filepath, ObjectsPtr& out )
+{
+    std::ifstream infile(filepath.c_str());
+    if( !infile ) {
+        LOG(logERROR) << "GraphImporter::readNodeSet cannot open file " << filepath;
+        return false;
+    }
+
+    // Labels to find, marked when matched
+    Converter converter;
+    std::unordered_map<std::wstring, bool> labels;
+    std::string line;
+    while( std::getline(infile, line) ) {
+        ba::trim(line);
+        if( line.empty() || line[0] == '#' )
+            continue;
+        labels.emplace(converter.from_bytes(line), false);
+    }
+    infile.close();
+
+    // Single pass over the base layer instead of one select per label
+    MLGDao dao(g);
+    out = dao.newObjectsPtr();
+    attr_t labelAttr = g->FindAttribute(dao.nodeType(), Attrs::V[NodeAttr::LABEL]);
+    ObjectsPtr base(dao.getAllNodeIds(dao.baseLayer()));
+    Value v;
+    ObjectsIt it(base->Iterator());
+    while( it->HasNext() ) {
+        oid_t nid = it->Next();
+        g->GetAttribute(nid, labelAttr, v);
+        if( v.IsNull() )
+            continue;
+        auto label = labels.find(v.GetString());
+        if( label != labels.end() ) {
+            label->second = true;
+            out->Add(nid);
+        }
+    }
+
+    std::vector<std::wstring> notFound;
+    for( auto& kv: labels ) {
+        if( !kv.second )
+            notFound.push_back(kv.first);
+    }
+    if( !notFound.empty() ) {
+        std::sort(notFound.begin(), notFound.end());
+        const size_t maxListed = 20;
+        std::string list;
+        for( size_t i = 0; i < notFound.size() && i < maxListed; ++i )
+            list += (i == 0 ? "" : ", ") + converter.to_bytes(notFound[i]);
+        if( notFound.size() > maxListed )
+            list += ", ...";
+        LOG(logWARNING) << "GraphImporter::readNodeSet " << notFound.size()
+                        << " labels match no base layer node: " << list;
+    }
+    LOG(logINFO) << "Node set: " << out->Count() << " nodes read from " << filepath;
+    return true;
+}
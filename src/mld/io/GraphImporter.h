@@ -31,16 +31,23 @@ class MLD_API GraphImporter
 public:
     typedef std::map<uint64_t, sparksee::gdb::oid_t> IndexMap;
     /**
-     * @brief Import a SNAP graph
+     * @brief Import a SNAP graph. The file is mapped in memory and parsed in parallel
+     * by line aligned chunks, nodes and HLinks are then inserted in bulk.
+     * Nodes are created in increasing id order, the id is the node label
      * @param g Graph handle
      * @param filepath Graph to import
+     * @param numThreads Number of parser threads, 0 for the number of cores
      * @return success
      */
-    static bool fromSnapFormat( sparksee::gdb::Graph* g, const std::string& filepath );
+    static bool fromSnapFormat( sparksee::gdb::Graph* g, const std::string& filepath,
+                                uint32_t numThreads=0 );
 
     /**
      * @brief Import a timeSeries graph from 2 files
-     * name.nodes.csv and name.edges.csv
+     * name.nodes.csv and name.edges.csv.
+     * The node file is validated before the first write, an invalid node file leaves
+     * the database untouched. An invalid edge file is only detected once the nodes
+     * are imported, the database has to be discarded
      * @param g Graph handle
      * @param nodePath filepath to the *.nodes.csv file
      * @param edgePath filepath to the *.edges.csv file
@@ -49,6 +56,47 @@ public:
     static bool fromTimeSeries( sparksee::gdb::Graph* g, const std::string& nodePath,
                                 const std::string& edgePath, bool autoCreateAttributes=true );
 
+    /**
+     * @brief Append the time series of a *.nodes.csv file to an existing timeSeries graph.
+     * Rows are matched to the nodes through the indexed attribute of the matchKey column,
+     * each series value is stored on a new layer stacked on top.
+     * The database is left untouched if a row does not match exactly one node, if
+     * the file does not hold a row for every node or if the layer count does not match
+     * the first step of the file. The first step is read from the header "ts:N:first"
+     * or given by expectedLayers, at least one of them is required
+     * @param g Graph handle
+     * @param nodePath filepath to the *.nodes.csv file
+     * @param matchKey Header key of the column used to match the nodes ("label", "id", ...)
+     * @param expectedLayers Number of layers the database must hold before appending,
+     * -1 to use the first step of the header
+     * @return success
+     */
+    static bool appendTimeSeries( sparksee::gdb::Graph* g, const std::string& nodePath,
+                                  const std::string& matchKey="label", int64_t expectedLayers=-1 );
+
+    /**
+     * @brief Import a timeSeries graph from a binary file written by
+     * GraphExporter::toBinaryTimeSeries. The file is read as a stream,
+     * OLinks and HLinks are inserted in bulk
+     * @param g Graph handle
+     * @param path Binary file
+     * @param autoCreateAttributes Create the node attributes missing in the database
+     * @return success
+     */
+    static bool fromBinaryTimeSeries( sparksee::gdb::Graph* g, const std::string& path,
+                                      bool autoCreateAttributes=true );
+
+    /**
+     * @brief Read a set of base layer nodes from a file with one node label per line.
+     * Empty lines and lines starting with # are skipped, the labels matching
+     * no base layer node are logged
+     * @param g Graph handle
+     * @param filepath File to read
+     * @param out Node set
+     * @return success
+     */
+    static bool readNodeSet( sparksee::gdb::Graph* g, const std::string& filepath, ObjectsPtr& out );
+
 private:
     static bool importTSNodes( sparksee::gdb::Graph* g,
                                const std::string& nodePath, IndexMap& indexMap, bool autoCreateAttributes );
@@ -0,0 +1,82 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mld/io/MappedFile.h"
+
+using namespace mld;
+
+MappedFile::MappedFile()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_open(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open( const std::string& path )
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if( fd < 0 ) {
+        LOG(logERROR) << "MappedFile::open cannot open file " << path;
+        return false;
+    }
+
+    struct stat st;
+    if( ::fstat(fd, &st) != 0 ) {
+        LOG(logERROR) << "MappedFile::open cannot stat file " << path;
+        ::close(fd);
+        return false;
+    }
+
+    m_size = size_t(st.st_size);
+    if( m_size > 0 ) {
+        void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if( addr == MAP_FAILED ) {
+            LOG(logERROR) << "MappedFile::open cannot map file " << path;
+            ::close(fd);
+            m_size = 0;
+            return false;
+        }
+        // Files are parsed front to back
+        ::madvise(addr, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(addr);
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    m_open = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if( m_data )
+        ::munmap(const_cast<char*>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
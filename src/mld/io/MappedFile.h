@@ -0,0 +1,62 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_MAPPEDFILE_H
+#define MLD_MAPPEDFILE_H
+
+#include <string>
+#include <boost/noncopyable.hpp>
+
+#include "mld/common.h"
+
+namespace mld {
+
+/**
+ * @brief Read only memory mapping of a whole file.
+ * Pages are loaded by the OS on access, parsing a file does not need
+ * to copy it in a stream buffer first.
+ */
+class MLD_API MappedFile : private boost::noncopyable
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    /**
+     * @brief Map a file, the previous one is unmapped
+     * @param path File path
+     * @return success
+     */
+    bool open( const std::string& path );
+    void close();
+
+    inline bool isOpen() const { return m_open; }
+    inline const char* data() const { return m_data; }
+    inline size_t size() const { return m_size; }
+    inline const char* begin() const { return m_data; }
+    inline const char* end() const { return m_data + m_size; }
+
+private:
+    const char* m_data;
+    size_t m_size;
+    bool m_open;
+};
+
+} // end namespace mld
+
+#endif // MLD_MAPPEDFILE_H
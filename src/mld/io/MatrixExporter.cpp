@@ -0,0 +1,361 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include <unordered_map>
+
+#include <boost/algorithm/string.hpp>
+#include <sparksee/gdb/Objects.h>
+#include <sparksee/gdb/ObjectsIterator.h>
+
+#include "mld/GraphTypes.h"
+#include "mld/utils/Timer.h"
+#include "mld/dao/MLGDao.h"
+#include "mld/io/BinaryCodec.h"
+#include "mld/io/MatrixExporter.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+namespace ba = boost::algorithm;
+
+namespace {
+
+const size_t FLUSH_SIZE = size_t(1) << 20;
+// Width reserved for the number of entries, patched when the matrix is closed
+const int MM_NNZ_WIDTH = 20;
+const std::streamoff CSR_NNZ_OFFSET = 24;
+
+// Column index and value, sorted by column
+using Row = std::vector<std::pair<size_t, double>>;
+
+/**
+ * @brief Sparse matrix written one row at a time, in row order
+ */
+class MatrixWriter
+{
+public:
+    virtual ~MatrixWriter() {}
+    virtual const char* extension() const = 0;
+    virtual bool open( const std::string& path, size_t rows, size_t cols, bool symmetric ) = 0;
+    virtual void addRow( const Row& row ) = 0;
+    virtual bool close() = 0;
+};
+
+class MatrixMarketWriter: public MatrixWriter
+{
+public:
+    const char* extension() const override { return ".mtx"; }
+
+    bool open( const std::string& path, size_t rows, size_t cols, bool symmetric ) override
+    {
+        m_out.open(path, std::ios::binary | std::ios::trunc);
+        if( !m_out )
+            return false;
+        m_symmetric = symmetric;
+        m_row = 0;
+        m_nnz = 0;
+        m_buf.clear();
+        m_out << "%%MatrixMarket matrix coordinate real " << (symmetric ? "symmetric" : "general") << "\n"
+              << "% MLD multilevel graph\n"
+              << rows << " " << cols << " ";
+        m_nnzPos = m_out.tellp();
+        m_out << std::string(MM_NNZ_WIDTH, ' ') << "\n";
+        return bool(m_out);
+    }
+
+    void addRow( const Row& row ) override
+    {
+        char line[64];
+        for( auto& e: row ) {
+            // Lower triangle only
+            if( m_symmetric && e.first > m_row )
+                break;
+            int len = std::snprintf(line, sizeof(line), "%zu %zu %.17g\n", m_row + 1, e.first + 1, e.second);
+            m_buf.append(line, size_t(len));
+            ++m_nnz;
+        }
+        ++m_row;
+        if( m_buf.size() >= FLUSH_SIZE ) {
+            m_out.write(m_buf.data(), m_buf.size());
+            m_buf.clear();
+        }
+    }
+
+    bool close() override
+    {
+        m_out.write(m_buf.data(), m_buf.size());
+        m_buf.clear();
+        m_out.seekp(m_nnzPos);
+        m_out << std::to_string(m_nnz);
+        bool ok = bool(m_out);
+        m_out.close();
+        return ok;
+    }
+
+private:
+    std::ofstream m_out;
+    std::string m_buf;
+    std::streampos m_nnzPos;
+    bool m_symmetric;
+    size_t m_row;
+    uint64_t m_nnz;
+};
+
+class CSRWriter: public MatrixWriter
+{
+public:
+    const char* extension() const override { return ".csr"; }
+
+    bool open( const std::string& path, size_t rows, size_t cols, bool ) override
+    {
+        // Values are streamed to a side file and appended after the indices
+        m_valPath = path + ".values";
+        m_out.open(path, std::ios::binary | std::ios::trunc);
+        m_values.open(m_valPath, std::ios::binary | std::ios::trunc);
+        if( !m_out || !m_values )
+            return false;
+        m_indptr.assign(1, 0);
+        m_idxBuf.clear();
+        m_valBuf.clear();
+
+        std::string header(bin::CSR_MAGIC, sizeof(bin::CSR_MAGIC));
+        header += static_cast<char>(bin::CSR_VERSION);
+        // Widths of the indices and values written by addRow
+        header += static_cast<char>(sizeof(uint64_t) * 8);
+        header += static_cast<char>(sizeof(double) * 8);
+        header += '\0';
+        bin::writeUint64(header, rows);
+        bin::writeUint64(header, cols);
+        bin::writeUint64(header, 0);
+        m_out.write(header.data(), header.size());
+        return bool(m_out);
+    }
+
+    void addRow( const Row& row ) override
+    {
+        for( auto& e: row ) {
+            bin::writeUint64(m_idxBuf, e.first);
+            bin::writeDouble(m_valBuf, e.second);
+        }
+        m_indptr.push_back(m_indptr.back() + row.size());
+        if( m_idxBuf.size() >= FLUSH_SIZE ) {
+            m_out.write(m_idxBuf.data(), m_idxBuf.size());
+            m_values.write(m_valBuf.data(), m_valBuf.size());
+            m_idxBuf.clear();
+            m_valBuf.clear();
+        }
+    }
+
+    bool close() override
+    {
+        m_out.write(m_idxBuf.data(), m_idxBuf.size());
+        m_values.write(m_valBuf.data(), m_valBuf.size());
+        m_idxBuf.clear();
+        m_valBuf.clear();
+        bool ok = bool(m_values);
+        m_values.close();
+
+        uint64_t nnz = m_indptr.back();
+        if( ok && nnz > 0 ) {
+            std::ifstream in(m_valPath, std::ios::binary);
+            m_out << in.rdbuf();
+        }
+        std::remove(m_valPath.c_str());
+
+        for( auto p: m_indptr ) {
+            bin::writeUint64(m_idxBuf, p);
+            if( m_idxBuf.size() >= FLUSH_SIZE ) {
+                m_out.write(m_idxBuf.data(), m_idxBuf.size());
+                m_idxBuf.clear();
+            }
+        }
+        bin::writeUint64(m_idxBuf, nnz);
+        m_out.write(m_idxBuf.data(), m_idxBuf.size() - 8);
+        m_out.seekp(CSR_NNZ_OFFSET);
+        m_out.write(m_idxBuf.data() + m_idxBuf.size() - 8, 8);
+        m_idxBuf.clear();
+        ok = ok && bool(m_out);
+        m_out.close();
+        return ok;
+    }
+
+private:
+    std::ofstream m_out;
+    std::ofstream m_values;
+    std::string m_valPath;
+    std::string m_idxBuf;
+    std::string m_valBuf;
+    std::vector<uint64_t> m_indptr;
+};
+
+// Nodes of a layer sorted by oid and their row index
+struct LayerIndex
+{
+    std::vector<oid_t> ids;
+    std::unordered_map<oid_t, size_t> index;
+};
+
+bool loadLayer( MLGDao& dao, const Layer& layer, LayerIndex& out )
+{
+    out.ids.clear();
+    out.index.clear();
+    ObjectsPtr nodes(dao.getAllNodeIds(layer));
+    if( !nodes )
+        return false;
+    out.ids.reserve(nodes->Count());
+    ObjectsIt it(nodes->Iterator());
+    while( it->HasNext() )
+        out.ids.push_back(it->Next());
+    std::sort(out.ids.begin(), out.ids.end());
+    out.index.reserve(out.ids.size());
+    for( size_t i = 0; i < out.ids.size(); ++i )
+        out.index[out.ids[i]] = i;
+    return true;
+}
+
+bool writeIds( const std::string& path, const LayerIndex& layer )
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if( !out )
+        return false;
+    std::string buf;
+    for( auto nid: layer.ids ) {
+        buf += std::to_string(nid);
+        buf += '\n';
+        if( buf.size() >= FLUSH_SIZE ) {
+            out.write(buf.data(), buf.size());
+            buf.clear();
+        }
+    }
+    out.write(buf.data(), buf.size());
+    return bool(out);
+}
+
+/**
+ * @brief Write the links of type eType from the row nodes to the column nodes,
+ * links to nodes outside of the columns are skipped
+ */
+bool writeLinks( Graph* g, MatrixWriter& writer, const std::string& path,
+                 const LayerIndex& rows, const LayerIndex& cols,
+                 type_t eType, const std::wstring& weightAttr, double defWeight,
+                 EdgesDirection dir, bool symmetric )
+{
+    std::string file(path + writer.extension());
+    if( !writer.open(file, rows.ids.size(), cols.ids.size(), symmetric) ) {
+        LOG(logERROR) << "MatrixExporter cannot open file " << file;
+        return false;
+    }
+
+    attr_t wAttr = g->FindAttribute(eType, weightAttr);
+    Row row;
+    Value v;
+    for( auto nid: rows.ids ) {
+        row.clear();
+        ObjectsPtr links(g->Explode(nid, eType, dir));
+        ObjectsIt it(links->Iterator());
+        while( it->HasNext() ) {
+            oid_t eid = it->Next();
+            auto peer = cols.index.find(g->GetEdgePeer(eid, nid));
+            if( peer == cols.index.end() )
+                continue;
+            g->GetAttribute(eid, wAttr, v);
+            row.emplace_back(peer->second, v.IsNull() ? defWeight : v.GetDouble());
+        }
+        std::sort(row.begin(), row.end());
+        writer.addRow(row);
+    }
+
+    if( !writer.close() ) {
+        LOG(logERROR) << "MatrixExporter error writing " << file;
+        return false;
+    }
+    LOG(logINFO) << "Wrote: " << file;
+    return true;
+}
+
+} // end namespace anonymous
+
+bool MatrixExporter::toSparseMatrices( Graph* g, const std::string& name, std::string& exportFolderPath,
+                                       Format format, size_t firstLayer, size_t lastLayer )
+{
+    std::unique_ptr<Timer> t(new Timer("Exporting sparse matrices"));
+    if( !ba::ends_with(exportFolderPath, "/") ) {
+        exportFolderPath.append("/");
+    }
+
+    MLGDao dao(g);
+    auto layers(dao.getAllLayers()); // Get layers ordered bot to top
+    if( layers.empty() ) {
+        LOG(logERROR) << "MatrixExporter::toSparseMatrices no layer in graph";
+        return false;
+    }
+    lastLayer = std::min(lastLayer, layers.size() - 1);
+    if( firstLayer > lastLayer ) {
+        LOG(logERROR) << "MatrixExporter::toSparseMatrices invalid layer range "
+                      << firstLayer << " " << lastLayer;
+        return false;
+    }
+
+    std::unique_ptr<MatrixWriter> writer;
+    if( format == BINARY_CSR )
+        writer.reset(new CSRWriter);
+    else
+        writer.reset(new MatrixMarketWriter);
+
+    const std::string prefix(exportFolderPath + name);
+    type_t hType = dao.hlinkType();
+    type_t vType = dao.vlinkType();
+    LayerIndex fine;
+    LayerIndex coarse;
+    if( !loadLayer(dao, layers[firstLayer], fine) ) {
+        LOG(logERROR) << "MatrixExporter::toSparseMatrices cannot read layer " << firstLayer;
+        return false;
+    }
+
+    for( size_t k = firstLayer; k <= lastLayer; ++k ) {
+        const std::string suffix(std::to_string(k));
+        if( !writeIds(prefix + "_L" + suffix + ".ids", fine) ) {
+            LOG(logERROR) << "MatrixExporter::toSparseMatrices cannot write ids of layer " << k;
+            return false;
+        }
+        if( !writeLinks(g, *writer, prefix + "_L" + suffix, fine, fine, hType,
+                        Attrs::V[HLinkAttr::WEIGHT], HLINK_DEF_VALUE, Outgoing, true) ) {
+            return false;
+        }
+        if( k == lastLayer )
+            break;
+
+        if( !loadLayer(dao, layers[k + 1], coarse) ) {
+            LOG(logERROR) << "MatrixExporter::toSparseMatrices cannot read layer " << k + 1;
+            return false;
+        }
+        // VLinks go from the child to the parent node
+        if( !writeLinks(g, *writer, prefix + "_R" + suffix, coarse, fine, vType,
+                        Attrs::V[VLinkAttr::WEIGHT], VLINK_DEF_VALUE, Ingoing, false) ) {
+            return false;
+        }
+        if( !writeLinks(g, *writer, prefix + "_P" + suffix, fine, coarse, vType,
+                        Attrs::V[VLinkAttr::WEIGHT], VLINK_DEF_VALUE, Outgoing, false) ) {
+            return false;
+        }
+        std::swap(fine, coarse);
+    }
+    return true;
+}
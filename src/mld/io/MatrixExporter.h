@@ -0,0 +1,77 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_MATRIXEXPORTER_H
+#define MLD_MATRIXEXPORTER_H
+
+#include <string>
+#include <sparksee/gdb/Graph.h>
+
+#include "mld/common.h"
+
+namespace mld {
+
+class MLGDao;
+
+/**
+ * @brief Export the layers of the multilevel graph as sparse matrices.
+ * Layers are numbered from the bottom layer (0) to the top layer, rows and
+ * columns of a layer are its nodes sorted by oid. For a layer k the exporter writes:
+ *  - name_L<k>: weighted adjacency of the HLinks (nodes x nodes)
+ *  - name_L<k>.ids: oid of each row, one per line
+ * and for each pair of consecutive layers k, k+1 in the range:
+ *  - name_R<k>: restriction from layer k to k+1, VLink weights (parents x children)
+ *  - name_P<k>: prolongation from layer k+1 to k, its transpose (children x parents)
+ * Rows are streamed one node at a time, links are never loaded as a whole.
+ */
+class MLD_API MatrixExporter
+{
+public:
+    enum Format {
+        /**
+         * Matrix Market coordinate real, 1-based. Adjacency matrices are
+         * "symmetric" (lower triangle only), operators are "general". Extension .mtx
+         */
+        MATRIX_MARKET,
+        /**
+         * Raw little endian CSR, extension .csr. 32 bytes header: "MLDC", version byte,
+         * index bits byte (64), value bits byte (64), reserved byte, rows, cols, nnz (uint64).
+         * Then indices (uint64 x nnz), values (float64 x nnz) and indptr (uint64 x rows+1).
+         * Adjacency matrices are stored in full
+         */
+        BINARY_CSR
+    };
+
+    /**
+     * @brief Export a range of layers and the maps between them
+     * @param g Graph
+     * @param name Prefix of the output files
+     * @param exportFolderPath Output directory
+     * @param format Output format
+     * @param firstLayer Index of the first layer from the bottom
+     * @param lastLayer Index of the last layer (included), clamped to the top layer
+     * @return success
+     */
+    static bool toSparseMatrices( sparksee::gdb::Graph* g, const std::string& name,
+                                  std::string& exportFolderPath, Format format=MATRIX_MARKET,
+                                  size_t firstLayer=0, size_t lastLayer=INVALID_INDEX );
+};
+
+} // end namespace mld
+
+#endif // MLD_MATRIXEXPORTER_H
@@ -0,0 +1,210 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <string>
+#include <boost/algorithm/string.hpp>
+#include <sparksee/gdb/Objects.h>
+#include <sparksee/gdb/ObjectsIterator.h>
+#include <sparksee/gdb/Session.h>
+
+#include "mld/io/StreamImporter.h"
+#include "mld/dao/MLGDao.h"
+#include "mld/operator/TSOperator.h"
+#include "mld/operator/filter/AbstractTimeVertexFilter.h"
+#include "mld/utils/Timer.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+namespace ba = boost::algorithm;
+
+StreamImporter::StreamImporter( Graph* g )
+    : m_dao(new MLGDao(g))
+    , m_op(new TSOperator(g))
+    , m_hasFilter(false)
+    , m_dir(TSDirection::BOTH)
+    , m_radius(0)
+    , m_firstPending(Objects::InvalidOID)
+    , m_pending(0)
+{
+    m_op->setRawAttribute(L"raw_weight");
+    // Batches only read their new layers
+    m_op->setKeepState(true);
+}
+
+StreamImporter::~StreamImporter()
+{
+}
+
+void StreamImporter::setFilter( AbstractTimeVertexFilter* filter )
+{
+    m_hasFilter = filter != nullptr;
+    if( filter ) {
+        m_dir = filter->direction();
+        m_radius = filter->radius();
+    }
+    m_op->setFilter(filter);
+    m_op->clearState();
+}
+
+void StreamImporter::setRawAttribute( const std::wstring& attr )
+{
+    m_op->setRawAttribute(attr);
+    m_op->clearState();
+}
+
+const std::wstring& StreamImporter::rawAttribute() const
+{
+    return m_op->rawAttribute();
+}
+
+bool StreamImporter::loadNodes()
+{
+    ObjectsPtr nodes(m_dao->getAllNodeIds(m_dao->baseLayer()));
+    if( !nodes || nodes->Count() == 0 ) {
+        LOG(logERROR) << "StreamImporter::loadNodes empty base layer";
+        return false;
+    }
+    m_nodes.clear();
+    m_nodes.reserve(nodes->Count());
+    ObjectsIt it(nodes->Iterator()); // sorted by oid
+    while( it->HasNext() )
+        m_nodes.push_back(it->Next());
+    return true;
+}
+
+bool StreamImporter::appendTimeStep( const std::vector<double>& values )
+{
+    if( m_nodes.empty() && !loadNodes() )
+        return false;
+    if( values.size() != m_nodes.size() ) {
+        LOG(logERROR) << "StreamImporter::appendTimeStep expected " << m_nodes.size()
+                      << " values, got " << values.size();
+        return false;
+    }
+
+    Layer layer(m_dao->addLayerOnTop());
+    if( layer.id() == Objects::InvalidOID ) {
+        LOG(logERROR) << "StreamImporter::appendTimeStep cannot add layer";
+        return false;
+    }
+    if( !m_dao->addOLinks(layer.id(), m_nodes, values) ) {
+        // Otherwise the layer is commited with the batch, drop it with its OLinks
+        // but not the base nodes, unlike removeTopLayer
+        m_dao->graph()->Drop(layer.id());
+        LOG(logERROR) << "StreamImporter::appendTimeStep cannot add OLinks, layer removed";
+        return false;
+    }
+
+    if( m_pending == 0 )
+        m_firstPending = layer.id();
+    ++m_pending;
+    return true;
+}
+
+bool StreamImporter::appendTimeStep( const std::string& line )
+{
+    std::vector<std::string> tokens;
+    ba::split(tokens, line, ba::is_any_of(","));
+    std::vector<double> values;
+    values.reserve(tokens.size());
+    try {
+        for( auto& tok: tokens ) {
+            ba::erase_all(tok, "\"");
+            ba::trim_if(tok, ba::is_any_of(" \t\r#"));
+            values.push_back(std::stod(tok));
+        }
+    } catch( std::exception& e ) {
+        LOG(logERROR) << "StreamImporter::appendTimeStep invalid row: " << line;
+        return false;
+    }
+    return appendTimeStep(values);
+}
+
+bool StreamImporter::refilter()
+{
+    if( m_pending == 0 || !m_hasFilter ) {
+        m_pending = 0;
+        return true;
+    }
+
+    std::unique_ptr<Timer> t(new Timer("StreamImporter::refilter"));
+    // Previous layers only see the new time steps in the future part of their window
+    oid_t first = m_firstPending;
+    if( m_dir != TSDirection::PAST ) {
+        for( size_t i = 0; i < m_radius; ++i ) {
+            oid_t child = m_dao->child(first);
+            if( child == Objects::InvalidOID )
+                break;
+            first = child;
+        }
+    }
+
+    m_op->setLayerRange(first, m_dao->topLayer().id());
+    bool ok = m_op->run();
+    m_op->clearLayerRange();
+    if( !ok ) {
+        LOG(logERROR) << "StreamImporter::refilter failed";
+        return false;
+    }
+    m_pending = 0;
+    m_firstPending = Objects::InvalidOID;
+    return true;
+}
+
+bool StreamImporter::fromStream( std::istream& in, size_t& count, Session* sess, size_t batchSize )
+{
+    if( batchSize == 0 )
+        batchSize = 1;
+
+    count = 0;
+    size_t batch = 0;
+    bool ok = true;
+    std::string line;
+    if( sess )
+        sess->Begin();
+    while( std::getline(in, line) ) {
+        ba::trim(line);
+        if( line.empty() || line[0] == '#' )
+            continue;
+        if( !appendTimeStep(line) ) {
+            ok = false;
+            break;
+        }
+        ++count;
+        if( ++batch == batchSize ) {
+            batch = 0;
+            if( !refilter() ) {
+                ok = false;
+                break;
+            }
+            if( sess ) { // Publish the batch
+                sess->Commit();
+                sess->Begin();
+            }
+            LOG(logINFO) << "Time steps appended: " << count;
+        }
+    }
+    // No layer is commited unfiltered, even after an invalid row
+    if( m_pending > 0 && !refilter() ) {
+        LOG(logERROR) << "StreamImporter::fromStream " << m_pending << " time steps left unfiltered";
+        ok = false;
+    }
+    if( sess )
+        sess->Commit();
+    return ok;
+}
@@ -0,0 +1,123 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_STREAMIMPORTER_H
+#define MLD_STREAMIMPORTER_H
+
+#include <istream>
+#include <sparksee/gdb/Graph.h>
+
+#include "mld/common.h"
+
+namespace sparksee {
+namespace gdb {
+    class Session;
+}}
+
+namespace mld {
+
+class MLGDao;
+class TSOperator;
+class AbstractTimeVertexFilter;
+
+/**
+ * @brief Append new time steps on top of an imported timeseries graph
+ * and incrementally refilter the layers whose time window contains them.
+ * A time step is a CSV row with one value per base layer node, nodes are
+ * ordered by id which is the row order of the imported *.nodes.csv file.
+ * Refiltering reads the unfiltered values kept in an OLink raw attribute
+ * (see TSOperator::setRawAttribute), so the result is the one of a batch filtering
+ * of all the time steps. A database filtered before streaming must have been filtered
+ * with the same raw attribute, otherwise its filtered weights are taken as raw.
+ * The base layer snapshot and the raw values of the last refiltered layers are kept
+ * between refilters (see TSOperator::setKeepState), the HLinks must not be updated
+ * while streaming.
+ */
+class MLD_API StreamImporter
+{
+public:
+    StreamImporter( sparksee::gdb::Graph* g );
+    ~StreamImporter();
+
+    /**
+     * @brief Set filter used to refilter new time steps and TAKE OWNERSHIP of it.
+     * Without filter, time steps are only appended. The filter has to be configured
+     * prior to this call.
+     * @param filter
+     */
+    void setFilter( AbstractTimeVertexFilter* filter );
+
+    /**
+     * @brief Set the OLink attribute keeping the unfiltered values, default is "raw_weight"
+     * @param attr
+     */
+    void setRawAttribute( const std::wstring& attr );
+    const std::wstring& rawAttribute() const;
+
+    /**
+     * @brief Append a new layer on top with the OLink weights of all the nodes
+     * @param values One value per base layer node
+     * @return success
+     */
+    bool appendTimeStep( const std::vector<double>& values );
+    /**
+     * @brief Parse a comma separated row and append it as a new time step
+     * @param line CSV row
+     * @return success
+     */
+    bool appendTimeStep( const std::string& line );
+
+    /**
+     * @brief Refilter the layers whose time window contains a time step
+     * appended since the last refilter. The last radius layers and the new ones
+     * are refiltered for BOTH and FUTURE directions, only the new ones for PAST.
+     * @return success
+     */
+    bool refilter();
+
+    /**
+     * @brief Read time steps until the end of the stream or the first invalid row.
+     * The time steps appended before an invalid row are refiltered before being commited.
+     * @param in Input stream, ex: std::cin or a file tail
+     * @param count Number of time steps appended
+     * @param sess If not null, each batch is appended and refiltered in its own transaction
+     * @param batchSize Number of time steps appended before refiltering
+     * @return success, false on an invalid row or if refiltering failed
+     */
+    bool fromStream( std::istream& in, size_t& count, sparksee::gdb::Session* sess=nullptr,
+                     size_t batchSize=1 );
+
+    inline size_t pendingSteps() const { return m_pending; }
+
+private:
+    bool loadNodes();
+
+private:
+    std::unique_ptr<MLGDao> m_dao;
+    std::unique_ptr<TSOperator> m_op;
+    bool m_hasFilter;
+    TSDirection m_dir;
+    size_t m_radius;
+    std::vector<sparksee::gdb::oid_t> m_nodes; // base layer nodes sorted by id
+    sparksee::gdb::oid_t m_firstPending;  // first layer not filtered yet
+    size_t m_pending;
+};
+
+} // end namespace mld
+
+#endif // MLD_STREAMIMPORTER_H
@@ -0,0 +1,186 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <sparksee/gdb/Objects.h>
+
+#include "mld/model/AncestryIndex.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+AncestryIndex::AncestryIndex()
+{
+}
+
+void AncestryIndex::clear()
+{
+    m_levels.clear();
+    m_pos.clear();
+}
+
+bool AncestryIndex::addLayer( oid_t lid, const std::vector<oid_t>& nodes, const std::vector<size_t>& parents )
+{
+    const size_t top = m_levels.size();
+    if( level(lid) != INVALID_INDEX ) {
+        LOG(logERROR) << "AncestryIndex::addLayer layer already indexed: " << lid;
+        return false;
+    }
+    if( top > 0 ) {
+        if( parents.size() != m_levels.back().nodes.size() ) {
+            LOG(logERROR) << "AncestryIndex::addLayer one parent per node of the top layer expected";
+            return false;
+        }
+        for( auto p: parents ) {
+            if( p != INVALID_INDEX && p >= nodes.size() ) {
+                LOG(logERROR) << "AncestryIndex::addLayer invalid parent index: " << p;
+                return false;
+            }
+        }
+    }
+    for( size_t i = 0; i < nodes.size(); ++i ) {
+        if( !m_pos.insert(std::make_pair(nodes[i], Position{ top, i })).second ) {
+            LOG(logERROR) << "AncestryIndex::addLayer node already indexed: " << nodes[i];
+            // Roll back the nodes of the layer
+            for( size_t k = 0; k < i; ++k )
+                m_pos.erase(nodes[k]);
+            return false;
+        }
+    }
+
+    m_levels.push_back(Level{ lid, nodes, std::vector<std::vector<size_t>>() });
+    if( top == 0 )
+        return true;
+
+    // Level top - 2^j gets its 2^j-th ancestors, through level top - 2^(j-1)
+    m_levels[top - 1].up.push_back(parents);
+    for( size_t step = 2, j = 1; step <= top; step *= 2, ++j ) {
+        Level& l = m_levels[top - step];
+        const Level& mid = m_levels[top - step / 2];
+        std::vector<size_t> up(l.nodes.size(), INVALID_INDEX);
+        for( size_t i = 0; i < up.size(); ++i ) {
+            const size_t a = l.up[j - 1][i];
+            if( a != INVALID_INDEX )
+                up[i] = mid.up[j - 1][a];
+        }
+        l.up.push_back(std::move(up));
+    }
+    return true;
+}
+
+size_t AncestryIndex::level( oid_t lid ) const
+{
+    for( size_t k = 0; k < m_levels.size(); ++k ) {
+        if( m_levels[k].lid == lid )
+            return k;
+    }
+    return INVALID_INDEX;
+}
+
+size_t AncestryIndex::nodeLevel( oid_t nid ) const
+{
+    auto it = m_pos.find(nid);
+    return it == m_pos.end() ? INVALID_INDEX : it->second.level;
+}
+
+oid_t AncestryIndex::layerOf( oid_t nid ) const
+{
+    auto it = m_pos.find(nid);
+    return it == m_pos.end() ? Objects::InvalidOID : m_levels[it->second.level].lid;
+}
+
+oid_t AncestryIndex::parent( oid_t nid ) const
+{
+    auto it = m_pos.find(nid);
+    if( it == m_pos.end() || it->second.level + 1 >= m_levels.size() )
+        return Objects::InvalidOID;
+    const Level& l = m_levels[it->second.level];
+    const size_t p = l.up[0][it->second.index];
+    return p == INVALID_INDEX ? Objects::InvalidOID : m_levels[it->second.level + 1].nodes[p];
+}
+
+oid_t AncestryIndex::ancestor( oid_t nid, size_t level ) const
+{
+    auto it = m_pos.find(nid);
+    if( it == m_pos.end() || level < it->second.level || level >= m_levels.size() )
+        return Objects::InvalidOID;
+    const size_t idx = jump(it->second.level, it->second.index, level - it->second.level);
+    return idx == INVALID_INDEX ? Objects::InvalidOID : m_levels[level].nodes[idx];
+}
+
+size_t AncestryIndex::mergeLevel( oid_t a, oid_t b ) const
+{
+    return merge(a, b).level;
+}
+
+oid_t AncestryIndex::commonAncestor( oid_t a, oid_t b ) const
+{
+    Position p(merge(a, b));
+    return p.level == INVALID_INDEX ? Objects::InvalidOID : m_levels[p.level].nodes[p.index];
+}
+
+size_t AncestryIndex::jump( size_t level, size_t index, size_t steps ) const
+{
+    for( size_t j = 0; steps != 0 && index != INVALID_INDEX; ++j, steps >>= 1 ) {
+        if( steps & 1 ) {
+            index = m_levels[level].up[j][index];
+            level += size_t(1) << j;
+        }
+    }
+    return index;
+}
+
+AncestryIndex::Position AncestryIndex::merge( oid_t a, oid_t b ) const
+{
+    const Position none{ INVALID_INDEX, INVALID_INDEX };
+    auto ita = m_pos.find(a);
+    auto itb = m_pos.find(b);
+    if( ita == m_pos.end() || itb == m_pos.end() )
+        return none;
+
+    // Start on the same level
+    size_t level = std::max(ita->second.level, itb->second.level);
+    size_t ia = jump(ita->second.level, ita->second.index, level - ita->second.level);
+    size_t ib = jump(itb->second.level, itb->second.index, level - itb->second.level);
+    if( ia == INVALID_INDEX || ib == INVALID_INDEX )
+        return none;
+    if( ia == ib )
+        return Position{ level, ia };
+
+    // Highest level where the ancestors are still distinct, chains without parent stop
+    const size_t top = m_levels.size() - 1;
+    size_t j = 0;
+    while( (size_t(2) << j) <= top - level )
+        ++j;
+    for( size_t k = j + 1; k-- > 0; ) {
+        if( level + (size_t(1) << k) > top )
+            continue;
+        const size_t x = m_levels[level].up[k][ia];
+        const size_t y = m_levels[level].up[k][ib];
+        if( x != INVALID_INDEX && y != INVALID_INDEX && x != y ) {
+            ia = x;
+            ib = y;
+            level += size_t(1) << k;
+        }
+    }
+    if( level == top )
+        return none;
+    const size_t x = m_levels[level].up[0][ia];
+    if( x == INVALID_INDEX || x != m_levels[level].up[0][ib] )
+        return none;
+    return Position{ level + 1, x };
+}
@@ -0,0 +1,135 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_ANCESTRYINDEX_H
+#define MLD_ANCESTRYINDEX_H
+
+#include <vector>
+#include <unordered_map>
+#include <sparksee/gdb/Graph_data.h>
+
+#include "mld/common.h"
+
+namespace mld {
+
+/**
+ * @brief In-memory index of the VLink hierarchy of the layers.
+ * Levels are the layers from the bottom (level 0) to the top, each node has at most
+ * one parent on the level above. Besides the parent array of each level, jump
+ * tables give the 2^j-th ancestor of each node (binary lifting), so ancestor and
+ * merge queries cost O(log L) for L levels.
+ * Layers are appended on top, only the jump tables reaching the new layer are computed.
+ */
+class MLD_API AncestryIndex
+{
+public:
+    AncestryIndex();
+
+    void clear();
+
+    /**
+     * @brief Append a layer on top of the indexed ones
+     * @param lid Layer id
+     * @param nodes Node ids of the layer
+     * @param parents For each node of the current top layer, index of its parent in nodes
+     * or INVALID_INDEX. Ignored for the first layer
+     * @return false if the sizes, the parents or the node ids are invalid
+     */
+    bool addLayer( sparksee::gdb::oid_t lid, const std::vector<sparksee::gdb::oid_t>& nodes,
+                   const std::vector<size_t>& parents );
+
+    inline size_t levelCount() const { return m_levels.size(); }
+    inline bool empty() const { return m_levels.empty(); }
+    inline size_t nodeCount() const { return m_pos.size(); }
+    inline sparksee::gdb::oid_t layerId( size_t level ) const { return m_levels[level].lid; }
+    inline const std::vector<sparksee::gdb::oid_t>& nodes( size_t level ) const { return m_levels[level].nodes; }
+    /**
+     * @brief Level of a layer
+     * @param lid Layer id
+     * @return level or INVALID_INDEX if the layer is not indexed
+     */
+    size_t level( sparksee::gdb::oid_t lid ) const;
+
+    /**
+     * @brief Level of a node
+     * @param nid Node id
+     * @return level or INVALID_INDEX if the node is not indexed
+     */
+    size_t nodeLevel( sparksee::gdb::oid_t nid ) const;
+    /**
+     * @brief Layer of a node
+     * @param nid Node id
+     * @return layer id or InvalidOID if the node is not indexed
+     */
+    sparksee::gdb::oid_t layerOf( sparksee::gdb::oid_t nid ) const;
+    /**
+     * @brief Parent of a node
+     * @param nid Node id
+     * @return parent id or InvalidOID if the node has no parent
+     */
+    sparksee::gdb::oid_t parent( sparksee::gdb::oid_t nid ) const;
+    /**
+     * @brief Ancestor of a node on a level above, the node itself on its own level
+     * @param nid Node id
+     * @param level Level of the ancestor
+     * @return ancestor id or InvalidOID if there is none
+     */
+    sparksee::gdb::oid_t ancestor( sparksee::gdb::oid_t nid, size_t level ) const;
+    /**
+     * @brief Lowest level where the ancestors of 2 nodes are the same node
+     * @param a Node id
+     * @param b Node id
+     * @return level or INVALID_INDEX if they never merge
+     */
+    size_t mergeLevel( sparksee::gdb::oid_t a, sparksee::gdb::oid_t b ) const;
+    /**
+     * @brief Node where 2 nodes merge, at mergeLevel(a, b)
+     * @return node id or InvalidOID if they never merge
+     */
+    sparksee::gdb::oid_t commonAncestor( sparksee::gdb::oid_t a, sparksee::gdb::oid_t b ) const;
+
+private:
+    struct Level {
+        sparksee::gdb::oid_t lid;
+        std::vector<sparksee::gdb::oid_t> nodes;
+        // up[j][i] is the index of the ancestor of node i on level + 2^j
+        std::vector<std::vector<size_t>> up;
+    };
+    struct Position {
+        size_t level;
+        size_t index;
+    };
+
+    /**
+     * @brief Ancestor index steps levels above, level + steps must be indexed
+     * @return index or INVALID_INDEX
+     */
+    size_t jump( size_t level, size_t index, size_t steps ) const;
+    /**
+     * @brief Merge level and index of the merge node on that level
+     */
+    Position merge( sparksee::gdb::oid_t a, sparksee::gdb::oid_t b ) const;
+
+private:
+    std::vector<Level> m_levels;
+    std::unordered_map<sparksee::gdb::oid_t, Position> m_pos;
+};
+
+} // end namespace mld
+
+#endif // MLD_ANCESTRYINDEX_H
@@ -0,0 +1,121 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include "mld/model/CSRMatrix.h"
+#include "mld/model/GraphSnapshot.h"
+
+using namespace mld;
+
+CSRMatrix::CSRMatrix()
+    : n(0)
+    , offsets(1, 0)
+{
+}
+
+CSRMatrix CSRMatrix::laplacian( const GraphSnapshot& graph, double shift )
+{
+    // A = D - W + shift I, self loops do not contribute to the Laplacian
+    CSRMatrix a;
+    a.n = graph.nodeCount();
+    a.diag.assign(a.n, shift);
+    for( size_t i = 0; i < a.n; ++i ) {
+        for( size_t e = graph.neighborBegin(i); e != graph.neighborEnd(i); ++e ) {
+            const size_t j = graph.targets()[e];
+            if( j == i )
+                continue;
+            const double w = graph.weights()[e];
+            a.diag[i] += w;
+            a.cols.push_back(j);
+            a.vals.push_back(-w);
+        }
+        a.offsets.push_back(a.cols.size());
+    }
+    return a;
+}
+
+CSRMatrix CSRMatrix::adjacency( const GraphSnapshot& graph )
+{
+    CSRMatrix a;
+    a.n = graph.nodeCount();
+    a.diag.assign(a.n, 0.0);
+    for( size_t i = 0; i < a.n; ++i ) {
+        for( size_t e = graph.neighborBegin(i); e != graph.neighborEnd(i); ++e ) {
+            const size_t j = graph.targets()[e];
+            if( j == i )
+                continue;
+            a.cols.push_back(j);
+            a.vals.push_back(graph.weights()[e]);
+        }
+        a.offsets.push_back(a.cols.size());
+    }
+    return a;
+}
+
+CSRMatrix CSRMatrix::galerkin( const CSRMatrix& fine, const TransferMap& map,
+                               Aggregation mode, bool keepDiagonal )
+{
+    const bool weighted = mode == WEIGHTED;
+    CSRMatrix c;
+    c.n = map.coarseCount();
+    c.diag.assign(c.n, 0.0);
+    // Position of the coarse column in the row being built
+    std::vector<size_t> marker(c.n, INVALID_INDEX);
+    for( size_t p = 0; p < c.n; ++p ) {
+        const size_t rowStart = c.cols.size();
+        for( size_t e = map.childBegin(p); e != map.childEnd(p); ++e ) {
+            const size_t ch = map.children()[e];
+            const double wc = weighted ? map.childWeights()[e] : 1.0;
+            if( keepDiagonal )
+                c.diag[p] += wc * wc * fine.diag[ch];
+            for( size_t k = fine.offsets[ch]; k != fine.offsets[ch + 1]; ++k ) {
+                const size_t d = fine.cols[k];
+                const size_t q = map.parent(d);
+                if( q == INVALID_INDEX )
+                    continue;
+                const double v = weighted ? wc * fine.vals[k] * map.weight(d) : fine.vals[k];
+                if( q == p ) {
+                    if( keepDiagonal )
+                        c.diag[p] += v;
+                }
+                else if( marker[q] == INVALID_INDEX || marker[q] < rowStart ) {
+                    marker[q] = c.cols.size();
+                    c.cols.push_back(q);
+                    c.vals.push_back(v);
+                }
+                else {
+                    c.vals[marker[q]] += v;
+                }
+            }
+        }
+        // Parent without children, decoupled from the system
+        if( keepDiagonal && map.childBegin(p) == map.childEnd(p) )
+            c.diag[p] = 1.0;
+        c.offsets.push_back(c.cols.size());
+    }
+    return c;
+}
+
+void CSRMatrix::multiply( const double* x, double* y ) const
+{
+    for( size_t i = 0; i < n; ++i ) {
+        double acc = diag[i] * x[i];
+        for( size_t k = offsets[i]; k != offsets[i + 1]; ++k )
+            acc += vals[k] * x[cols[k]];
+        y[i] = acc;
+    }
+}
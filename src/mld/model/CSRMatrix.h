@@ -0,0 +1,95 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_CSRMATRIX_H
+#define MLD_CSRMATRIX_H
+
+#include <vector>
+
+#include "mld/common.h"
+#include "mld/model/TransferMap.h"
+
+namespace mld {
+
+class GraphSnapshot;
+
+/**
+ * @brief Square sparse matrix of a level of the multilevel operators, indexed as the
+ * GraphSnapshot nodes. The diagonal is stored apart, the off diagonal entries of row i
+ * are [offsets[i], offsets[i + 1]) of cols and vals.
+ * Coarse levels are built from the fine ones through the TransferMap of the VLinks.
+ */
+struct MLD_API CSRMatrix
+{
+    enum Aggregation {
+        WEIGHTED,   // P holds the VLink weights, x_c = w_c x_p
+        UNIT        // P holds ones, coarse entries are the sums of the fine ones
+    };
+
+    CSRMatrix();
+
+    /**
+     * @brief Build L + shift I, L is the combinatorial Laplacian of the graph.
+     * Self loops do not contribute to the Laplacian
+     * @param graph
+     * @param shift
+     * @return matrix
+     */
+    static CSRMatrix laplacian( const GraphSnapshot& graph, double shift=0.0 );
+    /**
+     * @brief Build the adjacency matrix of the graph without self loops, the diagonal is null
+     * @param graph
+     * @return matrix
+     */
+    static CSRMatrix adjacency( const GraphSnapshot& graph );
+    /**
+     * @brief Galerkin product P^T A P, P is the prolongation of the transfer map.
+     * A coarse node without children is decoupled with a unit diagonal
+     * @param fine Fine matrix A
+     * @param map Transfer map from the fine to the coarse nodes
+     * @param mode Weights of P
+     * @param keepDiagonal If false the diagonal is not computed and the entries
+     * between children of a same parent are dropped
+     * @return coarse matrix
+     */
+    static CSRMatrix galerkin( const CSRMatrix& fine, const TransferMap& map,
+                               Aggregation mode=WEIGHTED, bool keepDiagonal=true );
+
+    /**
+     * @brief y = A x
+     */
+    void multiply( const double* x, double* y ) const;
+
+    size_t n;
+    std::vector<double> diag;
+    std::vector<size_t> offsets;
+    std::vector<size_t> cols;
+    std::vector<double> vals;
+};
+
+inline double dot( const std::vector<double>& a, const std::vector<double>& b )
+{
+    double res = 0.0;
+    for( size_t i = 0; i < a.size(); ++i )
+        res += a[i] * b[i];
+    return res;
+}
+
+} // end namespace mld
+
+#endif // MLD_CSRMATRIX_H
@@ -0,0 +1,89 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include "mld/model/GraphSnapshot.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+GraphSnapshot::GraphSnapshot()
+    : m_offsets(1, 0)
+{
+}
+
+void GraphSnapshot::reset( const std::vector<oid_t>& nodes )
+{
+    clear();
+    m_nodes = nodes;
+    m_index.reserve(m_nodes.size());
+    for( size_t i = 0; i < m_nodes.size(); ++i )
+        m_index.emplace(m_nodes[i], i);
+    m_offsets.reserve(m_nodes.size() + 1);
+}
+
+void GraphSnapshot::addNeighbor( size_t target, double weight )
+{
+    m_targets.push_back(target);
+    m_weights.push_back(weight);
+}
+
+void GraphSnapshot::finishNode()
+{
+#ifdef MLD_SAFE
+    if( m_offsets.size() > m_nodes.size() ) {
+        LOG(logERROR) << "GraphSnapshot::finishNode all nodes are already filled";
+        return;
+    }
+#endif
+    m_offsets.push_back(m_targets.size());
+}
+
+void GraphSnapshot::clear()
+{
+    m_nodes.clear();
+    m_index.clear();
+    m_offsets.assign(1, 0);
+    m_targets.clear();
+    m_weights.clear();
+}
+
+size_t GraphSnapshot::index( oid_t nid ) const
+{
+    auto it = m_index.find(nid);
+    if( it == m_index.end() )
+        return INVALID_INDEX;
+    return it->second;
+}
+
+void GraphSnapshot::laplacian( const double* x, double* y, size_t blockSize ) const
+{
+    const size_t n = m_nodes.size();
+    for( size_t i = 0; i < n; ++i ) {
+        const double* xi = x + i * blockSize;
+        double* yi = y + i * blockSize;
+        for( size_t s = 0; s < blockSize; ++s )
+            yi[s] = 0.0;
+        // (Lx)_i = sum_j w_ij (x_i - x_j)
+        for( size_t e = m_offsets[i]; e != m_offsets[i + 1]; ++e ) {
+            const double w = m_weights[e];
+            const double* xj = x + m_targets[e] * blockSize;
+            for( size_t s = 0; s < blockSize; ++s )
+                yi[s] += w * (xi[s] - xj[s]);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_GRAPHSNAPSHOT_H
+#define MLD_GRAPHSNAPSHOT_H
+
+#include <vector>
+#include <unordered_map>
+#include <sparksee/gdb/Graph_data.h>
+
+#include "mld/common.h"
+
+namespace mld {
+
+/**
+ * @brief In-memory snapshot of the HLinks of a layer in compressed sparse row format.
+ * Nodes are referred to by their index, neighbors of node i are stored in
+ * [neighborBegin(i), neighborEnd(i)) of targets() and weights().
+ */
+class MLD_API GraphSnapshot
+{
+public:
+    GraphSnapshot();
+
+    /**
+     * @brief Reset the snapshot with a new set of nodes and no edges.
+     * Adjacency lists have then to be filled in node order with
+     * addNeighbor and finishNode.
+     * @param nodes Node ids, their position is their index
+     */
+    void reset( const std::vector<sparksee::gdb::oid_t>& nodes );
+    /**
+     * @brief Add a neighbor to the node being filled
+     * @param target Neighbor index
+     * @param weight HLink weight
+     */
+    void addNeighbor( size_t target, double weight );
+    /**
+     * @brief Close the adjacency list of the node being filled
+     */
+    void finishNode();
+    void clear();
+
+    inline size_t nodeCount() const { return m_nodes.size(); }
+    inline size_t edgeCount() const { return m_targets.size(); }
+    inline bool empty() const { return m_nodes.empty(); }
+
+    inline const std::vector<sparksee::gdb::oid_t>& nodes() const { return m_nodes; }
+    inline sparksee::gdb::oid_t nodeId( size_t idx ) const { return m_nodes[idx]; }
+    /**
+     * @brief Get node index
+     * @param nid Node id
+     * @return index or INVALID_INDEX if the node is not in the snapshot
+     */
+    size_t index( sparksee::gdb::oid_t nid ) const;
+
+    inline size_t neighborBegin( size_t idx ) const { return m_offsets[idx]; }
+    inline size_t neighborEnd( size_t idx ) const { return m_offsets[idx + 1]; }
+    inline size_t degree( size_t idx ) const { return m_offsets[idx + 1] - m_offsets[idx]; }
+    inline const std::vector<size_t>& targets() const { return m_targets; }
+    inline const std::vector<double>& weights() const { return m_weights; }
+
+    /**
+     * @brief Combinatorial Laplacian product y = (D - W) x on a block of signals.
+     * Blocks are stored node major, value of signal s on node i is x[i * blockSize + s]
+     * @param x Input block
+     * @param y Output block
+     * @param blockSize Number of signals
+     */
+    void laplacian( const double* x, double* y, size_t blockSize=1 ) const;
+
+private:
+    std::vector<sparksee::gdb::oid_t> m_nodes;
+    std::unordered_map<sparksee::gdb::oid_t, size_t> m_index;
+    std::vector<size_t> m_offsets;
+    std::vector<size_t> m_targets;
+    std::vector<double> m_weights;
+};
+
+} // end namespace mld
+
+#endif // MLD_GRAPHSNAPSHOT_H
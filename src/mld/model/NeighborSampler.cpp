@@ -0,0 +1,177 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <random>
+#include <algorithm>
+
+#include "mld/model/NeighborSampler.h"
+#include "mld/model/GraphSnapshot.h"
+
+using namespace mld;
+
+NeighborSampler::NeighborSampler()
+    : m_graph(nullptr)
+    , m_nodeCount(0)
+    , m_edgeCount(0)
+    , m_maxNeighbors(0)
+    , m_seed(0)
+{
+}
+
+void NeighborSampler::clear()
+{
+    m_graph = nullptr;
+    m_nodeCount = 0;
+    m_edgeCount = 0;
+    m_hubIndex.clear();
+    m_hubs.clear();
+    m_prob.clear();
+    m_alias.clear();
+}
+
+bool NeighborSampler::isBuiltFor( const GraphSnapshot& graph ) const
+{
+    return m_graph == &graph && m_nodeCount == graph.nodeCount() && m_edgeCount == graph.edgeCount();
+}
+
+void NeighborSampler::build( const GraphSnapshot& graph, size_t maxNeighbors, uint32_t seed,
+                             size_t checkCount )
+{
+    clear();
+    m_graph = &graph;
+    m_nodeCount = graph.nodeCount();
+    m_edgeCount = graph.edgeCount();
+    m_maxNeighbors = maxNeighbors;
+    m_seed = seed;
+    m_hubIndex.assign(m_nodeCount, INVALID_INDEX);
+    if( maxNeighbors == 0 )
+        return;
+
+    const auto& weights = graph.weights();
+    std::vector<double> scaled;
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for( size_t i = 0; i < m_nodeCount; ++i ) {
+        const size_t deg = graph.degree(i);
+        if( deg <= maxNeighbors )
+            continue;
+
+        // Null weights are never drawn
+        const size_t begin = graph.neighborBegin(i);
+        double total = 0.0;
+        scaled.resize(deg);
+        for( size_t k = 0; k < deg; ++k ) {
+            const size_t e = begin + k;
+            scaled[k] = weights[e] <= 0.0 ? 0.0 : weights[e];
+            total += scaled[k];
+        }
+
+        Hub hub;
+        hub.node = i;
+        hub.start = m_prob.size();
+        hub.total = total;
+        hub.check = false;
+        m_hubIndex[i] = m_hubs.size();
+        m_hubs.push_back(hub);
+        m_prob.resize(hub.start + deg, 1.0);
+        m_alias.resize(hub.start + deg);
+        if( total == 0.0 )
+            continue;
+
+        // Vose alias method
+        double* prob = &m_prob[hub.start];
+        uint32_t* alias = &m_alias[hub.start];
+        small.clear();
+        large.clear();
+        uint32_t positive = 0;
+        for( size_t k = 0; k < deg; ++k ) {
+            if( scaled[k] > 0.0 )
+                positive = uint32_t(k);
+            scaled[k] *= double(deg) / total;
+            alias[k] = uint32_t(k);
+            if( scaled[k] < 1.0 )
+                small.push_back(uint32_t(k));
+            else
+                large.push_back(uint32_t(k));
+        }
+        while( !small.empty() && !large.empty() ) {
+            uint32_t s = small.back();
+            small.pop_back();
+            uint32_t l = large.back();
+            prob[s] = scaled[s];
+            alias[s] = l;
+            scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+            if( scaled[l] < 1.0 ) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // Remaining entries are 1 up to rounding errors, never draw a null weight
+        for( auto k: large )
+            prob[k] = 1.0;
+        for( auto k: small ) {
+            prob[k] = scaled[k] > 0.0 ? 1.0 : 0.0;
+            alias[k] = positive;
+        }
+    }
+
+    // Spread the checked hubs over the whole snapshot
+    if( checkCount > 0 && !m_hubs.empty() ) {
+        size_t stride = std::max(size_t(1), m_hubs.size() / checkCount);
+        for( size_t h = 0; h < m_hubs.size(); h += stride )
+            m_hubs[h].check = true;
+    }
+}
+
+void NeighborSampler::draw( size_t idx, SampleVec& out ) const
+{
+    out.clear();
+    const Hub& hub = m_hubs[m_hubIndex[idx]];
+    if( hub.total == 0.0 )
+        return;
+
+    const size_t deg = m_graph->degree(idx);
+    const size_t begin = m_graph->neighborBegin(idx);
+    const auto& weights = m_graph->weights();
+    const auto nid = static_cast<uint64_t>(m_graph->nodeId(idx));
+    std::seed_seq seq{ m_seed, uint32_t(nid), uint32_t(nid >> 32) };
+    std::mt19937 rng(seq);
+    std::uniform_int_distribution<size_t> pick(0, deg - 1);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+    out.reserve(m_maxNeighbors);
+    const double scale = hub.total / double(m_maxNeighbors);
+    for( size_t s = 0; s < m_maxNeighbors; ++s ) {
+        size_t k = pick(rng);
+        if( coin(rng) >= m_prob[hub.start + k] )
+            k = m_alias[hub.start + k];
+        const size_t e = begin + k;
+        out.push_back(Sample(e, scale / weights[e]));
+    }
+
+    // Merge duplicates
+    std::sort(out.begin(), out.end());
+    size_t last = 0;
+    for( size_t s = 1; s < out.size(); ++s ) {
+        if( out[s].first == out[last].first )
+            out[last].second += out[s].second;
+        else
+            out[++last] = out[s];
+    }
+    out.resize(last + 1);
+}
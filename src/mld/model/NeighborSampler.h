@@ -0,0 +1,105 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_NEIGHBORSAMPLER_H
+#define MLD_NEIGHBORSAMPLER_H
+
+#include <vector>
+
+#include "mld/common.h"
+
+namespace mld {
+
+class GraphSnapshot;
+
+/**
+ * @brief Weight proportional neighbor sampling on a GraphSnapshot.
+ * An alias table is built once for each node with more neighbors than the cap (hub),
+ * a hub then draws cap neighbors in O(cap) whatever its degree.
+ */
+class MLD_API NeighborSampler
+{
+public:
+    // Edge position in the snapshot and its estimator scale
+    using Sample = std::pair<size_t, double>;
+    using SampleVec = std::vector<Sample>;
+
+    NeighborSampler();
+
+    /**
+     * @brief Build the alias tables of the hubs
+     * @param graph Snapshot, has to outlive the sampler
+     * @param maxNeighbors Number of draws per hub
+     * @param seed Random seed
+     * @param checkCount Number of hubs flagged for the approximation error report
+     */
+    void build( const GraphSnapshot& graph, size_t maxNeighbors, uint32_t seed, size_t checkCount=32 );
+    void clear();
+
+    /**
+     * @brief Check if the sampler was built on this snapshot
+     * @param graph
+     * @return built
+     */
+    bool isBuiltFor( const GraphSnapshot& graph ) const;
+
+    inline size_t maxNeighbors() const { return m_maxNeighbors; }
+    inline size_t hubCount() const { return m_hubs.size(); }
+    inline bool isHub( size_t idx ) const { return m_hubIndex[idx] != INVALID_INDEX; }
+    /**
+     * @brief Check if the hub is part of the nodes on which the
+     * approximation error is measured
+     * @param idx Node index
+     * @return checked
+     */
+    inline bool isChecked( size_t idx ) const { return isHub(idx) && m_hubs[m_hubIndex[idx]].check; }
+
+    /**
+     * @brief Draw the neighbors of a hub proportionally to their HLink weight.
+     * Draws are seeded with the seed and the node id, a hub always gets the same sample.
+     * Duplicates are merged and the samples are sorted by edge position.
+     * The sum over the samples of scale * f(edge) is an unbiased estimate of
+     * the sum of f over all the neighbors (Hansen-Hurwitz)
+     * @param idx Hub index
+     * @param out Samples
+     */
+    void draw( size_t idx, SampleVec& out ) const;
+
+private:
+    struct Hub {
+        size_t node;    // Node index
+        size_t start;   // Start of the alias table
+        double total;   // Sum of the drawable weights
+        bool check;
+    };
+
+    const GraphSnapshot* m_graph;
+    size_t m_nodeCount;
+    size_t m_edgeCount;
+    size_t m_maxNeighbors;
+    uint32_t m_seed;
+    std::vector<size_t> m_hubIndex;
+    std::vector<Hub> m_hubs;
+    // Alias tables of the hubs, one entry per neighbor
+    std::vector<double> m_prob;
+    std::vector<uint32_t> m_alias;
+};
+
+} // end namespace mld
+
+#endif // MLD_NEIGHBORSAMPLER_H
@@ -0,0 +1,242 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_RINGBUFFER_H
+#define MLD_RINGBUFFER_H
+
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+namespace mld {
+
+template <typename T> class RingBuffer;
+
+/**
+ * @brief Random access iterator on a RingBuffer, indexes are logical
+ * positions from the front of the buffer
+ */
+template <typename RB, typename V>
+class RingBufferIt : public std::iterator<std::random_access_iterator_tag, V>
+{
+public:
+    RingBufferIt() : m_rb(nullptr), m_index(0) {}
+    RingBufferIt( RB* rb, std::size_t index ) : m_rb(rb), m_index(index) {}
+
+    V& operator *() const { return (*m_rb)[m_index]; }
+    V* operator ->() const { return &(*m_rb)[m_index]; }
+    V& operator []( std::ptrdiff_t n ) const { return (*m_rb)[m_index + n]; }
+
+    RingBufferIt& operator ++() { ++m_index; return *this; }
+    RingBufferIt operator ++( int ) { RingBufferIt res(*this); ++m_index; return res; }
+    RingBufferIt& operator --() { --m_index; return *this; }
+    RingBufferIt operator --( int ) { RingBufferIt res(*this); --m_index; return res; }
+
+    RingBufferIt& operator +=( std::ptrdiff_t offset ) { m_index += offset; return *this; }
+    RingBufferIt& operator -=( std::ptrdiff_t offset ) { m_index -= offset; return *this; }
+    RingBufferIt operator +( std::ptrdiff_t offset ) const { RingBufferIt res(*this); res += offset; return res; }
+    RingBufferIt operator -( std::ptrdiff_t offset ) const { RingBufferIt res(*this); res -= offset; return res; }
+    std::ptrdiff_t operator -( const RingBufferIt& rhs ) const { return m_index - rhs.m_index; }
+
+    bool operator ==( const RingBufferIt& rhs ) const { return m_index == rhs.m_index && m_rb == rhs.m_rb; }
+    bool operator !=( const RingBufferIt& rhs ) const { return !(*this == rhs); }
+    bool operator <( const RingBufferIt& rhs ) const { return m_index < rhs.m_index; }
+    bool operator >( const RingBufferIt& rhs ) const { return m_index > rhs.m_index; }
+    bool operator <=( const RingBufferIt& rhs ) const { return m_index <= rhs.m_index; }
+    bool operator >=( const RingBufferIt& rhs ) const { return m_index >= rhs.m_index; }
+
+private:
+    RB* m_rb;
+    std::size_t m_index;
+};
+
+/**
+ * @brief Double ended queue stored in a single power of 2 sized array.
+ * Elements are accessed without bounds checks (except with at()),
+ * push and pop are O(1) at both ends, the storage grows only when full.
+ * A range of the buffer spans at most 2 contiguous segments.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = RingBufferIt<RingBuffer<T>, T>;
+    using const_iterator = RingBufferIt<const RingBuffer<T>, const T>;
+    // Pointer on the first element and length
+    using Segment = std::pair<const T*, size_type>;
+    using SegmentPair = std::pair<Segment, Segment>;
+
+    RingBuffer() : m_buf(), m_head(0), m_size(0), m_mask(0) {}
+    explicit RingBuffer( size_type capacity ) : RingBuffer() { reserve(capacity); }
+
+    inline size_type size() const { return m_size; }
+    inline bool empty() const { return m_size == 0; }
+    inline size_type capacity() const { return m_buf.size(); }
+
+    /**
+     * @brief Grow storage to hold at least n elements, no-op if already large enough
+     * @param n
+     */
+    void reserve( size_type n )
+    {
+        if( n <= m_buf.size() )
+            return;
+        size_type cap = 1;
+        while( cap < n )
+            cap <<= 1;
+        realloc(cap);
+    }
+
+    void clear() { m_head = 0; m_size = 0; }
+
+    inline T& operator []( size_type i ) { return m_buf[(m_head + i) & m_mask]; }
+    inline const T& operator []( size_type i ) const { return m_buf[(m_head + i) & m_mask]; }
+
+    T& at( size_type i )
+    {
+        if( i >= m_size )
+            throw std::out_of_range("RingBuffer::at");
+        return (*this)[i];
+    }
+
+    const T& at( size_type i ) const
+    {
+        if( i >= m_size )
+            throw std::out_of_range("RingBuffer::at");
+        return (*this)[i];
+    }
+
+    inline T& front() { return (*this)[0]; }
+    inline const T& front() const { return (*this)[0]; }
+    inline T& back() { return (*this)[m_size - 1]; }
+    inline const T& back() const { return (*this)[m_size - 1]; }
+
+    void push_back( const T& value )
+    {
+        if( m_size == m_buf.size() )
+            grow();
+        m_buf[(m_head + m_size) & m_mask] = value;
+        ++m_size;
+    }
+
+    void push_front( const T& value )
+    {
+        if( m_size == m_buf.size() )
+            grow();
+        m_head = (m_head - 1) & m_mask;
+        m_buf[m_head] = value;
+        ++m_size;
+    }
+
+    inline void pop_back() { --m_size; }
+    inline void pop_front() { m_head = (m_head + 1) & m_mask; --m_size; }
+
+    /**
+     * @brief Drop n elements from the front in O(1)
+     * @param n
+     */
+    void erase_front( size_type n )
+    {
+        if( n > m_size )
+            n = m_size;
+        m_head = (m_head + n) & m_mask;
+        m_size -= n;
+    }
+
+    /**
+     * @brief Drop n elements from the back in O(1)
+     * @param n
+     */
+    void erase_back( size_type n )
+    {
+        m_size -= (n > m_size) ? m_size : n;
+    }
+
+    /**
+     * @brief Get the contiguous memory segments for the range [first, last)
+     * The second segment is empty if the range does not wrap around the storage
+     * @param first Logical index of first element
+     * @param last Logical index after the last element
+     * @return segments
+     */
+    SegmentPair segments( size_type first, size_type last ) const
+    {
+        SegmentPair res(Segment(nullptr, 0), Segment(nullptr, 0));
+        if( last <= first )
+            return res;
+
+        size_type len = last - first;
+        size_type start = (m_head + first) & m_mask;
+        size_type firstLen = std::min(len, m_buf.size() - start);
+        res.first = Segment(m_buf.data() + start, firstLen);
+        if( firstLen < len )
+            res.second = Segment(m_buf.data(), len - firstLen);
+        return res;
+    }
+
+    /**
+     * @brief Rotate storage so that all the elements are contiguous
+     * @return pointer on first element
+     */
+    T* linearize()
+    {
+        if( m_head + m_size > m_buf.size() )
+            realloc(m_buf.size());
+        return m_buf.data() + m_head;
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, m_size); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_size); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+private:
+    void grow()
+    {
+        realloc(m_buf.empty() ? 2 : m_buf.size() * 2);
+    }
+
+    void realloc( size_type cap )
+    {
+        std::vector<T> buf(cap);
+        for( size_type i = 0; i < m_size; ++i )
+            buf[i] = (*this)[i];
+        m_buf.swap(buf);
+        m_head = 0;
+        m_mask = cap - 1;
+    }
+
+private:
+    std::vector<T> m_buf;
+    size_type m_head;
+    size_type m_size;
+    size_type m_mask;
+};
+
+} // end namespace mld
+
+#endif // MLD_RINGBUFFER_H
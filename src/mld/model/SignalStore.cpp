@@ -0,0 +1,62 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include "mld/model/SignalStore.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+SignalStore::SignalStore()
+    : m_nodeCount(0)
+    , m_channelCount(1)
+{
+}
+
+SignalStore::SignalStore( const std::vector<oid_t>& layers, size_t nodeCount, size_t channelCount )
+    : SignalStore()
+{
+    resize(layers, nodeCount, channelCount);
+}
+
+void SignalStore::resize( const std::vector<oid_t>& layers, size_t nodeCount, size_t channelCount )
+{
+    m_layers = layers;
+    m_layerIndex.clear();
+    for( size_t i = 0; i < m_layers.size(); ++i )
+        m_layerIndex.emplace(m_layers[i], i);
+    m_nodeCount = nodeCount;
+    m_channelCount = channelCount;
+    m_values.assign(m_channelCount * m_layers.size() * m_nodeCount, SignalValue(0));
+}
+
+void SignalStore::clear()
+{
+    m_layers.clear();
+    m_layerIndex.clear();
+    m_nodeCount = 0;
+    m_channelCount = 1;
+    m_values.clear();
+}
+
+size_t SignalStore::layerIndex( oid_t lid ) const
+{
+    auto it = m_layerIndex.find(lid);
+    if( it == m_layerIndex.end() )
+        return INVALID_INDEX;
+    return it->second;
+}
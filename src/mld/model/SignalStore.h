@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_SIGNALSTORE_H
+#define MLD_SIGNALSTORE_H
+
+#include <vector>
+#include <unordered_map>
+#include <sparksee/gdb/Graph_data.h>
+
+#include "mld/common.h"
+
+namespace mld {
+
+/**
+ * @brief Dense in-memory time series signal, one value per (channel, layer, node).
+ * Values are stored channel then layer major: value (l, i, c) is at
+ * (c * layerCount + l) * nodeCount + i. The channels of a (layer, node) are
+ * therefore not contiguous, each channel is a plane of contiguous layer rows
+ * indexed by the node indexes of a GraphSnapshot, so single channel code
+ * and the row kernels of the filters are unchanged. Channel 0 is the OLink weight.
+ * Values are SignalValue, float if built with MLD_FLOAT_SIGNAL.
+ */
+class MLD_API SignalStore
+{
+public:
+    SignalStore();
+    SignalStore( const std::vector<sparksee::gdb::oid_t>& layers, size_t nodeCount, size_t channelCount=1 );
+
+    friend void swap( SignalStore& lhs, SignalStore& rhs )
+    {
+        using std::swap;
+        swap(lhs.m_layers, rhs.m_layers);
+        swap(lhs.m_layerIndex, rhs.m_layerIndex);
+        swap(lhs.m_nodeCount, rhs.m_nodeCount);
+        swap(lhs.m_channelCount, rhs.m_channelCount);
+        swap(lhs.m_values, rhs.m_values);
+    }
+
+    /**
+     * @brief Resize the store, all values are set to 0
+     * @param layers Layer ids, ordered from bottom to top
+     * @param nodeCount Number of values per layer
+     * @param channelCount Number of values per (layer, node)
+     */
+    void resize( const std::vector<sparksee::gdb::oid_t>& layers, size_t nodeCount, size_t channelCount=1 );
+    void clear();
+
+    inline size_t layerCount() const { return m_layers.size(); }
+    inline size_t nodeCount() const { return m_nodeCount; }
+    inline size_t channelCount() const { return m_channelCount; }
+    inline bool empty() const { return m_values.empty(); }
+
+    inline const std::vector<sparksee::gdb::oid_t>& layers() const { return m_layers; }
+    inline sparksee::gdb::oid_t layerId( size_t idx ) const { return m_layers[idx]; }
+    /**
+     * @brief Get layer index
+     * @param lid Layer id
+     * @return index or INVALID_INDEX if the layer is not in the store
+     */
+    size_t layerIndex( sparksee::gdb::oid_t lid ) const;
+
+    inline SignalValue* layer( size_t idx, size_t channel=0 )
+    {
+        return m_values.data() + (channel * m_layers.size() + idx) * m_nodeCount;
+    }
+    inline const SignalValue* layer( size_t idx, size_t channel=0 ) const
+    {
+        return m_values.data() + (channel * m_layers.size() + idx) * m_nodeCount;
+    }
+
+    inline SignalValue& operator ()( size_t layerIdx, size_t nodeIdx, size_t channel=0 )
+    {
+        return layer(layerIdx, channel)[nodeIdx];
+    }
+    inline SignalValue operator ()( size_t layerIdx, size_t nodeIdx, size_t channel=0 ) const
+    {
+        return layer(layerIdx, channel)[nodeIdx];
+    }
+
+    inline std::vector<SignalValue>& data() { return m_values; }
+    inline const std::vector<SignalValue>& data() const { return m_values; }
+
+private:
+    std::vector<sparksee::gdb::oid_t> m_layers;
+    std::unordered_map<sparksee::gdb::oid_t, size_t> m_layerIndex;
+    size_t m_nodeCount;
+    size_t m_channelCount;
+    std::vector<SignalValue> m_values;
+};
+
+} // end namespace mld
+
+#endif // MLD_SIGNALSTORE_H
@@ -20,9 +20,9 @@
 #define MLD_TIMESERIES_H
 
 #include <cstddef>
-#include <deque>
 
 #include "mld/common.h"
+#include "mld/model/RingBuffer.h"
 
 namespace mld {
 
@@ -30,8 +30,11 @@ namespace mld {
  * Stable iterator for TimeSeries data even if data is
  * added in the underlying container via push_front or push_back
  */
-// Container used for TSData is a std::deque
-template <typename T> using TSData = std::deque<T>;
+// Container used for TSData is a ring buffer, the slice is
+// available as at most 2 contiguous memory segments
+template <typename T> using TSData = RingBuffer<T>;
+template <typename T> using TSSegment = typename RingBuffer<T>::Segment;
+template <typename T> using TSSegmentPair = typename RingBuffer<T>::SegmentPair;
 
 template <typename T>
 class TSIndexIt : public std::iterator<std::random_access_iterator_tag, T>
@@ -44,8 +47,13 @@ public:
     // if needed.
     typename TSData<T>::iterator getRegularIterator() const { return m_v->begin() + m_index; }
 
+#ifdef MLD_DEBUG
     T& operator *() const { return m_v->at(m_index); }
     T* operator ->() const { return &m_v->at(m_index); }
+#else
+    T& operator *() const { return (*m_v)[m_index]; }
+    T* operator ->() const { return &(*m_v)[m_index]; }
+#endif
 
     TSIndexIt& operator ++() { ++m_index; return *this; }
     TSIndexIt& operator +=( std::ptrdiff_t offset ) { m_index += offset; return *this; }
@@ -114,9 +122,9 @@ public:
         swap(lhs.m_radius, rhs.m_radius);
         swap(lhs.m_dir, rhs.m_dir);
         swap(lhs.m_data, rhs.m_data);
-        swap(lhs.m_curPos.m_index, rhs.m_curPos.m_index);
-        swap(lhs.m_start.m_index, rhs.m_start.m_index);
-        swap(lhs.m_finish.m_index, rhs.m_finish.m_index);
+        swapIndex(lhs.m_curPos, rhs.m_curPos);
+        swapIndex(lhs.m_start, rhs.m_start);
+        swapIndex(lhs.m_finish, rhs.m_finish);
     }
 
     inline TSIt sliceBegin() { return m_start; }
@@ -152,6 +160,13 @@ public:
     inline size_t totalSize() const { return m_data.size(); }
     inline size_t sliceSize() const { return distance<T>(m_finish, m_start); }
 
+    /**
+     * @brief Get the slice as contiguous memory segments, the second
+     * one is empty if the slice does not wrap around the ring buffer
+     * @return segments
+     */
+    inline TSSegmentPair<T> sliceSegments() const { return m_data.segments(m_start.index(), m_finish.index()); }
+
     /**
      * @brief Move the slice forward from 1 step     
      * @param delta
@@ -177,6 +192,8 @@ public:
 private:
     void moveIt( TSIt* it, int delta );
     void moveAll( int delta );
+    static void swapIndex( TSIt& lhs, TSIt& rhs ) { std::swap(lhs.m_index, rhs.m_index); }
+    void reserveWindow();
 
 private:
     size_t m_radius;
@@ -208,6 +225,7 @@ TimeSeries<T>::TimeSeries( size_t radius )
     : TimeSeries()
 {
     m_radius = radius;
+    reserveWindow();
 }
 
 template <typename T>
@@ -223,6 +241,7 @@ TimeSeries<T>::TimeSeries( size_t radius, TSDirection dir )
 {
     m_radius = radius;
     m_dir = dir;
+    reserveWindow();
 }
 
 template <typename T>
@@ -263,6 +282,7 @@ void TimeSeries<T>::setRadius( size_t newSize )
     if( m_radius == newSize )
         return;
     m_radius = newSize;
+    reserveWindow();
     clamp();
 }
 
@@ -328,13 +348,12 @@ void TimeSeries<T>::pop_front()
 template <typename T>
 void TimeSeries<T>::shrink()
 {
+    // Slice is [start, finish) and start <= curPos, drop both ends at once
     size_t startIdx = m_start.index();
-    for( size_t i = 0; i < startIdx; ++i )
-        pop_front();
-
-    size_t endDelta = distance(end(), m_finish);
-    for( size_t i = 0; i < endDelta; ++i )
-        pop_back();
+    m_data.erase_back(m_data.size() - m_finish.index());
+    m_data.erase_front(startIdx);
+    m_curPos -= startIdx;
+    clamp();
 }
 
 // Private
@@ -345,6 +364,13 @@ void TimeSeries<T>::moveAll( int delta )
     clamp();
 }
 
+template <typename T>
+void TimeSeries<T>::reserveWindow()
+{
+    // Full window and one extra slot for a push_back before shrinking
+    m_data.reserve(2 * m_radius + 2);
+}
+
 template <typename T>
 void TimeSeries<T>::clamp()
 {
@@ -0,0 +1,169 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <algorithm>
+
+#include "mld/model/TransferMap.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+namespace {
+// Signal rows moved together, the index arrays are read once per block
+const size_t ROW_BLOCK = 4;
+} // end namespace anonymous
+
+TransferMap::TransferMap()
+    : m_offsets(1, 0)
+    , m_orphans(0)
+{
+}
+
+void TransferMap::reset( size_t fineCount, size_t coarseCount )
+{
+    m_parents.assign(fineCount, INVALID_INDEX);
+    m_weights.assign(fineCount, 0.0);
+    m_offsets.assign(coarseCount + 1, 0);
+    m_children.clear();
+    m_childWeights.clear();
+    m_parentWeights.assign(coarseCount, 0.0);
+    m_orphans = fineCount;
+}
+
+void TransferMap::setParent( size_t child, size_t parent, double weight )
+{
+#ifdef MLD_SAFE
+    if( child >= m_parents.size() || parent >= coarseCount() ) {
+        LOG(logERROR) << "TransferMap::setParent index out of range";
+        return;
+    }
+#endif
+    if( m_parents[child] != INVALID_INDEX && m_weights[child] >= weight )
+        return;
+    m_parents[child] = parent;
+    m_weights[child] = weight;
+}
+
+void TransferMap::finalize()
+{
+    const size_t nc = coarseCount();
+    std::fill(m_offsets.begin(), m_offsets.end(), 0);
+    std::fill(m_parentWeights.begin(), m_parentWeights.end(), 0.0);
+    m_orphans = 0;
+    for( size_t c = 0; c < m_parents.size(); ++c ) {
+        if( m_parents[c] == INVALID_INDEX )
+            ++m_orphans;
+        else
+            ++m_offsets[m_parents[c] + 1];
+    }
+    for( size_t p = 0; p < nc; ++p )
+        m_offsets[p + 1] += m_offsets[p];
+
+    // Counting sort of the children by parent
+    m_children.resize(m_offsets[nc]);
+    m_childWeights.resize(m_offsets[nc]);
+    std::vector<size_t> pos(m_offsets.begin(), m_offsets.end() - 1);
+    for( size_t c = 0; c < m_parents.size(); ++c ) {
+        const size_t p = m_parents[c];
+        if( p == INVALID_INDEX )
+            continue;
+        m_children[pos[p]] = c;
+        m_childWeights[pos[p]] = m_weights[c];
+        m_parentWeights[p] += m_weights[c];
+        ++pos[p];
+    }
+}
+
+void TransferMap::clear()
+{
+    m_parents.clear();
+    m_weights.clear();
+    m_offsets.assign(1, 0);
+    m_children.clear();
+    m_childWeights.clear();
+    m_parentWeights.clear();
+    m_orphans = 0;
+}
+
+bool TransferMap::restrictSignal( const SignalStore& fine, const std::vector<oid_t>& layers,
+                                  SignalStore& coarse, RestrictMode mode ) const
+{
+    if( fine.nodeCount() != fineCount() || layers.size() != fine.layerCount() ) {
+        LOG(logERROR) << "TransferMap::restrictSignal signal and map sizes mismatch";
+        return false;
+    }
+
+    const size_t nf = fineCount();
+    const size_t nc = coarseCount();
+    coarse.resize(layers, nc, fine.channelCount());
+    // Rows of both stores are in the same channel then layer order
+    const size_t rows = fine.layerCount() * fine.channelCount();
+    const SignalValue* in = fine.data().data();
+    SignalValue* out = coarse.data().data();
+
+    for( size_t r0 = 0; r0 < rows; r0 += ROW_BLOCK ) {
+        const size_t nb = std::min(ROW_BLOCK, rows - r0);
+        for( size_t p = 0; p < nc; ++p ) {
+            double acc[ROW_BLOCK] = { 0.0 };
+            for( size_t e = m_offsets[p]; e != m_offsets[p + 1]; ++e ) {
+                const SignalValue* x = in + r0 * nf + m_children[e];
+                const double w = m_childWeights[e];
+                for( size_t b = 0; b < nb; ++b )
+                    acc[b] += w * x[b * nf];
+            }
+            double scale = 1.0;
+            if( mode == MEAN && m_parentWeights[p] != 0.0 )
+                scale = 1.0 / m_parentWeights[p];
+            SignalValue* y = out + r0 * nc + p;
+            for( size_t b = 0; b < nb; ++b )
+                y[b * nc] = SignalValue(acc[b] * scale);
+        }
+    }
+    return true;
+}
+
+bool TransferMap::prolongSignal( const SignalStore& coarse, const std::vector<oid_t>& layers,
+                                 SignalStore& fine, ProlongMode mode ) const
+{
+    if( coarse.nodeCount() != coarseCount() || layers.size() != coarse.layerCount() ) {
+        LOG(logERROR) << "TransferMap::prolongSignal signal and map sizes mismatch";
+        return false;
+    }
+
+    const size_t nf = fineCount();
+    const size_t nc = coarseCount();
+    fine.resize(layers, nf, coarse.channelCount());
+    const size_t rows = coarse.layerCount() * coarse.channelCount();
+    const SignalValue* in = coarse.data().data();
+    SignalValue* out = fine.data().data();
+
+    for( size_t r0 = 0; r0 < rows; r0 += ROW_BLOCK ) {
+        const size_t nb = std::min(ROW_BLOCK, rows - r0);
+        for( size_t c = 0; c < nf; ++c ) {
+            const size_t p = m_parents[c];
+            if( p == INVALID_INDEX )
+                continue;
+            const double w = mode == WEIGHTED ? m_weights[c] : 1.0;
+            const SignalValue* x = in + r0 * nc + p;
+            SignalValue* y = out + r0 * nf + c;
+            for( size_t b = 0; b < nb; ++b )
+                y[b * nf] = SignalValue(w * x[b * nc]);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,122 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_TRANSFERMAP_H
+#define MLD_TRANSFERMAP_H
+
+#include <vector>
+#include <sparksee/gdb/Graph_data.h>
+
+#include "mld/common.h"
+#include "mld/model/SignalStore.h"
+
+namespace mld {
+
+/**
+ * @brief Parent index of the nodes of a layer in the layer on top, built from the VLinks.
+ * Fine and coarse nodes are referred to by their GraphSnapshot index. Each fine node has
+ * at most one parent, children of coarse node p are stored in [childBegin(p), childEnd(p))
+ * of children() and childWeights().
+ * Signals are moved between the 2 layers for all the rows of a SignalStore at once.
+ */
+class MLD_API TransferMap
+{
+public:
+    enum RestrictMode {
+        SUM,    // x_p = sum_c w_c x_c
+        MEAN    // x_p = sum_c w_c x_c / sum_c w_c
+    };
+
+    enum ProlongMode {
+        INJECTION,  // x_c = x_p
+        WEIGHTED    // x_c = w_c x_p, transpose of the SUM restriction
+    };
+
+    TransferMap();
+
+    /**
+     * @brief Reset the map, no fine node has a parent
+     * @param fineCount Number of fine nodes
+     * @param coarseCount Number of coarse nodes
+     */
+    void reset( size_t fineCount, size_t coarseCount );
+    /**
+     * @brief Set the parent of a fine node, if it already has one the heaviest VLink is kept
+     * @param child Fine node index
+     * @param parent Coarse node index
+     * @param weight VLink weight
+     */
+    void setParent( size_t child, size_t parent, double weight );
+    /**
+     * @brief Build the children lists, to call once all the parents are set
+     */
+    void finalize();
+    void clear();
+
+    inline size_t fineCount() const { return m_parents.size(); }
+    inline size_t coarseCount() const { return m_offsets.size() - 1; }
+    /**
+     * @brief Number of fine nodes without parent, their prolonged value is 0
+     */
+    inline size_t orphanCount() const { return m_orphans; }
+
+    inline size_t parent( size_t child ) const { return m_parents[child]; }
+    inline double weight( size_t child ) const { return m_weights[child]; }
+    inline size_t childBegin( size_t p ) const { return m_offsets[p]; }
+    inline size_t childEnd( size_t p ) const { return m_offsets[p + 1]; }
+    inline const std::vector<size_t>& children() const { return m_children; }
+    inline const std::vector<double>& childWeights() const { return m_childWeights; }
+    /**
+     * @brief Sum of the VLink weights of the children of p
+     */
+    inline double parentWeight( size_t p ) const { return m_parentWeights[p]; }
+
+    /**
+     * @brief Restrict each row of the fine signal to the coarse nodes
+     * @param fine Fine signal, one value per fine node
+     * @param layers Layer ids of the coarse signal rows, one per fine signal layer
+     * @param coarse Output, resized
+     * @param mode Sum or mean of the children
+     * @return success
+     */
+    bool restrictSignal( const SignalStore& fine, const std::vector<sparksee::gdb::oid_t>& layers,
+                         SignalStore& coarse, RestrictMode mode=MEAN ) const;
+    /**
+     * @brief Prolong each row of the coarse signal to the fine nodes
+     * @param coarse Coarse signal, one value per coarse node
+     * @param layers Layer ids of the fine signal rows, one per coarse signal layer
+     * @param fine Output, resized
+     * @param mode Injection or weighted by the VLinks
+     * @return success
+     */
+    bool prolongSignal( const SignalStore& coarse, const std::vector<sparksee::gdb::oid_t>& layers,
+                        SignalStore& fine, ProlongMode mode=INJECTION ) const;
+
+private:
+    std::vector<size_t> m_parents;
+    std::vector<double> m_weights;
+    std::vector<size_t> m_offsets;
+    std::vector<size_t> m_children;
+    std::vector<double> m_childWeights;
+    std::vector<double> m_parentWeights;
+    size_t m_orphans;
+};
+
+} // end namespace mld
+
+#endif // MLD_TRANSFERMAP_H
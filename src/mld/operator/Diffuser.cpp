@@ -0,0 +1,138 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <sparksee/gdb/Graph.h>
+#include <sparksee/gdb/Objects.h>
+
+#include "mld/operator/Diffuser.h"
+#include "mld/dao/MLGDao.h"
+#include "mld/utils/Timer.h"
+#include "mld/utils/ProgressDisplay.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+Diffuser::Diffuser( Graph* g )
+    : m_dao(new MLGDao(g))
+    , m_times(1, 1.0)
+    , m_blockSize(8)
+    , m_writeBack(true)
+    , m_excludedNodes(m_dao->newObjectsPtr())
+    , m_expm()
+{
+}
+
+Diffuser::~Diffuser()
+{
+}
+
+void Diffuser::setTimes( const std::vector<double>& times )
+{
+    m_times = times;
+}
+
+void Diffuser::setBlockSize( uint32_t size )
+{
+    if( size == 0 ) {
+        LOG(logERROR) << "Diffuser::setBlockSize size 0, reset to 1";
+        size = 1;
+    }
+    m_blockSize = size;
+}
+
+bool Diffuser::diffuse( const GraphSnapshot& graph, const SignalStore& in, std::vector<SignalStore>& out )
+{
+    std::unique_ptr<Timer> t(new Timer("Diffuser::diffuse"));
+#ifdef MLD_SAFE
+    if( graph.nodeCount() != in.nodeCount() ) {
+        LOG(logERROR) << "Diffuser::diffuse snapshot and signal sizes mismatch";
+        return false;
+    }
+#endif
+    const size_t n = graph.nodeCount();
+    const size_t layerCount = in.layerCount();
+    out.assign(m_times.size(), SignalStore(in.layers(), n));
+
+    ProgressDisplay display(layerCount);
+    std::vector<double> block;
+    std::vector<LanczosExpm::Block> res;
+    for( size_t first = 0; first < layerCount; first += m_blockSize ) {
+        const size_t b = std::min<size_t>(m_blockSize, layerCount - first);
+        // Transpose layer rows into a node major block
+        block.resize(n * b);
+        for( size_t s = 0; s < b; ++s ) {
+            const SignalValue* row = in.layer(first + s);
+            for( size_t i = 0; i < n; ++i )
+                block[i * b + s] = row[i];
+        }
+
+        if( !m_expm.apply(graph, block.data(), b, m_times, res) ) {
+            LOG(logERROR) << "Diffuser::diffuse failed for layer: " << in.layerId(first);
+            return false;
+        }
+
+        for( size_t t = 0; t < m_times.size(); ++t ) {
+            for( size_t s = 0; s < b; ++s ) {
+                SignalValue* row = out[t].layer(first + s);
+                for( size_t i = 0; i < n; ++i )
+                    row[i] = SignalValue(res[t][i * b + s]);
+            }
+        }
+        display += b;
+    }
+    return true;
+}
+
+bool Diffuser::preExec()
+{
+    if( m_times.empty() ) {
+        LOG(logERROR) << "Diffuser::preExec no diffusion time";
+        return false;
+    }
+    if( m_writeBack && m_times.size() != 1 ) {
+        LOG(logERROR) << "Diffuser::preExec write back needs a single diffusion time";
+        return false;
+    }
+
+    std::unique_ptr<Timer> t(new Timer("Diffuser::preExec"));
+    m_results.clear();
+    m_graph = m_dao->getGraphSnapshot(m_dao->baseLayer(), m_excludedNodes.get());
+    std::vector<oid_t> layerIds;
+    for( auto& layer: m_dao->getAllLayers() )
+        layerIds.push_back(layer.id());
+    return m_dao->getSignalStore(m_graph, layerIds, m_signal);
+}
+
+bool Diffuser::exec()
+{
+    LOG(logINFO) << "Start diffusion of " << m_signal.layerCount() << " signals on "
+                 << m_graph.nodeCount() << " nodes, " << m_times.size() << " diffusion times";
+    bool ok = diffuse(m_graph, m_signal, m_results);
+    m_signal.clear();
+    return ok;
+}
+
+bool Diffuser::postExec()
+{
+    if( !m_writeBack )
+        return true;
+
+    std::unique_ptr<Timer> t(new Timer("Diffuser::postExec"));
+    LOG(logINFO) << "Commit diffused signal in DB";
+    return m_dao->updateSignalStore(m_graph, m_results.front());
+}
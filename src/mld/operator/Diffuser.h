@@ -0,0 +1,131 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_DIFFUSER_H
+#define MLD_DIFFUSER_H
+
+#include "mld/operator/AbstractOperator.h"
+#include "mld/operator/LanczosExpm.h"
+#include "mld/model/GraphSnapshot.h"
+#include "mld/model/SignalStore.h"
+
+namespace sparksee {
+namespace gdb {
+    class Graph;
+}}
+
+namespace mld {
+
+class MLGDao;
+
+/**
+ * @brief Heat diffusion of the layer signals on the base layer graph.
+ * Computes exp(-t L) x for each layer signal x and each diffusion time t,
+ * L is the combinatorial Laplacian of the base layer HLinks.
+ */
+class MLD_API Diffuser : public AbstractOperator
+{
+public:
+    Diffuser( sparksee::gdb::Graph* g );
+    virtual ~Diffuser() override;
+
+    /**
+     * @brief Set the diffusion times, they all share the same Krylov basis.
+     * Default is t = 1
+     * @param times
+     */
+    void setTimes( const std::vector<double>& times );
+    inline const std::vector<double>& times() const { return m_times; }
+
+    /**
+     * @brief Set the maximum Krylov subspace dimension, default is 30
+     * @param m
+     */
+    inline void setKrylovDim( uint32_t m ) { m_expm.setKrylovDim(m); }
+    inline uint32_t krylovDim() const { return m_expm.krylovDim(); }
+
+    /**
+     * @brief Set the number of layer signals diffused together, default is 8
+     * @param size
+     */
+    void setBlockSize( uint32_t size );
+    inline uint32_t blockSize() const { return m_blockSize; }
+
+    /**
+     * @brief Exclude nodes from the graph, their signal is left untouched
+     * @param nodeSet
+     */
+    inline void setExcludedNodes( const ObjectsPtr& nodeSet ) { m_excludedNodes = nodeSet; }
+
+    /**
+     * @brief Write the result back in the OLinks, needs a single diffusion time.
+     * Default is true
+     * @param v
+     */
+    inline void setWriteBack( bool v ) { m_writeBack = v; }
+    inline bool writeBack() const { return m_writeBack; }
+
+    /**
+     * @brief Diffuse an in-memory signal
+     * @param graph Graph
+     * @param in Input signal
+     * @param out Output, one store per diffusion time
+     * @return success
+     */
+    bool diffuse( const GraphSnapshot& graph, const SignalStore& in, std::vector<SignalStore>& out );
+
+    /**
+     * @brief Get results of the last run, one store per diffusion time
+     * @return results
+     */
+    inline const std::vector<SignalStore>& results() const { return m_results; }
+    inline const GraphSnapshot& graph() const { return m_graph; }
+
+protected:
+    /**
+     * @brief Load graph and signals
+     * @return success
+     */
+    virtual bool preExec() override;
+    /**
+     * @brief Diffuse all the layer signals
+     * @return success
+     */
+    virtual bool exec() override;
+    /**
+     * @brief Commit the result in the OLinks if write back is enabled
+     * @return success
+     */
+    virtual bool postExec() override;
+
+private:
+    std::unique_ptr<MLGDao> m_dao;
+    std::vector<double> m_times;
+    uint32_t m_blockSize;
+    bool m_writeBack;
+    ObjectsPtr m_excludedNodes;
+    LanczosExpm m_expm;
+
+    GraphSnapshot m_graph;
+    SignalStore m_signal;
+    std::vector<SignalStore> m_results;
+};
+
+} // end namespace mld
+
+#endif // MLD_DIFFUSER_H
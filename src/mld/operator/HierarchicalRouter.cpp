@@ -0,0 +1,237 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "mld/operator/HierarchicalRouter.h"
+
+using namespace mld;
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+
+} // end namespace anonymous
+
+HierarchicalRouter::HierarchicalRouter()
+    : m_search(DIJKSTRA)
+    , m_width(1)
+    , m_settled(0)
+    , m_fellBack(false)
+{
+}
+
+bool HierarchicalRouter::setup( std::vector<GraphSnapshot> levels, std::vector<TransferMap> maps )
+{
+    m_levels.clear();
+    m_maps.clear();
+    m_work.clear();
+    if( levels.empty() || maps.size() + 1 != levels.size() ) {
+        LOG(logERROR) << "HierarchicalRouter::setup expects one map less than levels";
+        return false;
+    }
+    for( size_t k = 0; k < maps.size(); ++k ) {
+        if( maps[k].fineCount() != levels[k].nodeCount()
+            || maps[k].coarseCount() != levels[k + 1].nodeCount() ) {
+            LOG(logERROR) << "HierarchicalRouter::setup map size mismatch on level " << k;
+            return false;
+        }
+    }
+
+    m_levels = std::move(levels);
+    m_maps = std::move(maps);
+    m_work.resize(m_levels.size());
+    for( size_t k = 0; k < m_levels.size(); ++k ) {
+        const size_t n = m_levels[k].nodeCount();
+        Workspace& w = m_work[k];
+        w.dist.assign(n, INF);
+        w.prev.assign(n, INVALID_INDEX);
+        w.seen.assign(n, 0);
+        w.allowed.assign(n, 0);
+        w.stamp = 0;
+        w.allowStamp = 0;
+    }
+    return true;
+}
+
+double HierarchicalRouter::shortestPath( size_t source, size_t target, std::vector<size_t>* path )
+{
+    m_settled = 0;
+    m_fellBack = false;
+    if( m_levels.empty() || source >= m_levels[0].nodeCount() || target >= m_levels[0].nodeCount() ) {
+        LOG(logERROR) << "HierarchicalRouter::shortestPath invalid node index";
+        return INF;
+    }
+    return searchLevel(0, source, target, false, path);
+}
+
+double HierarchicalRouter::route( size_t source, size_t target, std::vector<size_t>* path )
+{
+    m_settled = 0;
+    m_fellBack = false;
+    if( m_levels.empty() || source >= m_levels[0].nodeCount() || target >= m_levels[0].nodeCount() ) {
+        LOG(logERROR) << "HierarchicalRouter::route invalid node index";
+        return INF;
+    }
+
+    // Ancestors up to the first orphan
+    std::vector<size_t> src(1, source);
+    std::vector<size_t> dst(1, target);
+    for( size_t k = 0; k < m_maps.size(); ++k ) {
+        const size_t ps = m_maps[k].parent(src.back());
+        const size_t pt = m_maps[k].parent(dst.back());
+        if( ps == INVALID_INDEX || pt == INVALID_INDEX )
+            break;
+        src.push_back(ps);
+        dst.push_back(pt);
+    }
+
+    size_t top = src.size() - 1;
+    std::vector<size_t> coarsePath;
+    double len = searchLevel(top, src[top], dst[top], false, top > 0 ? &coarsePath : path);
+    for( size_t k = top; k-- > 0 && len != INF; ) {
+        allowCorridor(k + 1, coarsePath);
+        std::vector<size_t> finePath;
+        len = searchLevel(k, src[k], dst[k], true, k > 0 ? &finePath : path);
+        coarsePath.swap(finePath);
+    }
+    if( len == INF && top > 0 ) {
+        m_fellBack = true;
+        len = searchLevel(0, source, target, false, path);
+    }
+    return len;
+}
+
+uint32_t HierarchicalRouter::nextStamp( uint32_t& stamp, std::vector<uint32_t>& marks )
+{
+    if( ++stamp == 0 ) {
+        std::fill(marks.begin(), marks.end(), 0);
+        stamp = 1;
+    }
+    return stamp;
+}
+
+void HierarchicalRouter::allowCorridor( size_t level, const std::vector<size_t>& path )
+{
+    const GraphSnapshot& g = m_levels[level];
+    Workspace& w = m_work[level];
+    const uint32_t stamp = nextStamp(w.stamp, w.seen);
+
+    // Breadth first search from the path limited to width hops
+    m_queue.assign(path.begin(), path.end());
+    for( auto v: path ) {
+        w.seen[v] = stamp;
+        w.dist[v] = 0.0;
+    }
+    for( size_t h = 0; h < m_queue.size(); ++h ) {
+        const size_t v = m_queue[h];
+        const double hops = w.dist[v] + 1.0;
+        if( hops > double(m_width) )
+            continue;
+        for( size_t e = g.neighborBegin(v); e != g.neighborEnd(v); ++e ) {
+            const size_t u = g.targets()[e];
+            if( w.seen[u] != stamp ) {
+                w.seen[u] = stamp;
+                w.dist[u] = hops;
+                m_queue.push_back(u);
+            }
+        }
+    }
+
+    const TransferMap& map = m_maps[level - 1];
+    Workspace& fine = m_work[level - 1];
+    const uint32_t allow = nextStamp(fine.allowStamp, fine.allowed);
+    for( auto p: m_queue ) {
+        for( size_t e = map.childBegin(p); e != map.childEnd(p); ++e )
+            fine.allowed[map.children()[e]] = allow;
+    }
+}
+
+double HierarchicalRouter::searchLevel( size_t level, size_t source, size_t target, bool restricted,
+                                        std::vector<size_t>* path )
+{
+    const GraphSnapshot& g = m_levels[level];
+    Workspace& w = m_work[level];
+    auto allowed = [&]( size_t v ) { return !restricted || w.allowed[v] == w.allowStamp; };
+    if( !allowed(source) || !allowed(target) )
+        return INF;
+
+    const uint32_t stamp = nextStamp(w.stamp, w.seen);
+    w.seen[source] = stamp;
+    w.dist[source] = 0.0;
+    w.prev[source] = INVALID_INDEX;
+
+    if( m_search == BFS ) {
+        m_queue.assign(1, source);
+        for( size_t h = 0; h < m_queue.size() && w.seen[target] != stamp; ++h ) {
+            const size_t v = m_queue[h];
+            ++m_settled;
+            for( size_t e = g.neighborBegin(v); e != g.neighborEnd(v); ++e ) {
+                const size_t u = g.targets()[e];
+                if( w.seen[u] == stamp || !allowed(u) )
+                    continue;
+                w.seen[u] = stamp;
+                w.dist[u] = w.dist[v] + 1.0;
+                w.prev[u] = v;
+                m_queue.push_back(u);
+            }
+        }
+    }
+    else {
+        typedef std::pair<double, size_t> Entry;
+        std::greater<Entry> cmp;
+        m_heap.assign(1, Entry(0.0, source));
+        while( !m_heap.empty() ) {
+            std::pop_heap(m_heap.begin(), m_heap.end(), cmp);
+            const Entry top = m_heap.back();
+            m_heap.pop_back();
+            const size_t v = top.second;
+            // Stale entry
+            if( top.first > w.dist[v] )
+                continue;
+            ++m_settled;
+            if( v == target )
+                break;
+            for( size_t e = g.neighborBegin(v); e != g.neighborEnd(v); ++e ) {
+                const size_t u = g.targets()[e];
+                if( !allowed(u) )
+                    continue;
+                const double d = top.first + g.weights()[e];
+                if( w.seen[u] != stamp || d < w.dist[u] ) {
+                    w.seen[u] = stamp;
+                    w.dist[u] = d;
+                    w.prev[u] = v;
+                    m_heap.push_back(Entry(d, u));
+                    std::push_heap(m_heap.begin(), m_heap.end(), cmp);
+                }
+            }
+        }
+    }
+
+    if( w.seen[target] != stamp )
+        return INF;
+    if( path ) {
+        path->clear();
+        for( size_t v = target; v != INVALID_INDEX; v = w.prev[v] )
+            path->push_back(v);
+        std::reverse(path->begin(), path->end());
+    }
+    return w.dist[target];
+}
@@ -0,0 +1,135 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_HIERARCHICALROUTER_H
+#define MLD_HIERARCHICALROUTER_H
+
+#include <vector>
+
+#include "mld/common.h"
+#include "mld/model/GraphSnapshot.h"
+#include "mld/model/TransferMap.h"
+
+namespace mld {
+
+/**
+ * @brief Approximate shortest paths guided by the MLG hierarchy.
+ * The path is first searched on the coarsest level between the ancestors of the
+ * source and the target, each finer level then only searches the children of the
+ * corridor around the coarser path. If the corridor does not connect the endpoints
+ * the query falls back to an exact search on the finest level.
+ * The search state is reset lazily so a query only touches the nodes it visits.
+ */
+class MLD_API HierarchicalRouter
+{
+public:
+    enum Search {
+        DIJKSTRA,   // Weighted shortest paths, weights must be >= 0
+        BFS         // Number of hops, weights are ignored
+    };
+
+    HierarchicalRouter();
+
+    inline void setSearch( Search s ) { m_search = s; }
+    inline Search search() const { return m_search; }
+    /**
+     * @brief Coarse nodes within width hops of the coarse path are added to the corridor.
+     * Default is 1
+     * @param width
+     */
+    inline void setCorridorWidth( uint32_t width ) { m_width = width; }
+    inline uint32_t corridorWidth() const { return m_width; }
+
+    /**
+     * @brief Set the levels
+     * @param levels Graphs with their HLinks, levels[0] is the graph to route on
+     * @param maps maps[k] goes from levels[k] to levels[k + 1]
+     * @return success
+     */
+    bool setup( std::vector<GraphSnapshot> levels, std::vector<TransferMap> maps );
+
+    inline size_t levelCount() const { return m_levels.size(); }
+    inline const GraphSnapshot& level( size_t k ) const { return m_levels[k]; }
+
+    /**
+     * @brief Exact shortest path on the finest level
+     * @param source Node index
+     * @param target Node index
+     * @param path If not null, receives the node indexes from source to target
+     * @return path length, infinity if target is not reachable
+     */
+    double shortestPath( size_t source, size_t target, std::vector<size_t>* path=nullptr );
+    /**
+     * @brief Approximate shortest path on the finest level, see the class description
+     * @param source Node index
+     * @param target Node index
+     * @param path If not null, receives the node indexes from source to target
+     * @return path length, infinity if target is not reachable
+     */
+    double route( size_t source, size_t target, std::vector<size_t>* path=nullptr );
+
+    /**
+     * @brief Number of nodes settled by the last query on all the levels
+     */
+    inline size_t settledCount() const { return m_settled; }
+    /**
+     * @brief The last route fell back to an exact search
+     */
+    inline bool fellBack() const { return m_fellBack; }
+
+private:
+    // Search state of a level, an entry is valid if its stamp is the current one
+    struct Workspace {
+        std::vector<double> dist;
+        std::vector<size_t> prev;
+        std::vector<uint32_t> seen;
+        std::vector<uint32_t> allowed;
+        uint32_t stamp;
+        uint32_t allowStamp;
+    };
+
+    /**
+     * @brief Single source search stopped when the target is settled
+     * @param restricted Only visit the allowed nodes
+     */
+    double searchLevel( size_t level, size_t source, size_t target, bool restricted,
+                        std::vector<size_t>* path );
+    /**
+     * @brief Allow the children of the corridor around a path
+     * @param level Level of the path, its children are allowed on level - 1
+     * @param path Node indexes
+     */
+    void allowCorridor( size_t level, const std::vector<size_t>& path );
+    static uint32_t nextStamp( uint32_t& stamp, std::vector<uint32_t>& marks );
+
+private:
+    Search m_search;
+    uint32_t m_width;
+
+    std::vector<GraphSnapshot> m_levels;
+    std::vector<TransferMap> m_maps;
+    std::vector<Workspace> m_work;
+    std::vector<std::pair<double, size_t>> m_heap;
+    std::vector<size_t> m_queue;
+    size_t m_settled;
+    bool m_fellBack;
+};
+
+} // end namespace mld
+
+#endif // MLD_HIERARCHICALROUTER_H
@@ -0,0 +1,419 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <thread>
+
+#include "mld/operator/KWayPartitioner.h"
+#include "mld/model/GraphSnapshot.h"
+#include "mld/utils/mutable_priority_queue.h"
+#include "mld/utils/ParallelFor.h"
+
+using namespace mld;
+
+namespace {
+
+const uint32_t INVALID_PART = std::numeric_limits<uint32_t>::max();
+// Levels with less nodes per part are too coarse to be partitioned
+const size_t MIN_NODES_PER_PART = 8;
+// Nodes per refinement task
+const size_t BLOCK_SIZE = 1024;
+// Greedy growing trials on the coarsest level, the best cut is kept
+const size_t GROW_TRIALS = 4;
+
+struct Move {
+    double gain;
+    size_t node;
+    uint32_t part;
+};
+
+/**
+ * @brief Best target part of a node, -infinity gain if none fits
+ * @param own Current part of the node
+ * @param w Node weight
+ * @param maxW Maximum part weight
+ */
+Move bestMove( size_t v, uint32_t own, double w, double maxW,
+               const std::vector<double>& conn, const std::vector<uint32_t>& touched,
+               const std::vector<double>& partWeights )
+{
+    Move res{ -std::numeric_limits<double>::infinity(), v, INVALID_PART };
+    for( auto t: touched ) {
+        if( t == own || partWeights[t] + w > maxW )
+            continue;
+        const double gain = conn[t] - conn[own];
+        // Ties go to the lightest part
+        if( gain > res.gain || (gain == res.gain && partWeights[t] < partWeights[res.part]) ) {
+            res.gain = gain;
+            res.part = t;
+        }
+    }
+    return res;
+}
+
+/**
+ * @brief A move is worth it if it reduces the cut or the imbalance without increasing the cut
+ */
+bool accept( const Move& m, uint32_t own, double w, const std::vector<double>& partWeights )
+{
+    if( m.part == INVALID_PART )
+        return false;
+    return m.gain > 0.0 || (m.gain == 0.0 && partWeights[m.part] + w < partWeights[own]);
+}
+
+void clear( std::vector<double>& conn, std::vector<uint32_t>& touched )
+{
+    for( auto t: touched )
+        conn[t] = 0.0;
+    touched.clear();
+}
+
+} // end namespace anonymous
+
+KWayPartitioner::KWayPartitioner()
+    : m_k(2)
+    , m_eps(0.03)
+    , m_passes(8)
+    , m_threads(0)
+    , m_cut(0.0)
+{
+}
+
+double KWayPartitioner::balance() const
+{
+    if( m_partWeights.empty() )
+        return 0.0;
+    double total = 0.0;
+    double heaviest = 0.0;
+    for( auto w: m_partWeights ) {
+        total += w;
+        heaviest = std::max(heaviest, w);
+    }
+    return total > 0.0 ? heaviest * double(m_partWeights.size()) / total : 0.0;
+}
+
+bool KWayPartitioner::partition( const GraphSnapshot& graph, const std::vector<TransferMap>& maps )
+{
+    m_levels.clear();
+    m_parts.clear();
+    m_partWeights.clear();
+    m_cut = 0.0;
+    if( m_k == 0 || m_eps < 0.0 ) {
+        LOG(logERROR) << "KWayPartitioner::partition part count must be > 0 and imbalance >= 0";
+        return false;
+    }
+    if( graph.nodeCount() == 0 ) {
+        LOG(logERROR) << "KWayPartitioner::partition empty graph";
+        return false;
+    }
+
+    Level fine(CSRMatrix::adjacency(graph));
+    fine.weight.assign(fine.n, 1.0);
+    m_levels.push_back(std::move(fine));
+
+    for( auto& map: maps ) {
+        const Level& l = m_levels.back();
+        if( map.fineCount() != l.n ) {
+            LOG(logERROR) << "KWayPartitioner::partition map size mismatch on level " << m_levels.size() - 1;
+            return false;
+        }
+        if( map.orphanCount() == map.fineCount() || map.coarseCount() < m_k * MIN_NODES_PER_PART )
+            break;
+        Level c(coarsen(l, map));
+        m_levels.push_back(std::move(c));
+    }
+
+    const Level& top = m_levels.back();
+    std::vector<uint32_t> parts;
+    double bestCut = std::numeric_limits<double>::infinity();
+    for( size_t trial = 0; trial < GROW_TRIALS; ++trial ) {
+        std::vector<uint32_t> candidate;
+        grow(top, candidate, trial * top.n / GROW_TRIALS);
+        refine(top, candidate);
+        rebalance(top, candidate);
+        const double c = cut(top, candidate);
+        if( c < bestCut ) {
+            bestCut = c;
+            parts.swap(candidate);
+        }
+    }
+
+    std::vector<double> conn(m_k, 0.0);
+    std::vector<uint32_t> touched;
+    for( size_t k = m_levels.size() - 1; k-- > 0; ) {
+        const TransferMap& map = maps[k];
+        const Level& l = m_levels[k];
+        std::vector<uint32_t> fineParts(l.n, INVALID_PART);
+        std::vector<double> pw(m_k, 0.0);
+        for( size_t i = 0; i < l.n; ++i ) {
+            const size_t p = map.parent(i);
+            if( p != INVALID_INDEX ) {
+                fineParts[i] = parts[p];
+                pw[parts[p]] += l.weight[i];
+            }
+        }
+        // Orphans join their most connected part, else the lightest one
+        for( size_t i = 0; i < l.n; ++i ) {
+            if( fineParts[i] != INVALID_PART )
+                continue;
+            connect(l, fineParts, i, conn, touched);
+            uint32_t best = uint32_t(std::min_element(pw.begin(), pw.end()) - pw.begin());
+            for( auto t: touched ) {
+                if( conn[t] > conn[best] )
+                    best = t;
+            }
+            clear(conn, touched);
+            fineParts[i] = best;
+            pw[best] += l.weight[i];
+        }
+        parts.swap(fineParts);
+        refine(l, parts);
+        rebalance(l, parts);
+    }
+
+    const Level& base = m_levels.front();
+    m_partWeights.assign(m_k, 0.0);
+    for( size_t i = 0; i < base.n; ++i )
+        m_partWeights[parts[i]] += base.weight[i];
+    m_cut = cut(base, parts);
+    m_parts.swap(parts);
+    return true;
+}
+
+KWayPartitioner::Level KWayPartitioner::coarsen( const Level& fine, const TransferMap& map )
+{
+    // Edges inside a parent are not cut anymore, they are dropped with the diagonal
+    Level c(CSRMatrix::galerkin(fine, map, CSRMatrix::UNIT, false));
+    c.weight.assign(c.n, 0.0);
+    for( size_t p = 0; p < c.n; ++p ) {
+        for( size_t e = map.childBegin(p); e != map.childEnd(p); ++e )
+            c.weight[p] += fine.weight[map.children()[e]];
+    }
+    return c;
+}
+
+void KWayPartitioner::connect( const Level& l, const std::vector<uint32_t>& parts, size_t v,
+                               std::vector<double>& conn, std::vector<uint32_t>& touched )
+{
+    for( size_t e = l.offsets[v]; e != l.offsets[v + 1]; ++e ) {
+        const uint32_t t = parts[l.cols[e]];
+        if( t == INVALID_PART )
+            continue;
+        if( conn[t] == 0.0 )
+            touched.push_back(t);
+        conn[t] += l.vals[e];
+    }
+}
+
+double KWayPartitioner::cut( const Level& l, const std::vector<uint32_t>& parts )
+{
+    double res = 0.0;
+    for( size_t i = 0; i < l.n; ++i ) {
+        for( size_t e = l.offsets[i]; e != l.offsets[i + 1]; ++e ) {
+            if( parts[l.cols[e]] != parts[i] )
+                res += l.vals[e];
+        }
+    }
+    // Each edge is stored in both directions
+    return res / 2.0;
+}
+
+double KWayPartitioner::maxPartWeight( const Level& l ) const
+{
+    double total = 0.0;
+    double heaviest = 0.0;
+    for( auto w: l.weight ) {
+        total += w;
+        heaviest = std::max(heaviest, w);
+    }
+    const double avg = total / double(m_k);
+    return std::max((1.0 + m_eps) * avg, avg + heaviest);
+}
+
+void KWayPartitioner::grow( const Level& l, std::vector<uint32_t>& parts, size_t start ) const
+{
+    parts.assign(l.n, INVALID_PART);
+    double total = 0.0;
+    for( auto w: l.weight )
+        total += w;
+    const double target = total / double(m_k);
+
+    // Breadth first search on the free nodes, the last one reached is pseudo peripheral
+    size_t firstFree = 0;
+    std::vector<size_t> bfs;
+    std::vector<char> seen(l.n, 0);
+    auto peripheral = [&]() {
+        size_t root = start;
+        if( root >= l.n || parts[root] != INVALID_PART ) {
+            while( firstFree < l.n && parts[firstFree] != INVALID_PART )
+                ++firstFree;
+            if( firstFree == l.n )
+                return INVALID_INDEX;
+            root = firstFree;
+        }
+        bfs.assign(1, root);
+        seen[root] = 1;
+        for( size_t h = 0; h < bfs.size(); ++h ) {
+            const size_t v = bfs[h];
+            for( size_t e = l.offsets[v]; e != l.offsets[v + 1]; ++e ) {
+                const size_t u = l.cols[e];
+                if( !seen[u] && parts[u] == INVALID_PART ) {
+                    seen[u] = 1;
+                    bfs.push_back(u);
+                }
+            }
+        }
+        for( auto v: bfs )
+            seen[v] = 0;
+        return bfs.back();
+    };
+
+    // Grow each part from a seed, the free node most connected to the part comes next
+    for( uint32_t p = 0; p + 1 < m_k; ++p ) {
+        mutable_priority_queue<double, size_t> queue;
+        double w = 0.0;
+        while( w < target ) {
+            if( queue.empty() ) {
+                const size_t seed = peripheral();
+                if( seed == INVALID_INDEX )
+                    break;
+                queue.insert(seed, 0.0);
+            }
+            const size_t v = queue.front_value();
+            queue.pop();
+            parts[v] = p;
+            w += l.weight[v];
+            for( size_t e = l.offsets[v]; e != l.offsets[v + 1]; ++e ) {
+                const size_t u = l.cols[e];
+                if( parts[u] != INVALID_PART )
+                    continue;
+                auto it = queue.findByVal(u);
+                if( it != queue.valEndIterator() )
+                    queue.update(u, it->second + l.vals[e]);
+                else
+                    queue.insert(u, l.vals[e]);
+            }
+        }
+    }
+    for( auto& p: parts ) {
+        if( p == INVALID_PART )
+            p = m_k - 1;
+    }
+}
+
+void KWayPartitioner::refine( const Level& l, std::vector<uint32_t>& parts ) const
+{
+    if( m_k < 2 )
+        return;
+    const double maxW = maxPartWeight(l);
+    std::vector<double> pw(m_k, 0.0);
+    for( size_t i = 0; i < l.n; ++i )
+        pw[parts[i]] += l.weight[i];
+
+    const size_t numThreads = m_threads > 0 ? m_threads
+                                            : std::max(1u, std::thread::hardware_concurrency());
+    const size_t blocks = (l.n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<std::vector<Move>> proposals(numThreads);
+    std::vector<std::vector<double>> conns(numThreads, std::vector<double>(m_k, 0.0));
+    std::vector<std::vector<uint32_t>> touched(numThreads);
+    for( uint32_t pass = 0; pass < m_passes; ++pass ) {
+        // Propose moves against the assignment of the previous pass
+        parallelFor(blocks, numThreads, [&]( size_t b, size_t th ) {
+            const size_t end = std::min(l.n, (b + 1) * BLOCK_SIZE);
+            for( size_t v = b * BLOCK_SIZE; v < end; ++v ) {
+                connect(l, parts, v, conns[th], touched[th]);
+                Move m(bestMove(v, parts[v], l.weight[v], maxW, conns[th], touched[th], pw));
+                if( accept(m, parts[v], l.weight[v], pw) )
+                    proposals[th].push_back(m);
+                clear(conns[th], touched[th]);
+            }
+        });
+
+        std::vector<Move> moves;
+        for( auto& p: proposals ) {
+            moves.insert(moves.end(), p.begin(), p.end());
+            p.clear();
+        }
+        std::sort(moves.begin(), moves.end(), []( const Move& a, const Move& b ) {
+            return a.gain > b.gain || (a.gain == b.gain && a.node < b.node);
+        });
+
+        // Commit the moves still worth it, neighbors may have moved already
+        size_t moved = 0;
+        for( auto& proposal: moves ) {
+            const size_t v = proposal.node;
+            const uint32_t own = parts[v];
+            connect(l, parts, v, conns[0], touched[0]);
+            Move m(bestMove(v, own, l.weight[v], maxW, conns[0], touched[0], pw));
+            clear(conns[0], touched[0]);
+            if( !accept(m, own, l.weight[v], pw) )
+                continue;
+            parts[v] = m.part;
+            pw[own] -= l.weight[v];
+            pw[m.part] += l.weight[v];
+            ++moved;
+        }
+        if( moved == 0 )
+            break;
+    }
+}
+
+void KWayPartitioner::rebalance( const Level& l, std::vector<uint32_t>& parts ) const
+{
+    const double maxW = maxPartWeight(l);
+    std::vector<double> pw(m_k, 0.0);
+    for( size_t i = 0; i < l.n; ++i )
+        pw[parts[i]] += l.weight[i];
+
+    std::vector<double> conn(m_k, 0.0);
+    std::vector<uint32_t> touched;
+    for( uint32_t p = 0; p < m_k; ++p ) {
+        if( pw[p] <= maxW )
+            continue;
+        // Best target of each node of the part, the lightest part if no neighbor part fits
+        std::vector<Move> moves;
+        for( size_t v = 0; v < l.n; ++v ) {
+            if( parts[v] != p )
+                continue;
+            connect(l, parts, v, conn, touched);
+            Move m(bestMove(v, p, l.weight[v], maxW, conn, touched, pw));
+            if( m.part == INVALID_PART )
+                m.gain = conn[p] > 0.0 ? -conn[p] : 0.0;
+            clear(conn, touched);
+            moves.push_back(m);
+        }
+        std::sort(moves.begin(), moves.end(), []( const Move& a, const Move& b ) {
+            return a.gain > b.gain || (a.gain == b.gain && a.node < b.node);
+        });
+        for( auto& m: moves ) {
+            if( pw[p] <= maxW )
+                break;
+            const double w = l.weight[m.node];
+            if( m.part == INVALID_PART || pw[m.part] + w > maxW )
+                m.part = uint32_t(std::min_element(pw.begin(), pw.end()) - pw.begin());
+            if( m.part == p || pw[m.part] + w > maxW )
+                continue;
+            parts[m.node] = m.part;
+            pw[p] -= w;
+            pw[m.part] += w;
+        }
+    }
+}
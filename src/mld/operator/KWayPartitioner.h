@@ -0,0 +1,157 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_KWAYPARTITIONER_H
+#define MLD_KWAYPARTITIONER_H
+
+#include <vector>
+
+#include "mld/common.h"
+#include "mld/model/CSRMatrix.h"
+#include "mld/model/TransferMap.h"
+
+namespace mld {
+
+class GraphSnapshot;
+
+/**
+ * @brief Multilevel k-way partitioning of the finest level, the coarse levels are the
+ * layers of the MLG: level k+1 aggregates the nodes of level k through the VLinks,
+ * node weights and inter aggregate edge weights are summed.
+ * The coarsest level is partitioned by greedy graph growing, the assignment is then
+ * projected level by level and refined with parallel label propagation moves
+ * (positive gain, balance constraint) followed by a rebalancing pass.
+ */
+class MLD_API KWayPartitioner
+{
+public:
+    KWayPartitioner();
+
+    /**
+     * @brief Number of parts. Default is 2
+     * @param k
+     */
+    inline void setPartCount( uint32_t k ) { m_k = k; }
+    inline uint32_t partCount() const { return m_k; }
+    /**
+     * @brief Allowed imbalance, the parts weigh at most (1 + eps) * total / k. Default is 0.03
+     * @param eps
+     */
+    inline void setImbalance( double eps ) { m_eps = eps; }
+    inline double imbalance() const { return m_eps; }
+    /**
+     * @brief Maximum number of refinement passes on each level. Default is 8
+     * @param passes
+     */
+    inline void setRefinePasses( uint32_t passes ) { m_passes = passes; }
+    inline uint32_t refinePasses() const { return m_passes; }
+    /**
+     * @brief Number of threads of the refinement, 0 for the hardware concurrency. Default is 0
+     * @param threads
+     */
+    inline void setThreads( uint32_t threads ) { m_threads = threads; }
+    inline uint32_t threads() const { return m_threads; }
+
+    /**
+     * @brief Partition the graph nodes
+     * @param graph Finest level
+     * @param maps Transfer maps, maps[k] goes from level k to level k+1
+     * @return success
+     */
+    bool partition( const GraphSnapshot& graph, const std::vector<TransferMap>& maps );
+
+    inline size_t levelCount() const { return m_levels.size(); }
+    inline size_t levelSize( size_t k ) const { return m_levels[k].n; }
+    /**
+     * @brief Part of each finest level node, in [0, partCount())
+     */
+    inline const std::vector<uint32_t>& parts() const { return m_parts; }
+    /**
+     * @brief Number of nodes in each part
+     */
+    inline const std::vector<double>& partWeights() const { return m_partWeights; }
+    /**
+     * @brief Sum of the weights of the edges between parts
+     */
+    inline double edgeCut() const { return m_cut; }
+    /**
+     * @brief Weight of the heaviest part over the average part weight
+     */
+    double balance() const;
+
+private:
+    // Adjacency of a level without self loops and the node weights
+    struct Level : public CSRMatrix
+    {
+        Level( CSRMatrix&& a ) : CSRMatrix(std::move(a)) {}
+
+        std::vector<double> weight;
+    };
+
+    static Level coarsen( const Level& fine, const TransferMap& map );
+    /**
+     * @brief Accumulate the edge weights from node v to each part
+     * @param conn Connection per part, must be 0 for the parts not touched
+     * @param touched Parts with a non zero connection
+     */
+    static void connect( const Level& l, const std::vector<uint32_t>& parts, size_t v,
+                         std::vector<double>& conn, std::vector<uint32_t>& touched );
+    /**
+     * @brief Sum of the weights of the edges between parts
+     */
+    static double cut( const Level& l, const std::vector<uint32_t>& parts );
+    /**
+     * @brief Greedy graph growing from pseudo peripheral seeds
+     * @param l Coarsest level
+     * @param parts Output assignment
+     * @param start Root of the search of the first seed
+     */
+    void grow( const Level& l, std::vector<uint32_t>& parts, size_t start ) const;
+    /**
+     * @brief Label propagation moves proposed in parallel and committed sequentially
+     * by decreasing gain while the balance constraint holds
+     * @param l Level
+     * @param parts Assignment, updated
+     */
+    void refine( const Level& l, std::vector<uint32_t>& parts ) const;
+    /**
+     * @brief Move the nodes of the overweight parts to the lightest parts, best gains first
+     * @param l Level
+     * @param parts Assignment, updated
+     */
+    void rebalance( const Level& l, std::vector<uint32_t>& parts ) const;
+    /**
+     * @brief Maximum part weight on a level, a part can always take the heaviest node
+     */
+    double maxPartWeight( const Level& l ) const;
+
+private:
+    uint32_t m_k;
+    double m_eps;
+    uint32_t m_passes;
+    uint32_t m_threads;
+
+    std::vector<Level> m_levels;
+    std::vector<uint32_t> m_parts;
+    std::vector<double> m_partWeights;
+    double m_cut;
+};
+
+} // end namespace mld
+
+#endif // MLD_KWAYPARTITIONER_H
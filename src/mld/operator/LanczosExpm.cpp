@@ -0,0 +1,195 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <cmath>
+
+#include "mld/operator/LanczosExpm.h"
+#include "mld/model/GraphSnapshot.h"
+#include "mld/utils/Tridiagonal.h"
+
+using namespace mld;
+
+namespace {
+// Relative threshold for the invariant subspace detection
+const double BREAKDOWN_TOL = 1e-12;
+}
+
+LanczosExpm::LanczosExpm( uint32_t krylovDim )
+    : m_krylovDim(1)
+{
+    setKrylovDim(krylovDim);
+}
+
+void LanczosExpm::setKrylovDim( uint32_t m )
+{
+    if( m == 0 ) {
+        LOG(logERROR) << "LanczosExpm::setKrylovDim dimension 0, reset to 1";
+        m = 1;
+    }
+    m_krylovDim = m;
+}
+
+bool LanczosExpm::apply( const GraphSnapshot& graph, const double* x, size_t blockSize,
+                         const std::vector<double>& times, std::vector<Block>& y )
+{
+    const size_t n = graph.nodeCount();
+    const size_t b = blockSize;
+    const size_t len = n * b;
+    y.assign(times.size(), Block(len, 0.0));
+    if( len == 0 )
+        return true;
+
+    // Norm of each signal
+    std::vector<double> beta0(b, 0.0);
+    for( size_t i = 0; i < n; ++i ) {
+        for( size_t s = 0; s < b; ++s )
+            beta0[s] += x[i * b + s] * x[i * b + s];
+    }
+    for( auto& v: beta0 )
+        v = std::sqrt(v);
+
+    auto start = [&]() {
+        m_prev.assign(len, 0.0);
+        m_cur.resize(len);
+        m_next.resize(len);
+        for( size_t i = 0; i < n; ++i ) {
+            for( size_t s = 0; s < b; ++s )
+                m_cur[i * b + s] = beta0[s] > 0.0 ? x[i * b + s] / beta0[s] : 0.0;
+        }
+    };
+
+    // First pass: tridiagonal matrices T = V^t L V
+    std::vector<std::vector<double>> alpha(b);
+    std::vector<std::vector<double>> beta(b);
+    std::vector<bool> active(b);
+    size_t activeCount = 0;
+    for( size_t s = 0; s < b; ++s ) {
+        active[s] = beta0[s] > 0.0;
+        activeCount += active[s];
+    }
+
+    start();
+    std::vector<double> dots(b);
+    for( uint32_t j = 0; j < m_krylovDim && activeCount > 0; ++j ) {
+        graph.laplacian(m_cur.data(), m_next.data(), b);
+
+        std::fill(dots.begin(), dots.end(), 0.0);
+        for( size_t i = 0; i < n; ++i ) {
+            for( size_t s = 0; s < b; ++s )
+                dots[s] += m_cur[i * b + s] * m_next[i * b + s];
+        }
+
+        // Orthogonalize against the 2 last vectors
+        std::vector<double> norms(b, 0.0);
+        for( size_t i = 0; i < n; ++i ) {
+            for( size_t s = 0; s < b; ++s ) {
+                if( !active[s] )
+                    continue;
+                const size_t k = i * b + s;
+                const double bprev = j > 0 ? beta[s][j - 1] : 0.0;
+                m_next[k] = m_next[k] - dots[s] * m_cur[k] - bprev * m_prev[k];
+                norms[s] += m_next[k] * m_next[k];
+            }
+        }
+
+        for( size_t s = 0; s < b; ++s ) {
+            if( !active[s] )
+                continue;
+            alpha[s].push_back(dots[s]);
+            double nrm = std::sqrt(norms[s]);
+            double scale = std::fabs(dots[s]) + (j > 0 ? beta[s][j - 1] : 0.0);
+            // Invariant subspace found or max dimension reached
+            if( nrm <= BREAKDOWN_TOL * scale || j + 1 == m_krylovDim ) {
+                active[s] = false;
+                --activeCount;
+            }
+            else {
+                beta[s].push_back(nrm);
+            }
+        }
+
+        // Next Lanczos vectors
+        for( size_t i = 0; i < n; ++i ) {
+            for( size_t s = 0; s < b; ++s ) {
+                if( !active[s] )
+                    continue;
+                const size_t k = i * b + s;
+                m_prev[k] = m_cur[k];
+                m_cur[k] = m_next[k] / beta[s].back();
+            }
+        }
+    }
+
+    // exp(-t T) e1 in the eigen basis of T, coeffs[t][s][j]
+    std::vector<std::vector<std::vector<double>>> coeffs(times.size(),
+                                                         std::vector<std::vector<double>>(b));
+    size_t maxSteps = 0;
+    for( size_t s = 0; s < b; ++s ) {
+        const size_t m = alpha[s].size();
+        maxSteps = std::max(maxSteps, m);
+        if( m == 0 )
+            continue;
+        std::vector<double> theta(alpha[s]);
+        std::vector<double> q;
+        if( !tridiagonalEigen(theta, beta[s], q) ) {
+            LOG(logERROR) << "LanczosExpm::apply tridiagonal eigen decomposition did not converge";
+            return false;
+        }
+        for( size_t t = 0; t < times.size(); ++t ) {
+            auto& c = coeffs[t][s];
+            c.assign(m, 0.0);
+            for( size_t l = 0; l < m; ++l ) {
+                const double w = beta0[s] * std::exp(-times[t] * theta[l]) * q[l];  // q[0 * m + l]
+                for( size_t r = 0; r < m; ++r )
+                    c[r] += q[r * m + l] * w;
+            }
+        }
+    }
+
+    // Second pass: regenerate the basis and accumulate
+    auto accumulate = [&]( size_t j ) {
+        for( size_t t = 0; t < times.size(); ++t ) {
+            double* yt = y[t].data();
+            for( size_t i = 0; i < n; ++i ) {
+                for( size_t s = 0; s < b; ++s ) {
+                    if( j < coeffs[t][s].size() )
+                        yt[i * b + s] += coeffs[t][s][j] * m_cur[i * b + s];
+                }
+            }
+        }
+    };
+
+    start();
+    accumulate(0);
+    for( size_t j = 0; j + 1 < maxSteps; ++j ) {
+        graph.laplacian(m_cur.data(), m_next.data(), b);
+        for( size_t i = 0; i < n; ++i ) {
+            for( size_t s = 0; s < b; ++s ) {
+                if( j + 1 >= alpha[s].size() )
+                    continue;
+                const size_t k = i * b + s;
+                const double bprev = j > 0 ? beta[s][j - 1] : 0.0;
+                m_next[k] = m_next[k] - alpha[s][j] * m_cur[k] - bprev * m_prev[k];
+                m_prev[k] = m_cur[k];
+                m_cur[k] = m_next[k] / beta[s][j];
+            }
+        }
+        accumulate(j + 1);
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_LANCZOSEXPM_H
+#define MLD_LANCZOSEXPM_H
+
+#include <vector>
+
+#include "mld/common.h"
+
+namespace mld {
+
+class GraphSnapshot;
+
+/**
+ * @brief Heat kernel exp(-t L) x with the Lanczos method, L is the combinatorial Laplacian.
+ * Each signal gets its own Krylov basis, shared by all the diffusion times.
+ * Signals of a block are processed together, their Laplacian products
+ * share one traversal of the graph.
+ * The basis is not stored: a first pass builds the tridiagonal matrix,
+ * a second pass regenerates the basis to accumulate the results,
+ * memory is O(n * blockSize) whatever the Krylov dimension.
+ */
+class MLD_API LanczosExpm
+{
+public:
+    using Block = std::vector<double>;
+
+    LanczosExpm( uint32_t krylovDim=30 );
+
+    /**
+     * @brief Set the maximum Krylov subspace dimension.
+     * Convergence needs roughly sqrt(t * lmax) steps
+     * @param m
+     */
+    void setKrylovDim( uint32_t m );
+    inline uint32_t krylovDim() const { return m_krylovDim; }
+
+    /**
+     * @brief Compute exp(-t L) x for each diffusion time
+     * @param graph Graph
+     * @param x Block of signals, node major: x[i * blockSize + s]
+     * @param blockSize Number of signals in the block
+     * @param times Diffusion times
+     * @param y Output, one block per diffusion time
+     * @return success
+     */
+    bool apply( const GraphSnapshot& graph, const double* x, size_t blockSize,
+                const std::vector<double>& times, std::vector<Block>& y );
+
+private:
+    uint32_t m_krylovDim;
+    Block m_prev;
+    Block m_cur;
+    Block m_next;
+};
+
+} // end namespace mld
+
+#endif // MLD_LANCZOSEXPM_H
@@ -0,0 +1,159 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <sparksee/gdb/Graph.h>
+#include <sparksee/gdb/Objects.h>
+
+#include "mld/operator/LayerTransfer.h"
+#include "mld/dao/MLGDao.h"
+#include "mld/utils/Timer.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+LayerTransfer::LayerTransfer( Graph* g )
+    : m_dao(new MLGDao(g))
+    , m_fineLayer(Objects::InvalidOID)
+    , m_levels(1)
+    , m_dir(RESTRICT)
+    , m_restrictMode(TransferMap::MEAN)
+    , m_prolongMode(TransferMap::INJECTION)
+    , m_writeBack(true)
+{
+}
+
+LayerTransfer::~LayerTransfer()
+{
+}
+
+bool LayerTransfer::preExec()
+{
+    std::unique_ptr<Timer> t(new Timer("LayerTransfer::preExec"));
+    m_result.clear();
+    m_layerIds.clear();
+    m_snapshots.clear();
+    m_maps.clear();
+    if( m_levels == 0 ) {
+        LOG(logERROR) << "LayerTransfer::preExec levels must be positive";
+        return false;
+    }
+    if( m_fineLayer == Objects::InvalidOID )
+        m_fineLayer = m_dao->baseLayer().id();
+    if( m_fineLayer == Objects::InvalidOID ) {
+        LOG(logERROR) << "LayerTransfer::preExec no fine layer";
+        return false;
+    }
+
+    m_layerIds.push_back(m_fineLayer);
+    m_snapshots.push_back(m_dao->getNodeSnapshot(m_dao->getLayer(m_fineLayer)));
+    for( uint32_t k = 1; k <= m_levels; ++k ) {
+        oid_t parent = m_dao->parent(m_layerIds.back());
+        if( parent == Objects::InvalidOID ) {
+            LOG(logERROR) << "LayerTransfer::preExec the fine layer has less than "
+                          << m_levels << " layers above";
+            return false;
+        }
+        m_layerIds.push_back(parent);
+        m_snapshots.push_back(m_dao->getNodeSnapshot(m_dao->getLayer(parent)));
+        TransferMap map;
+        if( !m_dao->getTransferMap(m_snapshots[k - 1], m_snapshots[k], map) )
+            return false;
+        if( map.orphanCount() > 0 ) {
+            LOG(logWARNING) << "LayerTransfer::preExec " << map.orphanCount()
+                            << " nodes of level " << k - 1 << " have no parent";
+        }
+        m_maps.push_back(std::move(map));
+    }
+
+    oid_t source = m_dir == RESTRICT ? m_layerIds.front() : m_layerIds.back();
+    std::vector<oid_t> layers(1, source);
+    return m_dao->getSignalStore(this->source(), layers, m_signal, m_channels);
+}
+
+bool LayerTransfer::exec()
+{
+    bool ok = true;
+    if( m_dir == RESTRICT ) {
+        LOG(logINFO) << "Restrict " << m_signal.channelCount() << " channels from "
+                     << source().nodeCount() << " to " << target().nodeCount()
+                     << " nodes over " << m_levels << " levels";
+        for( size_t k = 0; ok && k < m_maps.size(); ++k ) {
+            std::vector<oid_t> layers(1, m_layerIds[k + 1]);
+            ok = m_maps[k].restrictSignal(m_signal, layers, m_result, m_restrictMode);
+            std::swap(m_signal, m_result);
+        }
+    }
+    else {
+        LOG(logINFO) << "Prolong " << m_signal.channelCount() << " channels from "
+                     << source().nodeCount() << " to " << target().nodeCount()
+                     << " nodes over " << m_levels << " levels";
+        for( size_t k = m_maps.size(); ok && k > 0; --k ) {
+            const TransferMap& map = m_maps[k - 1];
+            std::vector<oid_t> layers(1, m_layerIds[k - 1]);
+            ok = map.prolongSignal(m_signal, layers, m_result, m_prolongMode);
+            if( ok && map.orphanCount() > 0 )
+                keepOrphanValues(k - 1);
+            std::swap(m_signal, m_result);
+        }
+    }
+    // The last level is in m_signal after the swap
+    std::swap(m_signal, m_result);
+    m_signal.clear();
+    return ok;
+}
+
+void LayerTransfer::keepOrphanValues( size_t level )
+{
+    // Nodes without parent keep their current value. An intermediate layer
+    // may have no value for a channel, the default OLink weight is used then
+    const GraphSnapshot& fine = m_snapshots[level];
+    const TransferMap& map = m_maps[level];
+    size_t missing = 0;
+    for( size_t ch = 0; ch < m_result.channelCount(); ++ch ) {
+        const std::wstring& attr = ch == 0 ? Attrs::V[OLinkAttr::WEIGHT] : m_channels[ch - 1];
+        OLinkWeightMap current(m_dao->getOLinkWeights(m_layerIds[level], attr));
+        SignalValue* row = m_result.layer(0, ch);
+        for( size_t c = 0; c < fine.nodeCount(); ++c ) {
+            if( map.parent(c) != INVALID_INDEX )
+                continue;
+            auto it = current.find(fine.nodeId(c));
+            if( it != current.end() ) {
+                row[c] = SignalValue(it->second);
+            }
+            else {
+                row[c] = SignalValue(OLINK_DEF_VALUE);
+                ++missing;
+            }
+        }
+    }
+    if( missing > 0 ) {
+        LOG(logWARNING) << "LayerTransfer::keepOrphanValues " << missing
+                        << " orphan values missing at level " << level << ", set to "
+                        << OLINK_DEF_VALUE;
+    }
+}
+
+bool LayerTransfer::postExec()
+{
+    if( !m_writeBack )
+        return true;
+
+    std::unique_ptr<Timer> t(new Timer("LayerTransfer::postExec"));
+    LOG(logINFO) << "Commit transferred signal in DB";
+    return m_dao->updateSignalStore(target(), m_result, m_channels);
+}
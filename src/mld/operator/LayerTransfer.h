@@ -0,0 +1,154 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_LAYERTRANSFER_H
+#define MLD_LAYERTRANSFER_H
+
+#include "mld/operator/AbstractOperator.h"
+#include "mld/model/GraphSnapshot.h"
+#include "mld/model/SignalStore.h"
+#include "mld/model/TransferMap.h"
+
+namespace sparksee {
+namespace gdb {
+    class Graph;
+}}
+
+namespace mld {
+
+class MLGDao;
+
+/**
+ * @brief Move the OLink signal of a layer to a layer above (restriction)
+ * or from a layer above to the layer below it (prolongation) through the VLinks.
+ * The signal crosses the levels one transfer map at a time, all the nodes
+ * and all the OLink channels are moved at once. Only the target layer is written,
+ * the intermediate layers are left untouched.
+ */
+class MLD_API LayerTransfer : public AbstractOperator
+{
+public:
+    enum Direction {
+        RESTRICT,   // fine to coarse
+        PROLONG     // coarse to fine
+    };
+
+    LayerTransfer( sparksee::gdb::Graph* g );
+    virtual ~LayerTransfer() override;
+
+    /**
+     * @brief Set the fine layer, the coarse layer is levels() layers above.
+     * Default is the base layer
+     * @param lid Layer id
+     */
+    inline void setFineLayer( sparksee::gdb::oid_t lid ) { m_fineLayer = lid; }
+    inline sparksee::gdb::oid_t fineLayer() const { return m_fineLayer; }
+
+    /**
+     * @brief Set the number of layer pairs crossed between the fine and the coarse layer.
+     * Default is 1, the parent of the fine layer
+     * @param levels
+     */
+    inline void setLevels( uint32_t levels ) { m_levels = levels; }
+    inline uint32_t levels() const { return m_levels; }
+
+    inline void setDirection( Direction dir ) { m_dir = dir; }
+    inline Direction direction() const { return m_dir; }
+
+    /**
+     * @brief Default is the weighted mean of the children
+     */
+    inline void setRestrictMode( TransferMap::RestrictMode mode ) { m_restrictMode = mode; }
+    inline TransferMap::RestrictMode restrictMode() const { return m_restrictMode; }
+    /**
+     * @brief Default is injection of the parent value
+     */
+    inline void setProlongMode( TransferMap::ProlongMode mode ) { m_prolongMode = mode; }
+    inline TransferMap::ProlongMode prolongMode() const { return m_prolongMode; }
+
+    /**
+     * @brief Extra OLink double attributes moved with the OLink weight
+     * @param channels
+     */
+    inline void setChannels( const std::vector<std::wstring>& channels ) { m_channels = channels; }
+    inline const std::vector<std::wstring>& channels() const { return m_channels; }
+
+    /**
+     * @brief Write the result in the OLinks of the target layer. Default is true
+     * @param v
+     */
+    inline void setWriteBack( bool v ) { m_writeBack = v; }
+    inline bool writeBack() const { return m_writeBack; }
+
+    /**
+     * @brief Get the result of the last run, indexed as target()
+     */
+    inline const SignalStore& result() const { return m_result; }
+    /**
+     * @brief Get the transfer maps of the last run, maps()[k] goes from
+     * the level k to the level k + 1 above the fine layer
+     */
+    inline const std::vector<TransferMap>& maps() const { return m_maps; }
+    inline const GraphSnapshot& source() const { return m_dir == RESTRICT ? m_snapshots.front() : m_snapshots.back(); }
+    inline const GraphSnapshot& target() const { return m_dir == RESTRICT ? m_snapshots.back() : m_snapshots.front(); }
+
+protected:
+    /**
+     * @brief Load the nodes of each level, the VLinks and the source signal
+     * @return success
+     */
+    virtual bool preExec() override;
+    /**
+     * @brief Restrict or prolong the source signal
+     * @return success
+     */
+    virtual bool exec() override;
+    /**
+     * @brief Commit the result in the OLinks if write back is enabled
+     * @return success
+     */
+    virtual bool postExec() override;
+
+private:
+    /**
+     * @brief Overwrite the prolonged values of the nodes without parent
+     * by their values in the database
+     * @param level Level of the prolonged result
+     */
+    void keepOrphanValues( size_t level );
+
+private:
+    std::unique_ptr<MLGDao> m_dao;
+    sparksee::gdb::oid_t m_fineLayer;
+    uint32_t m_levels;
+    Direction m_dir;
+    TransferMap::RestrictMode m_restrictMode;
+    TransferMap::ProlongMode m_prolongMode;
+    std::vector<std::wstring> m_channels;
+    bool m_writeBack;
+
+    std::vector<sparksee::gdb::oid_t> m_layerIds;
+    std::vector<GraphSnapshot> m_snapshots;
+    std::vector<TransferMap> m_maps;
+    SignalStore m_signal;
+    SignalStore m_result;
+};
+
+} // end namespace mld
+
+#endif // MLD_LAYERTRANSFER_H
@@ -0,0 +1,290 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+
+#include "mld/operator/Multigrid.h"
+#include "mld/model/GraphSnapshot.h"
+
+using namespace mld;
+
+Multigrid::Multigrid()
+    : m_alpha(1.0)
+    , m_smoother(GAUSS_SEIDEL)
+    , m_steps(2)
+    , m_jacobiWeight(2.0 / 3.0)
+    , m_directSize(512)
+    , m_tolerance(1e-8)
+    , m_maxIterations(100)
+    , m_preconditioned(true)
+    , m_iterations(0)
+    , m_residual(0.0)
+{
+}
+
+bool Multigrid::setup( const GraphSnapshot& graph, const std::vector<TransferMap>& maps )
+{
+    m_levels.clear();
+    m_maps.clear();
+    m_chol.clear();
+    if( m_alpha <= 0.0 ) {
+        LOG(logERROR) << "Multigrid::setup alpha must be > 0";
+        return false;
+    }
+
+    m_levels.push_back(Level(CSRMatrix::laplacian(graph, m_alpha)));
+
+    for( auto& map: maps ) {
+        const Level& l = m_levels.back();
+        if( map.fineCount() != l.n ) {
+            LOG(logERROR) << "Multigrid::setup map size mismatch on level " << m_levels.size() - 1;
+            return false;
+        }
+        // Small enough or nothing to aggregate
+        if( l.n <= m_directSize || map.orphanCount() == map.fineCount() )
+            break;
+        m_maps.push_back(map);
+        m_levels.push_back(Level(CSRMatrix::galerkin(l, map)));
+    }
+
+    for( auto& l: m_levels ) {
+        l.b.assign(l.n, 0.0);
+        l.x.assign(l.n, 0.0);
+        l.r.assign(l.n, 0.0);
+    }
+    const size_t n = m_levels.front().n;
+    m_r.assign(n, 0.0);
+    m_z.assign(n, 0.0);
+    m_p.assign(n, 0.0);
+    m_ap.assign(n, 0.0);
+
+    const Level& top = m_levels.back();
+    if( top.n <= m_directSize && !factorize(top) ) {
+        LOG(logERROR) << "Multigrid::setup coarsest level is not positive definite";
+        return false;
+    }
+    return true;
+}
+
+void Multigrid::smooth( Level& l, bool forward )
+{
+    for( uint32_t s = 0; s < m_steps; ++s ) {
+        if( m_smoother == JACOBI ) {
+            l.multiply(l.x.data(), l.r.data());
+            for( size_t i = 0; i < l.n; ++i )
+                l.x[i] += m_jacobiWeight * (l.b[i] - l.r[i]) / l.diag[i];
+            continue;
+        }
+        for( size_t t = 0; t < l.n; ++t ) {
+            const size_t i = forward ? t : l.n - 1 - t;
+            double acc = l.b[i];
+            for( size_t k = l.offsets[i]; k != l.offsets[i + 1]; ++k )
+                acc -= l.vals[k] * l.x[l.cols[k]];
+            l.x[i] = acc / l.diag[i];
+        }
+    }
+}
+
+void Multigrid::vcycle( size_t k )
+{
+    Level& l = m_levels[k];
+    std::fill(l.x.begin(), l.x.end(), 0.0);
+    if( k + 1 == m_levels.size() ) {
+        coarseSolve(l);
+        return;
+    }
+
+    smooth(l, true);
+    l.multiply(l.x.data(), l.r.data());
+    for( size_t i = 0; i < l.n; ++i )
+        l.r[i] = l.b[i] - l.r[i];
+
+    // Restrict the residual, P^T r
+    Level& c = m_levels[k + 1];
+    const TransferMap& map = m_maps[k];
+    for( size_t p = 0; p < c.n; ++p ) {
+        double acc = 0.0;
+        for( size_t e = map.childBegin(p); e != map.childEnd(p); ++e )
+            acc += map.childWeights()[e] * l.r[map.children()[e]];
+        c.b[p] = acc;
+    }
+    vcycle(k + 1);
+
+    // Prolong the correction
+    for( size_t i = 0; i < l.n; ++i ) {
+        const size_t p = map.parent(i);
+        if( p != INVALID_INDEX )
+            l.x[i] += map.weight(i) * c.x[p];
+    }
+    smooth(l, false);
+}
+
+void Multigrid::precondition( const std::vector<double>& r, std::vector<double>& z )
+{
+    Level& l = m_levels.front();
+    // A single level without factorization falls back on Jacobi
+    if( m_levels.size() == 1 && m_chol.empty() ) {
+        for( size_t i = 0; i < l.n; ++i )
+            z[i] = r[i] / l.diag[i];
+        return;
+    }
+    std::copy(r.begin(), r.end(), l.b.begin());
+    vcycle(0);
+    std::copy(l.x.begin(), l.x.end(), z.begin());
+}
+
+bool Multigrid::factorize( const Level& l )
+{
+    const size_t n = l.n;
+    m_chol.assign(n * n, 0.0);
+    for( size_t i = 0; i < n; ++i ) {
+        m_chol[i * n + i] = l.diag[i];
+        for( size_t k = l.offsets[i]; k != l.offsets[i + 1]; ++k )
+            m_chol[i * n + l.cols[k]] += l.vals[k];
+    }
+    for( size_t j = 0; j < n; ++j ) {
+        double d = m_chol[j * n + j];
+        for( size_t k = 0; k < j; ++k )
+            d -= m_chol[j * n + k] * m_chol[j * n + k];
+        if( d <= 0.0 ) {
+            m_chol.clear();
+            return false;
+        }
+        d = std::sqrt(d);
+        m_chol[j * n + j] = d;
+        for( size_t i = j + 1; i < n; ++i ) {
+            double v = m_chol[i * n + j];
+            for( size_t k = 0; k < j; ++k )
+                v -= m_chol[i * n + k] * m_chol[j * n + k];
+            m_chol[i * n + j] = v / d;
+        }
+    }
+    return true;
+}
+
+void Multigrid::coarseSolve( Level& l )
+{
+    const size_t n = l.n;
+    if( !m_chol.empty() ) {
+        // L y = b then L^T x = y
+        for( size_t i = 0; i < n; ++i ) {
+            double v = l.b[i];
+            for( size_t k = 0; k < i; ++k )
+                v -= m_chol[i * n + k] * l.x[k];
+            l.x[i] = v / m_chol[i * n + i];
+        }
+        for( size_t t = n; t-- > 0; ) {
+            double v = l.x[t];
+            for( size_t k = t + 1; k < n; ++k )
+                v -= m_chol[k * n + t] * l.x[k];
+            l.x[t] = v / m_chol[t * n + t];
+        }
+        return;
+    }
+
+    // Jacobi preconditioned CG, solved tightly to keep the V-cycle linear
+    std::vector<double> r(l.b);
+    std::vector<double> z(n);
+    std::vector<double> p(n);
+    std::vector<double> ap(n);
+    for( size_t i = 0; i < n; ++i )
+        z[i] = r[i] / l.diag[i];
+    p = z;
+    double rz = dot(r, z);
+    const double bnorm = std::sqrt(dot(l.b, l.b));
+    for( size_t it = 0; it < n && std::sqrt(dot(r, r)) > 1e-12 * bnorm; ++it ) {
+        l.multiply(p.data(), ap.data());
+        const double a = rz / dot(p, ap);
+        for( size_t i = 0; i < n; ++i ) {
+            l.x[i] += a * p[i];
+            r[i] -= a * ap[i];
+            z[i] = r[i] / l.diag[i];
+        }
+        const double rzNew = dot(r, z);
+        const double beta = rzNew / rz;
+        rz = rzNew;
+        for( size_t i = 0; i < n; ++i )
+            p[i] = z[i] + beta * p[i];
+    }
+}
+
+bool Multigrid::solve( const double* b, double* x )
+{
+    m_iterations = 0;
+    m_residual = 0.0;
+    if( m_levels.empty() ) {
+        LOG(logERROR) << "Multigrid::solve setup was not done";
+        return false;
+    }
+
+    Level& l = m_levels.front();
+    const size_t n = l.n;
+    std::fill(x, x + n, 0.0);
+    std::copy(b, b + n, m_r.begin());
+    const double bnorm = std::sqrt(dot(m_r, m_r));
+    if( bnorm == 0.0 )
+        return true;
+
+    m_residual = 1.0;
+    if( m_preconditioned ) {
+        precondition(m_r, m_z);
+        m_p = m_z;
+        double rz = dot(m_r, m_z);
+        while( m_iterations < m_maxIterations && m_residual > m_tolerance ) {
+            l.multiply(m_p.data(), m_ap.data());
+            const double pap = dot(m_p, m_ap);
+            if( pap <= 0.0 )
+                break;
+            const double a = rz / pap;
+            for( size_t i = 0; i < n; ++i ) {
+                x[i] += a * m_p[i];
+                m_r[i] -= a * m_ap[i];
+            }
+            ++m_iterations;
+            m_residual = std::sqrt(dot(m_r, m_r)) / bnorm;
+            if( m_residual <= m_tolerance )
+                break;
+            precondition(m_r, m_z);
+            const double rzNew = dot(m_r, m_z);
+            const double beta = rzNew / rz;
+            rz = rzNew;
+            for( size_t i = 0; i < n; ++i )
+                m_p[i] = m_z[i] + beta * m_p[i];
+        }
+    }
+    else {
+        while( m_iterations < m_maxIterations && m_residual > m_tolerance ) {
+            precondition(m_r, m_z);
+            for( size_t i = 0; i < n; ++i )
+                x[i] += m_z[i];
+            l.multiply(x, m_ap.data());
+            for( size_t i = 0; i < n; ++i )
+                m_r[i] = b[i] - m_ap[i];
+            ++m_iterations;
+            m_residual = std::sqrt(dot(m_r, m_r)) / bnorm;
+        }
+    }
+
+    if( m_residual > m_tolerance ) {
+        LOG(logWARNING) << "Multigrid::solve residual " << m_residual << " after "
+                        << m_iterations << " iterations";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,161 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_MULTIGRID_H
+#define MLD_MULTIGRID_H
+
+#include <vector>
+
+#include "mld/common.h"
+#include "mld/model/CSRMatrix.h"
+#include "mld/model/TransferMap.h"
+
+namespace mld {
+
+class GraphSnapshot;
+
+/**
+ * @brief Multigrid solver of (L + alpha I) x = b, L is the combinatorial Laplacian.
+ * The levels follow the layers of the MLG: level k+1 aggregates the nodes of level k
+ * through the VLinks. The prolongation is x_c = w_c x_p (TransferMap::WEIGHTED),
+ * the restriction is its transpose and coarse operators are the Galerkin products
+ * A_k+1 = P^T A_k P, so the V-cycle is symmetric positive definite.
+ * The coarsest level is factorized (Cholesky) if small enough, else solved with CG.
+ * By default the V-cycle preconditions a conjugate gradient on the finest level.
+ */
+class MLD_API Multigrid
+{
+public:
+    enum Smoother {
+        JACOBI,         // Damped Jacobi
+        GAUSS_SEIDEL    // Forward sweeps before, backward sweeps after the coarse correction
+    };
+
+    Multigrid();
+
+    /**
+     * @brief Set the shift of the Laplacian, must be > 0. Default is 1
+     * @param alpha
+     */
+    inline void setAlpha( double alpha ) { m_alpha = alpha; }
+    inline double alpha() const { return m_alpha; }
+
+    inline void setSmoother( Smoother s ) { m_smoother = s; }
+    inline Smoother smoother() const { return m_smoother; }
+    /**
+     * @brief Number of pre and post smoothing sweeps. Default is 2
+     */
+    inline void setSmoothingSteps( uint32_t steps ) { m_steps = steps; }
+    inline uint32_t smoothingSteps() const { return m_steps; }
+    /**
+     * @brief Damping of the Jacobi smoother. Default is 2/3
+     */
+    inline void setJacobiWeight( double w ) { m_jacobiWeight = w; }
+    inline double jacobiWeight() const { return m_jacobiWeight; }
+
+    /**
+     * @brief Levels with at most size nodes are the coarsest and are factorized.
+     * Default is 512
+     * @param size
+     */
+    inline void setDirectSize( size_t size ) { m_directSize = size; }
+    inline size_t directSize() const { return m_directSize; }
+
+    /**
+     * @brief Relative residual norm to reach. Default is 1e-8
+     */
+    inline void setTolerance( double tol ) { m_tolerance = tol; }
+    inline double tolerance() const { return m_tolerance; }
+    /**
+     * @brief Maximum number of CG iterations or V-cycles. Default is 100
+     */
+    inline void setMaxIterations( uint32_t it ) { m_maxIterations = it; }
+    inline uint32_t maxIterations() const { return m_maxIterations; }
+    /**
+     * @brief Use the V-cycle as a CG preconditioner (default) or iterate V-cycles
+     */
+    inline void setPreconditioned( bool v ) { m_preconditioned = v; }
+    inline bool preconditioned() const { return m_preconditioned; }
+
+    /**
+     * @brief Build the operators of all the levels
+     * @param graph Finest level
+     * @param maps Map of each level to the next one, from the finest level.
+     * Coarsening stops at the first level small enough to be factorized
+     * @return success
+     */
+    bool setup( const GraphSnapshot& graph, const std::vector<TransferMap>& maps );
+
+    /**
+     * @brief Solve the system for one right hand side
+     * @param b Right hand side, one value per node of the finest level
+     * @param x Output solution
+     * @return true if the tolerance was reached
+     */
+    bool solve( const double* b, double* x );
+
+    inline size_t levelCount() const { return m_levels.size(); }
+    inline size_t levelSize( size_t k ) const { return m_levels[k].n; }
+    /**
+     * @brief Iterations and relative residual norm of the last solve
+     */
+    inline uint32_t iterations() const { return m_iterations; }
+    inline double residual() const { return m_residual; }
+
+private:
+    // Symmetric operator of a level and the work vectors of the V-cycle
+    struct Level : public CSRMatrix
+    {
+        Level( CSRMatrix&& a ) : CSRMatrix(std::move(a)) {}
+
+        std::vector<double> b;
+        std::vector<double> x;
+        std::vector<double> r;
+    };
+
+    void smooth( Level& l, bool forward );
+    void vcycle( size_t k );
+    void precondition( const std::vector<double>& r, std::vector<double>& z );
+    bool factorize( const Level& l );
+    void coarseSolve( Level& l );
+
+private:
+    double m_alpha;
+    Smoother m_smoother;
+    uint32_t m_steps;
+    double m_jacobiWeight;
+    size_t m_directSize;
+    double m_tolerance;
+    uint32_t m_maxIterations;
+    bool m_preconditioned;
+
+    std::vector<Level> m_levels;
+    std::vector<TransferMap> m_maps;
+    // Cholesky factor of the coarsest level, row major lower triangle
+    std::vector<double> m_chol;
+    std::vector<double> m_r;
+    std::vector<double> m_z;
+    std::vector<double> m_p;
+    std::vector<double> m_ap;
+    uint32_t m_iterations;
+    double m_residual;
+};
+
+} // end namespace mld
+
+#endif // MLD_MULTIGRID_H
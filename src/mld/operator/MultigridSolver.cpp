@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <sparksee/gdb/Graph.h>
+
+#include "mld/operator/MultigridSolver.h"
+#include "mld/model/TransferMap.h"
+#include "mld/dao/MLGDao.h"
+#include "mld/utils/Timer.h"
+#include "mld/utils/ProgressDisplay.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+MultigridSolver::MultigridSolver( Graph* g )
+    : m_dao(new MLGDao(g))
+    , m_mg()
+    , m_scale(1.0)
+    , m_maxLevels(0)
+    , m_writeBack(true)
+    , m_maxIt(0)
+    , m_maxResidual(0.0)
+{
+}
+
+MultigridSolver::~MultigridSolver()
+{
+}
+
+void MultigridSolver::setAlpha( double alpha )
+{
+    m_mg.setAlpha(alpha);
+    m_scale = 1.0;
+}
+
+bool MultigridSolver::setTikhonov( double gamma )
+{
+    if( gamma <= 0.0 ) {
+        LOG(logERROR) << "MultigridSolver::setTikhonov gamma must be > 0";
+        m_scale = 0.0;  // checked in preExec
+        return false;
+    }
+    // (I + gamma L) x = y  <=>  (L + I / gamma) x = y / gamma
+    m_mg.setAlpha(1.0 / gamma);
+    m_scale = 1.0 / gamma;
+    return true;
+}
+
+bool MultigridSolver::solve( const SignalStore& in, SignalStore& out )
+{
+    std::unique_ptr<Timer> t(new Timer("MultigridSolver::solve"));
+    if( m_mg.levelCount() == 0 || in.nodeCount() != m_mg.levelSize(0) ) {
+        LOG(logERROR) << "MultigridSolver::solve signal and levels sizes mismatch";
+        return false;
+    }
+
+    const size_t n = in.nodeCount();
+    const size_t rows = in.layerCount() * in.channelCount();
+    out.resize(in.layers(), n, in.channelCount());
+    m_maxIt = 0;
+    m_maxResidual = 0.0;
+
+    std::vector<double> b(n);
+    std::vector<double> x(n);
+    bool ok = true;
+    ProgressDisplay display(rows);
+    for( size_t r = 0; r < rows; ++r ) {
+        const SignalValue* row = in.data().data() + r * n;
+        for( size_t i = 0; i < n; ++i )
+            b[i] = m_scale * row[i];
+        ok = m_mg.solve(b.data(), x.data()) && ok;
+        SignalValue* res = out.data().data() + r * n;
+        for( size_t i = 0; i < n; ++i )
+            res[i] = SignalValue(x[i]);
+        m_maxIt = std::max(m_maxIt, m_mg.iterations());
+        m_maxResidual = std::max(m_maxResidual, m_mg.residual());
+        ++display;
+    }
+    return ok;
+}
+
+bool MultigridSolver::preExec()
+{
+    std::unique_ptr<Timer> t(new Timer("MultigridSolver::preExec"));
+    m_result.clear();
+    if( m_scale <= 0.0 ) {
+        LOG(logERROR) << "MultigridSolver::preExec invalid Tikhonov regularization";
+        return false;
+    }
+    Layer base(m_dao->baseLayer());
+    m_graph = m_dao->getGraphSnapshot(base);
+
+    std::vector<TransferMap> maps;
+    if( !m_dao->getTransferMaps(m_graph, base, maps, m_maxLevels) )
+        return false;
+    if( !m_mg.setup(m_graph, maps) )
+        return false;
+    std::string sizes;
+    for( size_t k = 0; k < m_mg.levelCount(); ++k )
+        sizes += " " + std::to_string(m_mg.levelSize(k));
+    LOG(logINFO) << "Multigrid levels:" << sizes;
+
+    std::vector<oid_t> layers(m_layers);
+    if( layers.empty() )
+        layers.push_back(base.id());
+    return m_dao->getSignalStore(m_graph, layers, m_signal, m_channels);
+}
+
+bool MultigridSolver::exec()
+{
+    LOG(logINFO) << "Solve " << m_signal.layerCount() * m_signal.channelCount()
+                 << " signals on " << m_graph.nodeCount() << " nodes";
+    bool ok = solve(m_signal, m_result);
+    LOG(logINFO) << "Max iterations: " << m_maxIt << " max relative residual: " << m_maxResidual;
+    m_signal.clear();
+    return ok;
+}
+
+bool MultigridSolver::postExec()
+{
+    if( !m_writeBack )
+        return true;
+
+    std::unique_ptr<Timer> t(new Timer("MultigridSolver::postExec"));
+    LOG(logINFO) << "Commit solution in DB";
+    return m_dao->updateSignalStore(m_graph, m_result, m_channels);
+}
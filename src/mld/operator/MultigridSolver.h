@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_MULTIGRIDSOLVER_H
+#define MLD_MULTIGRIDSOLVER_H
+
+#include "mld/operator/AbstractOperator.h"
+#include "mld/operator/Multigrid.h"
+#include "mld/model/GraphSnapshot.h"
+#include "mld/model/SignalStore.h"
+
+namespace sparksee {
+namespace gdb {
+    class Graph;
+}}
+
+namespace mld {
+
+class MLGDao;
+
+/**
+ * @brief Solve (L + alpha I) x = b on the base layer for the OLink signals,
+ * L is the combinatorial Laplacian of the base layer HLinks.
+ * The layers above the base layer linked by VLinks are the multigrid levels.
+ * With setTikhonov the signal y is denoised: x = argmin |x - y|^2 + gamma x^T L x.
+ */
+class MLD_API MultigridSolver : public AbstractOperator
+{
+public:
+    MultigridSolver( sparksee::gdb::Graph* g );
+    virtual ~MultigridSolver() override;
+
+    /**
+     * @brief Solve (L + alpha I) x = b, b is the OLink signal
+     * @param alpha Shift, > 0
+     */
+    void setAlpha( double alpha );
+    /**
+     * @brief Solve (I + gamma L) x = y, y is the OLink signal
+     * @param gamma Regularization, > 0. Otherwise run fails until
+     * a valid gamma or alpha is set
+     * @return success
+     */
+    bool setTikhonov( double gamma );
+
+    /**
+     * @brief Maximum number of levels, 0 for all the layers. Default is 0
+     * @param levels
+     */
+    inline void setMaxLevels( uint32_t levels ) { m_maxLevels = levels; }
+    inline uint32_t maxLevels() const { return m_maxLevels; }
+
+    /**
+     * @brief Layers of the signals to solve for. Default is the base layer
+     * @param layers Layer ids
+     */
+    inline void setSignalLayers( const std::vector<sparksee::gdb::oid_t>& layers ) { m_layers = layers; }
+    /**
+     * @brief Extra OLink double attributes solved with the OLink weight
+     * @param channels
+     */
+    inline void setChannels( const std::vector<std::wstring>& channels ) { m_channels = channels; }
+
+    /**
+     * @brief Write the solution back in the OLinks. Default is true
+     * @param v
+     */
+    inline void setWriteBack( bool v ) { m_writeBack = v; }
+    inline bool writeBack() const { return m_writeBack; }
+
+    /**
+     * @brief Solver settings: smoother, tolerance, iterations ...
+     */
+    inline Multigrid& multigrid() { return m_mg; }
+
+    /**
+     * @brief Solve each row of an in-memory signal, the multigrid has to be set up
+     * @param in Right hand sides
+     * @param out Solutions
+     * @return success
+     */
+    bool solve( const SignalStore& in, SignalStore& out );
+
+    inline const SignalStore& result() const { return m_result; }
+    inline const GraphSnapshot& graph() const { return m_graph; }
+    /**
+     * @brief Largest number of iterations and relative residual over the signals of the last run
+     */
+    inline uint32_t maxIterations() const { return m_maxIt; }
+    inline double maxResidual() const { return m_maxResidual; }
+
+protected:
+    /**
+     * @brief Load the level hierarchy and the signals, build the level operators
+     * @return success
+     */
+    virtual bool preExec() override;
+    /**
+     * @brief Solve for all the signals
+     * @return success
+     */
+    virtual bool exec() override;
+    /**
+     * @brief Commit the solution in the OLinks if write back is enabled
+     * @return success
+     */
+    virtual bool postExec() override;
+
+private:
+    std::unique_ptr<MLGDao> m_dao;
+    Multigrid m_mg;
+    double m_scale;
+    uint32_t m_maxLevels;
+    std::vector<sparksee::gdb::oid_t> m_layers;
+    std::vector<std::wstring> m_channels;
+    bool m_writeBack;
+
+    GraphSnapshot m_graph;
+    SignalStore m_signal;
+    SignalStore m_result;
+    uint32_t m_maxIt;
+    double m_maxResidual;
+};
+
+} // end namespace mld
+
+#endif // MLD_MULTIGRIDSOLVER_H
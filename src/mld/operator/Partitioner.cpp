@@ -0,0 +1,96 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <sparksee/gdb/Graph.h>
+#include <sparksee/gdb/Value.h>
+
+#include "mld/operator/Partitioner.h"
+#include "mld/SparkseeManager.h"
+#include "mld/dao/MLGDao.h"
+#include "mld/utils/Timer.h"
+#include "mld/utils/ProgressDisplay.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+Partitioner::Partitioner( Graph* g )
+    : m_dao(new MLGDao(g))
+    , m_partitioner()
+    , m_maxLevels(0)
+    , m_key(L"partition")
+    , m_writeBack(true)
+{
+}
+
+Partitioner::~Partitioner()
+{
+}
+
+bool Partitioner::preExec()
+{
+    std::unique_ptr<Timer> t(new Timer("Partitioner::preExec"));
+    Layer base(m_dao->baseLayer());
+    m_graph = m_dao->getGraphSnapshot(base);
+    return m_dao->getTransferMaps(m_graph, base, m_maps, m_maxLevels);
+}
+
+bool Partitioner::exec()
+{
+    std::unique_ptr<Timer> t(new Timer("Partitioner::exec"));
+    bool ok = m_partitioner.partition(m_graph, m_maps);
+    m_maps.clear();
+    if( !ok )
+        return false;
+
+    std::string sizes;
+    for( size_t k = 0; k < m_partitioner.levelCount(); ++k )
+        sizes += " " + std::to_string(m_partitioner.levelSize(k));
+    LOG(logINFO) << "Partitioner levels:" << sizes;
+    LOG(logINFO) << m_partitioner.partCount() << " parts, edge cut: " << m_partitioner.edgeCut()
+                 << " balance: " << m_partitioner.balance();
+    return true;
+}
+
+bool Partitioner::postExec()
+{
+    if( !m_writeBack )
+        return true;
+
+    std::unique_ptr<Timer> t(new Timer("Partitioner::postExec"));
+    LOG(logINFO) << "Commit partition in DB";
+    Graph* g = m_dao->graph();
+    attr_t attr = g->FindAttribute(m_dao->nodeType(), m_key);
+    if( attr == Attribute::InvalidAttribute ) {
+        // Indexed to select the nodes of a shard
+        if( !SparkseeManager::addAttrToNode(g, m_key, Integer, Indexed, Value().SetNull()) ) {
+            LOG(logERROR) << "Partitioner::postExec failed to add node attribute "
+                          << std::string(m_key.begin(), m_key.end());
+            return false;
+        }
+        attr = g->FindAttribute(m_dao->nodeType(), m_key);
+    }
+
+    const std::vector<uint32_t>& parts = m_partitioner.parts();
+    Value v;
+    ProgressDisplay display(m_graph.nodeCount());
+    for( size_t i = 0; i < m_graph.nodeCount(); ++i ) {
+        g->SetAttribute(m_graph.nodeId(i), attr, v.SetInteger(int32_t(parts[i])));
+        ++display;
+    }
+    return true;
+}
@@ -0,0 +1,103 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_PARTITIONER_H
+#define MLD_PARTITIONER_H
+
+#include "mld/operator/AbstractOperator.h"
+#include "mld/operator/KWayPartitioner.h"
+#include "mld/model/GraphSnapshot.h"
+
+namespace sparksee {
+namespace gdb {
+    class Graph;
+}}
+
+namespace mld {
+
+class MLGDao;
+
+/**
+ * @brief k-way partitioning of the base layer nodes computed on the MLG hierarchy,
+ * the layers above the base layer linked by VLinks are the coarse levels.
+ * The part of each node is stored in an integer node attribute.
+ */
+class MLD_API Partitioner : public AbstractOperator
+{
+public:
+    Partitioner( sparksee::gdb::Graph* g );
+    virtual ~Partitioner() override;
+
+    /**
+     * @brief Maximum number of levels, 0 for all the layers. Default is 0
+     * @param levels
+     */
+    inline void setMaxLevels( uint32_t levels ) { m_maxLevels = levels; }
+    inline uint32_t maxLevels() const { return m_maxLevels; }
+
+    /**
+     * @brief Name of the node attribute. Default is "partition"
+     * @param key
+     */
+    inline void setAttribute( const std::wstring& key ) { m_key = key; }
+    inline const std::wstring& attribute() const { return m_key; }
+
+    /**
+     * @brief Write the parts in the node attribute. Default is true
+     * @param v
+     */
+    inline void setWriteBack( bool v ) { m_writeBack = v; }
+    inline bool writeBack() const { return m_writeBack; }
+
+    /**
+     * @brief Partitioner settings: number of parts, imbalance ...
+     */
+    inline KWayPartitioner& partitioner() { return m_partitioner; }
+    inline const GraphSnapshot& graph() const { return m_graph; }
+
+protected:
+    /**
+     * @brief Load the base layer and the level hierarchy
+     * @return success
+     */
+    virtual bool preExec() override;
+    /**
+     * @brief Partition the base layer
+     * @return success
+     */
+    virtual bool exec() override;
+    /**
+     * @brief Store the parts in the node attribute if write back is enabled
+     * @return success
+     */
+    virtual bool postExec() override;
+
+private:
+    std::unique_ptr<MLGDao> m_dao;
+    KWayPartitioner m_partitioner;
+    uint32_t m_maxLevels;
+    std::wstring m_key;
+    bool m_writeBack;
+
+    GraphSnapshot m_graph;
+    std::vector<TransferMap> m_maps;
+};
+
+} // end namespace mld
+
+#endif // MLD_PARTITIONER_H
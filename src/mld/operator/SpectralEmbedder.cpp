@@ -0,0 +1,104 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <sparksee/gdb/Graph.h>
+#include <sparksee/gdb/Value.h>
+
+#include "mld/operator/SpectralEmbedder.h"
+#include "mld/SparkseeManager.h"
+#include "mld/dao/MLGDao.h"
+#include "mld/utils/Timer.h"
+#include "mld/utils/ProgressDisplay.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+SpectralEmbedder::SpectralEmbedder( Graph* g )
+    : m_dao(new MLGDao(g))
+    , m_embedding()
+    , m_maxLevels(0)
+    , m_prefix(L"spectral_")
+    , m_writeBack(true)
+{
+}
+
+SpectralEmbedder::~SpectralEmbedder()
+{
+}
+
+bool SpectralEmbedder::preExec()
+{
+    std::unique_ptr<Timer> t(new Timer("SpectralEmbedder::preExec"));
+    Layer base(m_dao->baseLayer());
+    m_graph = m_dao->getGraphSnapshot(base);
+    return m_dao->getTransferMaps(m_graph, base, m_maps, m_maxLevels);
+}
+
+bool SpectralEmbedder::exec()
+{
+    std::unique_ptr<Timer> t(new Timer("SpectralEmbedder::exec"));
+    bool ok = m_embedding.compute(m_graph, m_maps);
+    m_maps.clear();
+    if( !ok )
+        return false;
+
+    std::string sizes;
+    for( size_t k = 0; k < m_embedding.levelCount(); ++k )
+        sizes += " " + std::to_string(m_embedding.levelSize(k));
+    LOG(logINFO) << "Spectral embedding levels:" << sizes;
+    std::string values;
+    for( auto v: m_embedding.eigenvalues() )
+        values += " " + std::to_string(v);
+    LOG(logINFO) << "Eigenvalues:" << values << " max residual: " << m_embedding.residual();
+    return true;
+}
+
+bool SpectralEmbedder::postExec()
+{
+    if( !m_writeBack )
+        return true;
+
+    std::unique_ptr<Timer> t(new Timer("SpectralEmbedder::postExec"));
+    LOG(logINFO) << "Commit embedding in DB";
+    Graph* g = m_dao->graph();
+    const size_t dim = m_embedding.dimension();
+    std::vector<attr_t> attrs;
+    for( size_t j = 0; j < dim; ++j ) {
+        std::wstring key(m_prefix + std::to_wstring(j));
+        attr_t attr = g->FindAttribute(m_dao->nodeType(), key);
+        if( attr == Attribute::InvalidAttribute ) {
+            if( !SparkseeManager::addAttrToNode(g, key, Double, Basic, Value().SetNull()) ) {
+                LOG(logERROR) << "SpectralEmbedder::postExec failed to add node attribute "
+                              << std::string(key.begin(), key.end());
+                return false;
+            }
+            attr = g->FindAttribute(m_dao->nodeType(), key);
+        }
+        attrs.push_back(attr);
+    }
+
+    const std::vector<double>& coords = m_embedding.embedding();
+    Value v;
+    ProgressDisplay display(m_graph.nodeCount());
+    for( size_t i = 0; i < m_graph.nodeCount(); ++i ) {
+        for( size_t j = 0; j < dim; ++j )
+            g->SetAttribute(m_graph.nodeId(i), attrs[j], v.SetDouble(coords[i * dim + j]));
+        ++display;
+    }
+    return true;
+}
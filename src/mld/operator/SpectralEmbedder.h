@@ -0,0 +1,103 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_SPECTRALEMBEDDER_H
+#define MLD_SPECTRALEMBEDDER_H
+
+#include "mld/operator/AbstractOperator.h"
+#include "mld/operator/SpectralEmbedding.h"
+#include "mld/model/GraphSnapshot.h"
+
+namespace sparksee {
+namespace gdb {
+    class Graph;
+}}
+
+namespace mld {
+
+class MLGDao;
+
+/**
+ * @brief Spectral embedding of the base layer nodes computed on the MLG hierarchy,
+ * the layers above the base layer linked by VLinks are the levels.
+ * Coordinate j of each node is stored in the double node attribute prefix + j.
+ */
+class MLD_API SpectralEmbedder : public AbstractOperator
+{
+public:
+    SpectralEmbedder( sparksee::gdb::Graph* g );
+    virtual ~SpectralEmbedder() override;
+
+    /**
+     * @brief Maximum number of levels, 0 for all the layers. Default is 0
+     * @param levels
+     */
+    inline void setMaxLevels( uint32_t levels ) { m_maxLevels = levels; }
+    inline uint32_t maxLevels() const { return m_maxLevels; }
+
+    /**
+     * @brief Prefix of the node attributes. Default is "spectral_"
+     * @param prefix
+     */
+    inline void setAttributePrefix( const std::wstring& prefix ) { m_prefix = prefix; }
+    inline const std::wstring& attributePrefix() const { return m_prefix; }
+
+    /**
+     * @brief Write the coordinates in the node attributes. Default is true
+     * @param v
+     */
+    inline void setWriteBack( bool v ) { m_writeBack = v; }
+    inline bool writeBack() const { return m_writeBack; }
+
+    /**
+     * @brief Eigen solver settings: dimension, refinement steps ...
+     */
+    inline SpectralEmbedding& embedding() { return m_embedding; }
+    inline const GraphSnapshot& graph() const { return m_graph; }
+
+protected:
+    /**
+     * @brief Load the base layer and the level hierarchy
+     * @return success
+     */
+    virtual bool preExec() override;
+    /**
+     * @brief Compute the eigenvectors
+     * @return success
+     */
+    virtual bool exec() override;
+    /**
+     * @brief Store the coordinates in the node attributes if write back is enabled
+     * @return success
+     */
+    virtual bool postExec() override;
+
+private:
+    std::unique_ptr<MLGDao> m_dao;
+    SpectralEmbedding m_embedding;
+    uint32_t m_maxLevels;
+    std::wstring m_prefix;
+    bool m_writeBack;
+
+    GraphSnapshot m_graph;
+    std::vector<TransferMap> m_maps;
+};
+
+} // end namespace mld
+
+#endif // MLD_SPECTRALEMBEDDER_H
@@ -0,0 +1,358 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+#include "mld/operator/SpectralEmbedding.h"
+#include "mld/model/GraphSnapshot.h"
+#include "mld/utils/Tridiagonal.h"
+
+using namespace mld;
+
+namespace {
+
+using Vectors = std::vector<std::vector<double>>;
+
+double massDot( const std::vector<double>& a, const std::vector<double>& b, const std::vector<double>& mass )
+{
+    double res = 0.0;
+    for( size_t i = 0; i < a.size(); ++i )
+        res += mass[i] * a[i] * b[i];
+    return res;
+}
+
+/**
+ * @brief M-orthogonalize x against the constant vector and the basis then M-normalize it
+ * @return false if x is (numerically) in the span of the basis
+ */
+bool orthonormalize( std::vector<double>& x, const Vectors& basis,
+                     const std::vector<double>& mass, double totalMass )
+{
+    const double before = std::sqrt(massDot(x, x, mass));
+    if( before == 0.0 )
+        return false;
+    // Twice is enough (Kahan)
+    for( int pass = 0; pass < 2; ++pass ) {
+        double mean = 0.0;
+        for( size_t i = 0; i < x.size(); ++i )
+            mean += mass[i] * x[i];
+        mean /= totalMass;
+        for( auto& v: x )
+            v -= mean;
+        for( auto& b: basis ) {
+            const double c = massDot(x, b, mass);
+            for( size_t i = 0; i < x.size(); ++i )
+                x[i] -= c * b[i];
+        }
+    }
+    const double after = std::sqrt(massDot(x, x, mass));
+    if( after <= 1e-10 * before )
+        return false;
+    for( auto& v: x )
+        v /= after;
+    return true;
+}
+
+} // end namespace anonymous
+
+SpectralEmbedding::SpectralEmbedding()
+    : m_dim(2)
+    , m_krylov(100)
+    , m_steps(3)
+    , m_seed(0)
+    , m_residual(0.0)
+{
+}
+
+bool SpectralEmbedding::compute( const GraphSnapshot& graph, const std::vector<TransferMap>& maps )
+{
+    m_levels.clear();
+    m_values.clear();
+    m_embedding.clear();
+    m_residual = 0.0;
+    if( m_dim == 0 ) {
+        LOG(logERROR) << "SpectralEmbedding::compute dimension must be > 0";
+        return false;
+    }
+
+    Level fine(CSRMatrix::laplacian(graph));
+    fine.mass.assign(fine.n, 1.0);
+    if( fine.n <= m_dim ) {
+        LOG(logERROR) << "SpectralEmbedding::compute graph has less than " << m_dim + 1 << " nodes";
+        return false;
+    }
+    m_levels.push_back(std::move(fine));
+
+    for( auto& map: maps ) {
+        const Level& l = m_levels.back();
+        if( map.fineCount() != l.n ) {
+            LOG(logERROR) << "SpectralEmbedding::compute map size mismatch on level " << m_levels.size() - 1;
+            return false;
+        }
+        // The coarse problem needs at least dim non trivial eigenvectors
+        if( map.orphanCount() == map.fineCount() || map.coarseCount() <= m_dim )
+            break;
+        Level c(coarsen(l, map));
+        m_levels.push_back(std::move(c));
+    }
+
+    Vectors vecs;
+    bool exhausted = false;
+    if( !lanczos(m_levels.back(), vecs, exhausted) )
+        return false;
+    if( !exhausted && !refine(m_levels.back(), vecs) )
+        return false;
+
+    for( size_t k = m_levels.size() - 1; k-- > 0; ) {
+        const TransferMap& map = maps[k];
+        const Level& l = m_levels[k];
+        for( auto& v: vecs ) {
+            // Orphans start at 0, the refinement fixes them
+            std::vector<double> vf(l.n, 0.0);
+            for( size_t i = 0; i < l.n; ++i ) {
+                const size_t p = map.parent(i);
+                if( p != INVALID_INDEX )
+                    vf[i] = v[p];
+            }
+            v.swap(vf);
+        }
+        if( !refine(l, vecs) )
+            return false;
+    }
+
+    // Fix the sign: the largest component is positive
+    const Level& base = m_levels.front();
+    std::vector<double> lv(base.n);
+    m_embedding.assign(base.n * m_dim, 0.0);
+    for( size_t j = 0; j < m_dim; ++j ) {
+        auto& v = vecs[j];
+        size_t imax = 0;
+        for( size_t i = 1; i < base.n; ++i ) {
+            if( std::fabs(v[i]) > std::fabs(v[imax]) )
+                imax = i;
+        }
+        if( v[imax] < 0.0 ) {
+            for( auto& x: v )
+                x = -x;
+        }
+        base.multiply(v.data(), lv.data());
+        double res = 0.0;
+        for( size_t i = 0; i < base.n; ++i ) {
+            const double r = lv[i] - m_values[j] * v[i];
+            res += r * r;
+            m_embedding[i * m_dim + j] = v[i];
+        }
+        m_residual = std::max(m_residual, std::sqrt(res));
+    }
+    return true;
+}
+
+SpectralEmbedding::Level SpectralEmbedding::coarsen( const Level& fine, const TransferMap& map )
+{
+    // Unweighted aggregation, the mass of a parent is the mass of its children
+    Level c(CSRMatrix::galerkin(fine, map, CSRMatrix::UNIT));
+    c.mass.assign(c.n, 0.0);
+    for( size_t p = 0; p < c.n; ++p ) {
+        for( size_t e = map.childBegin(p); e != map.childEnd(p); ++e )
+            c.mass[p] += fine.mass[map.children()[e]];
+        // Parent without children, decoupled
+        if( c.mass[p] == 0.0 )
+            c.mass[p] = 1.0;
+    }
+    return c;
+}
+
+bool SpectralEmbedding::lanczos( const Level& l, Vectors& vecs, bool& exhausted )
+{
+    const size_t n = l.n;
+    // The constant vector is deflated, n - 1 dimensions remain
+    const size_t m = std::min<size_t>(std::max<size_t>(m_krylov, m_dim), n - 1);
+    exhausted = m == n - 1;
+
+    // Work with y = M^1/2 v, the constant becomes u0 = M^1/2 1
+    std::vector<double> sqrtM(n);
+    double totalMass = 0.0;
+    for( size_t i = 0; i < n; ++i ) {
+        sqrtM[i] = std::sqrt(l.mass[i]);
+        totalMass += l.mass[i];
+    }
+    std::vector<double> u0(sqrtM);
+    for( auto& v: u0 )
+        v /= std::sqrt(totalMass);
+
+    std::mt19937 gen(m_seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<double> q(n);
+    for( auto& v: q )
+        v = dist(gen);
+
+    Vectors basis;
+    std::vector<double> alpha;
+    std::vector<double> beta;
+    std::vector<double> tmp(n);
+    std::vector<double> w(n);
+    double anorm = 0.0;
+    while( true ) {
+        // Full reorthogonalization, twice
+        for( int pass = 0; pass < 2; ++pass ) {
+            double c = dot(q, u0);
+            for( size_t i = 0; i < n; ++i )
+                q[i] -= c * u0[i];
+            for( auto& b: basis ) {
+                c = dot(q, b);
+                for( size_t i = 0; i < n; ++i )
+                    q[i] -= c * b[i];
+            }
+        }
+        const double norm = std::sqrt(dot(q, q));
+        if( !basis.empty() ) {
+            // Invariant subspace found
+            if( norm <= 1e-10 * anorm )
+                break;
+            beta.push_back(norm);
+        }
+        for( auto& v: q )
+            v /= norm;
+        basis.push_back(q);
+
+        // w = M^-1/2 L M^-1/2 q
+        for( size_t i = 0; i < n; ++i )
+            tmp[i] = q[i] / sqrtM[i];
+        l.multiply(tmp.data(), w.data());
+        for( size_t i = 0; i < n; ++i )
+            w[i] /= sqrtM[i];
+        const double a = dot(q, w);
+        alpha.push_back(a);
+        anorm = std::max(anorm, std::fabs(a) + (beta.empty() ? 0.0 : beta.back()));
+        if( basis.size() == m )
+            break;
+        q.swap(w);
+    }
+
+    const size_t size = alpha.size();
+    if( size < m_dim ) {
+        LOG(logERROR) << "SpectralEmbedding::lanczos Krylov space of dimension " << size
+                      << " is too small";
+        return false;
+    }
+    if( size < m )
+        exhausted = true;
+
+    std::vector<double> d(alpha);
+    std::vector<double> z;
+    if( !tridiagonalEigen(d, beta, z) ) {
+        LOG(logERROR) << "SpectralEmbedding::lanczos tridiagonal eigen solver did not converge";
+        return false;
+    }
+    std::vector<size_t> order(size);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&d]( size_t x, size_t y ) { return d[x] < d[y]; });
+
+    vecs.assign(m_dim, std::vector<double>(n, 0.0));
+    m_values.assign(m_dim, 0.0);
+    for( size_t j = 0; j < m_dim; ++j ) {
+        const size_t c = order[j];
+        m_values[j] = d[c];
+        auto& v = vecs[j];
+        for( size_t b = 0; b < size; ++b ) {
+            const double coef = z[b * size + c];
+            for( size_t i = 0; i < n; ++i )
+                v[i] += coef * basis[b][i];
+        }
+        for( size_t i = 0; i < n; ++i )
+            v[i] /= sqrtM[i];
+    }
+    return true;
+}
+
+bool SpectralEmbedding::refine( const Level& l, Vectors& vecs )
+{
+    const size_t n = l.n;
+    const size_t k = vecs.size();
+    const double totalMass = std::accumulate(l.mass.begin(), l.mass.end(), 0.0);
+    Vectors dirs;
+    std::vector<double> lv(n);
+    for( uint32_t step = 0; step < m_steps; ++step ) {
+        // Basis [V, D^-1 (L V - M V Lambda), P]
+        Vectors candidates(vecs);
+        for( size_t j = 0; j < k; ++j ) {
+            l.multiply(vecs[j].data(), lv.data());
+            std::vector<double> r(n, 0.0);
+            for( size_t i = 0; i < n; ++i ) {
+                if( l.diag[i] > 0.0 )
+                    r[i] = (lv[i] - m_values[j] * l.mass[i] * vecs[j][i]) / l.diag[i];
+            }
+            candidates.push_back(std::move(r));
+        }
+        for( auto& p: dirs )
+            candidates.push_back(std::move(p));
+
+        Vectors basis;
+        for( auto& c: candidates ) {
+            if( orthonormalize(c, basis, l.mass, totalMass) )
+                basis.push_back(std::move(c));
+        }
+        const size_t nb = basis.size();
+        if( nb < k ) {
+            LOG(logERROR) << "SpectralEmbedding::refine search space is degenerated";
+            return false;
+        }
+
+        // Projected problem H = B^T L B, B is M-orthonormal
+        Vectors lb(nb, std::vector<double>(n));
+        for( size_t a = 0; a < nb; ++a )
+            l.multiply(basis[a].data(), lb[a].data());
+        std::vector<double> h(nb * nb);
+        for( size_t a = 0; a < nb; ++a ) {
+            for( size_t b = a; b < nb; ++b ) {
+                const double v = 0.5 * (dot(basis[a], lb[b]) + dot(basis[b], lb[a]));
+                h[a * nb + b] = v;
+                h[b * nb + a] = v;
+            }
+        }
+        std::vector<double> d;
+        std::vector<double> z;
+        if( !symmetricEigen(h, nb, d, z) ) {
+            LOG(logERROR) << "SpectralEmbedding::refine eigen solver did not converge";
+            return false;
+        }
+
+        // New vectors and search directions (their part outside the current vectors)
+        const size_t first = std::min(k, nb);
+        dirs.assign(k, std::vector<double>(n, 0.0));
+        for( size_t j = 0; j < k; ++j ) {
+            auto& v = vecs[j];
+            auto& p = dirs[j];
+            std::fill(v.begin(), v.end(), 0.0);
+            for( size_t a = 0; a < nb; ++a ) {
+                const double coef = z[a * nb + j];
+                for( size_t i = 0; i < n; ++i )
+                    v[i] += coef * basis[a][i];
+                if( a >= first ) {
+                    for( size_t i = 0; i < n; ++i )
+                        p[i] += coef * basis[a][i];
+                }
+            }
+            m_values[j] = d[j];
+        }
+    }
+    return true;
+}
@@ -0,0 +1,136 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_SPECTRALEMBEDDING_H
+#define MLD_SPECTRALEMBEDDING_H
+
+#include <vector>
+
+#include "mld/common.h"
+#include "mld/model/CSRMatrix.h"
+#include "mld/model/TransferMap.h"
+
+namespace mld {
+
+class GraphSnapshot;
+
+/**
+ * @brief Smallest non trivial eigenvectors of the combinatorial Laplacian L computed
+ * on the MLG hierarchy. Level k+1 aggregates the nodes of level k through the VLinks,
+ * the prolongation copies the parent value (x_c = x_p) and the coarse problems are
+ * L_k+1 v = lambda M_k+1 v with L_k+1 = P^T L_k P and M_k+1 = P^T M_k P, M_0 = I.
+ * The coarsest level is solved by Lanczos with full reorthogonalization, the
+ * eigenvectors are then prolonged level by level and refined with block
+ * preconditioned Rayleigh-Ritz steps.
+ */
+class MLD_API SpectralEmbedding
+{
+public:
+    SpectralEmbedding();
+
+    /**
+     * @brief Number of eigenvectors, the constant one is skipped. Default is 2
+     * @param k
+     */
+    inline void setDimension( uint32_t k ) { m_dim = k; }
+    inline uint32_t dimension() const { return m_dim; }
+    /**
+     * @brief Maximum dimension of the Krylov space on the coarsest level. Default is 100
+     * @param size
+     */
+    inline void setKrylovSize( uint32_t size ) { m_krylov = size; }
+    inline uint32_t krylovSize() const { return m_krylov; }
+    /**
+     * @brief Number of Rayleigh-Ritz refinement steps on each finer level. Default is 3
+     * @param steps
+     */
+    inline void setRefineSteps( uint32_t steps ) { m_steps = steps; }
+    inline uint32_t refineSteps() const { return m_steps; }
+    /**
+     * @brief Seed of the Lanczos start vector. Default is 0
+     * @param seed
+     */
+    inline void setSeed( uint32_t seed ) { m_seed = seed; }
+
+    /**
+     * @brief Compute the embedding of the graph nodes
+     * @param graph Finest level
+     * @param maps Transfer maps, maps[k] goes from level k to level k+1
+     * @return success
+     */
+    bool compute( const GraphSnapshot& graph, const std::vector<TransferMap>& maps );
+
+    inline size_t levelCount() const { return m_levels.size(); }
+    inline size_t levelSize( size_t k ) const { return m_levels[k].n; }
+    /**
+     * @brief Eigenvalues of the last computation, in increasing order
+     */
+    inline const std::vector<double>& eigenvalues() const { return m_values; }
+    /**
+     * @brief Coordinates of the finest level nodes, node i is
+     * [embedding()[i * dimension()], embedding()[(i + 1) * dimension()])
+     */
+    inline const std::vector<double>& embedding() const { return m_embedding; }
+    /**
+     * @brief Largest residual norm |L v - lambda v| of the unit eigenvectors
+     */
+    inline double residual() const { return m_residual; }
+
+private:
+    // Laplacian of a level, M is the mass
+    struct Level : public CSRMatrix
+    {
+        Level( CSRMatrix&& a ) : CSRMatrix(std::move(a)) {}
+
+        std::vector<double> mass;
+    };
+    using Vectors = std::vector<std::vector<double>>;
+
+    static Level coarsen( const Level& fine, const TransferMap& map );
+    /**
+     * @brief Lanczos on M^-1/2 L M^-1/2, deflated of the constant vector
+     * @param l Level
+     * @param vecs Output M-orthonormal eigenvectors
+     * @param exhausted Set if the Krylov space spans the whole problem
+     * @return false if the Krylov space is too small
+     */
+    bool lanczos( const Level& l, Vectors& vecs, bool& exhausted );
+    /**
+     * @brief Rayleigh-Ritz on the vectors, their Jacobi preconditioned residuals
+     * and the previous search directions (LOBPCG)
+     * @param l Level
+     * @param vecs Eigenvectors, updated
+     * @return success
+     */
+    bool refine( const Level& l, Vectors& vecs );
+
+private:
+    uint32_t m_dim;
+    uint32_t m_krylov;
+    uint32_t m_steps;
+    uint32_t m_seed;
+
+    std::vector<Level> m_levels;
+    std::vector<double> m_values;
+    std::vector<double> m_embedding;
+    double m_residual;
+};
+
+} // end namespace mld
+
+#endif // MLD_SPECTRALEMBEDDING_H
@@ -36,19 +36,31 @@ TSCache::TSCache( const std::shared_ptr<MLGDao>& dao )
     , m_upperBoundLayer(Objects::InvalidOID)
     , m_entries(0)
     , m_maxEntries(MAXUINT)
+    , m_prefetchLayer(Objects::InvalidOID)
 {
 }
 
+TSCache::~TSCache()
+{
+    flushPrefetch();
+}
+
 void TSCache::reset( oid_t startLayer, TSDirection dir, size_t radius )
 {
     clear();
     m_activeLayer = startLayer;
     m_dir = dir;
     m_radius = radius;
+    if( startLayer == Objects::InvalidOID )
+        return;
+    // Entries are loaded up to this layer
+    m_upperBoundLayer = m_dao->getLayerBounds(m_activeLayer, m_dir, m_radius).second;
+    prefetch(m_dao->parent(m_upperBoundLayer));
 }
 
 void TSCache::clear()
 {
+    flushPrefetch();
     m_cacheMap.clear();
     m_cacheList.clear();
     m_entries = 0;
@@ -84,18 +96,26 @@ void TSCache::scrollUp()
     }
 
     m_upperBoundLayer = bounds.second;
-    // Update cache entries
-    type_t oType = m_dao->olinkType();
-    Value v;
-
-    for( auto& p: m_cacheList ) {
-        // Get OLink weight
-        oid_t eid = m_dao->findEdge(oType, m_upperBoundLayer, p.first);
-        m_dao->graph()->GetAttribute(eid, m_dao->graph()->FindAttribute(oType, Attrs::V[OLinkAttr::WEIGHT]), v);
+    // Fetch the new layer values at once and prepare the next one
+    OLinkWeightMap weights(loadLayer(m_upperBoundLayer));
+    prefetch(m_dao->parent(m_upperBoundLayer));
+
+    for( auto p = m_cacheList.begin(); p != m_cacheList.end(); ) {
+        auto it = weights.find(p->first);
+        if( it == weights.end() ) {
+            // Evict the entry, the next get() reloads it and reports the error
+            LOG(logERROR) << "TSCache::scrollUp no OLink for nid: " << p->first
+                          << " lid: " << m_upperBoundLayer;
+            m_cacheMap.erase(p->first);
+            p = m_cacheList.erase(p);
+            --m_entries;
+            continue;
+        }
         // Add new value
-        p.second.push_back(v.GetDouble());
-        p.second.scroll(); // scroll iterators
-        p.second.shrink(); // remove olds values
+        p->second.push_back(SignalValue(it->second));
+        p->second.scroll(); // scroll iterators
+        p->second.shrink(); // remove olds values
+        ++p;
     }
 }
 
@@ -110,14 +130,14 @@ EntryPair TSCache::get( oid_t nid )
     auto ts(m_dao->getSignal(nid, m_activeLayer, m_dir, m_radius));
     if( ts.empty() ) {
         LOG(logERROR) << "TSCache::get error nid: " << nid << " lid: " << m_activeLayer;
-        return std::make_pair(Objects::InvalidOID, TimeSeries<double>());
+        return std::make_pair(Objects::InvalidOID, TimeSeries<SignalValue>());
     }
 
     insert(nid, ts);  // insert in cache
     return EntryPair(nid, ts);
 }
 
-void TSCache::insert( oid_t nid, const TimeSeries<double>& ts )
+void TSCache::insert( oid_t nid, const TimeSeries<SignalValue>& ts )
 {
     // push it to the front;
     m_cacheList.push_front( std::make_pair(nid, ts) );
@@ -141,5 +161,56 @@ void TSCache::insert( oid_t nid, const TimeSeries<double>& ts )
     }
 }
 
+void TSCache::setPrefetchDao( const std::shared_ptr<MLGDao>& dao )
+{
+    flushPrefetch();
+    m_prefetchDao = dao;
+}
+
+uint64_t TSCache::size() const
+{
+    return m_entries;
+}
+
+bool TSCache::isPrefetchEnabled() const
+{
+    return m_prefetchDao != nullptr;
+}
+
+void TSCache::flushPrefetch()
+{
+    if( m_prefetch.valid() )
+        m_prefetch.wait();
+    m_prefetch = std::future<OLinkWeightMap>();
+    m_prefetchLayer = Objects::InvalidOID;
+}
 
+void TSCache::waitPrefetch()
+{
+    if( m_prefetch.valid() )
+        m_prefetch.wait();
+}
 
+OLinkWeightMap TSCache::loadLayer( oid_t lid )
+{
+    if( m_prefetch.valid() && m_prefetchLayer == lid ) {
+        m_prefetchLayer = Objects::InvalidOID;
+        return m_prefetch.get();
+    }
+    // Wrong layer prefetched, should not happen when scrolling up
+    flushPrefetch();
+    return m_dao->getOLinkWeights(lid);
+}
+
+void TSCache::prefetch( oid_t lid )
+{
+    if( !m_prefetchDao || lid == Objects::InvalidOID )
+        return;
+
+    flushPrefetch();
+    m_prefetchLayer = lid;
+    auto dao = m_prefetchDao;
+    m_prefetch = std::async(std::launch::async, [dao, lid]() {
+        return dao->getOLinkWeights(lid);
+    });
+}
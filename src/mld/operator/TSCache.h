@@ -21,18 +21,18 @@
 
 #include <list>
 #include <unordered_map>
+#include <future>
 
 //#include <boost/thread/shared_mutex.hpp>
 #include <sparksee/gdb/Graph_data.h>
 
 #include "mld/common.h"
 #include "mld/model/TimeSeries.h"
+#include "mld/dao/MLGDao.h"
 
 namespace mld {
 
-class MLGDao;
-
-using EntryPair = std::pair<sparksee::gdb::oid_t, TimeSeries<double>>;
+using EntryPair = std::pair<sparksee::gdb::oid_t, TimeSeries<SignalValue>>;
 using CacheList = std::list<EntryPair>;
 using CacheMap = std::unordered_map<sparksee::gdb::oid_t, CacheList::iterator>;
 
@@ -46,6 +46,7 @@ public:
     TSCache( const std::shared_ptr<MLGDao>& dao );
     TSCache( const TSCache& ) = delete;
     TSCache& operator =( TSCache ) = delete;
+    ~TSCache();
 
     void reset( sparksee::gdb::oid_t startLayer, TSDirection dir, size_t radius );
     void clear();
@@ -55,9 +56,40 @@ public:
      */
     void scrollUp();
     EntryPair get( sparksee::gdb::oid_t nid );
+    /**
+     * @brief Number of timeseries currently held in the cache
+     */
+    uint64_t size() const;
+
+    /**
+     * @brief Enable the prefetching of the next upper bound layer in a background
+     * thread while the current layer is processed.
+     * The dao MUST be bound to a graph from a dedicated session,
+     * sparksee sessions are not thread-safe.
+     * @param dao Prefetching dao, nullptr disables prefetching
+     */
+    void setPrefetchDao( const std::shared_ptr<MLGDao>& dao );
+    bool isPrefetchEnabled() const;
+    /**
+     * @brief Wait for the pending prefetch (if any) and drop its result.
+     * Has to be called before writing in the database.
+     */
+    void flushPrefetch();
+    /**
+     * @brief Wait for the pending prefetch (if any) and keep its result
+     */
+    void waitPrefetch();
 
 private:
-    void insert( sparksee::gdb::oid_t nid, const TimeSeries<double>& ts );
+    void insert( sparksee::gdb::oid_t nid, const TimeSeries<SignalValue>& ts );
+    /**
+     * @brief Get all the OLink weights of a layer, use the prefetched
+     * values if available
+     * @param lid Layer id
+     * @return map node id -> weight
+     */
+    OLinkWeightMap loadLayer( sparksee::gdb::oid_t lid );
+    void prefetch( sparksee::gdb::oid_t lid );
 
 private:
     std::shared_ptr<MLGDao> m_dao;
@@ -70,6 +102,10 @@ private:
     uint64_t m_maxEntries;
     CacheList m_cacheList;
     CacheMap m_cacheMap;
+
+    std::shared_ptr<MLGDao> m_prefetchDao;
+    sparksee::gdb::oid_t m_prefetchLayer;
+    std::future<OLinkWeightMap> m_prefetch;
     //Lock m_lock;
 };
 
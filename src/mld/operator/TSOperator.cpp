@@ -21,6 +21,7 @@
 #include <sparksee/gdb/ObjectsIterator.h>
 
 #include "mld/operator/TSOperator.h"
+#include "mld/SparkseeManager.h"
 #include "mld/dao/MLGDao.h"
 #include "mld/operator/filter/AbstractTimeVertexFilter.h"
 #include "mld/utils/Timer.h"
@@ -33,6 +34,12 @@ TSOperator::TSOperator( Graph* g )
     : m_dao(new MLGDao(g))
     , m_cache(new TSCache(m_dao))
     , m_filt(nullptr)
+    , m_iterations(1)
+    , m_inMemory(false)
+    , m_flushPerLayer(false)
+    , m_keepState(false)
+    , m_firstLayer(Objects::InvalidOID)
+    , m_lastLayer(Objects::InvalidOID)
 {
 }
 
@@ -45,71 +52,387 @@ void TSOperator::setFilter( AbstractTimeVertexFilter* filter )
     m_filt.reset(filter);
 }
 
+void TSOperator::setPrefetchGraph( Graph* g )
+{
+    if( g )
+        m_prefetchDao.reset(new MLGDao(g));
+    else
+        m_prefetchDao.reset();
+    m_cache->setPrefetchDao(m_prefetchDao);
+}
+
+void TSOperator::setIterations( uint32_t n )
+{
+    if( n == 0 ) {
+        LOG(logERROR) << "TSOperator::setIterations 0 pass, reset to 1";
+        n = 1;
+    }
+    m_iterations = n;
+}
+
+void TSOperator::setKeepState( bool v )
+{
+    m_keepState = v;
+    if( !v )
+        clearState();
+}
+
+void TSOperator::clearState()
+{
+    m_graph.clear();
+    m_rawSignal.clear();
+}
+
+void TSOperator::setLayerRange( oid_t first, oid_t last )
+{
+    m_firstLayer = first;
+    m_lastLayer = last;
+}
+
+void TSOperator::clearLayerRange()
+{
+    m_firstLayer = Objects::InvalidOID;
+    m_lastLayer = Objects::InvalidOID;
+}
+
 bool TSOperator::preExec()
 {
     if( !m_filt ) {
         LOG(logERROR) << "TSOperator::preExec: No filter set. Please set a filter first";
         return false;
     }
-    return true;
+    if( !m_channels.empty() && !m_filt->supportsInMemory() ) {
+        LOG(logERROR) << "TSOperator::preExec: multi-channel filtering not supported by " << m_filt->name();
+        return false;
+    }
+    if( m_keepState && m_rawAttr.empty() ) {
+        LOG(logERROR) << "TSOperator::preExec: keeping the state needs a raw attribute";
+        return false;
+    }
+    if( !m_rawAttr.empty() ) {
+        if( !m_filt->supportsInMemory() || !m_channels.empty() ) {
+            LOG(logERROR) << "TSOperator::preExec: raw attribute needs in-memory filtering "
+                          << "and no extra channel";
+            return false;
+        }
+        Graph* g = m_dao->graph();
+        if( g->FindAttribute(m_dao->olinkType(), m_rawAttr) == Attribute::InvalidAttribute
+            && !SparkseeManager::addAttrToOLink(g, m_rawAttr, Double, Basic, Value().SetNull()) ) {
+            LOG(logERROR) << "TSOperator::preExec: cannot create raw attribute";
+            return false;
+        }
+    }
+    // Read the CLinks once for all the layers and passes,
+    // a partial refilter only needs the chain to cover the new top layers
+    if( m_firstLayer != Objects::InvalidOID )
+        return m_filt->extendLayerChain();
+    return m_filt->buildLayerChain();
 }
 
 bool TSOperator::exec()
-{    
-    std::unique_ptr<Timer> t(new Timer("TSOperator::exec"));
+{
+    // Channels and raw values are only stored in memory
+    m_inMemory = (m_iterations > 1 || !m_channels.empty() || !m_rawAttr.empty())
+            && m_filt->supportsInMemory();
+    if( m_inMemory )
+        return execInMemory();
+
+    // Filter without in-memory implementation, commit each intermediate pass
+    bool ok = true;
+    for( uint32_t i = 1; ok && i < m_iterations; ++i ) {
+        ok = execInDatabase();
+        if( ok ) {
+            stopPrefetch();
+            ok = commitOLinks();
+        }
+        if( !ok ) {
+            LOG(logERROR) << "TSOperator::exec pass " << i << " failed";
+        }
+    }
+    ok = ok && execInDatabase();
+    // Nothing is written anymore before the commit, prefetch again on the next run
+    m_cache->setPrefetchDao(m_prefetchDao);
+    return ok;
+}
+
+bool TSOperator::postExec()
+{
+    if( m_inMemory )
+        return commitSignal();
+    return commitOLinks();
+}
+
+bool TSOperator::execInDatabase()
+{
+    std::unique_ptr<Timer> t(new Timer("TSOperator::execInDatabase"));
     m_buffer.clear();
     // Select all nodes from base layer
     ObjectsPtr nodes(m_dao->getAllNodeIds(m_dao->baseLayer()));
     // Remove excluded nodes
     nodes->Difference(m_filt->excludedNodes());
 
-    // Get all layers
-    std::vector<Layer> layers(m_dao->getAllLayers());
+    // Get layers to filter
+    std::vector<oid_t> layers;
+    std::vector<oid_t> window;
+    if( !selectLayers(layers, window) )
+        return false;
     size_t oLinkCount = layers.size() * nodes->Count();
-    m_buffer.reserve(oLinkCount);
+    // A layer is read by the windows of the radius layers above it
+    const size_t maxBuffered = (m_filt->direction() == TSDirection::FUTURE ? 0 : m_filt->radius()) + 1;
 
     // Setup cache
-    Layer base = m_dao->baseLayer();
-    m_cache->reset(base.id(), m_filt->direction(), m_filt->radius());
+    m_cache->reset(layers.front(), m_filt->direction(), m_filt->radius());
     m_filt->setCache(m_cache);
 
     LOG(logINFO) << "Start filtering, " << oLinkCount << " timeseries values to process";
     LOG(logINFO) << *m_filt;
     ProgressDisplay display(oLinkCount);
 
-    for( auto& layer: layers ) {
+    for( auto lid: layers ) {
         // Generate filter coefficient for this layer
-        m_filt->computeTWCoeffs(layer.id());
+        m_filt->computeTWCoeffs(lid);
+        m_buffer.emplace_back();
+        EdgeWeightVec& values = m_buffer.back();
+        values.reserve(nodes->Count());
         ObjectsIt it(nodes->Iterator());
         while( it->HasNext() ) {
             oid_t nid = it->Next();
-            OLink olink( m_filt->compute(layer.id(), nid) );
+            OLink olink( m_filt->compute(lid, nid) );
 #ifdef MLD_SAFE
             if( olink.id() == Objects::InvalidOID ) {
                 LOG(logERROR) << "TSOperator::exec invalid OLink";
                 return false;
             }
 #endif
-            m_buffer.push_back(olink);
+            values.emplace_back(olink.id(), olink.weight());
             ++display;
         }
         m_cache->scrollUp();
+
+        if( m_flushPerLayer && m_buffer.size() >= maxBuffered ) {
+            stopPrefetch();
+            if( !commitOLinks(m_buffer.size() - maxBuffered + 1) )
+                return false;
+        }
     }
+    // No reader left before commit
+    m_cache->flushPrefetch();
     return true;
 }
 
-bool TSOperator::postExec()
+bool TSOperator::execInMemory()
 {
-    std::unique_ptr<Timer> t(new Timer("TSOperator::postExec"));
-    LOG(logINFO) << "Commit OLink in-memory stored values in DB";
-    ProgressDisplay display(m_buffer.size());
+    std::unique_ptr<Timer> t(new Timer("TSOperator::execInMemory"));
+    std::vector<oid_t> layers;
+    std::vector<oid_t> window;
+    if( !selectLayers(layers, window) || !loadSignal(window) )
+        return false;
+    m_targets = layers;
+    if( !m_rawAttr.empty() && !loadRawSignal() )
+        return false;
+    if( m_keepState )
+        m_rawSignal = m_signal;
+
+    SignalStore next(m_signal);
+    std::vector<size_t> layerIdx;
+    for( auto lid: layers )
+        layerIdx.push_back(m_signal.layerIndex(lid));
+
+    LOG(logINFO) << "Start in-memory filtering, " << m_iterations << " passes of "
+                 << layerIdx.size() * m_graph.nodeCount() << " timeseries values, "
+                 << m_signal.channelCount() << " channels";
+    LOG(logINFO) << *m_filt;
+    ProgressDisplay display(m_iterations * layerIdx.size());
 
-    for( auto& olink: m_buffer ) {
-        if( !m_dao->updateOLink(olink) ) {
-            LOG(logERROR) << "TSOperator::postExec: updateOLink failed: " << olink;
+    for( uint32_t i = 0; i < m_iterations; ++i ) {
+        for( auto l: layerIdx ) {
+            // Generate filter coefficient for this layer
+            m_filt->computeTWCoeffs(m_signal.layerId(l));
+            if( !m_filt->computeLayer(m_graph, m_signal, l, next) ) {
+                LOG(logERROR) << "TSOperator::execInMemory filtering failed pass: " << i;
+                return false;
+            }
+            ++display;
+        }
+        // Output of this pass is the input of the next one
+        swap(m_signal, next);
+    }
+    return true;
+}
+
+bool TSOperator::selectLayers( std::vector<oid_t>& targets, std::vector<oid_t>& window )
+{
+    targets.clear();
+    window.clear();
+    if( m_firstLayer == Objects::InvalidOID ) {
+        for( auto& layer: m_dao->getAllLayers() )
+            targets.push_back(layer.id());
+        window = targets;
+        return !targets.empty();
+    }
+
+    // Walk the range only, the other layers are never touched
+    oid_t cur = m_firstLayer;
+    while( cur != Objects::InvalidOID ) {
+        targets.push_back(cur);
+        if( cur == m_lastLayer )
+            break;
+        cur = m_dao->parent(cur);
+    }
+    if( cur == Objects::InvalidOID ) {
+        LOG(logERROR) << "TSOperator::selectLayers invalid layer range: "
+                      << m_firstLayer << " " << m_lastLayer;
+        targets.clear();
+        return false;
+    }
+
+    // Add the time window layers below and above the range
+    const TSDirection dir = m_filt->direction();
+    if( dir != TSDirection::FUTURE ) {
+        cur = targets.front();
+        for( size_t i = 0; i < m_filt->radius(); ++i ) {
+            cur = m_dao->child(cur);
+            if( cur == Objects::InvalidOID )
+                break;
+            window.push_back(cur);
+        }
+        std::reverse(window.begin(), window.end());
+    }
+    window.insert(window.end(), targets.begin(), targets.end());
+    if( dir != TSDirection::PAST ) {
+        cur = targets.back();
+        for( size_t i = 0; i < m_filt->radius(); ++i ) {
+            cur = m_dao->parent(cur);
+            if( cur == Objects::InvalidOID )
+                break;
+            window.push_back(cur);
+        }
+    }
+    return true;
+}
+
+bool TSOperator::loadSignal( const std::vector<oid_t>& layerIds )
+{
+    std::unique_ptr<Timer> t(new Timer("TSOperator::loadSignal"));
+    if( !m_keepState || m_graph.empty() ) {
+        m_graph = m_dao->getGraphSnapshot(m_dao->baseLayer(), m_filt->excludedNodes());
+        // Data built by the filter on the previous snapshot is stale
+        m_filt->resetGraph();
+        m_rawSignal.clear();
+    }
+    if( m_rawSignal.empty() )
+        return m_dao->getSignalStore(m_graph, layerIds, m_signal, m_channels);
+
+    // Only read the layers not kept from the previous run
+    std::vector<oid_t> missing;
+    for( auto lid: layerIds ) {
+        if( m_rawSignal.layerIndex(lid) == INVALID_INDEX )
+            missing.push_back(lid);
+    }
+    SignalStore fresh;
+    if( !missing.empty() && !m_dao->getSignalStore(m_graph, missing, fresh, m_channels) )
+        return false;
+
+    m_signal.resize(layerIds, m_graph.nodeCount());
+    for( size_t l = 0; l < layerIds.size(); ++l ) {
+        size_t idx = m_rawSignal.layerIndex(layerIds[l]);
+        const SignalValue* src = idx != INVALID_INDEX ? m_rawSignal.layer(idx)
+                                                      : fresh.layer(fresh.layerIndex(layerIds[l]));
+        std::copy(src, src + m_graph.nodeCount(), m_signal.layer(l));
+    }
+    return true;
+}
+
+bool TSOperator::loadRawSignal()
+{
+    m_rawInit.clear();
+    for( size_t l = 0; l < m_signal.layerCount(); ++l ) {
+        const oid_t lid = m_signal.layerId(l);
+        if( m_rawSignal.layerIndex(lid) != INVALID_INDEX ) // Kept from the previous run
+            continue;
+        OLinkWeightMap raw(m_dao->getOLinkWeights(lid, m_rawAttr));
+        if( raw.empty() ) { // Never filtered, the weight is raw
+            m_rawInit.push_back(lid);
+            continue;
+        }
+        SignalValue* row = m_signal.layer(l);
+        for( size_t i = 0; i < m_graph.nodeCount(); ++i ) {
+            auto it = raw.find(m_graph.nodeId(i));
+            if( it == raw.end() ) {
+                LOG(logERROR) << "TSOperator::loadRawSignal no raw value for nid: "
+                              << m_graph.nodeId(i) << " lid: " << lid;
+                return false;
+            }
+            row[i] = SignalValue(it->second);
+        }
+    }
+    return true;
+}
+
+bool TSOperator::commitRawSignal()
+{
+    // Store the raw values before overwriting the weights
+    for( auto lid: m_rawInit ) {
+        if( !m_dao->updateOLinkWeights(lid, m_dao->getOLinkWeights(lid), m_rawAttr) )
+            return false;
+    }
+    // Only the filtered layers, the other ones hold raw values
+    OLinkWeightMap weights;
+    weights.reserve(m_graph.nodeCount());
+    for( auto lid: m_targets ) {
+        const SignalValue* row = m_signal.layer(m_signal.layerIndex(lid));
+        for( size_t i = 0; i < m_graph.nodeCount(); ++i )
+            weights[m_graph.nodeId(i)] = row[i];
+        if( !m_dao->updateOLinkWeights(lid, weights) )
+            return false;
+    }
+    m_rawInit.clear();
+    return true;
+}
+
+bool TSOperator::commitSignal()
+{
+    std::unique_ptr<Timer> t(new Timer("TSOperator::commitSignal"));
+    LOG(logINFO) << "Commit in-memory signal in DB";
+    bool ok = m_rawAttr.empty() ? m_dao->updateSignalStore(m_graph, m_signal, m_channels)
+                                : commitRawSignal();
+    if( !ok ) {
+        LOG(logERROR) << "TSOperator::commitSignal: update failed";
+        clearState();
+        return false;
+    }
+    m_signal.clear();
+    if( !m_keepState )
+        m_graph.clear();
+    return true;
+}
+
+bool TSOperator::commitOLinks( size_t count )
+{
+    for( size_t i = 0; i < count && !m_buffer.empty(); ++i ) {
+        const EdgeWeightVec& values = m_buffer.front();
+        if( !m_dao->updateOLinkWeights(values.cbegin(), values.cend()) ) {
+            LOG(logERROR) << "TSOperator::commitOLinks: bulk update failed";
             return false;
         }
-        ++display;
+        m_buffer.pop_front();
     }
     return true;
 }
+
+bool TSOperator::commitOLinks()
+{
+    std::unique_ptr<Timer> t(new Timer("TSOperator::commitOLinks"));
+    LOG(logINFO) << "Commit OLink in-memory stored values in DB";
+    return commitOLinks(m_buffer.size());
+}
+
+void TSOperator::stopPrefetch()
+{
+    if( !m_cache->isPrefetchEnabled() )
+        return;
+    // Sparksee has a single writer, once the transaction writes, the prefetching
+    // session is blocked until the commit done after the run
+    LOG(logINFO) << "TSOperator: writing before commit, prefetching is disabled";
+    m_cache->setPrefetchDao(std::shared_ptr<MLGDao>());
+}
@@ -19,9 +19,13 @@
 #ifndef MLD_TSOPERATOR_H
 #define MLD_TSOPERATOR_H
 
+#include <deque>
+
 #include "mld/operator/AbstractOperator.h"
 #include "mld/model/Link.h"
 #include "mld/operator/TSCache.h"
+#include "mld/model/GraphSnapshot.h"
+#include "mld/model/SignalStore.h"
 
 namespace sparksee {
 namespace gdb {
@@ -35,6 +39,8 @@ namespace mld {
 class MLGDao;
 class AbstractTimeVertexFilter;
 
+using EdgeWeightVec = std::vector<std::pair<sparksee::gdb::oid_t, double>>;
+
 class MLD_API TSOperator : public AbstractOperator
 {
 public:
@@ -47,6 +53,85 @@ public:
      */
     void setFilter( AbstractTimeVertexFilter* filter );
 
+    /**
+     * @brief Prefetch the next layer values in a background thread
+     * Must be set outside of any transaction. Prefetching stops at the first
+     * write done before postExec (flush per layer, intermediate passes) as
+     * the prefetching session would wait for the commit of the transaction.
+     * It is enabled again for the next run.
+     * @param g Graph from a dedicated session, nullptr disables prefetching
+     */
+    void setPrefetchGraph( sparksee::gdb::Graph* g );
+
+    /**
+     * @brief Set the number of filtering passes done by a single run.
+     * If the filter supports it, passes are chained in memory with
+     * 2 signal buffers and only the last one is commited.
+     * Default is 1 pass.
+     * @param n number of passes
+     */
+    void setIterations( uint32_t n );
+    inline uint32_t iterations() const { return m_iterations; }
+
+    /**
+     * @brief Commit the filtered values of a layer as soon as no remaining
+     * time window reads it, at most radius + 1 layers are buffered.
+     * Only used when filtering in database. Default is false, all the values
+     * are commited in postExec.
+     * @param v
+     */
+    inline void setFlushPerLayer( bool v ) { m_flushPerLayer = v; }
+    inline bool flushPerLayer() const { return m_flushPerLayer; }
+
+    /**
+     * @brief Filter extra OLink double attributes together with the weight.
+     * Each neighbor and coefficient is computed once for all the channels.
+     * Needs a filter supporting in-memory filtering.
+     * @param channels OLink attribute names, empty for weight only (default)
+     */
+    inline void setChannels( const std::vector<std::wstring>& channels ) { m_channels = channels; }
+    inline const std::vector<std::wstring>& channels() const { return m_channels; }
+
+    /**
+     * @brief Keep the unfiltered weights in an OLink double attribute, created if needed.
+     * The filter reads this attribute and writes the weight, so a layer filtered again,
+     * ex: when new time steps are streamed, starts from its raw values and the raw values
+     * of its time window instead of filtered ones. The weight of a layer without raw
+     * values is taken as raw and copied in the attribute.
+     * Needs a filter supporting in-memory filtering, no extra channel.
+     * @param attr OLink attribute name, empty to filter the weight in place (default)
+     */
+    inline void setRawAttribute( const std::wstring& attr ) { m_rawAttr = attr; }
+    inline const std::wstring& rawAttribute() const { return m_rawAttr; }
+
+    /**
+     * @brief Keep the base layer snapshot, the filter graph and the raw values of the
+     * loaded layers across runs, the next run only reads the layers not loaded yet.
+     * Used to refilter streamed time steps. The HLinks, the excluded nodes and the raw
+     * values of the kept layers must not change in between, call clearState otherwise.
+     * Needs a raw attribute. Default is false.
+     * @param v
+     */
+    void setKeepState( bool v );
+    inline bool keepState() const { return m_keepState; }
+    /**
+     * @brief Drop the kept snapshot and raw values, reloaded on next run
+     */
+    void clearState();
+
+    /**
+     * @brief Only filter the layers in between first and last (included).
+     * Layers out of the range are still read in the time window but are left untouched.
+     * Used to refilter the layers impacted by new time steps.
+     * @param first Bottom layer id of the range
+     * @param last Top layer id of the range
+     */
+    void setLayerRange( sparksee::gdb::oid_t first, sparksee::gdb::oid_t last );
+    /**
+     * @brief Filter all the layers (default)
+     */
+    void clearLayerRange();
+
 protected:
     /**
      * @brief Select set of Nodes to operate
@@ -64,11 +149,65 @@ protected:
      */
     virtual bool postExec() override;
 
+private:
+    /**
+     * @brief One filtering pass reading the database through the cache
+     * @return success
+     */
+    bool execInDatabase();
+    /**
+     * @brief Chain all the passes on the in-memory signal
+     * @return success
+     */
+    bool execInMemory();
+    /**
+     * @brief Get the layers to filter and the layers read by their time windows
+     * @param targets Layers to filter, ordered from bottom to top
+     * @param window Targets and their time window layers, ordered from bottom to top
+     * @return success
+     */
+    bool selectLayers( std::vector<sparksee::gdb::oid_t>& targets,
+                       std::vector<sparksee::gdb::oid_t>& window );
+    bool loadSignal( const std::vector<sparksee::gdb::oid_t>& layerIds );
+    /**
+     * @brief Replace the loaded weights by the raw values,
+     * the layers without raw values are recorded to be initialized on commit
+     * @return success
+     */
+    bool loadRawSignal();
+    bool commitRawSignal();
+    /**
+     * @brief Commit the oldest buffered layers
+     * @param count Number of layers to commit
+     * @return success
+     */
+    bool commitOLinks( size_t count );
+    /**
+     * @brief Stop prefetching before writing in the database during exec
+     */
+    void stopPrefetch();
+    bool commitOLinks();
+    bool commitSignal();
+
 protected:
     std::shared_ptr<MLGDao> m_dao;
     std::shared_ptr<TSCache> m_cache;
+    std::shared_ptr<MLGDao> m_prefetchDao;
     std::unique_ptr<AbstractTimeVertexFilter> m_filt;
-    std::vector<OLink> m_buffer; // store OLink to be commited
+    std::deque<EdgeWeightVec> m_buffer; // (OLink id, weight) to be commited, one entry per layer
+    uint32_t m_iterations;
+    bool m_inMemory;
+    bool m_flushPerLayer;
+    bool m_keepState;
+    GraphSnapshot m_graph;
+    SignalStore m_signal;  // current signal for in-memory passes
+    SignalStore m_rawSignal;  // raw values kept across runs
+    std::vector<std::wstring> m_channels;
+    std::wstring m_rawAttr;
+    std::vector<sparksee::gdb::oid_t> m_targets;  // layers filtered in memory
+    std::vector<sparksee::gdb::oid_t> m_rawInit;  // layers whose raw values are not stored yet
+    sparksee::gdb::oid_t m_firstLayer;
+    sparksee::gdb::oid_t m_lastLayer;
 };
 
 } // end namespace mld
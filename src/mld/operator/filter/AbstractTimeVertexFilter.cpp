@@ -16,8 +16,11 @@
 **
 ****************************************************************************/
 
+#include <cmath>
+
 #include "mld/operator/filter/AbstractTimeVertexFilter.h"
 #include "mld/dao/MLGDao.h"
+#include "mld/model/GraphSnapshot.h"
 
 using namespace mld;
 using namespace sparksee::gdb;
@@ -40,6 +43,24 @@ AbstractTimeVertexFilter::~AbstractTimeVertexFilter()
 void AbstractTimeVertexFilter::setExcludedNodes( const ObjectsPtr& nodeSet )
 {
     m_excludedNodes = nodeSet;
+    // Snapshot is rebuilt without the excluded nodes
+    resetGraph();
+}
+
+void AbstractTimeVertexFilter::resetGraph()
+{
+    m_baseGraph.reset();
+}
+
+const GraphSnapshot& AbstractTimeVertexFilter::baseGraph()
+{
+    if( m_baseGraph )
+        return *m_baseGraph;
+
+    // Same snapshot as the in-memory filtering
+    m_baseGraph.reset(new GraphSnapshot(m_dao->getGraphSnapshot(m_dao->baseLayer(),
+                                                                m_excludedNodes.get())));
+    return *m_baseGraph;
 }
 
 void AbstractTimeVertexFilter::setOverrideInterLayerWeight( bool override, double w )
@@ -56,33 +77,103 @@ void AbstractTimeVertexFilter::setOverrideInterLayerWeight( bool override, doubl
 void AbstractTimeVertexFilter::computeTWCoeffs( oid_t layerId )
 {
     m_coeffs.clear();
+    // No need to compute any coeffs
+    if( m_radius == 0 ) {
+        m_coeffs.push_back(TWCoeff(layerId, 0.0));
+        return;
+    }
+
+    if( hasLayerChain() ) {
+        auto it = m_chainIndex.find(layerId);
+        if( it != m_chainIndex.end() ) {
+            computeTWCoeffsFromChain(it->second);
+            return;
+        }
+        LOG(logWARNING) << "AbstractTimeVertexFilter::computeTWCoeffs layer not in chain: " << layerId;
+    }
+    computeTWCoeffsFromDb(layerId);
+}
+
+bool AbstractTimeVertexFilter::buildLayerChain()
+{
+    clearLayerChain();
+    Layer cur(m_dao->baseLayer());
+    if( cur.id() == Objects::InvalidOID ) {
+        LOG(logERROR) << "AbstractTimeVertexFilter::buildLayerChain no base layer";
+        return false;
+    }
+
+    m_chainLayers.push_back(cur.id());
+    m_chainResist.push_back(0.0);
+    m_chainIndex[cur.id()] = 0;
+    return extendLayerChain();
+}
+
+bool AbstractTimeVertexFilter::extendLayerChain()
+{
+    if( !hasLayerChain() )
+        return buildLayerChain();
 
+    while( true ) {
+        CLink link(m_dao->topCLink(m_chainLayers.back()));
+        if( link.id() == Objects::InvalidOID )
+            break;
+        m_chainIndex[link.target()] = m_chainLayers.size();
+        m_chainLayers.push_back(link.target());
+        m_chainResist.push_back(m_chainResist.back() + clinkResistivity(link));
+    }
+    return true;
+}
+
+void AbstractTimeVertexFilter::clearLayerChain()
+{
+    m_chainLayers.clear();
+    m_chainResist.clear();
+    m_chainIndex.clear();
+}
+
+void AbstractTimeVertexFilter::computeTWCoeffsFromChain( size_t layerIdx )
+{
+    size_t first = layerIdx;
+    size_t last = layerIdx;
+    if( m_dir != TSDirection::FUTURE )
+        first = layerIdx - std::min(layerIdx, m_radius);
+    if( m_dir != TSDirection::PAST )
+        last = std::min(layerIdx + m_radius, m_chainLayers.size() - 1);
+
+    // Resistivity distance is a difference of cumulative sums, [bot2, bot1, 1, top1, top2]
+    const double ref = m_chainResist[layerIdx];
+    for( size_t i = first; i <= last; ++i ) {
+        double lambda = m_override ? std::abs(double(i) - double(layerIdx)) / m_lambda
+                                   : std::abs(m_chainResist[i] - ref);
+        m_coeffs.push_back(TWCoeff(m_chainLayers[i], lambda));
+    }
+}
+
+double AbstractTimeVertexFilter::clinkResistivity( CLink& link ) const
+{
+    if( link.weight() == 0.0 ) {
+        LOG(logERROR) << "AbstractTimeVertexFilter::computeTWCoeffs CLink weight = 0";
+        link.setWeight(1.0);
+    }
+    return 1 / link.weight();
+}
+
+void AbstractTimeVertexFilter::computeTWCoeffsFromDb( oid_t layerId )
+{
     // Current layerId coeff
     oid_t curLayerId = layerId;
     double lastLambda = 0.0;
     m_coeffs.push_back(TWCoeff(layerId, lastLambda));
 
-    // No need to compute any coeffs
-    if( m_radius == 0 )
-        return;
-
     if( m_dir != TSDirection::FUTURE ) {
         // Bottom layers
         for( uint32_t i = 0; i < m_radius; ++i ) {
             CLink link(m_dao->bottomCLink(curLayerId));
             if( link.id() == Objects::InvalidOID )
                 break;
-            if( !m_override ) {
-                if( link.weight() == 0.0 ) {
-                    LOG(logERROR) << "AbstractTimeVertexFilter::computeTWCoeffs CLink weight = 0";
-                    link.setWeight(1.0);
-                }
-                lastLambda += 1 / link.weight();
-                // Go down 1 layer
-            }
-            else {
-                lastLambda += 1 / m_lambda;
-            }
+            lastLambda += m_override ? 1 / m_lambda : clinkResistivity(link);
+            // Go down 1 layer
             curLayerId = link.source();
             m_coeffs.push_back(TWCoeff(curLayerId, lastLambda));
         }
@@ -101,16 +192,7 @@ void AbstractTimeVertexFilter::computeTWCoeffs( oid_t layerId )
             CLink link(m_dao->topCLink(curLayerId));
             if( link.id() == Objects::InvalidOID )
                 break;
-            if( !m_override ) {
-                if( link.weight() == 0.0 ) {
-                    LOG(logERROR) << "AbstractTimeVertexFilter::computeTWCoeffs CLink weight = 0";
-                    link.setWeight(1.0);
-                }
-                lastLambda += 1 / link.weight();
-            }
-            else {
-                lastLambda += 1 / m_lambda;
-            }
+            lastLambda += m_override ? 1 / m_lambda : clinkResistivity(link);
 
             // Go up 1 layer
             curLayerId = link.target();
@@ -119,6 +201,17 @@ void AbstractTimeVertexFilter::computeTWCoeffs( oid_t layerId )
     }
 }
 
+bool AbstractTimeVertexFilter::computeLayer( const GraphSnapshot& graph, const SignalStore& in,
+                                             size_t layerIdx, SignalStore& out )
+{
+    MLD_UNUSED(graph);
+    MLD_UNUSED(in);
+    MLD_UNUSED(layerIdx);
+    MLD_UNUSED(out);
+    LOG(logERROR) << "AbstractTimeVertexFilter::computeLayer not supported by " << name();
+    return false;
+}
+
 std::ostream& operator <<( std::ostream& out, const mld::AbstractTimeVertexFilter& filter )
 {
     out << filter.name();
@@ -19,6 +19,8 @@
 #ifndef MLD_ABSTRACTTIMEVERTEXFILTER_H
 #define MLD_ABSTRACTTIMEVERTEXFILTER_H
 
+#include <unordered_map>
+
 #include "mld/common.h"
 #include "mld/model/Link.h"
 
@@ -32,6 +34,8 @@ namespace mld {
 class MLGDao;
 class AbstractTimeVertexFilter;
 class TSCache;
+class GraphSnapshot;
+class SignalStore;
 
 class MLD_API AbstractTimeVertexFilter
 {
@@ -46,7 +50,7 @@ public:
      * be processed nor retrieved as neighbors
      * @param nodeSet
      */
-    void setExcludedNodes( const ObjectsPtr& nodeSet );
+    virtual void setExcludedNodes( const ObjectsPtr& nodeSet );
 
     /**
      * @brief Override CLink weight in between layer with given value.
@@ -81,6 +85,12 @@ public:
      */
     inline void setFilterOnlyInTimeDomain( bool v ) { m_timeOnly = v; }
 
+    /**
+     * @brief Drop the base layer snapshot used to iterate the neighbors,
+     * it is reloaded on next compute. Has to be called if HLinks are updated
+     */
+    virtual void resetGraph();
+
     /**
      * @brief Get excluded node set, DO NOT DELETE
      * @return excluded nodes
@@ -97,11 +107,46 @@ public:
     virtual OLink compute( sparksee::gdb::oid_t layerId, sparksee::gdb::oid_t rootId ) = 0;
 
     /**
-     * @brief Compute TimeWidow coeffs using the resistivity distance
+     * @brief Check if the filter can run in memory with computeLayer
+     * @return supported
+     */
+    virtual bool supportsInMemory() const { return false; }
+
+    /**
+     * @brief Filter all the nodes of a layer in memory,
+     * computeTWCoeffs has to be called prior to computeLayer
+     * @param graph Snapshot of the base layer, excluded nodes are not in it
+     * @param in Input signal
+     * @param layerIdx Index in the signal of the layer to filter
+     * @param out Output signal, same layout as in. Only layerIdx row is written
+     * @return success
+     */
+    virtual bool computeLayer( const GraphSnapshot& graph, const SignalStore& in,
+                               size_t layerIdx, SignalStore& out );
+
+    /**
+     * @brief Compute TimeWidow coeffs using the resistivity distance.
+     * Coeffs are read from the layer chain if built, else CLinks are walked in the database
      * @param layerId layer
      */
     virtual void computeTWCoeffs( sparksee::gdb::oid_t layerId );
 
+    /**
+     * @brief Walk the CLinks once from the base layer to the top layer and store
+     * the cumulative resistivity (sum of 1 / CLink weight) of each layer.
+     * Has to be called again if CLinks are updated
+     * @return success
+     */
+    bool buildLayerChain();
+    /**
+     * @brief Append the layers added on top since the last build to the layer chain.
+     * Builds the chain if empty
+     * @return success
+     */
+    bool extendLayerChain();
+    void clearLayerChain();
+    inline bool hasLayerChain() const { return !m_chainLayers.empty(); }
+
 protected:
     using TWCoeff = std::pair<sparksee::gdb::oid_t, double>;
     using TWCoeffVec = std::vector<TWCoeff>;
@@ -116,6 +161,18 @@ protected:
     virtual double computeNodeWeight( sparksee::gdb::oid_t node, double hlinkWeight) = 0;
     virtual double computeNodeSelfWeight( sparksee::gdb::oid_t node ) = 0;
 
+    /**
+     * @brief Get the snapshot of the base layer without the excluded nodes, loaded on first call.
+     * It is the snapshot used by the in-memory filtering, both paths see the same neighbors
+     * @return snapshot
+     */
+    const GraphSnapshot& baseGraph();
+
+private:
+    void computeTWCoeffsFromChain( size_t layerIdx );
+    void computeTWCoeffsFromDb( sparksee::gdb::oid_t layerId );
+    double clinkResistivity( CLink& link ) const;
+
 protected:
     std::unique_ptr<MLGDao> m_dao;
     size_t m_radius;
@@ -127,6 +184,14 @@ protected:
     ObjectsPtr m_excludedNodes;
     TWCoeffVec m_coeffs;
     std::shared_ptr<TSCache> m_cache;
+
+private:
+    // Layers ordered from bottom to top and their cumulative resistivity from the base layer
+    std::vector<sparksee::gdb::oid_t> m_chainLayers;
+    std::vector<double> m_chainResist;
+    std::unordered_map<sparksee::gdb::oid_t, size_t> m_chainIndex;
+
+    std::unique_ptr<GraphSnapshot> m_baseGraph;
 };
 
 } // end namespace mld
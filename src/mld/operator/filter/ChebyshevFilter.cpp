@@ -0,0 +1,329 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+
+#include "mld/operator/filter/ChebyshevFilter.h"
+#include "mld/model/SignalStore.h"
+#include "mld/dao/MLGDao.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+namespace {
+const double PI = 3.14159265358979323846;
+// Quadrature points used to compute the Chebyshev coefficients
+const size_t MIN_QUADRATURE_POINTS = 256;
+}
+
+ChebyshevFilter::ChebyshevFilter( Graph* g )
+    : AbstractTimeVertexFilter(g)
+    , m_kernel(HEAT)
+    , m_order(30)
+    , m_tau(1.0)
+    , m_low(0.0)
+    , m_high(0.5)
+    , m_resultLayer(Objects::InvalidOID)
+{
+}
+
+ChebyshevFilter::~ChebyshevFilter()
+{
+}
+
+std::string ChebyshevFilter::name() const
+{
+    std::string name("ChebyshevFilter: ");
+    switch( m_kernel ) {
+        case HEAT:
+            name += "heat tau: " + std::to_string(m_tau);
+            break;
+        case LOWPASS:
+            name += "lowpass cutoff: " + std::to_string(m_high);
+            break;
+        case BANDPASS:
+            name += "bandpass band: [" + std::to_string(m_low) + ", " + std::to_string(m_high) + "]";
+            break;
+        default:
+            LOG(logERROR) << "Unsupported kernel";
+            break;
+    }
+    name += " order: " + std::to_string(m_order);
+
+    if( m_timeOnly ) {
+        name += " filter on time domain only";
+        return name;
+    }
+
+    name += " radius: " + std::to_string(m_radius);
+    if( m_override )
+        name += " overriden lambda: " + std::to_string(m_lambda);
+    return name;
+}
+
+void ChebyshevFilter::setBand( double low, double high )
+{
+    if( low < 0.0 || high > 1.0 || low > high ) {
+        LOG(logERROR) << "ChebyshevFilter::setBand invalid band [" << low << ", " << high << "]";
+        return;
+    }
+    m_low = low;
+    m_high = high;
+}
+
+void ChebyshevFilter::setExcludedNodes( const ObjectsPtr& nodeSet )
+{
+    AbstractTimeVertexFilter::setExcludedNodes(nodeSet);
+    // Snapshot has to be reloaded
+    m_graph.clear();
+    m_resultLayer = Objects::InvalidOID;
+}
+
+void ChebyshevFilter::computeTWCoeffs( oid_t layerId )
+{
+    AbstractTimeVertexFilter::computeTWCoeffs(layerId);
+    // Coeffs may have changed, invalidate filtered layer
+    m_resultLayer = Objects::InvalidOID;
+}
+
+OLink ChebyshevFilter::compute( oid_t layerId, oid_t rootId )
+{
+    OLink rootOLink(m_dao->getOLink(layerId, rootId));
+    if( rootOLink.id() == Objects::InvalidOID ) {
+        LOG(logERROR) << "ChebyshevFilter::compute invalid Olink " << layerId << " " << rootId;
+        return rootOLink;
+    }
+
+    // The whole layer is filtered at once
+    if( m_resultLayer != layerId && !computeLayerFromDb(layerId) )
+        return rootOLink;
+
+    size_t idx = m_graph.index(rootId);
+    if( idx == INVALID_INDEX ) {  // excluded node
+        return rootOLink;
+    }
+    rootOLink.setWeight(m_result[idx]);
+    return rootOLink;
+}
+
+double ChebyshevFilter::computeNodeWeight( oid_t node, double hlinkWeight )
+{
+    return hlinkWeight * computeNodeSelfWeight(node);
+}
+
+double ChebyshevFilter::computeNodeSelfWeight( oid_t node )
+{
+    double total = 0.0;
+    double weightSum = 0.0;
+    for( auto& coeff: m_coeffs ) {
+        OLink olink(m_dao->getOLink(coeff.first, node));
+#ifdef MLD_SAFE
+        if( olink.id() == Objects::InvalidOID ) {
+            LOG(logERROR) << "ChebyshevFilter::computeNodeSelfWeight invalid Olink " << coeff.first << " " << node;
+            return 0.0;
+        }
+#endif
+        double c = 1.0;
+        if( coeff.second != 0.0 )
+            c = 1.0 / coeff.second;
+        weightSum += c;
+        total += c * olink.weight();
+    }
+    if( weightSum == 0.0 )
+        return 0.0;
+    return total / weightSum;
+}
+
+bool ChebyshevFilter::computeLayer( const GraphSnapshot& graph, const SignalStore& in,
+                                    size_t layerIdx, SignalStore& out )
+{
+    if( m_coeffs.empty() ) {
+        LOG(logERROR) << "ChebyshevFilter::computeLayer empty coeff, call computeTWCoeffs prior to computeLayer";
+        return false;
+    }
+
+    // Resolve time window rows
+    std::vector<size_t> rows;
+    std::vector<double> coeffs;
+    double weightSum = 0.0;
+    for( auto& coeff: m_coeffs ) {
+        size_t idx = in.layerIndex(coeff.first);
+        if( idx == INVALID_INDEX ) {
+            LOG(logERROR) << "ChebyshevFilter::computeLayer unknown layer " << coeff.first;
+            return false;
+        }
+        double c = 1.0;
+        if( coeff.second != 0.0 )
+            c = 1.0 / coeff.second;
+        weightSum += c;
+        rows.push_back(idx);
+        coeffs.push_back(c);
+    }
+
+    // Average over the time window then filter, channel by channel
+    const size_t n = graph.nodeCount();
+    for( size_t ch = 0; ch < in.channelCount(); ++ch ) {
+        m_tw.assign(n, 0.0);
+        for( size_t k = 0; k < rows.size(); ++k ) {
+            const SignalValue* row = in.layer(rows[k], ch);
+            for( size_t i = 0; i < n; ++i )
+                m_tw[i] += coeffs[k] * row[i];
+        }
+        for( auto& v: m_tw )
+            v /= weightSum;
+
+        // Kernel is applied in double precision
+        SignalValue* res = out.layer(layerIdx, ch);
+        if( m_timeOnly ) {
+            std::copy(m_tw.begin(), m_tw.end(), res);
+        }
+        else {
+            m_filtered.resize(n);
+            applyKernel(graph, m_tw.data(), m_filtered.data());
+            std::copy(m_filtered.begin(), m_filtered.end(), res);
+        }
+    }
+    return true;
+}
+
+bool ChebyshevFilter::computeLayerFromDb( oid_t layerId )
+{
+    if( m_coeffs.empty() ) {
+        LOG(logERROR) << "ChebyshevFilter::compute empty coeff, call computeTWCoeffs prior to compute";
+        return false;
+    }
+
+    if( m_graph.empty() )
+        m_graph = m_dao->getGraphSnapshot(m_dao->baseLayer(), m_excludedNodes.get());
+
+    // Load the time window in a store local to this layer
+    std::vector<oid_t> layers;
+    for( auto& coeff: m_coeffs )
+        layers.push_back(coeff.first);
+    SignalStore in;
+    if( !m_dao->getSignalStore(m_graph, layers, in) )
+        return false;
+
+    SignalStore out(std::vector<oid_t>(1, layerId), m_graph.nodeCount());
+    if( !computeLayer(m_graph, in, 0, out) )
+        return false;
+
+    m_result.swap(out.data());
+    m_resultLayer = layerId;
+    return true;
+}
+
+void ChebyshevFilter::applyKernel( const GraphSnapshot& graph, const double* x, double* y )
+{
+    const size_t n = graph.nodeCount();
+    const auto& targets = graph.targets();
+    const auto& weights = graph.weights();
+
+    // Weighted degrees and upper bound of the spectrum
+    m_degrees.assign(n, 0.0);
+    double lmax = 0.0;
+    for( size_t i = 0; i < n; ++i ) {
+        double d = 0.0;
+        for( size_t e = graph.neighborBegin(i); e != graph.neighborEnd(i); ++e )
+            d += weights[e];
+        m_degrees[i] = d;
+        lmax = std::max(lmax, 2.0 * d);
+    }
+    if( lmax == 0.0 )  // no edge, L = 0
+        lmax = 1.0;
+
+    const std::vector<double> coeffs(chebyshevCoeffs(lmax));
+    const double alpha = lmax / 2.0;
+
+    // out = (L - alpha * I) / alpha * in, spectrum is mapped to [-1, 1]
+    auto shiftedLaplacian = [&]( const double* in, double* out ) {
+        for( size_t i = 0; i < n; ++i ) {
+            double v = (m_degrees[i] - alpha) * in[i];
+            for( size_t e = graph.neighborBegin(i); e != graph.neighborEnd(i); ++e )
+                v -= weights[e] * in[targets[e]];
+            out[i] = v / alpha;
+        }
+    };
+
+    // y = c0 / 2 * T0(x) + sum_k ck * Tk(x)
+    for( size_t i = 0; i < n; ++i )
+        y[i] = 0.5 * coeffs[0] * x[i];
+    if( m_order == 0 )
+        return;
+
+    m_prev.assign(x, x + n);
+    m_cur.resize(n);
+    m_next.resize(n);
+    shiftedLaplacian(x, m_cur.data());
+    for( size_t i = 0; i < n; ++i )
+        y[i] += coeffs[1] * m_cur[i];
+
+    for( uint32_t k = 2; k <= m_order; ++k ) {
+        // T_k = 2 * L~ * T_k-1 - T_k-2
+        shiftedLaplacian(m_cur.data(), m_next.data());
+        for( size_t i = 0; i < n; ++i ) {
+            m_next[i] = 2.0 * m_next[i] - m_prev[i];
+            y[i] += coeffs[k] * m_next[i];
+        }
+        m_prev.swap(m_cur);
+        m_cur.swap(m_next);
+    }
+}
+
+double ChebyshevFilter::response( double x, double lmax ) const
+{
+    switch( m_kernel ) {
+        case HEAT:
+            return std::exp(-m_tau * x);
+        case LOWPASS:
+            return x <= m_high * lmax ? 1.0 : 0.0;
+        case BANDPASS:
+            return (x >= m_low * lmax && x <= m_high * lmax) ? 1.0 : 0.0;
+        default:
+            LOG(logERROR) << "ChebyshevFilter::response unsupported kernel";
+            break;
+    }
+    return 0.0;
+}
+
+std::vector<double> ChebyshevFilter::chebyshevCoeffs( double lmax ) const
+{
+    const size_t K = m_order + 1;
+    const size_t N = std::max(K, MIN_QUADRATURE_POINTS);
+    const double alpha = lmax / 2.0;
+
+    std::vector<double> res(K, 0.0);
+    for( size_t j = 0; j < N; ++j ) {
+        double theta = PI * (j + 0.5) / N;
+        double g = response(alpha * std::cos(theta) + alpha, lmax);
+        for( size_t k = 0; k < K; ++k )
+            res[k] += g * std::cos(k * theta);
+    }
+    for( auto& c: res )
+        c *= 2.0 / N;
+
+    // Jackson damping removes Gibbs oscillations of ideal kernels
+    if( m_kernel != HEAT ) {
+        const double a = PI / (K + 1);
+        for( size_t k = 0; k < K; ++k ) {
+            res[k] *= ((K - k + 1) * std::cos(k * a) + std::sin(k * a) / std::tan(a)) / (K + 1);
+        }
+    }
+    return res;
+}
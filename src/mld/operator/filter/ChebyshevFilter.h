@@ -0,0 +1,135 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_CHEBYSHEVFILTER_H
+#define MLD_CHEBYSHEVFILTER_H
+
+#include <vector>
+
+#include "mld/common.h"
+#include "mld/operator/filter/AbstractTimeVertexFilter.h"
+#include "mld/model/GraphSnapshot.h"
+
+namespace sparksee {
+namespace gdb {
+    class Graph;
+}}
+
+namespace mld {
+
+/**
+ * @brief Spectral graph filter approximated by a Chebyshev polynomial of the Laplacian.
+ * The signal is first averaged over the time window with the resistivity coeffs
+ * (1 / lambda), then filtered on the base layer graph with K Laplacian-vector products.
+ * The largest eigenvalue is bounded with the Gershgorin circle theorem (2 * max degree).
+ */
+class MLD_API ChebyshevFilter : public AbstractTimeVertexFilter
+{
+public:
+    enum Kernel {
+        HEAT,       // exp(-tau * x)
+        LOWPASS,    // 1 if x <= high * lmax
+        BANDPASS    // 1 if low * lmax <= x <= high * lmax
+    };
+
+    ChebyshevFilter( sparksee::gdb::Graph* g );
+    virtual ~ChebyshevFilter();
+
+    virtual std::string name() const override;
+
+    inline void setKernel( Kernel k ) { m_kernel = k; }
+    inline Kernel kernel() const { return m_kernel; }
+    /**
+     * @brief Set Chebyshev polynomial order, number of Laplacian-vector products
+     * @param order
+     */
+    inline void setOrder( uint32_t order ) { m_order = order; }
+    inline uint32_t order() const { return m_order; }
+    /**
+     * @brief Set heat kernel scale
+     * @param tau
+     */
+    inline void setTau( double tau ) { m_tau = tau; }
+    inline double tau() const { return m_tau; }
+    /**
+     * @brief Set pass band for LOWPASS (only high is used) and BANDPASS kernels.
+     * Bounds are relative to the largest eigenvalue, in [0, 1]
+     * @param low
+     * @param high
+     */
+    void setBand( double low, double high );
+
+    virtual void setExcludedNodes( const ObjectsPtr& nodeSet ) override;
+    virtual void computeTWCoeffs( sparksee::gdb::oid_t layerId ) override;
+    virtual OLink compute( sparksee::gdb::oid_t layerId, sparksee::gdb::oid_t rootId ) override;
+    /**
+     * @brief Weight of a neighbor in the Laplacian product
+     * @return hlinkWeight times the time window average of node
+     */
+    virtual double computeNodeWeight( sparksee::gdb::oid_t node, double hlinkWeight ) override;
+    /**
+     * @brief Time window average of the node signal
+     */
+    virtual double computeNodeSelfWeight( sparksee::gdb::oid_t node ) override;
+
+    virtual bool supportsInMemory() const override { return true; }
+    virtual bool computeLayer( const GraphSnapshot& graph, const SignalStore& in,
+                               size_t layerIdx, SignalStore& out ) override;
+
+    /**
+     * @brief Filter a signal on a graph, time window is not used
+     * @param graph Graph
+     * @param x Input signal, one value per node
+     * @param y Output signal
+     */
+    void applyKernel( const GraphSnapshot& graph, const double* x, double* y );
+
+private:
+    double response( double x, double lmax ) const;
+    std::vector<double> chebyshevCoeffs( double lmax ) const;
+    /**
+     * @brief Filter the current layer in the database, result is kept in m_result
+     * @param layerId
+     * @return success
+     */
+    bool computeLayerFromDb( sparksee::gdb::oid_t layerId );
+
+private:
+    Kernel m_kernel;
+    uint32_t m_order;
+    double m_tau;
+    double m_low;
+    double m_high;
+
+    // Database mode, filtered layer
+    GraphSnapshot m_graph;
+    sparksee::gdb::oid_t m_resultLayer;
+    std::vector<SignalValue> m_result;
+
+    // Scratch buffers
+    std::vector<double> m_tw;
+    std::vector<double> m_filtered;
+    std::vector<double> m_degrees;
+    std::vector<double> m_prev;
+    std::vector<double> m_cur;
+    std::vector<double> m_next;
+};
+
+} // end namespace mld
+
+#endif // MLD_CHEBYSHEVFILTER_H
@@ -20,19 +20,45 @@
 
 #include "mld/operator/filter/FilterFactory.h"
 #include "mld/operator/filter/TimeVertexMeanFilter.h"
+#include "mld/operator/filter/ChebyshevFilter.h"
 
 using namespace mld;
 namespace ba = boost::algorithm;
 
-AbstractTimeVertexFilter* FilterFactory::create( sparksee::gdb::Graph* g, const std::string& name, double lambda, uint32_t twSize )
+AbstractTimeVertexFilter* FilterFactory::create( sparksee::gdb::Graph* g, const std::string& name,
+                                                 double lambda, uint32_t twSize,
+                                                 const FilterOptions& opts )
 {
     AbstractTimeVertexFilter* filter = nullptr;
     auto s = ba::to_lower_copy(name);
     if( s == "tvm" ) {
-        filter = new TimeVertexMeanFilter(g);
-        filter->setRadius(twSize);
-        if( lambda > 0.0 )
-            filter->setOverrideInterLayerWeight(true, lambda);
+        auto tvm = new TimeVertexMeanFilter(g);
+        tvm->setNeighborSampling(opts.maxNeighbors, opts.seed);
+        filter = tvm;
     }
+    else if( s == "heat" || s == "lowpass" || s == "bandpass" ) {
+        auto cheb = new ChebyshevFilter(g);
+        if( s == "heat" )
+            cheb->setKernel(ChebyshevFilter::HEAT);
+        else if( s == "lowpass" )
+            cheb->setKernel(ChebyshevFilter::LOWPASS);
+        else
+            cheb->setKernel(ChebyshevFilter::BANDPASS);
+        cheb->setOrder(opts.order);
+        cheb->setTau(opts.tau);
+        cheb->setBand(opts.bandLow, opts.bandHigh);
+        filter = cheb;
+        if( opts.maxNeighbors > 0 ) {
+            LOG(logWARNING) << "FilterFactory::create neighbor sampling ignored by filter: " << name;
+        }
+    }
+    else {
+        LOG(logERROR) << "FilterFactory::create unknown filter: " << name;
+        return filter;
+    }
+
+    filter->setRadius(twSize);
+    if( lambda > 0.0 )
+        filter->setOverrideInterLayerWeight(true, lambda);
     return filter;
 }
@@ -30,20 +30,44 @@ namespace mld {
 
 class AbstractTimeVertexFilter;
 
+/**
+ * @brief Optional filter parameters, only used by the filters that need them
+ */
+struct MLD_API FilterOptions
+{
+    FilterOptions()
+        : order(30)
+        , tau(1.0)
+        , bandLow(0.0)
+        , bandHigh(0.5)
+        , maxNeighbors(0)
+        , seed(0)
+    {}
+
+    uint32_t order;     // Chebyshev polynomial order
+    double tau;         // Heat kernel scale
+    double bandLow;     // Pass band relative to the largest eigenvalue
+    double bandHigh;
+    size_t maxNeighbors; // Neighbor sampling cap of tvm, 0 for exact filtering
+    uint32_t seed;       // Neighbor sampling seed
+};
+
 class MLD_API FilterFactory
 {
 public:
     /**
      * @brief Create a filter from name and parameters
      * @param g Graph
-     * @param name Name of the filter
+     * @param name Name of the filter: tvm, heat, lowpass or bandpass
      * @param lambda if lambda > 0.0 the default lambda is overriden
      * @param twSize TimeWindow Size
-     * @return filter
+     * @param opts Filter specific options
+     * @return filter, nullptr if the name is unknown
      */
     static AbstractTimeVertexFilter* create( sparksee::gdb::Graph* g,
                                              const std::string& name,
-                                             double lambda, uint32_t twSize );
+                                             double lambda, uint32_t twSize,
+                                             const FilterOptions& opts=FilterOptions() );
 };
 
 } // end namespace mld
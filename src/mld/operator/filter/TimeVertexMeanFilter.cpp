@@ -18,9 +18,13 @@
 
 #include <vector>
 #include <algorithm>
+#include <cmath>
 #include "mld/operator/filter/TimeVertexMeanFilter.h"
 #include "mld/operator/TSCache.h"
 #include "mld/dao/MLGDao.h"
+#include "mld/model/GraphSnapshot.h"
+#include "mld/model/SignalStore.h"
+#include "mld/utils/Timer.h"
 
 using namespace mld;
 using namespace sparksee::gdb;
@@ -28,6 +32,8 @@ using namespace sparksee::gdb;
 TimeVertexMeanFilter::TimeVertexMeanFilter( Graph* g )
     : AbstractTimeVertexFilter(g)
     , m_weightSum(0.0)
+    , m_maxNeighbors(0)
+    , m_seed(0)
 {
 }
 
@@ -69,9 +75,147 @@ std::string TimeVertexMeanFilter::name() const
     if( m_override )
         name += " overriden lambda: " + std::to_string(m_lambda);
 
+    if( m_maxNeighbors > 0 )
+        name += " max neighbors: " + std::to_string(m_maxNeighbors) + " seed: " + std::to_string(m_seed);
+
     return name;
 }
 
+namespace {
+
+// Layer invariant inputs of the in-memory kernels
+struct LayerArgs
+{
+    const GraphSnapshot* graph;
+    size_t twSize;
+    size_t channels;
+    const SignalValue* const* rows;      // Time window rows, rows[ch * twSize + k]
+    const SignalValue* const* selfRows;  // Rows of the filtered layer, one per channel
+    const double* lambdas;
+    const double* selfCoeffs;
+    double selfSum;
+    SignalValue* const* outRows;         // Output rows, one per channel
+    const NeighborSampler* sampler;      // nullptr if all the neighbors are used
+};
+
+/**
+ * @brief Accumulate the weighted time window of a neighbor
+ * @param nb Neighbor index
+ * @param w HLink weight
+ * @param scale Estimator scale of a sampled neighbor, 1 otherwise
+ * @param coeffs Scratch buffer of twSize coeffs
+ * @param totals Weighted sums, one per channel
+ * @param weightSum Sum of the coeffs
+ */
+template <size_t N>
+inline void accumulateNeighbor( const LayerArgs& a, size_t nb, double w, double scale,
+                                double* coeffs, double* totals, double& weightSum )
+{
+    const size_t tw = N ? N : a.twSize;
+    const double invW = 1.0 / w;
+    for( size_t k = 0; k < tw; ++k ) {
+        // Resistivity coeff
+        coeffs[k] = scale * (1.0 / (invW + a.lambdas[k]));
+        weightSum += coeffs[k];
+    }
+    for( size_t ch = 0; ch < a.channels; ++ch ) {
+        const SignalValue* const* chRows = a.rows + ch * tw;
+        double total = totals[ch];
+        for( size_t k = 0; k < tw; ++k )
+            total += coeffs[k] * chRows[k][nb];
+        totals[ch] = total;
+    }
+}
+
+/**
+ * @brief Compute the weighted sums of a node, N is the time window size known
+ * at compile time (0 for any size) so that the window loops are unrolled
+ * @param i Node index
+ * @param sampled Use the sampled neighbors if the node is a hub
+ * @param samples Scratch buffer
+ * @return sum of the coeffs
+ */
+template <size_t N, bool TimeOnly>
+double filterNode( const LayerArgs& a, size_t i, bool sampled, NeighborSampler::SampleVec& samples,
+                   double* coeffs, double* totals )
+{
+    const size_t tw = N ? N : a.twSize;
+    double weightSum = a.selfSum;
+    for( size_t ch = 0; ch < a.channels; ++ch ) {
+        const SignalValue* const* chRows = a.rows + ch * tw;
+        double total = 0.0;
+        for( size_t k = 0; k < tw; ++k )
+            total += a.selfCoeffs[k] * chRows[k][i];
+        totals[ch] = total;
+    }
+
+    if( TimeOnly )
+        return weightSum;
+
+    // Filter in the vertex domain, neighbor coeffs are reused for every channel
+    const GraphSnapshot& graph = *a.graph;
+    const auto& targets = graph.targets();
+    const auto& weights = graph.weights();
+    if( sampled && a.sampler && a.sampler->isHub(i) ) {
+        a.sampler->draw(i, samples);
+        for( auto& s: samples )
+            accumulateNeighbor<N>(a, targets[s.first], weights[s.first], s.second, coeffs, totals, weightSum);
+    }
+    else {
+        for( size_t e = graph.neighborBegin(i); e != graph.neighborEnd(i); ++e )
+            accumulateNeighbor<N>(a, targets[e], weights[e], 1.0, coeffs, totals, weightSum);
+    }
+    return weightSum;
+}
+
+/**
+ * @brief Filter all the nodes of one layer
+ */
+template <size_t N, bool TimeOnly>
+void filterLayer( const LayerArgs& a )
+{
+    const size_t tw = N ? N : a.twSize;
+    std::vector<double> totals(a.channels);
+    std::vector<double> coeffs(tw);
+    NeighborSampler::SampleVec samples;
+
+    for( size_t i = 0; i < a.graph->nodeCount(); ++i ) {
+        double weightSum = filterNode<N, TimeOnly>(a, i, true, samples, coeffs.data(), totals.data());
+#ifdef MLD_SAFE
+        if( weightSum == 0.0 ) {
+            LOG(logERROR) << "TimeVertexMeanFilter::computeLayer invalid weighted sum " << a.graph->nodeId(i);
+            for( size_t ch = 0; ch < a.channels; ++ch )
+                a.outRows[ch][i] = a.selfRows[ch][i];
+            continue;
+        }
+#endif
+        for( size_t ch = 0; ch < a.channels; ++ch )
+            a.outRows[ch][i] = SignalValue(totals[ch] / weightSum);
+    }
+}
+
+using LayerKernel = void (*)( const LayerArgs& );
+
+// Window sizes of radius 1 to 4 in any direction
+template <bool TimeOnly>
+LayerKernel selectKernel( size_t twSize )
+{
+    switch( twSize ) {
+    case 1: return &filterLayer<1, TimeOnly>;
+    case 2: return &filterLayer<2, TimeOnly>;
+    case 3: return &filterLayer<3, TimeOnly>;
+    case 4: return &filterLayer<4, TimeOnly>;
+    case 5: return &filterLayer<5, TimeOnly>;
+    case 6: return &filterLayer<6, TimeOnly>;
+    case 7: return &filterLayer<7, TimeOnly>;
+    case 8: return &filterLayer<8, TimeOnly>;
+    case 9: return &filterLayer<9, TimeOnly>;
+    default: return &filterLayer<0, TimeOnly>;
+    }
+}
+
+} // end namespace anonymous
+
 OLink TimeVertexMeanFilter::compute( oid_t layerId, oid_t rootId )
 {
     OLink rootOLink(m_dao->getOLink(layerId, rootId));
@@ -85,23 +229,45 @@ OLink TimeVertexMeanFilter::compute( oid_t layerId, oid_t rootId )
         return rootOLink;
     }
 
+    // Cache mode is resolved once per node instead of once per neighbor
+    if( m_cache )
+        return computeNode<true>(rootOLink, rootId);
+    return computeNode<false>(rootOLink, rootId);
+}
+
+template <bool Cached>
+OLink TimeVertexMeanFilter::computeNode( OLink& rootOLink, oid_t rootId )
+{
     m_weightSum = 0.0; // weighted sum of all coeffs
     double total = 0.0;
-    int neighborsCount = 0;
     // Compute weight for root node itself (no hlink, set value to 1)
-    total += computeNodeSelfWeight(rootId);
+    total += nodeSelfWeight<Cached>(rootId);
 
     if( !m_timeOnly ) {  // Filter in the vertex domain
-        // Get current valid neighbors
-        ObjectsPtr neigh(m_dao->graph()->Neighbors(rootId, m_dao->hlinkType(), Outgoing));
-        neigh->Difference(m_excludedNodes.get());
-        neighborsCount = neigh->Count();
-
-        ObjectsIt it(neigh->Iterator());
-        while( it->HasNext() ) {  // Iterate through each neighbors
-            oid_t current = it->Next();
-            HLink currentHLink(m_dao->getHLink(rootId, current));
-            total += computeNodeWeight(current, currentHLink.weight());
+        // Iterate through each valid neighbor of the base layer snapshot
+        const GraphSnapshot& graph = baseGraph();
+        size_t idx = graph.index(rootId);
+        if( idx == INVALID_INDEX ) {
+            LOG(logERROR) << "TimeVertexMeanFilter::compute node excluded or not in base layer " << rootId;
+            return rootOLink;
+        }
+
+        if( useSampler(graph) && m_sampler.isHub(idx) ) {
+            // Exact value of the hubs flagged for the error report
+            double exact = 0.0;
+            bool checked = m_sampler.isChecked(idx);
+            if( checked ) {
+                double weightSum = m_weightSum;
+                exact = total + neighborsWeight<Cached>(graph, idx, false);
+                exact /= m_weightSum;
+                m_weightSum = weightSum;
+            }
+            total += neighborsWeight<Cached>(graph, idx, true);
+            if( checked && m_weightSum != 0.0 )
+                addSamplingError(total / m_weightSum, exact);
+        }
+        else {
+            total += neighborsWeight<Cached>(graph, idx, false);
         }
     }
 
@@ -119,20 +285,67 @@ OLink TimeVertexMeanFilter::compute( oid_t layerId, oid_t rootId )
     return rootOLink;
 }
 
+template <bool Cached>
+double TimeVertexMeanFilter::neighborsWeight( const GraphSnapshot& graph, size_t idx, bool sampled )
+{
+    double total = 0.0;
+    const auto& targets = graph.targets();
+    const auto& weights = graph.weights();
+    if( sampled ) {
+        m_sampler.draw(idx, m_samples);
+        for( auto& s: m_samples ) {
+            double weightSum = m_weightSum;
+            double w = nodeWeight<Cached>(graph.nodeId(targets[s.first]), weights[s.first]);
+            total += s.second * w;
+            m_weightSum = weightSum + s.second * (m_weightSum - weightSum);
+        }
+        return total;
+    }
+
+    for( size_t e = graph.neighborBegin(idx); e != graph.neighborEnd(idx); ++e )
+        total += nodeWeight<Cached>(graph.nodeId(targets[e]), weights[e]);
+    return total;
+}
+
 double TimeVertexMeanFilter::computeNodeWeight( oid_t node, double hlinkWeight )
+{
+    if( m_cache )
+        return nodeWeight<true>(node, hlinkWeight);
+    return nodeWeight<false>(node, hlinkWeight);
+}
+
+double TimeVertexMeanFilter::computeNodeSelfWeight( oid_t node )
+{
+    if( m_cache )
+        return nodeSelfWeight<true>(node);
+    return nodeSelfWeight<false>(node);
+}
+
+template <bool Cached>
+double TimeVertexMeanFilter::nodeWeight( oid_t node, double hlinkWeight )
 {
     double total = 0.0;
 
-    if( m_cache ) { // use cache and TimeSeries
+    if( Cached ) { // use cache and TimeSeries
         // Get TimeSeries
         auto entry = m_cache->get(node);
-        size_t i = 0;
-        for( auto it = entry.second.sliceBegin(); it != entry.second.sliceEnd(); ++it ) {
-            // Resistivity coeff
-            double c = 1.0 / (1.0 / hlinkWeight + m_coeffs.at(i).second);
-            m_weightSum += c;
-            total += c * (*it);
-            ++i;
+#ifdef MLD_SAFE
+        if( entry.second.sliceSize() != m_coeffs.size() ) {
+            LOG(logERROR) << "TimeVertexMeanFilter::computeNodeWeight slice and coeffs size mismatch " << node;
+            return 0.0;
+        }
+#endif
+        const double invW = 1.0 / hlinkWeight;
+        // Slice is stored in at most 2 contiguous segments
+        auto segs = entry.second.sliceSegments();
+        const TWCoeff* coeff = m_coeffs.data();
+        for( auto& seg: { segs.first, segs.second } ) {
+            for( size_t k = 0; k < seg.second; ++k, ++coeff ) {
+                // Resistivity coeff
+                double c = 1.0 / (invW + coeff->second);
+                m_weightSum += c;
+                total += c * seg.first[k];
+            }
         }
     }
     else {  // No cache
@@ -160,21 +373,30 @@ double TimeVertexMeanFilter::computeNodeWeight( oid_t node, double hlinkWeight )
     return total;
 }
 
-double TimeVertexMeanFilter::computeNodeSelfWeight( oid_t node )
+template <bool Cached>
+double TimeVertexMeanFilter::nodeSelfWeight( oid_t node )
 {
     double total = 0.0;
-    if( m_cache ) {
+    if( Cached ) {
         // Get TimeSeries
         auto entry = m_cache->get(node);
-        size_t i = 0;
-        for( auto it = entry.second.sliceBegin(); it != entry.second.sliceEnd(); ++it ) {
-            double c = 1.0;
-            if( m_coeffs.at(i).second != 0.0 ) {
-                c = 1.0 / m_coeffs.at(i).second;
+#ifdef MLD_SAFE
+        if( entry.second.sliceSize() != m_coeffs.size() ) {
+            LOG(logERROR) << "TimeVertexMeanFilter::computeNodeSelfWeight slice and coeffs size mismatch " << node;
+            return 0.0;
+        }
+#endif
+        auto segs = entry.second.sliceSegments();
+        const TWCoeff* coeff = m_coeffs.data();
+        for( auto& seg: { segs.first, segs.second } ) {
+            for( size_t k = 0; k < seg.second; ++k, ++coeff ) {
+                double c = 1.0;
+                if( coeff->second != 0.0 ) {
+                    c = 1.0 / coeff->second;
+                }
+                m_weightSum += c;
+                total += c * seg.first[k];
             }
-            m_weightSum += c;
-            total += c * (*it);
-            ++i;
         }
     }
     else {  // No cache
@@ -201,3 +423,116 @@ double TimeVertexMeanFilter::computeNodeSelfWeight( oid_t node )
 
     return total;
 }
+
+bool TimeVertexMeanFilter::computeLayer( const GraphSnapshot& graph, const SignalStore& in,
+                                         size_t layerIdx, SignalStore& out )
+{
+    if( m_coeffs.empty() ) {
+        LOG(logERROR) << "TimeVertexMeanFilter::computeLayer empty coeff, call computeTWCoeffs prior to computeLayer";
+        return false;
+    }
+
+    // Resolve time window rows, self coeffs do not depend on the node
+    const size_t twSize = m_coeffs.size();
+    const size_t channels = in.channelCount();
+    std::vector<const SignalValue*> rows(channels * twSize); // rows[ch * twSize + k]
+    std::vector<double> lambdas;
+    std::vector<double> selfCoeffs;
+    double selfSum = 0.0;
+    for( size_t k = 0; k < twSize; ++k ) {
+        const TWCoeff& coeff = m_coeffs[k];
+        size_t idx = in.layerIndex(coeff.first);
+        if( idx == INVALID_INDEX ) {
+            LOG(logERROR) << "TimeVertexMeanFilter::computeLayer unknown layer " << coeff.first;
+            return false;
+        }
+        for( size_t ch = 0; ch < channels; ++ch )
+            rows[ch * twSize + k] = in.layer(idx, ch);
+        lambdas.push_back(coeff.second);
+        // Special value for self value at current time
+        double c = 1.0;
+        if( coeff.second != 0.0 )
+            c = 1.0 / coeff.second;
+        selfCoeffs.push_back(c);
+        selfSum += c;
+    }
+
+    std::vector<const SignalValue*> selfRows(channels);
+    std::vector<SignalValue*> outRows(channels);
+    for( size_t ch = 0; ch < channels; ++ch ) {
+        selfRows[ch] = in.layer(layerIdx, ch);
+        outRows[ch] = out.layer(layerIdx, ch);
+    }
+
+    LayerArgs args;
+    args.graph = &graph;
+    args.twSize = twSize;
+    args.channels = channels;
+    args.rows = rows.data();
+    args.selfRows = selfRows.data();
+    args.lambdas = lambdas.data();
+    args.selfCoeffs = selfCoeffs.data();
+    args.selfSum = selfSum;
+    args.outRows = outRows.data();
+    args.sampler = (!m_timeOnly && useSampler(graph)) ? &m_sampler : nullptr;
+
+    // Kernel specialized on the window size and the filtering domain
+    LayerKernel kernel = m_timeOnly ? selectKernel<true>(twSize) : selectKernel<false>(twSize);
+    kernel(args);
+
+    // Compare the sampled value with the exact one on the checked hubs
+    if( args.sampler ) {
+        std::vector<double> totals(channels);
+        std::vector<double> coeffs(twSize);
+        for( size_t i = 0; i < graph.nodeCount(); ++i ) {
+            if( !m_sampler.isChecked(i) )
+                continue;
+            double weightSum = filterNode<0, false>(args, i, false, m_samples, coeffs.data(), totals.data());
+            if( weightSum != 0.0 )
+                addSamplingError(outRows[0][i], totals[0] / weightSum);
+        }
+    }
+    return true;
+}
+
+void TimeVertexMeanFilter::setNeighborSampling( size_t maxNeighbors, uint32_t seed )
+{
+    m_maxNeighbors = maxNeighbors;
+    m_seed = seed;
+    m_sampler.clear();
+    resetSamplingError();
+}
+
+void TimeVertexMeanFilter::resetGraph()
+{
+    AbstractTimeVertexFilter::resetGraph();
+    m_sampler.clear();
+}
+
+void TimeVertexMeanFilter::resetSamplingError()
+{
+    m_samplingError = SamplingError();
+}
+
+bool TimeVertexMeanFilter::useSampler( const GraphSnapshot& graph )
+{
+    if( m_maxNeighbors == 0 )
+        return false;
+    if( !m_sampler.isBuiltFor(graph) ) {
+        std::unique_ptr<Timer> t(new Timer("TimeVertexMeanFilter::buildSampler"));
+        m_sampler.build(graph, m_maxNeighbors, m_seed);
+        LOG(logDEBUG) << "TimeVertexMeanFilter::useSampler hubs: " << m_sampler.hubCount()
+                      << " max neighbors: " << m_maxNeighbors;
+    }
+    return m_sampler.hubCount() > 0;
+}
+
+void TimeVertexMeanFilter::addSamplingError( double approx, double exact )
+{
+    double err = std::abs(approx - exact);
+    m_samplingError.nodes += 1;
+    m_samplingError.sumAbs += err;
+    m_samplingError.maxAbs = std::max(m_samplingError.maxAbs, err);
+    if( exact != 0.0 )
+        m_samplingError.maxRel = std::max(m_samplingError.maxRel, err / std::abs(exact));
+}
@@ -21,6 +21,7 @@
 
 #include "mld/common.h"
 #include "mld/operator/filter/AbstractTimeVertexFilter.h"
+#include "mld/model/NeighborSampler.h"
 
 namespace sparksee {
 namespace gdb {
@@ -29,6 +30,27 @@ namespace gdb {
 
 namespace mld {
 
+/**
+ * @brief Approximation error of the neighbor sampling,
+ * measured on a sample of hubs against the exact filter
+ */
+struct MLD_API SamplingError
+{
+    SamplingError()
+        : nodes(0)
+        , sumAbs(0.0)
+        , maxAbs(0.0)
+        , maxRel(0.0)
+    {}
+
+    inline double meanAbs() const { return nodes ? sumAbs / nodes : 0.0; }
+
+    size_t nodes;   // Number of measures (node, layer)
+    double sumAbs;
+    double maxAbs;
+    double maxRel;
+};
+
 class MLD_API TimeVertexMeanFilter : public AbstractTimeVertexFilter
 {
 
@@ -41,12 +63,54 @@ public:
     virtual double computeNodeWeight( sparksee::gdb::oid_t node, double hlinkWeight ) override;
     virtual double computeNodeSelfWeight( sparksee::gdb::oid_t node ) override;
 
-//private:
-//    double computeNodeSelfWeightWithCache( sparksee::gdb::oid_t node, const TWCoeff& coeff );
-//    double computeNodeSelfWeightNoCache( sparksee::gdb::oid_t node, const TWCoeff& coeff );
+    virtual bool supportsInMemory() const override { return true; }
+    virtual bool computeLayer( const GraphSnapshot& graph, const SignalStore& in,
+                               size_t layerIdx, SignalStore& out ) override;
+
+    /**
+     * @brief Approximate mode, nodes with more than maxNeighbors HLinks only use
+     * maxNeighbors neighbors drawn proportionally to the HLink weights.
+     * @param maxNeighbors Neighbor cap, 0 to use all the neighbors (default)
+     * @param seed Random seed
+     */
+    void setNeighborSampling( size_t maxNeighbors, uint32_t seed=0 );
+    inline size_t maxNeighbors() const { return m_maxNeighbors; }
+
+    virtual void resetGraph() override;
+
+    /**
+     * @brief Get the approximation error of the neighbor sampling since the last reset
+     * @return error
+     */
+    inline const SamplingError& samplingError() const { return m_samplingError; }
+    void resetSamplingError();
+
+private:
+    // Cached: read the time window from the TSCache instead of the OLinks
+    template <bool Cached>
+    OLink computeNode( OLink& rootOLink, sparksee::gdb::oid_t rootId );
+    template <bool Cached>
+    double nodeWeight( sparksee::gdb::oid_t node, double hlinkWeight );
+    template <bool Cached>
+    double nodeSelfWeight( sparksee::gdb::oid_t node );
+    template <bool Cached>
+    double neighborsWeight( const GraphSnapshot& graph, size_t idx, bool sampled );
+
+    /**
+     * @brief Build the sampler on first use for this snapshot
+     * @param graph Snapshot
+     * @return true if at least one node is sampled
+     */
+    bool useSampler( const GraphSnapshot& graph );
+    void addSamplingError( double approx, double exact );
 
 private:
     double m_weightSum;
+    size_t m_maxNeighbors;
+    uint32_t m_seed;
+    NeighborSampler m_sampler;
+    NeighborSampler::SampleVec m_samples;
+    SamplingError m_samplingError;
 };
 
 } // end namespace mld
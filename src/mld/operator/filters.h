@@ -20,5 +20,6 @@
 #define MLD_FILTERS_H
 
 #include "mld/operator/filter/TimeVertexMeanFilter.h"
+#include "mld/operator/filter/ChebyshevFilter.h"
 
 #endif // MLD_FILTERS_H
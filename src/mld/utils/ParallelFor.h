@@ -0,0 +1,55 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_PARALLELFOR_H
+#define MLD_PARALLELFOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace mld {
+
+/**
+ * @brief Run fn(task, thread) for each task, tasks are dispatched on numThreads threads
+ * @param count Number of tasks
+ * @param numThreads Number of threads
+ * @param fn Task
+ */
+inline void parallelFor( size_t count, size_t numThreads, const std::function<void( size_t, size_t )>& fn )
+{
+    std::atomic<size_t> next(0);
+    auto worker = [&]( size_t thread ) {
+        for( size_t i = next++; i < count; i = next++ )
+            fn(i, thread);
+    };
+
+    numThreads = std::max<size_t>(1, std::min(numThreads, count));
+    std::vector<std::thread> threads;
+    for( size_t t = 1; t < numThreads; ++t )
+        threads.emplace_back(worker, t);
+    worker(0);
+    for( auto& th: threads )
+        th.join();
+}
+
+} // end namespace mld
+
+#endif // MLD_PARALLELFOR_H
@@ -0,0 +1,200 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_TRIDIAGONAL_H
+#define MLD_TRIDIAGONAL_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace mld {
+
+/**
+ * @brief Eigen decomposition of a symmetric tridiagonal matrix (implicit QL algorithm)
+ * @param d Diagonal, replaced by the eigenvalues (not sorted)
+ * @param e Sub-diagonal, e[i] = T(i + 1, i)
+ * @param z Output eigenvectors, n x n row major, column k is associated to d[k]
+ * @return false if the algorithm did not converge
+ */
+inline bool tridiagonalEigen( std::vector<double>& d, std::vector<double> e, std::vector<double>& z )
+{
+    const size_t n = d.size();
+    z.assign(n * n, 0.0);
+    for( size_t i = 0; i < n; ++i )
+        z[i * n + i] = 1.0;
+    e.resize(n, 0.0);
+    if( n > 0 )
+        e[n - 1] = 0.0;
+
+    for( size_t l = 0; l < n; ++l ) {
+        int iter = 0;
+        size_t m = l;
+        do {
+            // Look for a small sub-diagonal element to split the matrix
+            for( m = l; m + 1 < n; ++m ) {
+                double dd = std::fabs(d[m]) + std::fabs(d[m + 1]);
+                if( std::fabs(e[m]) <= std::numeric_limits<double>::epsilon() * dd )
+                    break;
+            }
+            if( m == l )
+                break;
+            if( iter++ == 60 )
+                return false;
+
+            // Wilkinson shift
+            double g = (d[l + 1] - d[l]) / (2.0 * e[l]);
+            double r = std::hypot(g, 1.0);
+            g = d[m] - d[l] + e[l] / (g + (g >= 0.0 ? r : -r));
+            double s = 1.0;
+            double c = 1.0;
+            double p = 0.0;
+            bool underflow = false;
+            for( size_t i = m; i-- > l; ) {
+                double f = s * e[i];
+                double b = c * e[i];
+                r = std::hypot(f, g);
+                e[i + 1] = r;
+                if( r == 0.0 ) {
+                    d[i + 1] -= p;
+                    e[m] = 0.0;
+                    underflow = true;
+                    break;
+                }
+                s = f / r;
+                c = g / r;
+                g = d[i + 1] - p;
+                r = (d[i] - g) * s + 2.0 * c * b;
+                p = s * r;
+                d[i + 1] = g + p;
+                g = c * r - b;
+                // Accumulate rotation
+                for( size_t k = 0; k < n; ++k ) {
+                    f = z[k * n + i + 1];
+                    z[k * n + i + 1] = s * z[k * n + i] + c * f;
+                    z[k * n + i] = c * z[k * n + i] - s * f;
+                }
+            }
+            if( underflow )
+                continue;
+            d[l] -= p;
+            e[l] = g;
+            e[m] = 0.0;
+        } while( m != l );
+    }
+    return true;
+}
+
+/**
+ * @brief Eigen decomposition of a small dense symmetric matrix, the matrix is reduced
+ * to tridiagonal form by Householder reflections then solved with tridiagonalEigen
+ * @param a Matrix, n x n row major, destroyed
+ * @param n Size
+ * @param d Output eigenvalues, sorted in increasing order
+ * @param z Output eigenvectors, n x n row major, column k is associated to d[k]
+ * @return false if the algorithm did not converge
+ */
+inline bool symmetricEigen( std::vector<double>& a, size_t n, std::vector<double>& d, std::vector<double>& z )
+{
+    // Q accumulates the reflections, A = Q T Q^T
+    std::vector<double> q(n * n, 0.0);
+    for( size_t i = 0; i < n; ++i )
+        q[i * n + i] = 1.0;
+    std::vector<double> v(n);
+    std::vector<double> w(n);
+    for( size_t k = 0; k + 2 < n; ++k ) {
+        double norm = 0.0;
+        for( size_t i = k + 1; i < n; ++i )
+            norm += a[i * n + k] * a[i * n + k];
+        norm = std::sqrt(norm);
+        if( norm == 0.0 )
+            continue;
+        // H = I - 2 v v^T maps the column below the diagonal on e_k+1
+        double alpha = a[(k + 1) * n + k] > 0.0 ? -norm : norm;
+        std::fill(v.begin(), v.end(), 0.0);
+        for( size_t i = k + 1; i < n; ++i )
+            v[i] = a[i * n + k];
+        v[k + 1] -= alpha;
+        double vnorm = 0.0;
+        for( size_t i = k + 1; i < n; ++i )
+            vnorm += v[i] * v[i];
+        if( vnorm == 0.0 )
+            continue;
+        vnorm = std::sqrt(vnorm);
+        for( size_t i = k + 1; i < n; ++i )
+            v[i] /= vnorm;
+
+        // H A H = A - v u^T - u v^T with u = 2 (A v - (v^T A v) v)
+        double vav = 0.0;
+        for( size_t i = 0; i < n; ++i ) {
+            double acc = 0.0;
+            for( size_t j = k + 1; j < n; ++j )
+                acc += a[i * n + j] * v[j];
+            w[i] = acc;
+            vav += v[i] * acc;
+        }
+        for( size_t i = 0; i < n; ++i )
+            w[i] = 2.0 * (w[i] - vav * v[i]);
+        for( size_t i = 0; i < n; ++i ) {
+            for( size_t j = 0; j < n; ++j )
+                a[i * n + j] -= v[i] * w[j] + w[i] * v[j];
+        }
+        // Q = Q H
+        for( size_t i = 0; i < n; ++i ) {
+            double acc = 0.0;
+            for( size_t j = k + 1; j < n; ++j )
+                acc += q[i * n + j] * v[j];
+            for( size_t j = k + 1; j < n; ++j )
+                q[i * n + j] -= 2.0 * acc * v[j];
+        }
+    }
+
+    std::vector<double> td(n);
+    std::vector<double> te(n, 0.0);
+    for( size_t i = 0; i < n; ++i ) {
+        td[i] = a[i * n + i];
+        if( i + 1 < n )
+            te[i] = a[(i + 1) * n + i];
+    }
+    std::vector<double> tz;
+    if( !tridiagonalEigen(td, te, tz) )
+        return false;
+
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&td]( size_t x, size_t y ) { return td[x] < td[y]; });
+    d.resize(n);
+    z.assign(n * n, 0.0);
+    for( size_t c = 0; c < n; ++c ) {
+        size_t src = order[c];
+        d[c] = td[src];
+        for( size_t i = 0; i < n; ++i ) {
+            double acc = 0.0;
+            for( size_t j = 0; j < n; ++j )
+                acc += q[i * n + j] * tz[j * n + src];
+            z[i * n + c] = acc;
+        }
+    }
+    return true;
+}
+
+} // end namespace mld
+
+#endif // MLD_TRIDIAGONAL_H
@@ -23,6 +23,7 @@
 
 #include <mld/dao/MLGDao.h>
 #include <mld/MLGBuilder.h>
+#include <mld/model/AncestryIndex.h>
 #include <mld/operator/coarseners.h>
 #include <mld/utils/Timer.h>
 
@@ -171,3 +172,62 @@ TEST( MLGBuilderTest, runStepTest )
 
     LOG(logINFO) << Timer::dumpTrials();
 }
+
+TEST( MLGBuilderTest, ancestryIndexTest )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    // Create Db scheme
+    sparkseeManager.createBaseScheme(g);
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+
+    Layer base = dao->addBaseLayer();
+
+    // Same graph as runStepTest, n1 - n2 is the heaviest hlink
+    mld::Node n1 = dao->addNodeToLayer(base);
+    mld::Node n2 = dao->addNodeToLayer(base);
+    mld::Node n3 = dao->addNodeToLayer(base);
+    mld::Node n4 = dao->addNodeToLayer(base);
+    mld::Node n5 = dao->addNodeToLayer(base);
+    n2.setWeight(100);
+    dao->updateNode(n2);
+    dao->addHLink(n1, n2, 5);
+    dao->addHLink(n1, n4, 4);
+    dao->addHLink(n2, n5, 3);
+    dao->addHLink(n1, n3);
+    dao->addHLink(n2, n3);
+
+    std::unique_ptr<MLGBuilder> builder( new MLGBuilder );
+    AncestryIndex index;
+    builder->setAncestryIndex(g, &index);
+
+    CoarsenerPtr coarsener = builder->createCoarsener(g, "Hs", 0.0);
+    for( int i = 0; i < 4; ++i )
+        builder->addStep(coarsener);
+    EXPECT_TRUE(builder->run());
+    Layer top = dao->topLayer();
+
+    // Index built incrementally, every base node ends in the top node
+    ASSERT_EQ(size_t(5), index.levelCount());
+    EXPECT_EQ(top.id(), index.layerId(4));
+    ASSERT_EQ(size_t(1), index.nodes(4).size());
+    for( auto& n: { n1, n2, n3, n4, n5 } ) {
+        EXPECT_EQ(base.id(), index.layerOf(n.id()));
+        EXPECT_EQ(index.nodes(4)[0], index.ancestor(n.id(), 4));
+    }
+    // Heaviest hlink collapsed first
+    EXPECT_EQ(size_t(1), index.mergeLevel(n1.id(), n2.id()));
+
+    // Failed step, no layer added to the index
+    builder->addStep(coarsener);
+    EXPECT_FALSE(builder->run());
+    EXPECT_EQ(size_t(5), index.levelCount());
+    coarsener.reset();
+
+    builder.reset();
+    dao.reset();
+    sess.reset();
+}
@@ -90,6 +90,8 @@ TEST( LayerDaoTest, BaseLayer )
 
     // Only baseLayer
     EXPECT_EQ(dao->getLayerCount(), 1);
+    // Width of the signal values written by this build
+    EXPECT_EQ(int(sizeof(SignalValue) * 8), dao->signalBits());
 
     dao.reset();
     sess.reset();
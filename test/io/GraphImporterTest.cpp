@@ -0,0 +1,385 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <locale>
+#include <codecvt>
+#include <fstream>
+#include <cstdio>
+
+#include <sparksee/gdb/Graph.h>
+#include <sparksee/gdb/Objects.h>
+#include <sparksee/gdb/ObjectsIterator.h>
+
+#include <mld/common.h>
+#include <mld/config.h>
+#include <mld/SparkseeManager.h>
+#include <mld/GraphTypes.h>
+
+#include <mld/dao/MLGDao.h>
+#include <mld/io/GraphImporter.h>
+#include <mld/io/GraphExporter.h>
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+TEST( GraphImporterTest, SnapParallel )
+{
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    std::string path(converter.to_bytes(mld::kRESOURCES_DIR) + "snap_test.txt");
+    {
+        // Comments, self loop, malformed lines, id above 2^64 and no final end of line
+        std::ofstream out(path);
+        out << "# Undirected graph\n# Nodes: 6 Edges: 4\n"
+            << "1 2\n2\t3\r\n3 3\n\nnot an edge\n18446744073709551616 7\n10 1\n4 5";
+    }
+
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+
+    // 8 threads, the chunks hold a few lines each and are cut at line ends
+    EXPECT_TRUE(GraphImporter::fromSnapFormat(g, path, 8));
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->baseLayer();
+    // 1, 2, 3, 4, 5 and 10
+    EXPECT_EQ(6, dao->getNodeCount(base));
+    EXPECT_EQ(4, dao->getHLinkCount(base));
+
+    // Labels are the SNAP ids
+    attr_t labelAttr = g->FindAttribute(dao->nodeType(), Attrs::V[NodeAttr::LABEL]);
+    Value v;
+    ObjectsPtr n1(g->Select(labelAttr, Equal, v.SetString(L"1")));
+    ObjectsPtr n10(g->Select(labelAttr, Equal, v.SetString(L"10")));
+    ASSERT_EQ(1, n1->Count());
+    ASSERT_EQ(1, n10->Count());
+    HLink link = dao->getHLink(n1->Any(), n10->Any());
+    EXPECT_NE(Objects::InvalidOID, link.id());
+
+    n1.reset();
+    n10.reset();
+    dao.reset();
+    sess.reset();
+    std::remove(path.c_str());
+}
+
+TEST( GraphImporterTest, TimeSeries )
+{
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    std::string nodePath(converter.to_bytes(mld::kRESOURCES_DIR) + "ts_test.nodes.csv");
+    std::string edgePath(converter.to_bytes(mld::kRESOURCES_DIR) + "ts_test.edges.csv");
+    {
+        // Quoted values, CRLF line, UTF-8 label and a blank line
+        std::ofstream out(nodePath);
+        out << "#id,label,weight,ts:3\n"
+            << "0,caf\xc3\xa9,1.5,\"1,2.5,-3e2\"\r\n"
+            << "\n"
+            << "1,b,2,4,5,6\n";
+        std::ofstream edges(edgePath);
+        edges << "src,tgt,weight\n0,1,0.5\n";
+    }
+
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+
+    EXPECT_TRUE(GraphImporter::fromTimeSeries(g, nodePath, edgePath));
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->baseLayer();
+    EXPECT_EQ(3, dao->getLayerCount());
+    EXPECT_EQ(2, dao->getNodeCount(base));
+    EXPECT_EQ(1, dao->getHLinkCount(base));
+
+    attr_t labelAttr = g->FindAttribute(dao->nodeType(), Attrs::V[NodeAttr::LABEL]);
+    Value v;
+    ObjectsPtr n0(g->Select(labelAttr, Equal, v.SetString(L"café")));
+    ObjectsPtr n1(g->Select(labelAttr, Equal, v.SetString(L"b")));
+    ASSERT_EQ(1, n0->Count());
+    ASSERT_EQ(1, n1->Count());
+    EXPECT_DOUBLE_EQ(1.5, dao->getNode(n0->Any()).weight());
+
+    // Values are stored layer by layer from the base layer
+    std::vector<double> expected0 = { 1.0, 2.5, -300.0 };
+    std::vector<double> expected1 = { 4.0, 5.0, 6.0 };
+    Layer layer = base;
+    for( size_t l = 0; l < 3; ++l ) {
+        EXPECT_DOUBLE_EQ(expected0[l], dao->getOLink(layer.id(), n0->Any()).weight());
+        EXPECT_DOUBLE_EQ(expected1[l], dao->getOLink(layer.id(), n1->Any()).weight());
+        layer = dao->parent(layer);
+    }
+
+    // Export streams the values back in layer order
+    std::string folder(converter.to_bytes(mld::kRESOURCES_DIR));
+    std::string exportPath(folder + "ts_export.nodes.csv");
+    EXPECT_TRUE(GraphExporter::toTimeSeries(g, "ts_export", folder));
+    {
+        std::ifstream in(exportPath);
+        std::string header;
+        std::getline(in, header);
+        EXPECT_NE(std::string::npos, header.find("ts:3"));
+        std::vector<std::string> lines;
+        std::string line;
+        while( std::getline(in, line) )
+            lines.push_back(line);
+        ASSERT_EQ(size_t(2), lines.size());
+        EXPECT_NE(std::string::npos, lines[0].find("\"1,2.5,-300\""));
+        EXPECT_NE(std::string::npos, lines[1].find("\"4,5,6\""));
+    }
+    std::remove(exportPath.c_str());
+    std::remove((folder + "ts_export.edges.csv").c_str());
+
+    // Node set by label, unknown labels are skipped
+    std::string setPath(folder + "ts_exclude.txt");
+    {
+        std::ofstream out(setPath);
+        out << "# excluded\nb\nunknown\n\nb\n";
+    }
+    ObjectsPtr excluded;
+    EXPECT_TRUE(GraphImporter::readNodeSet(g, setPath, excluded));
+    ASSERT_EQ(1, excluded->Count());
+    EXPECT_TRUE(excluded->Exists(n1->Any()));
+    excluded.reset();
+    std::remove(setPath.c_str());
+
+    n0.reset();
+    n1.reset();
+    dao.reset();
+    sess.reset();
+    std::remove(nodePath.c_str());
+    std::remove(edgePath.c_str());
+}
+
+TEST( GraphImporterTest, TimeSeriesInvalid )
+{
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    std::string nodePath(converter.to_bytes(mld::kRESOURCES_DIR) + "ts_invalid.nodes.csv");
+    std::string edgePath(converter.to_bytes(mld::kRESOURCES_DIR) + "ts_invalid.edges.csv");
+    {
+        // Invalid value on the last line
+        std::ofstream out(nodePath);
+        out << "id,label,ts:2\n0,a,1,2\n1,b,3,4\n2,c,5,x\n";
+        std::ofstream edges(edgePath);
+        edges << "src,tgt,weight\n0,1,0.5\n";
+    }
+
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+
+    // File is validated before the first write
+    EXPECT_FALSE(GraphImporter::fromTimeSeries(g, nodePath, edgePath));
+    {
+        MLGDao dao(g);
+        EXPECT_EQ(0, dao.getLayerCount());
+        EXPECT_EQ(0, g->CountNodes());
+        EXPECT_EQ(Attribute::InvalidAttribute, g->FindAttribute(dao.nodeType(), L"id"));
+    }
+
+    sess.reset();
+    std::remove(nodePath.c_str());
+    std::remove(edgePath.c_str());
+}
+
+TEST( GraphImporterTest, BinaryTimeSeries )
+{
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    std::string folder(converter.to_bytes(mld::kRESOURCES_DIR));
+    std::string nodePath(folder + "ts_bin.nodes.csv");
+    std::string edgePath(folder + "ts_bin.edges.csv");
+    std::string binPath(folder + "ts_bin.mldts");
+    {
+        std::ofstream out(nodePath);
+        out << "#id,label,weight,ts:3\n"
+            << "0,caf\xc3\xa9,1.5,1,2.5,-300\n"
+            << "1,b,2,4,4,4\n"
+            << "2,c,1,0,-0.5,8\n";
+        std::ofstream edges(edgePath);
+        edges << "src,tgt,weight\n0,1,0.5\n2,0,3\n";
+    }
+
+    {
+        mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+        sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+        SessionPtr sess = sparkseeManager.newSession();
+        Graph* g = sess->GetGraph();
+        sparkseeManager.createBaseScheme(g);
+        EXPECT_TRUE(GraphImporter::fromTimeSeries(g, nodePath, edgePath));
+        EXPECT_TRUE(GraphExporter::toBinaryTimeSeries(g, binPath));
+    }
+
+    // Import in a fresh database
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest2.sparksee", L"MLDTest2");
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+    EXPECT_TRUE(GraphImporter::fromBinaryTimeSeries(g, binPath));
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->baseLayer();
+    EXPECT_EQ(3, dao->getLayerCount());
+    EXPECT_EQ(3, dao->getNodeCount(base));
+    EXPECT_EQ(2, dao->getHLinkCount(base));
+
+    attr_t labelAttr = g->FindAttribute(dao->nodeType(), Attrs::V[NodeAttr::LABEL]);
+    Value v;
+    ObjectsPtr n0(g->Select(labelAttr, Equal, v.SetString(L"café")));
+    ObjectsPtr n1(g->Select(labelAttr, Equal, v.SetString(L"b")));
+    ObjectsPtr n2(g->Select(labelAttr, Equal, v.SetString(L"c")));
+    ASSERT_EQ(1, n0->Count());
+    ASSERT_EQ(1, n1->Count());
+    ASSERT_EQ(1, n2->Count());
+    EXPECT_DOUBLE_EQ(1.5, dao->getNode(n0->Any()).weight());
+    EXPECT_DOUBLE_EQ(0.5, dao->getHLink(n0->Any(), n1->Any()).weight());
+    EXPECT_DOUBLE_EQ(3.0, dao->getHLink(n2->Any(), n0->Any()).weight());
+
+    std::vector<double> expected0 = { 1.0, 2.5, -300.0 };
+    std::vector<double> expected2 = { 0.0, -0.5, 8.0 };
+    Layer layer = base;
+    for( size_t l = 0; l < 3; ++l ) {
+        EXPECT_DOUBLE_EQ(expected0[l], dao->getOLink(layer.id(), n0->Any()).weight());
+        EXPECT_DOUBLE_EQ(4.0, dao->getOLink(layer.id(), n1->Any()).weight());
+        EXPECT_DOUBLE_EQ(expected2[l], dao->getOLink(layer.id(), n2->Any()).weight());
+        layer = dao->parent(layer);
+    }
+
+    n0.reset();
+    n1.reset();
+    n2.reset();
+    dao.reset();
+    sess.reset();
+    std::remove(nodePath.c_str());
+    std::remove(edgePath.c_str());
+    std::remove(binPath.c_str());
+}
+
+TEST( GraphImporterTest, AppendTimeSeries )
+{
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    std::string folder(converter.to_bytes(mld::kRESOURCES_DIR));
+    std::string nodePath(folder + "ts_append.nodes.csv");
+    std::string edgePath(folder + "ts_append.edges.csv");
+    std::string dayPath(folder + "ts_day.nodes.csv");
+    std::string badPath(folder + "ts_bad.nodes.csv");
+    std::string noStepPath(folder + "ts_nostep.nodes.csv");
+    std::string codePath(folder + "ts_code.nodes.csv");
+    std::string badCodePath(folder + "ts_badcode.nodes.csv");
+    {
+        std::ofstream out(nodePath);
+        out << "#id,label,weight,ts:2\n"
+            << "0,a,1,1,2\n"
+            << "1,b,1,3,4\n";
+        std::ofstream edges(edgePath);
+        edges << "src,tgt,weight\n0,1,1\n";
+        // Rows in another order
+        std::ofstream day(dayPath);
+        day << "label,ts:2:2\n"
+            << "b,30,40\n"
+            << "a,10,20\n";
+        std::ofstream bad(badPath);
+        bad << "label,ts:1:2\n"
+            << "a,1\n"
+            << "unknown,2\n";
+        // No first step in the header
+        std::ofstream noStep(noStepPath);
+        noStep << "label,ts:2\n"
+               << "b,30,40\n"
+               << "a,10,20\n";
+        // Integer keys above 2^53
+        std::ofstream code(codePath);
+        code << "code,ts:1:4\n"
+             << "9007199254740993,50\n"
+             << "9007199254740992,60\n";
+        std::ofstream badCode(badCodePath);
+        badCode << "code,ts:1:4\n"
+                << "9007199254740993,50\n"
+                << "1,60\n";
+    }
+
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+    EXPECT_TRUE(GraphImporter::fromTimeSeries(g, nodePath, edgePath));
+
+    // Layer count check and unmatched rows leave the database untouched
+    EXPECT_FALSE(GraphImporter::appendTimeSeries(g, dayPath, "label", 3));
+    EXPECT_FALSE(GraphImporter::appendTimeSeries(g, noStepPath));
+    EXPECT_FALSE(GraphImporter::appendTimeSeries(g, badPath));
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    EXPECT_EQ(2, dao->getLayerCount());
+
+    EXPECT_TRUE(GraphImporter::appendTimeSeries(g, dayPath));
+    EXPECT_EQ(4, dao->getLayerCount());
+
+    attr_t labelAttr = g->FindAttribute(dao->nodeType(), Attrs::V[NodeAttr::LABEL]);
+    Value v;
+    ObjectsPtr a(g->Select(labelAttr, Equal, v.SetString(L"a")));
+    ObjectsPtr b(g->Select(labelAttr, Equal, v.SetString(L"b")));
+    ASSERT_EQ(1, a->Count());
+    ASSERT_EQ(1, b->Count());
+    std::vector<double> expectedA = { 1.0, 2.0, 10.0, 20.0 };
+    std::vector<double> expectedB = { 3.0, 4.0, 30.0, 40.0 };
+    Layer layer = dao->baseLayer();
+    for( size_t l = 0; l < 4; ++l ) {
+        EXPECT_DOUBLE_EQ(expectedA[l], dao->getOLink(layer.id(), a->Any()).weight());
+        EXPECT_DOUBLE_EQ(expectedB[l], dao->getOLink(layer.id(), b->Any()).weight());
+        layer = dao->parent(layer);
+    }
+
+    // Match on a Basic Long attribute, it is only indexed once a file is accepted
+    ASSERT_TRUE(SparkseeManager::addAttrToNode(g, L"code", Long, Basic, Value().SetNull()));
+    attr_t codeAttr = g->FindAttribute(dao->nodeType(), L"code");
+    g->SetAttribute(a->Any(), codeAttr, v.SetLong(9007199254740993LL));
+    g->SetAttribute(b->Any(), codeAttr, v.SetLong(9007199254740992LL));
+    EXPECT_FALSE(GraphImporter::appendTimeSeries(g, badCodePath, "code"));
+    EXPECT_EQ(4, dao->getLayerCount());
+    {
+        std::unique_ptr<Attribute> attr(g->GetAttribute(codeAttr));
+        EXPECT_EQ(Basic, attr->GetKind());
+    }
+    EXPECT_TRUE(GraphImporter::appendTimeSeries(g, codePath, "code"));
+    EXPECT_EQ(5, dao->getLayerCount());
+    {
+        std::unique_ptr<Attribute> attr(g->GetAttribute(codeAttr));
+        EXPECT_EQ(Indexed, attr->GetKind());
+    }
+    EXPECT_DOUBLE_EQ(50.0, dao->getOLink(dao->topLayer().id(), a->Any()).weight());
+    EXPECT_DOUBLE_EQ(60.0, dao->getOLink(dao->topLayer().id(), b->Any()).weight());
+
+    a.reset();
+    b.reset();
+    dao.reset();
+    sess.reset();
+    for( auto& path: { nodePath, edgePath, dayPath, badPath, noStepPath, codePath, badCodePath } )
+        std::remove(path.c_str());
+}
@@ -0,0 +1,149 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <locale>
+#include <codecvt>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+#include <sparksee/gdb/Graph.h>
+#include <sparksee/gdb/Objects.h>
+
+#include <mld/common.h>
+#include <mld/config.h>
+#include <mld/SparkseeManager.h>
+#include <mld/GraphTypes.h>
+
+#include <mld/dao/MLGDao.h>
+#include <mld/io/BinaryCodec.h>
+#include <mld/io/MatrixExporter.h>
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+namespace {
+
+std::vector<std::string> readLines( const std::string& path )
+{
+    std::vector<std::string> res;
+    std::ifstream in(path);
+    std::string line;
+    while( std::getline(in, line) )
+        res.push_back(line);
+    return res;
+}
+
+} // end namespace anonymous
+
+TEST( MatrixExporterTest, LayersAndMaps )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    // Base layer a - b - c, top layer p - q
+    Layer base = dao->addBaseLayer();
+    mld::Node a = dao->addNodeToLayer(base);
+    mld::Node b = dao->addNodeToLayer(base);
+    mld::Node c = dao->addNodeToLayer(base);
+    dao->addHLink(a, b, 2.0);
+    dao->addHLink(b, c, 3.0);
+    Layer top = dao->addLayerOnTop();
+    mld::Node p = dao->addNodeToLayer(top);
+    mld::Node q = dao->addNodeToLayer(top);
+    dao->addHLink(p, q, 5.0);
+    dao->addVLink(a, p, 1.0);
+    dao->addVLink(b, p, 0.5);
+    dao->addVLink(c, q, 1.0);
+
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    std::string folder(converter.to_bytes(mld::kRESOURCES_DIR));
+    EXPECT_TRUE(MatrixExporter::toSparseMatrices(g, "mat", folder));
+
+    // Lower triangle of the base layer adjacency
+    auto lines(readLines(folder + "mat_L0.mtx"));
+    ASSERT_EQ(size_t(5), lines.size());
+    EXPECT_EQ("%%MatrixMarket matrix coordinate real symmetric", lines[0]);
+    EXPECT_EQ(0u, lines[2].find("3 3 2"));
+    EXPECT_EQ("2 1 2", lines[3]);
+    EXPECT_EQ("3 2 3", lines[4]);
+
+    // Restriction and prolongation are transposed
+    lines = readLines(folder + "mat_R0.mtx");
+    ASSERT_EQ(size_t(6), lines.size());
+    EXPECT_EQ(0u, lines[2].find("2 3 3"));
+    EXPECT_EQ("1 1 1", lines[3]);
+    EXPECT_EQ("1 2 0.5", lines[4]);
+    EXPECT_EQ("2 3 1", lines[5]);
+    lines = readLines(folder + "mat_P0.mtx");
+    ASSERT_EQ(size_t(6), lines.size());
+    EXPECT_EQ("2 1 0.5", lines[4]);
+
+    lines = readLines(folder + "mat_L1.ids");
+    ASSERT_EQ(size_t(2), lines.size());
+    EXPECT_EQ(std::to_string(p.id()), lines[0]);
+
+    // Only the top layer, full adjacency in CSR
+    EXPECT_TRUE(MatrixExporter::toSparseMatrices(g, "mat", folder, MatrixExporter::BINARY_CSR, 1));
+    {
+        std::ifstream in(folder + "mat_L1.csr", std::ios::binary);
+        char magic[4];
+        in.read(magic, 4);
+        EXPECT_EQ(0, std::memcmp(magic, bin::CSR_MAGIC, 4));
+        char widths[4];
+        in.read(widths, 4);
+        EXPECT_EQ(64, widths[1]);  // uint64 indices
+        EXPECT_EQ(64, widths[2]);  // float64 values
+        uint64_t rows = 0, cols = 0, nnz = 0;
+        bin::readUint64(in, rows);
+        bin::readUint64(in, cols);
+        bin::readUint64(in, nnz);
+        EXPECT_EQ(2u, rows);
+        EXPECT_EQ(2u, cols);
+        ASSERT_EQ(2u, nnz);
+        uint64_t idx0 = 0, idx1 = 0, ptr = 0;
+        double w = 0.0;
+        bin::readUint64(in, idx0);
+        bin::readUint64(in, idx1);
+        EXPECT_EQ(1u, idx0);
+        EXPECT_EQ(0u, idx1);
+        bin::readDouble(in, w);
+        EXPECT_DOUBLE_EQ(5.0, w);
+        bin::readDouble(in, w);
+        std::vector<uint64_t> indptr;
+        while( bin::readUint64(in, ptr) )
+            indptr.push_back(ptr);
+        EXPECT_EQ(std::vector<uint64_t>({ 0, 1, 2 }), indptr);
+    }
+    std::ifstream noRestriction(folder + "mat_R1.csr");
+    EXPECT_FALSE(noRestriction.good());
+
+    for( auto f: { "mat_L0.mtx", "mat_R0.mtx", "mat_P0.mtx", "mat_L1.mtx",
+                   "mat_L0.ids", "mat_L1.ids", "mat_L1.csr" } ) {
+        std::remove((folder + f).c_str());
+    }
+    dao.reset();
+    sess.reset();
+}
@@ -0,0 +1,123 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <sparksee/gdb/Objects.h>
+
+#include <mld/model/AncestryIndex.h>
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+namespace {
+
+// Node ids of level k are k * 1000 + i
+oid_t nodeId( size_t level, size_t i )
+{
+    return oid_t(level * 1000 + i + 1);
+}
+
+// Parent of node i of level k, every 7th node of level 1 is an orphan
+size_t parentIndex( size_t level, size_t i )
+{
+    if( level == 1 && i % 7 == 3 )
+        return INVALID_INDEX;
+    return i / 2;
+}
+
+} // end namespace anonymous
+
+TEST( AncestryIndexTest, BinaryLifting )
+{
+    // 7 levels of 64, 32, ... 1 nodes
+    const size_t levels = 7;
+    AncestryIndex index;
+    EXPECT_TRUE(index.empty());
+    for( size_t k = 0; k < levels; ++k ) {
+        const size_t n = size_t(64) >> k;
+        std::vector<oid_t> nodes;
+        for( size_t i = 0; i < n; ++i )
+            nodes.push_back(nodeId(k, i));
+        std::vector<size_t> parents;
+        if( k > 0 ) {
+            for( size_t i = 0; i < 2 * n; ++i )
+                parents.push_back(parentIndex(k - 1, i));
+        }
+        ASSERT_TRUE(index.addLayer(oid_t(k + 100), nodes, parents));
+        EXPECT_EQ(k + 1, index.levelCount());
+    }
+    EXPECT_EQ(size_t(127), index.nodeCount());
+    EXPECT_EQ(size_t(3), index.level(103));
+    EXPECT_EQ(INVALID_INDEX, index.level(1));
+
+    // Compare with walking up the parents
+    auto walk = []( size_t level, size_t i, size_t target ) {
+        for( ; level < target && i != INVALID_INDEX; ++level )
+            i = parentIndex(level, i);
+        return i;
+    };
+    for( size_t k = 0; k < levels; ++k ) {
+        for( size_t i = 0; i < (size_t(64) >> k); ++i ) {
+            const oid_t nid = nodeId(k, i);
+            EXPECT_EQ(k, index.nodeLevel(nid));
+            EXPECT_EQ(oid_t(k + 100), index.layerOf(nid));
+            for( size_t up = 0; up < levels; ++up ) {
+                const size_t a = up < k ? INVALID_INDEX : walk(k, i, up);
+                EXPECT_EQ(a == INVALID_INDEX ? Objects::InvalidOID : nodeId(up, a), index.ancestor(nid, up));
+            }
+        }
+    }
+    EXPECT_EQ(nodeId(1, 2), index.parent(nodeId(0, 5)));
+    EXPECT_EQ(Objects::InvalidOID, index.parent(nodeId(1, 3)));
+    EXPECT_EQ(Objects::InvalidOID, index.parent(nodeId(6, 0)));
+
+    // Merge levels of all the base node pairs
+    for( size_t a = 0; a < 64; ++a ) {
+        for( size_t b = 0; b < 64; ++b ) {
+            size_t expected = INVALID_INDEX;
+            for( size_t up = 0; up < levels; ++up ) {
+                const size_t x = walk(0, a, up);
+                if( x != INVALID_INDEX && x == walk(0, b, up) ) {
+                    expected = up;
+                    break;
+                }
+            }
+            EXPECT_EQ(expected, index.mergeLevel(nodeId(0, a), nodeId(0, b)));
+        }
+    }
+    // Nodes on different levels
+    EXPECT_EQ(size_t(2), index.mergeLevel(nodeId(0, 0), nodeId(2, 0)));
+    EXPECT_EQ(nodeId(2, 0), index.commonAncestor(nodeId(0, 0), nodeId(2, 0)));
+    EXPECT_EQ(size_t(5), index.mergeLevel(nodeId(0, 0), nodeId(1, 8)));
+    EXPECT_EQ(INVALID_INDEX, index.mergeLevel(nodeId(0, 6), nodeId(0, 0)));
+    EXPECT_EQ(Objects::InvalidOID, index.commonAncestor(nodeId(0, 0), 999));
+
+    // Invalid layers
+    std::vector<oid_t> top(1, nodeId(7, 0));
+    EXPECT_FALSE(index.addLayer(100, top, std::vector<size_t>(1, 0)));
+    EXPECT_FALSE(index.addLayer(200, top, std::vector<size_t>()));
+    EXPECT_FALSE(index.addLayer(200, top, std::vector<size_t>(1, 1)));
+    EXPECT_FALSE(index.addLayer(200, std::vector<oid_t>(1, nodeId(0, 0)), std::vector<size_t>(1, 0)));
+    EXPECT_EQ(levels, index.levelCount());
+    EXPECT_TRUE(index.addLayer(200, top, std::vector<size_t>(1, 0)));
+    EXPECT_EQ(nodeId(7, 0), index.ancestor(nodeId(0, 0), 7));
+
+    index.clear();
+    EXPECT_EQ(size_t(0), index.nodeCount());
+}
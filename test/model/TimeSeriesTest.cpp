@@ -182,3 +182,43 @@ TEST( TimeSeriesTest, Slices )
     ts.shrink();
     EXPECT_EQ(size_t(7), ts.totalSize());
 }
+
+TEST( TimeSeriesTest, RingBuffer )
+{
+    TimeSeries<int> ts(1);
+    // radius 1: 4 slots reserved
+    ts.push_back(1); ts.push_back(2); ts.push_back(3);
+    ts.scroll();
+    EXPECT_EQ(2, *ts.current());
+
+    // Wrap around the storage while scrolling
+    for( int i = 4; i < 10; ++i ) {
+        ts.push_back(i);
+        ts.scroll();
+        ts.shrink();
+        EXPECT_EQ(size_t(3), ts.totalSize());
+        EXPECT_EQ(i - 1, *ts.current());
+        EXPECT_EQ(i - 2, *ts.sliceBegin());
+        EXPECT_EQ(i, ts.data().back());
+
+        auto segs = ts.sliceSegments();
+        EXPECT_EQ(ts.sliceSize(), segs.first.second + segs.second.second);
+        int expected = i - 2;
+        for( size_t k = 0; k < segs.first.second; ++k )
+            EXPECT_EQ(expected++, segs.first.first[k]);
+        for( size_t k = 0; k < segs.second.second; ++k )
+            EXPECT_EQ(expected++, segs.second.first[k]);
+    }
+    EXPECT_EQ(size_t(4), ts.data().capacity());
+
+    // Grow when full
+    ts.push_front(6); ts.push_back(10); ts.push_back(11);
+    EXPECT_EQ(size_t(6), ts.totalSize());
+    EXPECT_EQ(8, *ts.current());
+    EXPECT_EQ(6, ts.data().front());
+    EXPECT_EQ(11, ts.data().back());
+
+    int* first = ts.data().linearize();
+    for( int i = 0; i < 6; ++i )
+        EXPECT_EQ(6 + i, first[i]);
+}
@@ -0,0 +1,147 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include <mld/config.h>
+#include <mld/SparkseeManager.h>
+
+#include <mld/dao/MLGDao.h>
+#include <mld/operator/Diffuser.h>
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+namespace {
+
+// Closed form exp(-t * L) * x on a union of complete graphs:
+// on K_k with weight w, L = w * (k * I - J) so the signal relaxes to
+// the component mean at rate k * w
+// Components: { n1, n2 } weight 0.5, { n3, n4, n5 } weight 0.2
+std::vector<double> heatReference( const std::vector<double>& x, double t )
+{
+    const std::vector<std::vector<size_t>> comps{ { 0, 1 }, { 2, 3, 4 } };
+    const std::vector<double> weights{ 0.5, 0.2 };
+    std::vector<double> res(x.size());
+    for( size_t c = 0; c < comps.size(); ++c ) {
+        double mean = 0.0;
+        for( auto i: comps[c] )
+            mean += x[i];
+        mean /= comps[c].size();
+        const double decay = std::exp(-t * comps[c].size() * weights[c]);
+        for( auto i: comps[c] )
+            res[i] = mean + (x[i] - mean) * decay;
+    }
+    return res;
+}
+
+} // end namespace anonymous
+
+TEST( DiffuserTest, Heat )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    // Create Db scheme
+    sparkseeManager.createBaseScheme(g);
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->addBaseLayer();
+    Layer top = dao->addLayerOnTop();
+
+    // n1 -- 0.5 -- n2    n3 -- 0.2 -- n4
+    //                     \          /
+    //                     0.2      0.2
+    //                       \      /
+    //                          n5
+    std::vector<double> xBase{ 10, 20, 40, -5, 15 };
+    std::vector<double> xTop{ 1, -2, 5, 3, 0 };
+    std::vector<mld::Node> nodes;
+    AttrMap nodeData;
+    AttrMap data;
+    for( size_t i = 0; i < xBase.size(); ++i ) {
+        data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(xBase[i]);
+        nodes.push_back(dao->addNodeToLayer(base, nodeData, data));
+        data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(xTop[i]);
+        dao->addOLink(top, nodes.back(), data);
+    }
+    dao->addHLink(nodes[0], nodes[1], 0.5);
+    dao->addHLink(nodes[2], nodes[3], 0.2);
+    dao->addHLink(nodes[2], nodes[4], 0.2);
+    dao->addHLink(nodes[3], nodes[4], 0.2);
+
+    // Several times, both layers in the same block, no write back
+    {
+        Diffuser diffuser(g);
+        diffuser.setTimes({ 0.5, 2.0 });
+        diffuser.setBlockSize(2);
+        diffuser.setWriteBack(false);
+        EXPECT_TRUE(diffuser.run());
+        ASSERT_EQ(size_t(2), diffuser.results().size());
+
+        const GraphSnapshot& snap = diffuser.graph();
+        for( size_t t = 0; t < diffuser.times().size(); ++t ) {
+            const SignalStore& res = diffuser.results()[t];
+            auto eBase = heatReference(xBase, diffuser.times()[t]);
+            auto eTop = heatReference(xTop, diffuser.times()[t]);
+            size_t li = res.layerIndex(base.id());
+            size_t lt = res.layerIndex(top.id());
+            for( size_t i = 0; i < nodes.size(); ++i ) {
+                size_t idx = snap.index(nodes[i].id());
+                EXPECT_NEAR(eBase[i], res(li, idx), 1e-8);
+                EXPECT_NEAR(eTop[i], res(lt, idx), 1e-8);
+            }
+        }
+        // Signal is left untouched
+        EXPECT_DOUBLE_EQ(40.0, dao->getOLink(base.id(), nodes[2].id()).weight());
+    }
+
+    // Multiple times and write back are exclusive
+    {
+        Diffuser diffuser(g);
+        diffuser.setTimes({ 0.5, 2.0 });
+        EXPECT_FALSE(diffuser.run());
+    }
+
+    // Write back, one signal per block
+    {
+        Diffuser diffuser(g);
+        diffuser.setTimes({ 1.0 });
+        diffuser.setBlockSize(1);
+        EXPECT_TRUE(diffuser.run());
+
+        auto eBase = heatReference(xBase, 1.0);
+        auto eTop = heatReference(xTop, 1.0);
+        double sum = 0.0;
+        for( size_t i = 0; i < nodes.size(); ++i ) {
+            OLink ol = dao->getOLink(base.id(), nodes[i].id());
+            EXPECT_NEAR(eBase[i], ol.weight(), 1e-8);
+            sum += ol.weight();
+            EXPECT_NEAR(eTop[i], dao->getOLink(top.id(), nodes[i].id()).weight(), 1e-8);
+        }
+        // Each component keeps its mass
+        EXPECT_NEAR(80.0, sum, 1e-8);
+    }
+
+    dao.reset();
+    sess.reset();
+}
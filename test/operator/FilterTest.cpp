@@ -29,6 +29,8 @@
 #include <mld/operator/filters.h>
 #include <mld/dao/MLGDao.h>
 #include <mld/operator/TSCache.h>
+#include <mld/operator/TSOperator.h>
+#include <mld/io/StreamImporter.h>
 
 using namespace mld;
 using namespace sparksee::gdb;
@@ -143,6 +145,25 @@ TEST( FilterTest, TVMFilterVertexOnly )
         EXPECT_EQ(v/c, ol3.weight());
     }
 
+    // Exclude n3, it is not a neighbor anymore
+    {
+        ObjectsPtr nodes = dao->getAllNodeIds(base);
+        ObjectsIt it( nodes->Iterator() );
+        it->Next();
+        oid_t n2 = it->Next();
+        oid_t n3 = it->Next();
+        ObjectsPtr excluded(dao->newObjectsPtr());
+        excluded->Add(n3);
+        filter->setExcludedNodes(excluded);
+
+        OLink ol2 = filter->compute(base.id(), n2);
+        // value = n2 + n1 * n12
+        // coeff = 1 + n12
+        double v = 20 + 10 * 0.5;
+        double c = 1 + 0.5;
+        EXPECT_EQ(v/c, ol2.weight());
+    }
+
     dao.reset();
     filter.reset();
     sess.reset();
@@ -302,3 +323,479 @@ TEST( FilterTest, TVMFilter1 )
     filter.reset();
     sess.reset();
 }
+
+TEST( FilterTest, TVMLayerChain )
+{
+    createDatabase();
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.openDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    std::unique_ptr<TimeVertexMeanFilter> filter( new TimeVertexMeanFilter(g) );
+    filter->setRadius(2);
+
+    Layer base = dao->baseLayer();
+    Layer middle = dao->parent(base);
+    dao->updateCLink(base.id(), middle.id(), 2);
+
+    ObjectsPtr nodes = dao->getAllNodeIds(base);
+    std::vector<Layer> layers(dao->getAllLayers());
+    for( auto dir: { TSDirection::PAST, TSDirection::FUTURE, TSDirection::BOTH } ) {
+        filter->setDirection(dir);
+        for( auto& layer: layers ) {
+            // Walk CLinks in DB
+            filter->clearLayerChain();
+            filter->computeTWCoeffs(layer.id());
+            std::vector<double> expected;
+            ObjectsIt it(nodes->Iterator());
+            while( it->HasNext() )
+                expected.push_back(filter->compute(layer.id(), it->Next()).weight());
+
+            // Cumulative resistivity
+            EXPECT_TRUE(filter->buildLayerChain());
+            EXPECT_TRUE(filter->hasLayerChain());
+            filter->computeTWCoeffs(layer.id());
+            it.reset(nodes->Iterator());
+            for( size_t i = 0; i < expected.size(); ++i )
+                EXPECT_NEAR(expected[i], filter->compute(layer.id(), it->Next()).weight(), 1e-12);
+        }
+    }
+
+    dao.reset();
+    filter.reset();
+    sess.reset();
+}
+
+std::vector<double> runTVMPasses( uint32_t passes, bool inMemory, bool flush=false,
+                                  size_t maxNeighbors=0, SamplingError* err=nullptr )
+{
+    createDatabase();
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.openDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+
+    std::vector<double> res;
+    {
+        TSOperator op(g);
+        TimeVertexMeanFilter* filter = new TimeVertexMeanFilter(g);
+        filter->setRadius(1);
+        filter->setNeighborSampling(maxNeighbors, 42);
+        op.setFilter(filter);
+        op.setFlushPerLayer(flush);
+        if( inMemory ) {
+            op.setIterations(passes);
+            EXPECT_TRUE(op.run());
+        }
+        else {
+            for( uint32_t i = 0; i < passes; ++i )
+                EXPECT_TRUE(op.run());
+        }
+        if( err )
+            *err = filter->samplingError();
+
+        MLGDao dao(g);
+        ObjectsPtr nodes = dao.getAllNodeIds(dao.baseLayer());
+        for( auto& layer: dao.getAllLayers() ) {
+            auto weights = dao.getOLinkWeights(layer.id());
+            ObjectsIt it(nodes->Iterator());
+            while( it->HasNext() )
+                res.push_back(weights[it->Next()]);
+        }
+    }
+    sess.reset();
+    return res;
+}
+
+TEST( FilterTest, TVMInMemoryPasses )
+{
+    auto expected = runTVMPasses(3, false);
+    auto res = runTVMPasses(3, true);
+    ASSERT_EQ(size_t(9), expected.size());
+    ASSERT_EQ(expected.size(), res.size());
+    for( size_t i = 0; i < res.size(); ++i )
+        EXPECT_NEAR(expected[i], res[i], 1e-9);
+}
+
+TEST( FilterTest, TVMNeighborSampling )
+{
+    auto expected = runTVMPasses(1, true);
+    // Cap above the max degree, filter is exact
+    auto res = runTVMPasses(1, true, false, 2);
+    ASSERT_EQ(expected.size(), res.size());
+    for( size_t i = 0; i < res.size(); ++i )
+        EXPECT_DOUBLE_EQ(expected[i], res[i]);
+
+    // n2 is the only hub, it keeps 1 of its 2 neighbors
+    SamplingError err;
+    auto sampled = runTVMPasses(1, true, false, 1, &err);
+    auto sampledDb = runTVMPasses(1, false, false, 1);
+    ASSERT_EQ(expected.size(), sampled.size());
+    ASSERT_EQ(expected.size(), sampledDb.size());
+    for( size_t i = 0; i < sampled.size(); ++i ) {
+        EXPECT_NEAR(sampledDb[i], sampled[i], 1e-9);
+        if( i % 3 == 1 )
+            EXPECT_NE(expected[i], sampled[i]);
+        else
+            EXPECT_DOUBLE_EQ(expected[i], sampled[i]);
+    }
+
+    // Error is measured on the hub for each layer
+    EXPECT_EQ(size_t(3), err.nodes);
+    EXPECT_GT(err.maxAbs, 0.0);
+    EXPECT_LE(err.meanAbs(), err.maxAbs);
+}
+
+// Star of 6 leaves on 2 layers, the last leaf is excluded
+std::vector<double> runTVMStarExcluded( bool inMemory )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+
+    std::vector<double> res;
+    {
+        MLGDao dao(g);
+        Layer base = dao.addBaseLayer();
+        Layer top = dao.addLayerOnTop();
+        AttrMap nodeData;
+        AttrMap data;
+        std::vector<mld::Node> nodes;
+        for( size_t i = 0; i < 7; ++i ) {
+            data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(double(i * i));
+            nodes.push_back(dao.addNodeToLayer(base, nodeData, data));
+            data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(double(i));
+            dao.addOLink(top, nodes.back(), data);
+            if( i > 0 )
+                dao.addHLink(nodes[0], nodes.back(), 0.1 * i);
+        }
+        ObjectsPtr excluded(dao.newObjectsPtr());
+        excluded->Add(nodes.back().id());
+
+        TSOperator op(g);
+        TimeVertexMeanFilter* filter = new TimeVertexMeanFilter(g);
+        filter->setRadius(1);
+        filter->setNeighborSampling(2, 7);
+        filter->setExcludedNodes(excluded);
+        op.setFilter(filter);
+        // 2 passes, chained in memory or commited in between
+        op.setIterations(inMemory ? 2 : 1);
+        EXPECT_TRUE(op.run());
+        if( !inMemory ) {
+            EXPECT_TRUE(op.run());
+        }
+
+        for( auto& layer: dao.getAllLayers() ) {
+            auto weights = dao.getOLinkWeights(layer.id());
+            for( auto& n: nodes )
+                res.push_back(weights[n.id()]);
+        }
+    }
+    sess.reset();
+    return res;
+}
+
+TEST( FilterTest, TVMSamplingExcluded )
+{
+    // Both paths draw the hub neighbors from the same snapshot
+    auto db = runTVMStarExcluded(false);
+    auto mem = runTVMStarExcluded(true);
+    ASSERT_EQ(size_t(14), db.size());
+    ASSERT_EQ(db.size(), mem.size());
+    for( size_t i = 0; i < db.size(); ++i )
+        EXPECT_NEAR(db[i], mem[i], 1e-9);
+    // Excluded leaf is left untouched
+    EXPECT_DOUBLE_EQ(36.0, db[6]);
+    EXPECT_DOUBLE_EQ(6.0, db[13]);
+}
+
+TEST( FilterTest, ChebyshevHeat )
+{
+    createDatabase();
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.openDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    std::unique_ptr<ChebyshevFilter> filter( new ChebyshevFilter(g) );
+    filter->setKernel(ChebyshevFilter::HEAT);
+    filter->setTau(1.0);
+    filter->setOrder(30);
+
+    Layer base = dao->baseLayer();
+    filter->computeTWCoeffs(base.id());
+    LOG(logINFO) << *filter;
+
+    // Reference exp(-tau * L) * x with a Taylor series
+    // L = [0.5 -0.5 0; -0.5 0.6 -0.1; 0 -0.1 0.1]
+    auto laplacian = []( const std::vector<double>& x ) {
+        return std::vector<double>{ 0.5 * x[0] - 0.5 * x[1],
+                                   -0.5 * x[0] + 0.6 * x[1] - 0.1 * x[2],
+                                   -0.1 * x[1] + 0.1 * x[2] };
+    };
+    std::vector<double> term{ 10, 20, 40 };
+    std::vector<double> expected(term);
+    for( int k = 1; k < 60; ++k ) {
+        term = laplacian(term);
+        for( size_t i = 0; i < term.size(); ++i ) {
+            term[i] *= -1.0 / k;
+            expected[i] += term[i];
+        }
+    }
+
+    ObjectsPtr nodes = dao->getAllNodeIds(base);
+    ObjectsIt it( nodes->Iterator() ); // sorted by oid
+    double sum = 0.0;
+    for( size_t i = 0; i < expected.size(); ++i ) {
+        OLink ol = filter->compute(base.id(), it->Next());
+        EXPECT_NEAR(expected[i], ol.weight(), 1e-8);
+        sum += ol.weight();
+    }
+    // Heat diffusion preserves the total signal
+    EXPECT_NEAR(70.0, sum, 1e-8);
+
+    dao.reset();
+    filter.reset();
+    sess.reset();
+}
+
+TEST( FilterTest, TVMFlushPerLayer )
+{
+    auto expected = runTVMPasses(2, false);
+    auto res = runTVMPasses(2, false, true);
+    ASSERT_EQ(size_t(9), expected.size());
+    ASSERT_EQ(expected.size(), res.size());
+    for( size_t i = 0; i < res.size(); ++i )
+        EXPECT_DOUBLE_EQ(expected[i], res[i]);
+}
+
+std::vector<double> runTVMPrefetch( bool flush )
+{
+    createDatabase();
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.openDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    MLGDao dao(g);
+    ObjectsPtr nodes = dao.getAllNodeIds(dao.baseLayer());
+    // Stack more layers, upper layers are prefetched after the first flush
+    AttrMap data;
+    for( int i = 0; i < 3; ++i ) {
+        Layer layer = dao.addLayerOnTop();
+        data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(10 * i);
+        ObjectsIt it(nodes->Iterator());
+        while( it->HasNext() )
+            dao.addOLink(layer, dao.getNode(it->Next()), data);
+    }
+
+    SessionPtr prefetchSess = sparkseeManager.newSession();
+    std::vector<double> res;
+    {
+        TSOperator op(g);
+        TimeVertexMeanFilter* filter = new TimeVertexMeanFilter(g);
+        filter->setRadius(1);
+        op.setFilter(filter);
+        op.setFlushPerLayer(flush);
+        op.setPrefetchGraph(prefetchSess->GetGraph());
+        // Same transaction as ts_filter
+        sess->Begin();
+        EXPECT_TRUE(op.run());
+        sess->Commit();
+        op.setPrefetchGraph(nullptr);
+    }
+
+    for( auto& layer: dao.getAllLayers() ) {
+        auto weights = dao.getOLinkWeights(layer.id());
+        ObjectsIt it(nodes->Iterator());
+        while( it->HasNext() )
+            res.push_back(weights[it->Next()]);
+    }
+    nodes.reset();
+    prefetchSess.reset();
+    return res;
+}
+
+TEST( FilterTest, TVMFlushPrefetch )
+{
+    auto expected = runTVMPrefetch(false);
+    auto res = runTVMPrefetch(true);
+    ASSERT_EQ(size_t(18), expected.size());
+    ASSERT_EQ(expected.size(), res.size());
+    for( size_t i = 0; i < res.size(); ++i )
+        EXPECT_DOUBLE_EQ(expected[i], res[i]);
+}
+
+TEST( FilterTest, TVMMultiChannel )
+{
+    auto expected = runTVMPasses(1, false);
+    ASSERT_EQ(size_t(9), expected.size());
+
+    createDatabase();
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.openDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    {
+        // Second channel is the weight scaled by 2
+        const std::wstring channel(L"humidity");
+        Value def;
+        def.SetDouble(0.0);
+        EXPECT_TRUE(SparkseeManager::addAttrToOLink(g, channel, Double, Basic, def));
+        MLGDao dao(g);
+        for( auto& layer: dao.getAllLayers() ) {
+            auto weights = dao.getOLinkWeights(layer.id());
+            for( auto& w: weights )
+                w.second *= 2.0;
+            EXPECT_TRUE(dao.updateOLinkWeights(layer.id(), weights, channel));
+        }
+
+        TSOperator op(g);
+        TimeVertexMeanFilter* filter = new TimeVertexMeanFilter(g);
+        filter->setRadius(1);
+        op.setFilter(filter);
+        op.setChannels({ channel });
+        EXPECT_TRUE(op.run());
+
+        // Both channels are filtered in the same pass, the filter is linear
+        std::vector<double> res;
+        ObjectsPtr nodes = dao.getAllNodeIds(dao.baseLayer());
+        for( auto& layer: dao.getAllLayers() ) {
+            auto weights = dao.getOLinkWeights(layer.id());
+            auto scaled = dao.getOLinkWeights(layer.id(), channel);
+            ObjectsIt it(nodes->Iterator());
+            while( it->HasNext() ) {
+                oid_t nid = it->Next();
+                res.push_back(weights[nid]);
+                EXPECT_NEAR(2.0 * weights[nid], scaled[nid], 1e-9);
+            }
+        }
+        ASSERT_EQ(expected.size(), res.size());
+        for( size_t i = 0; i < res.size(); ++i )
+            EXPECT_NEAR(expected[i], res[i], 1e-9);
+    }
+    sess.reset();
+}
+
+std::vector<std::vector<double>> runStream( bool incremental, bool prefilter=false )
+{
+    createDatabase();
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.openDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+
+    std::vector<std::vector<double>> res;
+    if( prefilter ) {  // Batch filtering before streaming keeps the raw values
+        TSOperator op(g);
+        TimeVertexMeanFilter* filter = new TimeVertexMeanFilter(g);
+        filter->setRadius(1);
+        op.setFilter(filter);
+        op.setRawAttribute(L"raw_weight");
+        EXPECT_TRUE(op.run());
+    }
+    {
+        StreamImporter importer(g);
+        if( incremental ) {
+            TimeVertexMeanFilter* filter = new TimeVertexMeanFilter(g);
+            filter->setRadius(1);
+            importer.setFilter(filter);
+        }
+        // The second time step is refiltered from the state kept by the first one
+        std::stringstream stream("# new time steps\n1.0, 2.0, 3.0\n5.0, 7.0, 9.0\n");
+        size_t count = 0;
+        EXPECT_TRUE(importer.fromStream(stream, count));
+        EXPECT_EQ(size_t(2), count);
+        EXPECT_EQ(size_t(0), importer.pendingSteps());
+
+        if( !incremental ) {  // Filter everything
+            TSOperator op(g);
+            TimeVertexMeanFilter* filter = new TimeVertexMeanFilter(g);
+            filter->setRadius(1);
+            op.setFilter(filter);
+            EXPECT_TRUE(op.run());
+        }
+
+        MLGDao dao(g);
+        ObjectsPtr nodes = dao.getAllNodeIds(dao.baseLayer());
+        for( auto& layer: dao.getAllLayers() ) {
+            auto weights = dao.getOLinkWeights(layer.id());
+            std::vector<double> row;
+            ObjectsIt it(nodes->Iterator());
+            while( it->HasNext() )
+                row.push_back(weights[it->Next()]);
+            res.push_back(row);
+        }
+    }
+    sess.reset();
+    return res;
+}
+
+TEST( FilterTest, StreamIncremental )
+{
+    auto full = runStream(false);
+    auto res = runStream(true);
+    ASSERT_EQ(size_t(5), full.size());
+    ASSERT_EQ(full.size(), res.size());
+
+    // Only the layers seeing the new time steps in their window are refiltered
+    EXPECT_EQ(std::vector<double>({ 10, 20, 40 }), res[0]);
+    EXPECT_EQ(std::vector<double>({ 10, 20, 80 }), res[1]);
+    for( size_t l = 2; l < res.size(); ++l ) {
+        ASSERT_EQ(size_t(3), res[l].size());
+        for( size_t i = 0; i < res[l].size(); ++i )
+            EXPECT_NEAR(full[l][i], res[l][i], 1e-12);
+    }
+}
+
+TEST( FilterTest, StreamPrefiltered )
+{
+    auto full = runStream(false);
+    auto res = runStream(true, true);
+    ASSERT_EQ(size_t(5), full.size());
+    ASSERT_EQ(full.size(), res.size());
+
+    // Same result as a batch filtering of the raw time steps
+    for( size_t l = 0; l < res.size(); ++l ) {
+        ASSERT_EQ(size_t(3), res[l].size());
+        for( size_t i = 0; i < res[l].size(); ++i )
+            EXPECT_NEAR(full[l][i], res[l][i], 1e-9);
+    }
+}
+
+TEST( FilterTest, StreamInvalidRow )
+{
+    createDatabase();
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.openDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    {
+        StreamImporter importer(g);
+        TimeVertexMeanFilter* filter = new TimeVertexMeanFilter(g);
+        filter->setRadius(1);
+        importer.setFilter(filter);
+        // Valid row is refiltered before the invalid one stops the stream
+        std::stringstream stream("1.0, 2.0, 3.0\n1.0, x, 3.0\n4.0, 5.0, 6.0\n");
+        size_t count = 0;
+        EXPECT_FALSE(importer.fromStream(stream, count, nullptr, 10));
+        EXPECT_EQ(size_t(1), count);
+        EXPECT_EQ(size_t(0), importer.pendingSteps());
+
+        MLGDao dao(g);
+        EXPECT_EQ(4, dao.getLayerCount());
+    }
+    sess.reset();
+}
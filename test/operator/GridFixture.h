@@ -0,0 +1,152 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#ifndef MLD_GRIDFIXTURE_H
+#define MLD_GRIDFIXTURE_H
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <mld/dao/MLGDao.h>
+#include <mld/model/GraphSnapshot.h>
+#include <mld/model/TransferMap.h>
+
+namespace mld {
+namespace fixture {
+
+/**
+ * @brief rows x cols grid, node r * cols + c has id r * cols + c + 1
+ * @param rows
+ * @param cols
+ * @param weight weight(a, b) is the weight of the edge between nodes a < b,
+ * edges with a null weight are skipped
+ * @return snapshot
+ */
+inline GraphSnapshot grid( size_t rows, size_t cols, const std::function<double( size_t, size_t )>& weight )
+{
+    std::vector<sparksee::gdb::oid_t> ids(rows * cols);
+    for( size_t i = 0; i < ids.size(); ++i )
+        ids[i] = sparksee::gdb::oid_t(i + 1);
+    GraphSnapshot g;
+    g.reset(ids);
+    auto add = [&]( size_t a, size_t b ) {
+        double w = weight(std::min(a, b), std::max(a, b));
+        if( w > 0.0 )
+            g.addNeighbor(b, w);
+    };
+    for( size_t r = 0; r < rows; ++r ) {
+        for( size_t c = 0; c < cols; ++c ) {
+            const size_t i = r * cols + c;
+            if( r > 0 ) add(i, i - cols);
+            if( c > 0 ) add(i, i - 1);
+            if( c + 1 < cols ) add(i, i + 1);
+            if( r + 1 < rows ) add(i, i + cols);
+            g.finishNode();
+        }
+    }
+    return g;
+}
+
+/**
+ * @brief rows x cols grid with the same weight on every edge
+ */
+inline GraphSnapshot grid( size_t rows, size_t cols, double weight=1.0 )
+{
+    return grid(rows, cols, [weight]( size_t, size_t ) { return weight; });
+}
+
+/**
+ * @brief Aggregate the 2 x 2 blocks of a rows x cols grid, rows and cols are even
+ * @param rows
+ * @param cols
+ * @return map from the grid to the rows / 2 x cols / 2 grid
+ */
+inline TransferMap aggregate( size_t rows, size_t cols )
+{
+    const size_t half = cols / 2;
+    TransferMap map;
+    map.reset(rows * cols, (rows / 2) * half);
+    for( size_t r = 0; r < rows; ++r ) {
+        for( size_t c = 0; c < cols; ++c )
+            map.setParent(r * cols + c, (r / 2) * half + c / 2, 1.0);
+    }
+    map.finalize();
+    return map;
+}
+
+/**
+ * @brief Add n nodes with default OLinks to a layer of the database
+ */
+inline std::vector<Node> addNodes( MLGDao& dao, const Layer& layer, size_t n )
+{
+    std::vector<Node> nodes;
+    for( size_t i = 0; i < n; ++i )
+        nodes.push_back(dao.addNodeToLayer(layer));
+    return nodes;
+}
+
+/**
+ * @brief Add nodes to a layer of the database
+ * @param dao
+ * @param layer
+ * @param signal OLink weight of each node, its size is the number of nodes
+ * @return nodes
+ */
+inline std::vector<Node> addNodes( MLGDao& dao, const Layer& layer, const std::vector<double>& signal )
+{
+    std::vector<Node> nodes;
+    AttrMap nodeData;
+    AttrMap data;
+    for( auto x: signal ) {
+        data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(x);
+        nodes.push_back(dao.addNodeToLayer(layer, nodeData, data));
+    }
+    return nodes;
+}
+
+/**
+ * @brief Link the nodes in a path with HLinks of the same weight
+ */
+inline void addPath( MLGDao& dao, const std::vector<Node>& nodes, double weight=1.0 )
+{
+    for( size_t i = 0; i + 1 < nodes.size(); ++i )
+        dao.addHLink(nodes[i], nodes[i + 1], weight);
+}
+
+/**
+ * @brief Aggregate the nodes by pairs, nodes 2i and 2i + 1 get a parent on the layer on top
+ * @param dao
+ * @param top Layer on top of the nodes
+ * @param nodes
+ * @return parents
+ */
+inline std::vector<Node> aggregatePairs( MLGDao& dao, const Layer& top, const std::vector<Node>& nodes )
+{
+    std::vector<Node> parents(addNodes(dao, top, nodes.size() / 2));
+    for( size_t i = 0; i < parents.size(); ++i ) {
+        dao.addVLink(nodes[2 * i], parents[i]);
+        dao.addVLink(nodes[2 * i + 1], parents[i]);
+    }
+    return parents;
+}
+
+} // end namespace fixture
+} // end namespace mld
+
+#endif // MLD_GRIDFIXTURE_H
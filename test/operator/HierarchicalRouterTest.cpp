@@ -0,0 +1,162 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include <mld/config.h>
+#include <mld/SparkseeManager.h>
+
+#include <mld/dao/MLGDao.h>
+#include <mld/model/GraphSnapshot.h>
+#include <mld/model/TransferMap.h>
+#include <mld/operator/HierarchicalRouter.h>
+
+#include "GridFixture.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+namespace {
+
+bool setupGrid( HierarchicalRouter& router, size_t side,
+                const std::function<double( size_t, size_t )>& weight )
+{
+    std::vector<GraphSnapshot> levels;
+    std::vector<TransferMap> maps;
+    levels.push_back(fixture::grid(side, side, weight));
+    for( size_t s = side; s > 4; s /= 2 ) {
+        maps.push_back(fixture::aggregate(s, s));
+        levels.push_back(fixture::grid(s / 2, s / 2));
+    }
+    return router.setup(std::move(levels), std::move(maps));
+}
+
+} // end namespace anonymous
+
+TEST( HierarchicalRouterTest, Grid )
+{
+    const size_t side = 128;
+    // Road like weights in [1, 4)
+    auto weight = []( size_t a, size_t b ) { return 1.0 + double((a * 7919 + b * 104729) % 300) / 100.0; };
+    HierarchicalRouter router;
+    ASSERT_TRUE(setupGrid(router, side, weight));
+    EXPECT_EQ(size_t(6), router.levelCount());
+
+    double stretch = 0.0;
+    size_t exactSettled = 0;
+    size_t routeSettled = 0;
+    const size_t queries = 50;
+    for( size_t q = 0; q < queries; ++q ) {
+        const size_t s = (q * 2654435761u) % (side * side);
+        const size_t t = (q * 40503u + 12345u) % (side * side);
+        std::vector<size_t> exactPath;
+        std::vector<size_t> path;
+        const double exact = router.shortestPath(s, t, &exactPath);
+        exactSettled += router.settledCount();
+        const double approx = router.route(s, t, &path);
+        routeSettled += router.settledCount();
+        ASSERT_FALSE(router.fellBack());
+        ASSERT_FALSE(path.empty());
+        EXPECT_EQ(s, path.front());
+        EXPECT_EQ(t, path.back());
+        EXPECT_GE(approx, exact - 1e-9);
+        stretch += s == t ? 1.0 : approx / exact;
+    }
+    EXPECT_LT(stretch / queries, 1.2);
+    EXPECT_LT(4 * routeSettled, exactSettled);
+
+    // Unit grid: hop counts are exact within the corridor
+    router.setSearch(HierarchicalRouter::BFS);
+    EXPECT_DOUBLE_EQ(double(2 * (side - 1)), router.route(0, side * side - 1));
+    EXPECT_DOUBLE_EQ(double(2 * (side - 1)), router.shortestPath(0, side * side - 1));
+
+    EXPECT_EQ(std::numeric_limits<double>::infinity(), router.route(0, side * side));
+}
+
+TEST( HierarchicalRouterTest, Fallback )
+{
+    const size_t side = 32;
+    // Wall between the left and right halves, open on the first row only
+    auto wall = [side]( size_t a, size_t b ) {
+        const bool crosses = b == a + 1 && a % side == side / 2 - 1;
+        return crosses && a / side != 0 ? 0.0 : 1.0;
+    };
+    HierarchicalRouter router;
+    router.setCorridorWidth(0);
+    ASSERT_TRUE(setupGrid(router, side, wall));
+
+    // The coarse path goes straight along the last row
+    const size_t s = side * (side - 1);
+    const size_t t = side * side - 1;
+    const double exact = router.shortestPath(s, t);
+    EXPECT_DOUBLE_EQ(3.0 * (side - 1), exact);
+    EXPECT_DOUBLE_EQ(exact, router.route(s, t));
+    EXPECT_TRUE(router.fellBack());
+
+    std::vector<GraphSnapshot> levels(1);
+    EXPECT_FALSE(router.setup(levels, std::vector<TransferMap>(1)));
+}
+
+TEST( HierarchicalRouterTest, Layers )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->addBaseLayer();
+    Layer top = dao->addLayerOnTop();
+
+    // Path of 8 nodes aggregated by pairs, the shortcut 0 - 7 is heavy
+    const size_t n = 8;
+    std::vector<mld::Node> nodes(fixture::addNodes(*dao, base, n));
+    fixture::addPath(*dao, nodes);
+    dao->addHLink(nodes[0], nodes[n - 1], 10.0);
+    std::vector<mld::Node> parents(fixture::aggregatePairs(*dao, top, nodes));
+    fixture::addPath(*dao, parents, 2.0);
+
+    GraphSnapshot graph(dao->getGraphSnapshot(base));
+    std::vector<TransferMap> maps;
+    std::vector<GraphSnapshot> levels;
+    ASSERT_TRUE(dao->getTransferMaps(graph, base, maps, 0, &levels));
+    ASSERT_EQ(size_t(1), maps.size());
+    ASSERT_EQ(size_t(1), levels.size());
+    EXPECT_EQ(size_t(3 * 2), levels[0].edgeCount());
+    levels.insert(levels.begin(), graph);
+
+    HierarchicalRouter router;
+    ASSERT_TRUE(router.setup(levels, maps));
+    std::vector<size_t> path;
+    const size_t s = graph.index(nodes[0].id());
+    const size_t t = graph.index(nodes[n - 1].id());
+    EXPECT_DOUBLE_EQ(7.0, router.route(s, t, &path));
+    EXPECT_FALSE(router.fellBack());
+    ASSERT_EQ(n, path.size());
+    for( size_t i = 0; i < n; ++i )
+        EXPECT_EQ(nodes[i].id(), graph.nodeId(path[i]));
+
+    dao.reset();
+    sess.reset();
+}
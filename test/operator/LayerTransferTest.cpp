@@ -0,0 +1,276 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <mld/config.h>
+#include <mld/SparkseeManager.h>
+
+#include <mld/dao/MLGDao.h>
+#include <mld/model/TransferMap.h>
+#include <mld/operator/LayerTransfer.h>
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+TEST( LayerTransferTest, TransferMap )
+{
+    // Children 0, 1 -> parent 0, 2 -> parent 1, 3 has no parent
+    TransferMap map;
+    map.reset(4, 2);
+    map.setParent(0, 0, 1.0);
+    map.setParent(1, 0, 3.0);
+    map.setParent(2, 1, 0.5);
+    map.setParent(2, 0, 0.1);   // lighter VLink is ignored
+    map.finalize();
+    EXPECT_EQ(size_t(1), map.orphanCount());
+    EXPECT_EQ(size_t(2), map.childEnd(0) - map.childBegin(0));
+    EXPECT_DOUBLE_EQ(4.0, map.parentWeight(0));
+
+    // 6 rows: 3 layers, 2 channels, more than a row block
+    std::vector<oid_t> layers{ 10, 11, 12 };
+    SignalStore fine(layers, 4, 2);
+    for( size_t r = 0; r < 6; ++r ) {
+        for( size_t i = 0; i < 4; ++i )
+            fine.data()[r * 4 + i] = SignalValue(r * 10 + i);
+    }
+
+    SignalStore coarse;
+    std::vector<oid_t> coarseLayers{ 20, 21, 22 };
+    EXPECT_TRUE(map.restrictSignal(fine, coarseLayers, coarse, TransferMap::SUM));
+    ASSERT_EQ(size_t(2), coarse.nodeCount());
+    ASSERT_EQ(size_t(2), coarse.channelCount());
+    EXPECT_EQ(size_t(1), coarse.layerIndex(21));
+    for( size_t ch = 0; ch < 2; ++ch ) {
+        for( size_t l = 0; l < 3; ++l ) {
+            double base = double((ch * 3 + l) * 10);
+            EXPECT_DOUBLE_EQ(1.0 * base + 3.0 * (base + 1), coarse(l, 0, ch));
+            EXPECT_DOUBLE_EQ(0.5 * (base + 2), coarse(l, 1, ch));
+        }
+    }
+    EXPECT_TRUE(map.restrictSignal(fine, coarseLayers, coarse, TransferMap::MEAN));
+    EXPECT_DOUBLE_EQ((0.0 + 3.0 * 1.0) / 4.0, coarse(0, 0));
+    EXPECT_DOUBLE_EQ(2.0, coarse(0, 1));
+
+    // Prolongation
+    SignalStore back;
+    EXPECT_TRUE(map.prolongSignal(coarse, layers, back, TransferMap::INJECTION));
+    ASSERT_EQ(size_t(4), back.nodeCount());
+    EXPECT_DOUBLE_EQ(coarse(2, 0, 1), back(2, 0, 1));
+    EXPECT_DOUBLE_EQ(coarse(2, 0, 1), back(2, 1, 1));
+    EXPECT_DOUBLE_EQ(coarse(2, 1, 1), back(2, 2, 1));
+    EXPECT_DOUBLE_EQ(0.0, back(2, 3, 1));
+    EXPECT_TRUE(map.prolongSignal(coarse, layers, back, TransferMap::WEIGHTED));
+    EXPECT_DOUBLE_EQ(3.0 * coarse(1, 0), back(1, 1));
+
+    // Size mismatch
+    EXPECT_FALSE(map.prolongSignal(fine, layers, back));
+}
+
+TEST( LayerTransferTest, RestrictProlong )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->addBaseLayer();
+    Layer top = dao->addLayerOnTop();
+
+    // n0, n1 -> p0 ; n2 -> p1
+    std::vector<double> x{ 2, 4, 8 };
+    std::vector<mld::Node> nodes;
+    AttrMap nodeData;
+    AttrMap data;
+    for( size_t i = 0; i < x.size(); ++i ) {
+        data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(x[i]);
+        nodes.push_back(dao->addNodeToLayer(base, nodeData, data));
+    }
+    data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(0.0);
+    mld::Node p0 = dao->addNodeToLayer(top, nodeData, data);
+    mld::Node p1 = dao->addNodeToLayer(top, nodeData, data);
+    dao->addVLink(nodes[0], p0, 1.0);
+    dao->addVLink(nodes[1], p0, 3.0);
+    dao->addVLink(nodes[2], p1, 1.0);
+
+    // Weighted mean of the children in the coarse OLinks
+    {
+        LayerTransfer restrict(g);
+        EXPECT_TRUE(restrict.run());
+        ASSERT_EQ(size_t(1), restrict.maps().size());
+        EXPECT_EQ(size_t(0), restrict.maps()[0].orphanCount());
+        EXPECT_DOUBLE_EQ((2.0 + 3.0 * 4.0) / 4.0, dao->getOLink(top.id(), p0.id()).weight());
+        EXPECT_DOUBLE_EQ(8.0, dao->getOLink(top.id(), p1.id()).weight());
+    }
+
+    // Injection back to the base layer, no write back
+    {
+        LayerTransfer prolong(g);
+        prolong.setFineLayer(base.id());
+        prolong.setDirection(LayerTransfer::PROLONG);
+        prolong.setWriteBack(false);
+        EXPECT_TRUE(prolong.run());
+        const SignalStore& res = prolong.result();
+        EXPECT_DOUBLE_EQ(3.5, res(0, prolong.target().index(nodes[1].id())));
+        EXPECT_DOUBLE_EQ(8.0, res(0, prolong.target().index(nodes[2].id())));
+        EXPECT_DOUBLE_EQ(4.0, dao->getOLink(base.id(), nodes[1].id()).weight());
+    }
+
+    // The top layer has no parent
+    {
+        LayerTransfer restrict(g);
+        restrict.setFineLayer(top.id());
+        EXPECT_FALSE(restrict.run());
+    }
+
+    dao.reset();
+    sess.reset();
+}
+
+TEST( LayerTransferTest, MultiLevel )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->addBaseLayer();
+    Layer mid = dao->addLayerOnTop();
+    Layer top = dao->addLayerOnTop();
+
+    // n0, n1 -> p0 ; n2 -> p1 ; p0, p1 -> q0
+    std::vector<double> x{ 2, 4, 8 };
+    std::vector<mld::Node> nodes;
+    AttrMap nodeData;
+    AttrMap data;
+    for( size_t i = 0; i < x.size(); ++i ) {
+        data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(x[i]);
+        nodes.push_back(dao->addNodeToLayer(base, nodeData, data));
+    }
+    data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(0.0);
+    mld::Node p0 = dao->addNodeToLayer(mid, nodeData, data);
+    mld::Node p1 = dao->addNodeToLayer(mid, nodeData, data);
+    mld::Node q0 = dao->addNodeToLayer(top, nodeData, data);
+    dao->addVLink(nodes[0], p0, 1.0);
+    dao->addVLink(nodes[1], p0, 3.0);
+    dao->addVLink(nodes[2], p1, 1.0);
+    dao->addVLink(p0, q0, 1.0);
+    dao->addVLink(p1, q0, 1.0);
+
+    // Base to top in one run, the middle layer is not written
+    {
+        LayerTransfer restrict(g);
+        restrict.setLevels(2);
+        EXPECT_TRUE(restrict.run());
+        EXPECT_EQ(size_t(2), restrict.maps().size());
+        EXPECT_DOUBLE_EQ((3.5 + 8.0) / 2.0, dao->getOLink(top.id(), q0.id()).weight());
+        EXPECT_DOUBLE_EQ(0.0, dao->getOLink(mid.id(), p0.id()).weight());
+    }
+
+    // Top back to the base layer
+    {
+        LayerTransfer prolong(g);
+        prolong.setLevels(2);
+        prolong.setDirection(LayerTransfer::PROLONG);
+        prolong.setWriteBack(false);
+        EXPECT_TRUE(prolong.run());
+        EXPECT_EQ(size_t(1), prolong.source().nodeCount());
+        ASSERT_EQ(size_t(3), prolong.target().nodeCount());
+        const SignalStore& res = prolong.result();
+        for( auto& n: nodes )
+            EXPECT_DOUBLE_EQ(5.75, res(0, prolong.target().index(n.id())));
+    }
+
+    // Only 2 layers above the base layer
+    {
+        LayerTransfer restrict(g);
+        restrict.setLevels(3);
+        EXPECT_FALSE(restrict.run());
+    }
+
+    dao.reset();
+    sess.reset();
+}
+
+TEST( LayerTransferTest, MultiLevelOrphan )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+    // Channel unset by default
+    const std::wstring channel(L"humidity");
+    Value def;
+    def.SetNull();
+    EXPECT_TRUE(SparkseeManager::addAttrToOLink(g, channel, Double, Basic, def));
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->addBaseLayer();
+    Layer mid = dao->addLayerOnTop();
+    Layer top = dao->addLayerOnTop();
+
+    // n0, n1 -> p0 ; n2 -> p1 ; p0 -> q0, p1 has no parent
+    std::vector<mld::Node> nodes;
+    AttrMap nodeData;
+    AttrMap data;
+    data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(0.0);
+    for( size_t i = 0; i < 3; ++i )
+        nodes.push_back(dao->addNodeToLayer(base, nodeData, data));
+    mld::Node p0 = dao->addNodeToLayer(mid, nodeData, data);
+    data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(5.0);
+    mld::Node p1 = dao->addNodeToLayer(mid, nodeData, data);
+    data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(6.0);
+    mld::Node q0 = dao->addNodeToLayer(top, nodeData, data);
+    dao->addVLink(nodes[0], p0, 1.0);
+    dao->addVLink(nodes[1], p0, 1.0);
+    dao->addVLink(nodes[2], p1, 1.0);
+    dao->addVLink(p0, q0, 1.0);
+
+    // Only the top layer has the channel
+    OLinkWeightMap values;
+    values[q0.id()] = 7.0;
+    EXPECT_TRUE(dao->updateOLinkWeights(top.id(), values, channel));
+
+    LayerTransfer prolong(g);
+    prolong.setLevels(2);
+    prolong.setDirection(LayerTransfer::PROLONG);
+    prolong.setChannels({ channel });
+    prolong.setWriteBack(false);
+    EXPECT_TRUE(prolong.run());
+    EXPECT_EQ(size_t(1), prolong.maps()[1].orphanCount());
+
+    // The orphan keeps its middle layer weight, its missing channel is the default value
+    const SignalStore& res = prolong.result();
+    size_t n0 = prolong.target().index(nodes[0].id());
+    size_t n2 = prolong.target().index(nodes[2].id());
+    EXPECT_DOUBLE_EQ(6.0, res(0, n0));
+    EXPECT_DOUBLE_EQ(7.0, res(0, n0, 1));
+    EXPECT_DOUBLE_EQ(5.0, res(0, n2));
+    EXPECT_DOUBLE_EQ(OLINK_DEF_VALUE, res(0, n2, 1));
+
+    dao.reset();
+    sess.reset();
+}
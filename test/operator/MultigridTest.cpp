@@ -0,0 +1,155 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <mld/config.h>
+#include <mld/SparkseeManager.h>
+
+#include <mld/dao/MLGDao.h>
+#include <mld/model/GraphSnapshot.h>
+#include <mld/model/TransferMap.h>
+#include <mld/operator/Multigrid.h>
+#include <mld/operator/MultigridSolver.h>
+
+#include "GridFixture.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+namespace {
+
+double residual( const GraphSnapshot& g, double alpha, const std::vector<double>& b,
+                 const std::vector<double>& x )
+{
+    std::vector<double> lx(x.size());
+    g.laplacian(x.data(), lx.data());
+    double num = 0.0;
+    double den = 0.0;
+    for( size_t i = 0; i < x.size(); ++i ) {
+        double r = b[i] - lx[i] - alpha * x[i];
+        num += r * r;
+        den += b[i] * b[i];
+    }
+    return std::sqrt(num / den);
+}
+
+} // end namespace anonymous
+
+TEST( MultigridTest, VCycle )
+{
+    const size_t side = 64;
+    const double alpha = 1e-3;
+    GraphSnapshot g(fixture::grid(side, side));
+    std::vector<TransferMap> maps;
+    for( size_t s = side; s > 4; s /= 2 )
+        maps.push_back(fixture::aggregate(s, s));
+
+    std::vector<double> b(side * side);
+    for( size_t i = 0; i < b.size(); ++i )
+        b[i] = std::sin(0.37 * double(i)) + ((i % side) < side / 2 ? 1.0 : -1.0);
+    std::vector<double> x(b.size());
+
+    // Jacobi preconditioned CG on a single level
+    Multigrid cg;
+    cg.setAlpha(alpha);
+    cg.setDirectSize(0);
+    cg.setMaxIterations(2000);
+    ASSERT_TRUE(cg.setup(g, std::vector<TransferMap>()));
+    EXPECT_EQ(size_t(1), cg.levelCount());
+    EXPECT_TRUE(cg.solve(b.data(), x.data()));
+    EXPECT_LT(residual(g, alpha, b, x), 1e-7);
+
+    // Multigrid preconditioned CG, coarsest level factorized
+    Multigrid mg;
+    mg.setAlpha(alpha);
+    mg.setDirectSize(64);
+    ASSERT_TRUE(mg.setup(g, maps));
+    EXPECT_EQ(size_t(4), mg.levelCount());
+    EXPECT_EQ(size_t(64), mg.levelSize(3));
+    EXPECT_TRUE(mg.solve(b.data(), x.data()));
+    EXPECT_LT(residual(g, alpha, b, x), 1e-7);
+    EXPECT_LT(4 * mg.iterations(), cg.iterations());
+
+    // Jacobi smoother and coarsest level solved with CG
+    mg.setSmoother(Multigrid::JACOBI);
+    mg.setDirectSize(8);
+    ASSERT_TRUE(mg.setup(g, maps));
+    EXPECT_EQ(size_t(5), mg.levelCount());
+    EXPECT_TRUE(mg.solve(b.data(), x.data()));
+    EXPECT_LT(residual(g, alpha, b, x), 1e-7);
+
+    // Stationary V-cycles
+    mg.setSmoother(Multigrid::GAUSS_SEIDEL);
+    mg.setPreconditioned(false);
+    mg.setMaxIterations(500);
+    EXPECT_TRUE(mg.solve(b.data(), x.data()));
+    EXPECT_LT(residual(g, alpha, b, x), 1e-7);
+
+    // Shift must be positive
+    mg.setAlpha(0.0);
+    EXPECT_FALSE(mg.setup(g, maps));
+}
+
+TEST( MultigridTest, Tikhonov )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->addBaseLayer();
+    Layer top = dao->addLayerOnTop();
+
+    // Path n0 - n1 - n2 - n3, aggregated by pairs
+    std::vector<double> y{ 1, 5, 2, 8 };
+    std::vector<mld::Node> nodes(fixture::addNodes(*dao, base, y));
+    fixture::addPath(*dao, nodes);
+    fixture::aggregatePairs(*dao, top, nodes);
+
+    const double gamma = 0.5;
+    MultigridSolver solver(g);
+    solver.multigrid().setDirectSize(2);
+    // Invalid regularization is not silently ignored
+    EXPECT_FALSE(solver.setTikhonov(0.0));
+    EXPECT_FALSE(solver.run());
+    EXPECT_TRUE(solver.setTikhonov(gamma));
+    EXPECT_TRUE(solver.run());
+    EXPECT_GE(solver.maxIterations(), 1u);
+
+    // (I + gamma L) x = y
+    std::vector<double> x;
+    for( auto& n: nodes )
+        x.push_back(dao->getOLink(base.id(), n.id()).weight());
+    for( size_t i = 0; i < x.size(); ++i ) {
+        double lx = 0.0;
+        if( i > 0 ) lx += x[i] - x[i - 1];
+        if( i + 1 < x.size() ) lx += x[i] - x[i + 1];
+        EXPECT_NEAR(y[i], x[i] + gamma * lx, 1e-6);
+    }
+    // Denoising preserves the mean
+    EXPECT_NEAR(4.0, (x[0] + x[1] + x[2] + x[3]) / 4.0, 1e-6);
+
+    dao.reset();
+    sess.reset();
+}
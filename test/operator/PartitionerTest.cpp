@@ -0,0 +1,123 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <mld/config.h>
+#include <mld/SparkseeManager.h>
+
+#include <mld/dao/MLGDao.h>
+#include <mld/model/GraphSnapshot.h>
+#include <mld/model/TransferMap.h>
+#include <mld/operator/KWayPartitioner.h>
+#include <mld/operator/Partitioner.h>
+
+#include "GridFixture.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+TEST( PartitionerTest, Grid )
+{
+    const size_t side = 64;
+    GraphSnapshot g(fixture::grid(side, side));
+    std::vector<TransferMap> maps;
+    for( size_t s = side; s > 2; s /= 2 )
+        maps.push_back(fixture::aggregate(s, s));
+
+    KWayPartitioner kp;
+    kp.setPartCount(4);
+    kp.setThreads(1);
+    ASSERT_TRUE(kp.partition(g, maps));
+    // Levels with less than 8 nodes per part are skipped
+    EXPECT_EQ(size_t(4), kp.levelCount());
+    ASSERT_EQ(g.nodeCount(), kp.parts().size());
+    ASSERT_EQ(size_t(4), kp.partWeights().size());
+    for( auto p: kp.parts() )
+        EXPECT_LT(p, 4u);
+    EXPECT_LE(kp.balance(), 1.03);
+    // Quadrants are optimal
+    EXPECT_LE(kp.edgeCut(), 1.5 * 2 * side);
+
+    // The refinement gives the same result on any number of threads
+    KWayPartitioner parallel;
+    parallel.setPartCount(4);
+    parallel.setThreads(4);
+    ASSERT_TRUE(parallel.partition(g, maps));
+    EXPECT_EQ(kp.parts(), parallel.parts());
+
+    // Uneven parts and a tight balance
+    kp.setPartCount(7);
+    kp.setImbalance(0.01);
+    ASSERT_TRUE(kp.partition(g, maps));
+    EXPECT_LE(kp.balance(), 1.01);
+
+    kp.setPartCount(0);
+    EXPECT_FALSE(kp.partition(g, maps));
+}
+
+TEST( PartitionerTest, Partitioner )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->addBaseLayer();
+    Layer top = dao->addLayerOnTop();
+
+    // Two 8 node cliques joined by a single edge, aggregated by pairs.
+    // The top layer has less than 8 nodes per part, it is not a level
+    const size_t n = 16;
+    std::vector<mld::Node> nodes(fixture::addNodes(*dao, base, n));
+    for( size_t i = 0; i < n; ++i ) {
+        for( size_t j = i + 1; j < n; ++j ) {
+            if( i / 8 == j / 8 )
+                dao->addHLink(nodes[i], nodes[j], 1.0);
+        }
+    }
+    dao->addHLink(nodes[7], nodes[8], 1.0);
+    fixture::aggregatePairs(*dao, top, nodes);
+
+    Partitioner partitioner(g);
+    partitioner.partitioner().setPartCount(2);
+    partitioner.partitioner().setImbalance(0.0);
+    EXPECT_TRUE(partitioner.run());
+    EXPECT_EQ(size_t(1), partitioner.partitioner().levelCount());
+    EXPECT_DOUBLE_EQ(1.0, partitioner.partitioner().edgeCut());
+
+    // Parts stored in the node attribute, one per clique
+    attr_t attr = g->FindAttribute(dao->nodeType(), L"partition");
+    ASSERT_NE(Attribute::InvalidAttribute, attr);
+    Value v;
+    std::vector<int> parts;
+    for( auto& node: nodes ) {
+        g->GetAttribute(node.id(), attr, v);
+        ASSERT_FALSE(v.IsNull());
+        parts.push_back(v.GetInteger());
+    }
+    for( size_t i = 0; i < n; ++i )
+        EXPECT_EQ(parts[i / 8 * 8], parts[i]);
+    EXPECT_NE(parts[0], parts[8]);
+
+    dao.reset();
+    sess.reset();
+}
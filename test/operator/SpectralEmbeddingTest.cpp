@@ -0,0 +1,145 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <mld/config.h>
+#include <mld/SparkseeManager.h>
+
+#include <mld/dao/MLGDao.h>
+#include <mld/model/GraphSnapshot.h>
+#include <mld/model/TransferMap.h>
+#include <mld/operator/SpectralEmbedding.h>
+#include <mld/operator/SpectralEmbedder.h>
+
+#include "GridFixture.h"
+
+using namespace mld;
+using namespace sparksee::gdb;
+
+namespace {
+
+const double PI = std::acos(-1.0);
+
+// Smallest non trivial eigenvalue of the Laplacian of a path of n nodes
+double pathEigenvalue( size_t k, size_t n )
+{
+    return 2.0 - 2.0 * std::cos(PI * double(k) / double(n));
+}
+
+} // end namespace anonymous
+
+TEST( SpectralEmbeddingTest, Grid )
+{
+    const size_t rows = 64;
+    const size_t cols = 24;
+    GraphSnapshot g(fixture::grid(rows, cols));
+    std::vector<TransferMap> maps;
+    for( size_t r = rows, c = cols; c % 2 == 0; r /= 2, c /= 2 )
+        maps.push_back(fixture::aggregate(r, c));
+
+    SpectralEmbedding se;
+    se.setDimension(3);
+    se.setRefineSteps(10);
+    ASSERT_TRUE(se.compute(g, maps));
+    EXPECT_EQ(size_t(4), se.levelCount());
+    EXPECT_EQ(size_t(24), se.levelSize(3));
+
+    // Eigenvalues of the grid are sums of path eigenvalues
+    ASSERT_EQ(size_t(3), se.eigenvalues().size());
+    std::vector<double> exact{ pathEigenvalue(1, rows), pathEigenvalue(2, rows), pathEigenvalue(1, cols) };
+    for( size_t j = 0; j < 3; ++j )
+        EXPECT_NEAR(exact[j], se.eigenvalues()[j], 1e-7);
+    EXPECT_LT(se.residual(), 1e-3);
+
+    // Fiedler vector is cos(pi (r + 1/2) / rows) along the rows
+    const std::vector<double>& coords = se.embedding();
+    ASSERT_EQ(rows * cols * 3, coords.size());
+    double proj = 0.0;
+    double norm = 0.0;
+    for( size_t r = 0; r < rows; ++r ) {
+        double u = std::cos(PI * (double(r) + 0.5) / double(rows));
+        for( size_t c = 0; c < cols; ++c ) {
+            proj += u * coords[(r * cols + c) * 3];
+            norm += u * u;
+        }
+    }
+    EXPECT_NEAR(1.0, std::fabs(proj) / std::sqrt(norm), 1e-7);
+
+    // Lanczos on the finest level only is far less accurate for the same work
+    SpectralEmbedding single;
+    single.setDimension(3);
+    single.setRefineSteps(10);
+    ASSERT_TRUE(single.compute(g, std::vector<TransferMap>()));
+    EXPECT_EQ(size_t(1), single.levelCount());
+    for( size_t j = 0; j < 3; ++j )
+        EXPECT_LT(100.0 * (se.eigenvalues()[j] - exact[j]), single.eigenvalues()[j] - exact[j]);
+
+    // Not enough nodes
+    se.setDimension(uint32_t(rows * cols));
+    EXPECT_FALSE(se.compute(g, maps));
+}
+
+TEST( SpectralEmbeddingTest, Embedder )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    sparkseeManager.createBaseScheme(g);
+
+    std::unique_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->addBaseLayer();
+    Layer top = dao->addLayerOnTop();
+
+    // Path of 8 nodes, aggregated by pairs
+    const size_t n = 8;
+    std::vector<mld::Node> nodes(fixture::addNodes(*dao, base, n));
+    fixture::addPath(*dao, nodes);
+    std::vector<mld::Node> parents(fixture::aggregatePairs(*dao, top, nodes));
+
+    SpectralEmbedder embedder(g);
+    embedder.embedding().setDimension(1);
+    embedder.embedding().setRefineSteps(10);
+    EXPECT_TRUE(embedder.run());
+    EXPECT_EQ(size_t(2), embedder.embedding().levelCount());
+    EXPECT_NEAR(pathEigenvalue(1, n), embedder.embedding().eigenvalues()[0], 1e-8);
+
+    // Fiedler vector stored in the node attribute
+    attr_t attr = g->FindAttribute(dao->nodeType(), L"spectral_0");
+    ASSERT_NE(Attribute::InvalidAttribute, attr);
+    Value v;
+    double proj = 0.0;
+    double norm = 0.0;
+    for( size_t i = 0; i < n; ++i ) {
+        g->GetAttribute(nodes[i].id(), attr, v);
+        double u = std::cos(PI * (double(i) + 0.5) / double(n));
+        proj += u * v.GetDouble();
+        norm += u * u;
+    }
+    EXPECT_NEAR(1.0, std::fabs(proj) / std::sqrt(norm), 1e-6);
+    // Parent nodes are not embedded
+    g->GetAttribute(parents[0].id(), attr, v);
+    EXPECT_TRUE(v.IsNull());
+
+    dao.reset();
+    sess.reset();
+}
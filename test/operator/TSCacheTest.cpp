@@ -110,3 +110,110 @@ TEST( TSCacheTest, CRUD )
 //    LOG(logDEBUG) << p.first << " " << p.second;
 
 }
+
+TEST( TSCacheTest, Prefetch )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    // Create Db scheme
+    sparkseeManager.createBaseScheme(g);
+
+    std::shared_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->addBaseLayer();
+    mld::Node n1 = dao->addNodeToLayer(base);
+    mld::Node n2 = dao->addNodeToLayer(base);
+
+    AttrMap data;
+    for( int i = 2; i < 5; ++i ) {
+        Layer l = dao->addLayerOnTop();
+        data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(i);
+        dao->addOLink(l, n1, data);
+        data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(10 + i);
+        dao->addOLink(l, n2, data);
+    }
+
+    // Bulk read
+    auto weights = dao->getOLinkWeights(dao->topLayer().id());
+    EXPECT_EQ(size_t(2), weights.size());
+    EXPECT_DOUBLE_EQ(4, weights[n1.id()]);
+    EXPECT_DOUBLE_EQ(14, weights[n2.id()]);
+
+    SessionPtr prefetchSess = sparkseeManager.newSession();
+    TSCache cache(dao);
+    cache.setPrefetchDao(std::shared_ptr<MLGDao>(new MLGDao(prefetchSess->GetGraph())));
+    EXPECT_TRUE(cache.isPrefetchEnabled());
+    cache.reset(base.id(), TSDirection::BOTH, 1);
+
+    auto p1 = cache.get(n1.id());
+    auto p2 = cache.get(n2.id());
+    EXPECT_EQ(size_t(2), p1.second.totalSize());
+    EXPECT_DOUBLE_EQ(2, p1.second.data().back());
+    EXPECT_DOUBLE_EQ(12, p2.second.data().back());
+
+    cache.scrollUp();
+    p1 = cache.get(n1.id());
+    p2 = cache.get(n2.id());
+    EXPECT_EQ(size_t(3), p1.second.totalSize());
+    EXPECT_DOUBLE_EQ(3, p1.second.data().back());
+    EXPECT_DOUBLE_EQ(13, p2.second.data().back());
+
+    cache.scrollUp();
+    p1 = cache.get(n1.id());
+    EXPECT_EQ(size_t(3), p1.second.totalSize());
+    EXPECT_DOUBLE_EQ(4, p1.second.data().back());
+
+    cache.clear();
+    cache.setPrefetchDao(std::shared_ptr<MLGDao>());
+    prefetchSess.reset();
+}
+
+TEST( TSCacheTest, MissingOLink )
+{
+    mld::SparkseeManager sparkseeManager(mld::kRESOURCES_DIR + L"mysparksee.cfg");
+    sparkseeManager.createDatabase(mld::kRESOURCES_DIR + L"MLDTest.sparksee", L"MLDTest");
+
+    SessionPtr sess = sparkseeManager.newSession();
+    Graph* g = sess->GetGraph();
+    // Create Db scheme
+    sparkseeManager.createBaseScheme(g);
+
+    std::shared_ptr<MLGDao> dao( new MLGDao(g) );
+    Layer base = dao->addBaseLayer();
+    mld::Node n1 = dao->addNodeToLayer(base);
+    mld::Node n2 = dao->addNodeToLayer(base);
+
+    AttrMap data;
+    for( int i = 2; i < 4; ++i ) {
+        Layer l = dao->addLayerOnTop();
+        data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(i);
+        dao->addOLink(l, n1, data);
+        data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(10 + i);
+        dao->addOLink(l, n2, data);
+    }
+    // n2 has no OLink on the top layer
+    Layer top = dao->addLayerOnTop();
+    data[Attrs::V[OLinkAttr::WEIGHT]].SetDoubleVoid(4);
+    dao->addOLink(top, n1, data);
+
+    TSCache cache(dao);
+    cache.reset(base.id(), TSDirection::BOTH, 1);
+    cache.get(n1.id());
+    cache.get(n2.id());
+    EXPECT_EQ(uint64_t(2), cache.size());
+
+    cache.scrollUp();
+    EXPECT_EQ(uint64_t(2), cache.size());
+
+    // Top layer is loaded, n2 is evicted
+    cache.scrollUp();
+    EXPECT_EQ(uint64_t(1), cache.size());
+    auto p = cache.get(n1.id());
+    EXPECT_EQ(size_t(3), p.second.totalSize());
+    EXPECT_DOUBLE_EQ(4, p.second.data().back());
+
+    cache.clear();
+    EXPECT_EQ(uint64_t(0), cache.size());
+}
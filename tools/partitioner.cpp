@@ -0,0 +1,129 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <tclap/CmdLine.h>
+
+#include <locale>
+#include <codecvt>
+#include <string>
+
+#include <mld/config.h>
+#include <mld/SparkseeManager.h>
+#include <mld/Session.h>
+#include <mld/utils/Timer.h>
+#include <mld/operator/Partitioner.h>
+
+using namespace TCLAP;
+using namespace mld;
+
+struct InputContext {
+    std::wstring dbName;
+    std::wstring workDir;
+    std::wstring attribute;
+    uint32_t parts;
+    double imbalance;
+    uint32_t maxLevels;
+    uint32_t threads;
+};
+
+bool parseOptions( int argc, char *argv[], InputContext& out )
+{
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    try {
+        // Define the command line object.
+        CmdLine cmd("Partitioner", ' ', "0.1");
+
+        // Working dir
+        ValueArg<std::string> wdArg("d", "workDir", "MLD working directory",
+                                    false, converter.to_bytes(mld::kRESOURCES_DIR), "path");
+        cmd.add(wdArg);
+
+        // Db Name
+        ValueArg<std::string> nameArg("n", "name", "MLD database name (without extension)",
+                                    true, "", "string");
+        cmd.add(nameArg);
+
+        ValueArg<uint32_t> partsArg("k", "parts", "Number of parts", true, 2, "uint32_t");
+        cmd.add(partsArg);
+
+        ValueArg<double> epsArg("e", "imbalance", "Allowed imbalance, parts weigh at most (1 + e) * n / k",
+                                false, 0.03, "double");
+        cmd.add(epsArg);
+
+        ValueArg<uint32_t> levelsArg("l", "levels", "Maximum number of levels, 0 for all the layers",
+                                     false, 0, "uint32_t");
+        cmd.add(levelsArg);
+
+        ValueArg<uint32_t> threadsArg("t", "threads", "Number of threads, 0 for the hardware concurrency",
+                                      false, 0, "uint32_t");
+        cmd.add(threadsArg);
+
+        ValueArg<std::string> attrArg("a", "attribute", "Node attribute holding the part",
+                                      false, "partition", "string");
+        cmd.add(attrArg);
+
+        // Parse the args.
+        cmd.parse(argc, argv);
+
+        // Get the value parsed by each arg.
+        out.workDir = converter.from_bytes(wdArg.getValue());
+        out.dbName = converter.from_bytes(nameArg.getValue());
+        out.attribute = converter.from_bytes(attrArg.getValue());
+        out.parts = partsArg.getValue();
+        out.imbalance = epsArg.getValue();
+        out.maxLevels = levelsArg.getValue();
+        out.threads = threadsArg.getValue();
+    } catch( ArgException& e ) {
+        LOG(logERROR) << "error: " << e.error() << " for arg " << e.argId();
+        return false;
+    }
+
+    return true;
+}
+
+int main( int argc, char *argv[] )
+{
+    InputContext ctx;
+    if( !parseOptions(argc, argv, ctx) )
+        return EXIT_FAILURE;
+
+    mld::SparkseeManager sparkseeManager(ctx.workDir + L"mysparksee.cfg");
+    sparkseeManager.openDatabase(ctx.workDir + ctx.dbName + L".sparksee");
+    SessionPtr sess(sparkseeManager.newSession());
+    sparksee::gdb::Graph* g = sess->GetGraph();
+    bool ok = false;
+    {  // Partitioner will go out of scope before Session
+        Partitioner partitioner(g);
+        partitioner.setMaxLevels(ctx.maxLevels);
+        partitioner.setAttribute(ctx.attribute);
+        partitioner.partitioner().setPartCount(ctx.parts);
+        partitioner.partitioner().setImbalance(ctx.imbalance);
+        partitioner.partitioner().setThreads(ctx.threads);
+
+        sess->Begin();
+        ok = partitioner.run();
+        if( !ok ) {
+            LOG(logERROR) << "Partitioner: partitioning failed";
+        }
+        sess->Commit();
+    }
+
+    LOG(logINFO) << Timer::dumpTrials();
+    sess.reset();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -36,6 +36,7 @@ struct InputContext {
     std::wstring dbName;
     std::wstring workDir;
     std::string inputPath;
+    uint32_t numThreads;
 };
 
 std::wstring extractDbName( const std::wstring& inputPath )
@@ -64,6 +65,9 @@ bool parseOptions( int argc, char *argv[], InputContext& out )
         ValueArg<std::string> wdArg("d", "workDir", "MLD working directory",
                                     false, converter.to_bytes(mld::kRESOURCES_DIR), "path");
         cmd.add(wdArg);
+        ValueArg<uint32_t> threadsArg("t", "threads", "Number of parser threads, 0 for the number of cores",
+                                      false, 0, "uint32_t");
+        cmd.add(threadsArg);
         // Parse the args.
         cmd.parse(argc, argv);
 
@@ -71,6 +75,7 @@ bool parseOptions( int argc, char *argv[], InputContext& out )
         out.inputPath = inputArg.getValue();
         out.workDir = converter.from_bytes(wdArg.getValue());
         out.dbName = extractDbName(converter.from_bytes(out.inputPath));
+        out.numThreads = threadsArg.getValue();
     } catch( ArgException& e ) {
         LOG(logERROR) << "error: " << e.error() << " for arg " << e.argId();
         return false;
@@ -93,7 +98,7 @@ int main( int argc, char *argv[] )
     // Create Db scheme
     m.createBaseScheme(g);
     sess->Begin();
-    if( !GraphImporter::fromSnapFormat(g, ctx.inputPath) ) {
+    if( !GraphImporter::fromSnapFormat(g, ctx.inputPath, ctx.numThreads) ) {
         LOG(logERROR) << "Error parsing snap format";
     }
     sess->Commit();
@@ -0,0 +1,184 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 EPFL-LTS2
+** Contact: Kirell Benzi (first.last@epfl.ch)
+**
+** This file is part of MLD.
+**
+**
+** GNU General Public License Usage
+** This file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.md included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements
+** will be met: http://www.gnu.org/licenses/
+**
+****************************************************************************/
+
+#include <tclap/CmdLine.h>
+
+#include <locale>
+#include <codecvt>
+#include <string>
+#include <chrono>
+#include <random>
+#include <limits>
+
+#include <mld/config.h>
+#include <mld/SparkseeManager.h>
+#include <mld/Session.h>
+#include <mld/dao/MLGDao.h>
+#include <mld/operator/HierarchicalRouter.h>
+
+using namespace TCLAP;
+using namespace mld;
+
+struct InputContext {
+    std::wstring dbName;
+    std::wstring workDir;
+    uint32_t queries;
+    uint32_t seed;
+    uint32_t width;
+    uint32_t maxLevels;
+    bool bfs;
+};
+
+bool parseOptions( int argc, char *argv[], InputContext& out )
+{
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    try {
+        // Define the command line object.
+        CmdLine cmd("Compare exact and hierarchy guided shortest paths on the base layer", ' ', "0.1");
+
+        // Working dir
+        ValueArg<std::string> wdArg("d", "workDir", "MLD working directory",
+                                    false, converter.to_bytes(mld::kRESOURCES_DIR), "path");
+        cmd.add(wdArg);
+
+        // Db Name
+        ValueArg<std::string> nameArg("n", "name", "MLD database name (without extension)",
+                                    true, "", "string");
+        cmd.add(nameArg);
+
+        ValueArg<uint32_t> queriesArg("q", "queries", "Number of random queries", false, 1000, "uint32_t");
+        cmd.add(queriesArg);
+
+        ValueArg<uint32_t> seedArg("s", "seed", "Seed of the random queries", false, 0, "uint32_t");
+        cmd.add(seedArg);
+
+        ValueArg<uint32_t> widthArg("w", "width", "Corridor width in coarse hops", false, 1, "uint32_t");
+        cmd.add(widthArg);
+
+        ValueArg<uint32_t> levelsArg("l", "levels", "Maximum number of levels, 0 for all the layers",
+                                     false, 0, "uint32_t");
+        cmd.add(levelsArg);
+
+        SwitchArg bfsArg("b", "bfs", "Count hops (BFS) instead of weighted paths (Dijkstra)", false);
+        cmd.add(bfsArg);
+
+        // Parse the args.
+        cmd.parse(argc, argv);
+
+        // Get the value parsed by each arg.
+        out.workDir = converter.from_bytes(wdArg.getValue());
+        out.dbName = converter.from_bytes(nameArg.getValue());
+        out.queries = queriesArg.getValue();
+        out.seed = seedArg.getValue();
+        out.width = widthArg.getValue();
+        out.maxLevels = levelsArg.getValue();
+        out.bfs = bfsArg.getValue();
+    } catch( ArgException& e ) {
+        LOG(logERROR) << "error: " << e.error() << " for arg " << e.argId();
+        return false;
+    }
+
+    return true;
+}
+
+bool loadRouter( sparksee::gdb::Graph* g, const InputContext& ctx, HierarchicalRouter& router )
+{
+    MLGDao dao(g);
+    Layer base(dao.baseLayer());
+    GraphSnapshot graph(dao.getGraphSnapshot(base));
+    if( graph.empty() ) {
+        LOG(logERROR) << "SPBench: empty base layer";
+        return false;
+    }
+    std::vector<TransferMap> maps;
+    std::vector<GraphSnapshot> levels;
+    if( !dao.getTransferMaps(graph, base, maps, ctx.maxLevels, &levels) )
+        return false;
+    levels.insert(levels.begin(), std::move(graph));
+
+    std::string sizes;
+    for( auto& l: levels )
+        sizes += " " + std::to_string(l.nodeCount());
+    LOG(logINFO) << "Levels:" << sizes;
+    return router.setup(std::move(levels), std::move(maps));
+}
+
+int main( int argc, char *argv[] )
+{
+    InputContext ctx;
+    if( !parseOptions(argc, argv, ctx) )
+        return EXIT_FAILURE;
+
+    mld::SparkseeManager sparkseeManager(ctx.workDir + L"mysparksee.cfg");
+    sparkseeManager.openDatabase(ctx.workDir + ctx.dbName + L".sparksee");
+    SessionPtr sess(sparkseeManager.newSession());
+    HierarchicalRouter router;
+    router.setSearch(ctx.bfs ? HierarchicalRouter::BFS : HierarchicalRouter::DIJKSTRA);
+    router.setCorridorWidth(ctx.width);
+    bool ok = loadRouter(sess->GetGraph(), ctx, router);
+    // Queries run in memory
+    sess.reset();
+    if( !ok ) {
+        LOG(logERROR) << "SPBench: failed to load the layers";
+        return EXIT_FAILURE;
+    }
+
+    typedef std::chrono::high_resolution_clock Clock;
+    const size_t n = router.level(0).nodeCount();
+    std::mt19937 gen(ctx.seed);
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+    double exactMs = 0.0;
+    double routeMs = 0.0;
+    double stretch = 0.0;
+    double maxStretch = 1.0;
+    size_t exactSettled = 0;
+    size_t routeSettled = 0;
+    size_t reachable = 0;
+    size_t fallbacks = 0;
+    for( uint32_t q = 0; q < ctx.queries; ++q ) {
+        const size_t s = pick(gen);
+        const size_t t = pick(gen);
+        auto t0 = Clock::now();
+        const double exact = router.shortestPath(s, t);
+        auto t1 = Clock::now();
+        exactSettled += router.settledCount();
+        const double approx = router.route(s, t);
+        auto t2 = Clock::now();
+        routeSettled += router.settledCount();
+        exactMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        routeMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+        if( router.fellBack() )
+            ++fallbacks;
+        if( exact == std::numeric_limits<double>::infinity() )
+            continue;
+        ++reachable;
+        const double r = exact > 0.0 ? approx / exact : 1.0;
+        stretch += r;
+        maxStretch = std::max(maxStretch, r);
+    }
+
+    const double queries = std::max(1.0, double(ctx.queries));
+    LOG(logINFO) << "Queries: " << ctx.queries << " reachable: " << reachable
+                 << " fallbacks: " << fallbacks;
+    LOG(logINFO) << "Exact: " << exactMs / queries << " ms, " << exactSettled / queries << " settled nodes";
+    LOG(logINFO) << "Hierarchical: " << routeMs / queries << " ms, " << routeSettled / queries << " settled nodes";
+    LOG(logINFO) << "Speedup: " << (routeMs > 0.0 ? exactMs / routeMs : 0.0);
+    LOG(logINFO) << "Stretch mean: " << (reachable ? stretch / double(reachable) : 0.0)
+                 << " max: " << maxStretch;
+    return EXIT_SUCCESS;
+}
@@ -26,7 +26,9 @@
 #include <mld/config.h>
 #include <mld/SparkseeManager.h>
 #include <mld/Session.h>
+#include <mld/dao/MLGDao.h>
 #include <mld/io/GraphExporter.h>
+#include <mld/io/MatrixExporter.h>
 #include <mld/utils/Timer.h>
 
 using namespace TCLAP;
@@ -37,6 +39,10 @@ struct InputContext {
     std::wstring workDir;
     std::string exportDir;
     std::string outName;
+    bool binary;
+    std::string matrix;
+    size_t firstLayer;
+    size_t lastLayer;
 };
 
 bool parseOptions( int argc, char *argv[], InputContext& out )
@@ -66,6 +72,24 @@ bool parseOptions( int argc, char *argv[], InputContext& out )
         ValueArg<std::string> outNameArg("v", "outname", "Output name for both file ", false, "", "string");
         cmd.add(outNameArg);
 
+        // Binary format
+        SwitchArg binArg("b", "binary", "Export in the compact binary format (*.mldts)", false);
+        cmd.add(binArg);
+
+        // Sparse matrices
+        std::vector<std::string> formats = { "mm", "csr" };
+        ValuesConstraint<std::string> formatConstraint(formats);
+        ValueArg<std::string> matrixArg("m", "matrix",
+                                        "Export layers and inter-layer maps as sparse matrices",
+                                        false, "", &formatConstraint);
+        cmd.add(matrixArg);
+        ValueArg<size_t> firstArg("", "firstLayer", "First layer to export as matrix, from the bottom",
+                                  false, 0, "int");
+        cmd.add(firstArg);
+        ValueArg<size_t> lastArg("", "lastLayer", "Last layer to export as matrix (default: top)",
+                                 false, INVALID_INDEX, "int");
+        cmd.add(lastArg);
+
         // Parse the args.
         cmd.parse(argc, argv);
 
@@ -74,6 +98,10 @@ bool parseOptions( int argc, char *argv[], InputContext& out )
         out.dbName = converter.from_bytes(nameArg.getValue());
         out.exportDir = exportDirArg.getValue();
         out.outName = outNameArg.getValue();
+        out.binary = binArg.getValue();
+        out.matrix = matrixArg.getValue();
+        out.firstLayer = firstArg.getValue();
+        out.lastLayer = lastArg.getValue();
         if( out.outName.empty() ) {
             out.outName = converter.to_bytes(out.dbName);
         }
@@ -95,8 +123,26 @@ int main( int argc, char *argv[] )
     sparkseeManager.openDatabase(ctx.workDir + ctx.dbName + L".sparksee");
     SessionPtr sess(sparkseeManager.newSession());
     sparksee::gdb::Graph* g = sess->GetGraph();
+    if( !MLGDao(g).checkSignalBits() )
+        return EXIT_FAILURE;
 
-    if( !GraphExporter::toTimeSeries(g, ctx.outName, ctx.exportDir) ) {
+    bool ok = false;
+    if( !ctx.matrix.empty() ) {
+        auto format = ctx.matrix == "csr" ? MatrixExporter::BINARY_CSR : MatrixExporter::MATRIX_MARKET;
+        ok = MatrixExporter::toSparseMatrices(g, ctx.outName, ctx.exportDir, format,
+                                              ctx.firstLayer, ctx.lastLayer);
+    }
+    else if( ctx.binary ) {
+        std::string exportFolderPath(ctx.exportDir);
+        if( !boost::algorithm::ends_with(exportFolderPath, "/") ) {
+            exportFolderPath.append("/");
+        }
+        ok = GraphExporter::toBinaryTimeSeries(g, exportFolderPath + ctx.outName + ".mldts");
+    }
+    else {
+        ok = GraphExporter::toTimeSeries(g, ctx.outName, ctx.exportDir);
+    }
+    if( !ok ) {
         LOG(logERROR) << "Export TS graph failed";
         return EXIT_FAILURE;
     }
@@ -19,17 +19,24 @@
 #include <locale>
 #include <codecvt>
 #include <string>
+#include <fstream>
+#include <iostream>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
 #include <tclap/CmdLine.h>
 
 #include <mld/config.h>
 #include <mld/SparkseeManager.h>
 #include <mld/Session.h>
+#include <mld/dao/MLGDao.h>
 #include <mld/io/GraphImporter.h>
+#include <mld/io/StreamImporter.h>
 #include <mld/utils/Timer.h>
 #include <mld/operator/TSOperator.h>
 #include <mld/operator/filter/FilterFactory.h>
+#include <mld/operator/filter/AbstractTimeVertexFilter.h>
+#include <mld/operator/filter/TimeVertexMeanFilter.h>
 
 using namespace TCLAP;
 using namespace mld;
@@ -43,6 +50,14 @@ struct InputContext {
     double lambda;
     uint32_t twSize;
     uint32_t numIt;
+    bool prefetch;
+    bool flush;
+    std::string streamPath;
+    std::string excludePath;
+    std::wstring rawAttr;
+    std::vector<std::wstring> channels;
+    uint32_t batchSize;
+    FilterOptions filterOpts;
 };
 
 bool parseOptions( int argc, char *argv[], InputContext& out )
@@ -64,7 +79,8 @@ bool parseOptions( int argc, char *argv[], InputContext& out )
 
         // Filter name
         ValueArg<std::string> filterNameArg("f", "filter",
-                                       "Filter\n TimeVertexMeanFilter",
+                                       "Filter\n tvm: TimeVertexMeanFilter\n"
+                                       " heat, lowpass, bandpass: Chebyshev filters",
                                        false, "tvm", "string");
         cmd.add(filterNameArg);
 
@@ -80,6 +96,64 @@ bool parseOptions( int argc, char *argv[], InputContext& out )
         ValueArg<uint32_t> numItArg("i", "iteration", "Number of iterations", false, 1, "uint32_t");
         cmd.add(numItArg);
 
+        // Chebyshev order
+        ValueArg<uint32_t> orderArg("k", "order", "Chebyshev polynomial order", false, 30, "uint32_t");
+        cmd.add(orderArg);
+
+        // Heat kernel scale
+        ValueArg<double> tauArg("t", "tau", "Heat kernel scale", false, 1.0, "double");
+        cmd.add(tauArg);
+
+        // Pass band
+        ValueArg<std::string> bandArg("b", "band", "Pass band relative to the largest eigenvalue\n"
+                                      " ex: 0.1,0.5 (low,high)", false, "0.0,0.5", "string");
+        cmd.add(bandArg);
+
+        // Neighbor sampling
+        ValueArg<uint32_t> maxNeighborsArg("m", "maxNeighbors", "tvm: approximate the nodes with more neighbors "
+                                           "by sampling this number of neighbors proportionally to the HLink weights, "
+                                           "0 to use all the neighbors", false, 0, "uint32_t");
+        cmd.add(maxNeighborsArg);
+
+        ValueArg<uint32_t> seedArg("", "seed", "Neighbor sampling seed", false, 0, "uint32_t");
+        cmd.add(seedArg);
+
+        // Prefetch
+        SwitchArg prefetchArg("p", "prefetch", "Prefetch next layer in a background thread", false);
+        cmd.add(prefetchArg);
+
+        // Flush
+        SwitchArg flushArg("", "flush", "Commit each layer as soon as it is filtered to bound memory", false);
+        cmd.add(flushArg);
+
+        // Channels
+        ValueArg<std::string> channelsArg("c", "channels", "Extra OLink attributes filtered with the weight\n"
+                                          " ex: humidity,load", false, "", "string");
+        cmd.add(channelsArg);
+
+        // Excluded nodes
+        ValueArg<std::string> excludeArg("x", "exclude", "File with the labels of the nodes to exclude, "
+                                         "one per line", false, "", "path");
+        cmd.add(excludeArg);
+
+        // Stream
+        ValueArg<std::string> streamArg("a", "append", "Append time steps read from a CSV stream "
+                                        "and refilter incrementally, - for stdin.\n"
+                                        " One row per time step, one value per node", false, "", "path");
+        cmd.add(streamArg);
+
+        // Raw values
+        ValueArg<std::string> rawArg("r", "raw", "Keep the unfiltered weights in this OLink attribute "
+                                     "and always filter from them. A database filtered before streaming "
+                                     "must use the same attribute as the stream.\n"
+                                     " Stream default: raw_weight", false, "", "string");
+        cmd.add(rawArg);
+
+        // Stream batch size
+        ValueArg<uint32_t> batchArg("", "batch", "Number of time steps appended before refiltering",
+                                    false, 1, "uint32_t");
+        cmd.add(batchArg);
+
         // Parse the args.
         cmd.parse(argc, argv);
 
@@ -90,6 +164,48 @@ bool parseOptions( int argc, char *argv[], InputContext& out )
         out.lambda = lambdaArg.getValue();
         out.twSize = twSizeArg.getValue();
         out.numIt = numItArg.getValue();
+        out.prefetch = prefetchArg.getValue();
+        out.flush = flushArg.getValue();
+        out.streamPath = streamArg.getValue();
+        out.excludePath = excludeArg.getValue();
+        out.rawAttr = converter.from_bytes(rawArg.getValue());
+        if( !channelsArg.getValue().empty() ) {
+            std::vector<std::string> channels;
+            boost::split(channels, channelsArg.getValue(), boost::is_any_of(","));
+            for( auto& ch: channels )
+                out.channels.push_back(converter.from_bytes(ch));
+        }
+        out.batchSize = batchArg.getValue();
+        // Refiltering a range of layers from their raw values is one pass,
+        // the layers are commited once per batch
+        if( !out.streamPath.empty()
+            && (out.numIt > 1 || !out.channels.empty() || out.flush) ) {
+            LOG(logERROR) << "--iteration, --channels and --flush are not supported with --append";
+            return false;
+        }
+        out.filterOpts.order = orderArg.getValue();
+        out.filterOpts.tau = tauArg.getValue();
+        out.filterOpts.maxNeighbors = maxNeighborsArg.getValue();
+        out.filterOpts.seed = seedArg.getValue();
+
+        std::vector<std::string> band;
+        boost::split(band, bandArg.getValue(), boost::is_any_of(","));
+        if( band.size() != 2 ) {
+            LOG(logERROR) << "Invalid band: " << bandArg.getValue();
+            return false;
+        }
+        try {
+            out.filterOpts.bandLow = boost::lexical_cast<double>(boost::trim_copy(band[0]));
+            out.filterOpts.bandHigh = boost::lexical_cast<double>(boost::trim_copy(band[1]));
+        }
+        catch( const boost::bad_lexical_cast& ) {
+            LOG(logERROR) << "Invalid band: " << bandArg.getValue();
+            return false;
+        }
+        if( !(out.filterOpts.bandLow >= 0.0 && out.filterOpts.bandLow < out.filterOpts.bandHigh) ) {
+            LOG(logERROR) << "Invalid band, 0 <= low < high expected: " << bandArg.getValue();
+            return false;
+        }
     } catch( ArgException& e ) {
         LOG(logERROR) << "error: " << e.error() << " for arg " << e.argId();
         return false;
@@ -98,6 +214,16 @@ bool parseOptions( int argc, char *argv[], InputContext& out )
     return true;
 }
 
+void logSamplingError( AbstractTimeVertexFilter* filter )
+{
+    auto tvm = dynamic_cast<TimeVertexMeanFilter*>(filter);
+    if( !tvm || tvm->maxNeighbors() == 0 )
+        return;
+    const SamplingError& err = tvm->samplingError();
+    LOG(logINFO) << "Neighbor sampling error on " << err.nodes << " checked values, mean abs: "
+                 << err.meanAbs() << " max abs: " << err.maxAbs << " max rel: " << err.maxRel;
+}
+
 int main( int argc, char *argv[] )
 {
     InputContext ctx;
@@ -108,24 +234,77 @@ int main( int argc, char *argv[] )
     sparkseeManager.openDatabase(ctx.workDir + ctx.dbName + L".sparksee");
     SessionPtr sess(sparkseeManager.newSession());
     sparksee::gdb::Graph* g = sess->GetGraph();
+    if( !MLGDao(g).checkSignalBits() )
+        return EXIT_FAILURE;
+    // Dedicated session for the prefetching thread
+    SessionPtr prefetchSess;
+    if( ctx.prefetch )
+        prefetchSess = sparkseeManager.newSession();
 
-    {
-        auto* filter = FilterFactory::create(g, ctx.filterName, ctx.lambda, ctx.twSize);
+    ObjectsPtr excluded;
+    if( !ctx.excludePath.empty() && !GraphImporter::readNodeSet(g, ctx.excludePath, excluded) )
+        return EXIT_FAILURE;
 
-        TSOperator op(g);
-        op.setFilter(filter);
+    if( !ctx.streamPath.empty() ) {
+        auto* filter = FilterFactory::create(g, ctx.filterName, ctx.lambda, ctx.twSize, ctx.filterOpts);
+        if( !filter )
+            return EXIT_FAILURE;
+        if( excluded )
+            filter->setExcludedNodes(excluded);
 
-        for( uint32_t i = 0; i < ctx.numIt; ++i ) {
-            sess->Begin();
-            if( !op.run() ) {
-                LOG(logERROR) << "Filtering failed it: " << i;
-                sess->Commit();
+        StreamImporter importer(g);
+        importer.setFilter(filter);
+        if( !ctx.rawAttr.empty() )
+            importer.setRawAttribute(ctx.rawAttr);
+        size_t count = 0;
+        bool ok = false;
+        if( ctx.streamPath == "-" ) {
+            ok = importer.fromStream(std::cin, count, sess.get(), ctx.batchSize);
+        }
+        else {
+            std::ifstream infile(ctx.streamPath);
+            if( !infile ) {
+                LOG(logERROR) << "Cannot open stream: " << ctx.streamPath;
                 return EXIT_FAILURE;
             }
+            ok = importer.fromStream(infile, count, sess.get(), ctx.batchSize);
+        }
+        LOG(logINFO) << "Time steps appended: " << count;
+        if( !ok ) {
+            LOG(logERROR) << "Streaming failed";
+            return EXIT_FAILURE;
+        }
+        logSamplingError(filter);
+    }
+    else {
+        auto* filter = FilterFactory::create(g, ctx.filterName, ctx.lambda, ctx.twSize, ctx.filterOpts);
+        if( !filter )
+            return EXIT_FAILURE;
+        if( excluded )
+            filter->setExcludedNodes(excluded);
+
+        TSOperator op(g);
+        op.setFilter(filter);
+        op.setChannels(ctx.channels);
+        op.setFlushPerLayer(ctx.flush);
+        op.setRawAttribute(ctx.rawAttr);
+        if( prefetchSess )
+            op.setPrefetchGraph(prefetchSess->GetGraph());
+
+        // All the iterations are chained in memory, only the result is commited
+        op.setIterations(ctx.numIt);
+        sess->Begin();
+        if( !op.run() ) {
+            LOG(logERROR) << "Filtering failed";
             sess->Commit();
+            return EXIT_FAILURE;
         }
+        sess->Commit();
+        logSamplingError(filter);
     }
     LOG(logINFO) << Timer::dumpTrials();
+    excluded.reset();
+    prefetchSess.reset();
     sess.reset();
     return EXIT_SUCCESS;
 }
@@ -27,6 +27,7 @@
 #include <mld/config.h>
 #include <mld/SparkseeManager.h>
 #include <mld/Session.h>
+#include <mld/dao/MLGDao.h>
 #include <mld/io/GraphImporter.h>
 #include <mld/GraphTypes.h>
 #include <mld/utils/Timer.h>
@@ -39,6 +40,10 @@ struct InputContext {
     std::wstring workDir;
     std::string nodePath;
     std::string edgePath;
+    std::string binPath;
+    bool append;
+    std::string matchKey;
+    int64_t expectedLayers;
 };
 
 std::wstring extractDbName( const std::wstring& inputPath )
@@ -52,7 +57,8 @@ std::wstring extractDbName( const std::wstring& inputPath )
     // Remove last part of .txt for instance
     strs.pop_back();
     // Remove *.nodes or *.edges
-    strs.pop_back();
+    if( strs.size() > 1 )
+        strs.pop_back();
     return boost::algorithm::join(strs, L".");
 }
 
@@ -64,10 +70,23 @@ bool parseOptions( int argc, char *argv[], InputContext& out )
         CmdLine cmd("TimeSeries graph Parser", ' ', "0.1");
 
         // Define a value argument and add it to the command line.
-        ValueArg<std::string> nodeArg("n", "nodes", "nodes data filepath", true, "", "path");
+        ValueArg<std::string> nodeArg("n", "nodes", "nodes data filepath", false, "", "path");
         cmd.add(nodeArg);
-        ValueArg<std::string> edgeArg("e", "edges", "edges data filepath", true, "", "path");
+        ValueArg<std::string> edgeArg("e", "edges", "edges data filepath", false, "", "path");
         cmd.add(edgeArg);
+        ValueArg<std::string> binArg("b", "binary", "binary timeseries filepath (*.mldts)", false, "", "path");
+        cmd.add(binArg);
+        SwitchArg appendArg("a", "append", "Append the node series as new layers to the existing database", false);
+        cmd.add(appendArg);
+        ValueArg<std::string> matchArg("", "match", "Header key used to match the appended rows (default: label)",
+                                       false, "label", "string");
+        cmd.add(matchArg);
+        ValueArg<int64_t> expectArg("", "expectLayers", "Number of layers the database must hold before appending "
+                                    "(default: first step of the ts:N:first header)", false, -1, "int");
+        cmd.add(expectArg);
+        ValueArg<std::string> nameArg("", "dbname", "MLD database name (without extension), required by --append "
+                                      "(default: name of the input file)", false, "", "string");
+        cmd.add(nameArg);
         ValueArg<std::string> wdArg("d", "workDir", "MLD working directory",
                                     false, converter.to_bytes(mld::kRESOURCES_DIR), "path");
         cmd.add(wdArg);
@@ -77,8 +96,32 @@ bool parseOptions( int argc, char *argv[], InputContext& out )
         // Get the value parsed by each arg.
         out.nodePath = nodeArg.getValue();
         out.edgePath = edgeArg.getValue();
+        out.binPath = binArg.getValue();
         out.workDir = converter.from_bytes(wdArg.getValue());
-        out.dbName = extractDbName(converter.from_bytes(out.nodePath));
+        out.append = appendArg.getValue();
+        out.matchKey = matchArg.getValue();
+        out.expectedLayers = expectArg.getValue();
+        if( out.append && out.nodePath.empty() ) {
+            LOG(logERROR) << "error: --append requires --nodes";
+            return false;
+        }
+        if( out.append && !out.binPath.empty() ) {
+            LOG(logERROR) << "error: --binary cannot be used with --append";
+            return false;
+        }
+        // The appended file is not named after the database
+        if( out.append && nameArg.getValue().empty() ) {
+            LOG(logERROR) << "error: --append requires --dbname";
+            return false;
+        }
+        if( !out.append && out.binPath.empty() && (out.nodePath.empty() || out.edgePath.empty()) ) {
+            LOG(logERROR) << "error: either --binary or both --nodes and --edges are required";
+            return false;
+        }
+        if( !nameArg.getValue().empty() )
+            out.dbName = converter.from_bytes(nameArg.getValue());
+        else
+            out.dbName = extractDbName(converter.from_bytes(out.binPath.empty() ? out.nodePath : out.binPath));
     } catch( ArgException& e ) {
         LOG(logERROR) << "error: " << e.error() << " for arg " << e.argId();
         return false;
@@ -94,13 +137,32 @@ int main( int argc, char *argv[] )
         return EXIT_FAILURE;
 
     mld::SparkseeManager m(ctx.workDir + L"mysparksee.cfg");
+    if( ctx.append ) {
+        m.openDatabase(ctx.workDir + ctx.dbName + L".sparksee");
+        SessionPtr sess(m.newSession());
+        sparksee::gdb::Graph* g = sess->GetGraph();
+        if( !MLGDao(g).checkSignalBits() )
+            return EXIT_FAILURE;
+        sess->Begin();
+        if( !GraphImporter::appendTimeSeries(g, ctx.nodePath, ctx.matchKey, ctx.expectedLayers) ) {
+            LOG(logERROR) << "Error appending timeseries";
+            sess->Commit();
+            return EXIT_FAILURE;
+        }
+        sess->Commit();
+        LOG(logINFO) << Timer::dumpTrials();
+        return EXIT_SUCCESS;
+    }
+
     m.createDatabase(ctx.workDir + ctx.dbName + L".sparksee", ctx.dbName);
 
     SessionPtr sess(m.newSession());
     sparksee::gdb::Graph* g = sess->GetGraph();
     m.createBaseScheme(g);
     sess->Begin();
-    if( !GraphImporter::fromTimeSeries(g, ctx.nodePath, ctx.edgePath) ) {
+    bool ok = ctx.binPath.empty() ? GraphImporter::fromTimeSeries(g, ctx.nodePath, ctx.edgePath)
+                                  : GraphImporter::fromBinaryTimeSeries(g, ctx.binPath);
+    if( !ok ) {
         LOG(logERROR) << "Error parsing timeseries graph";
         sess->Commit();
         return EXIT_FAILURE;